@@ -2,6 +2,20 @@ export module Argo;
 
 import :ParserImpl;
 export import :Exceptions;
+export import :Arg;
 export import :Parser;
 export import :Validation;
 export import :Initializer;
+export import :Choices;
+export import :MappedFile;
+export import :Units;
+export import :IndexSet;
+export import :Net;
+export import :Constraint;
+export import :Snapshot;
+export import :Visit;
+export import :Lazy;
+export import :Stdin;
+export import :Reload;
+export import :Repl;
+export import :Server;
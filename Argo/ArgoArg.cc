@@ -3,6 +3,10 @@ export module Argo:Arg;
 import std;
 
 import :ArgName;
+import :MappedFile;
+import :Units;
+import :IndexSet;
+import :Net;
 import :Validation;
 import :TypeTraits;
 
@@ -35,6 +39,15 @@ struct ParserID {
       this->id.idName[i] = id[i];
     }
   };
+
+  // Set on the copy of a parser used by Reloader, it owns separate values
+  bool shadow = false;
+
+  [[nodiscard]] consteval auto shadowed() const -> ParserID {
+    auto ret = *this;
+    ret.shadow = true;
+    return ret;
+  }
 };
 
 ParserID(int) -> ParserID<1>;
@@ -71,7 +84,8 @@ struct String {
 
   String() = default;
 
-  consteval explicit String(const char (&str)[N + 1]) {
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  consteval String(const char (&str)[N + 1]) {
     for (std::size_t i = 0; i < N; i++) {
       str_[i] = str[i];
     }
@@ -124,7 +138,7 @@ template <class T>
 consteval auto get_type_name_base_type([[maybe_unused]] std::size_t n = 0) {
   if constexpr (std::is_same_v<T, bool>) {
     return String("BOOL");
-  } else if constexpr (std::is_integral_v<T>) {
+  } else if constexpr (std::is_integral_v<T> or std::is_enum_v<T>) {
     return String("NUMBER");
   } else if constexpr (std::is_floating_point_v<T>) {
     return String("FLOAT");
@@ -134,6 +148,26 @@ consteval auto get_type_name_base_type([[maybe_unused]] std::size_t n = 0) {
     return String("STRING");
   } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
     return String("PATH");
+  } else if constexpr (std::derived_from<T, MappedFileTag>) {
+    return String("FILE");
+  } else if constexpr (std::is_same_v<T, Bytes>) {
+    return String("BYTES");
+  } else if constexpr (is_duration_v<T>) {
+    return String("DURATION");
+  } else if constexpr (is_si_v<T>) {
+    return String("NUMBER");
+  } else if constexpr (is_rate_v<T>) {
+    return String("RATE");
+  } else if constexpr (std::is_same_v<T, IndexSet>) {
+    return String("INDEX_SET");
+  } else if constexpr (std::is_same_v<T, IpAddress>) {
+    return String("ADDRESS");
+  } else if constexpr (std::is_same_v<T, Cidr>) {
+    return String("CIDR");
+  } else if constexpr (std::is_same_v<T, Endpoint>) {
+    return String("HOST:PORT");
+  } else if constexpr (is_map_v<T>) {
+    return String("KEY=VALUE");
   } else {
     return String("UNKNOWN");
   }
@@ -166,7 +200,13 @@ consteval auto get_base_type_name_form_stl() {
 
 template <class T, NArgs TNArgs>
 consteval auto get_type_name() {
-  if constexpr (is_array_v<T> or TNArgs.nargs > 1) {
+  if constexpr (is_map_v<T>) {
+    if constexpr (TNArgs.nargs == 1) {
+      return get_type_name_base_type<T>();
+    } else {
+      return String("<") + get_type_name_base_type<T>() + String(",...>");
+    }
+  } else if constexpr (is_array_v<T> or TNArgs.nargs > 1) {
     return String("<") + get_base_type_name_form_stl<T, TNArgs>() + String(">");
   } else if constexpr (TNArgs.nargs == 1) {
     if constexpr (is_vector_v<T>) {
@@ -174,7 +214,7 @@ consteval auto get_type_name() {
     } else {
       return get_type_name_base_type<T>();
     }
-  } else if constexpr (is_vector_v<T>) {
+  } else if constexpr (is_vector_v<T> or is_lazy_args_v<T>) {
     if constexpr (TNArgs.nargs_char == '*') {
       return String("[<") + get_type_name_base_type<vector_base_t<T>>() +
              String(",...>]");
@@ -189,12 +229,24 @@ consteval auto get_type_name() {
   }
 }
 
+/*!
+ * Where the value of an argument came from, later ones take precedence
+ */
+export enum class ValueSource {
+  Default,
+  ConfigFile,
+  Environment,
+  CommandLine,
+};
+
 struct ArgTag {};
 
 /*!
  * Arg type this holds argument value
+ * Append: each occurrence appends to the vector instead of being an error
  */
-template <class Type, ArgName Name, NArgs TNArgs, bool Required, ParserID ID>
+template <class Type, ArgName Name, NArgs TNArgs, bool Required, ParserID ID,
+          bool Append = false>
 struct Arg : ArgTag {
   using type =             //
       std::conditional_t<  //
@@ -202,7 +254,9 @@ struct Arg : ArgTag {
            (TNArgs.nargs_char != '*'))                              //
               || is_array_v<Type>                                   //
               || is_tuple_v<Type>                                   //
-              || is_vector_v<Type>,                                 //
+              || is_vector_v<Type>                                  //
+              || is_lazy_args_v<Type>                               //
+              || is_map_v<Type>,                                    //
           Type,                                                     //
           std::conditional_t<                                       //
               (TNArgs.nargs > 1),                                   //
@@ -214,25 +268,49 @@ struct Arg : ArgTag {
       is_array_v<Type>,                                             //
       array_base_t<Type>,                                           //
       std::conditional_t<                                           //
-          is_vector_v<Type>,                                        //
+          is_vector_v<Type> || is_lazy_args_v<Type>,                //
           vector_base_t<Type>,                                      //
           Type                                                      //
           >                                                         //
       >;
+  static_assert(!is_lazy_args_v<Type> or TNArgs.nargs_char == '+' or
+                    TNArgs.nargs_char == '*',
+                "LazyArgs takes nargs('+') or nargs('*')");
   static constexpr auto name = Name;
+  static constexpr auto id = ID;
   inline static std::string_view description{};
   inline static bool assigned = false;
+  inline static ValueSource source = ValueSource::Default;
   inline static bool required = Required;
   inline static type value = {};
   inline static type defaultValue = {};
+  inline static type explicitDefault = {};
   inline static constexpr NArgs nargs = TNArgs;
-  inline static std::function<type(std::string_view)> caster = nullptr;
+  static constexpr bool append = Append;
+  static constexpr bool repeatable = Append || is_map_v<Type>;
+  inline static baseType (*caster)(std::string_view, std::string_view) =
+      nullptr;
   inline static std::function<void(
       const type& value, std::span<std::string_view>, std::string_view)>
       validator = nullptr;
   inline static std::function<void(type&, std::span<std::string_view>)>
       callback = nullptr;
-  inline static constexpr auto typeName = get_type_name<type, TNArgs>();
+  inline static constexpr auto defaultTypeName = get_type_name<type, TNArgs>();
+  inline static std::string_view typeName = std::string_view(defaultTypeName);
+
+  template <ParserID NewID>
+  using rebind = Arg<Type, Name, TNArgs, Required, NewID, Append>;
+};
+
+/*!
+ * Validator of each element of a lazy argument, run when it is accessed
+ */
+template <class Arg>
+struct ElementValidator {
+  inline static std::function<void(const typename Arg::baseType& value,
+                                   std::span<std::string_view>,
+                                   std::string_view)>
+      validator = nullptr;
 };
 
 struct FlagArgTag {};
@@ -242,13 +320,56 @@ struct FlagArg : FlagArgTag {
   using type = bool;
   using baseType = bool;
   static constexpr auto name = Name;
+  static constexpr auto id = ID;
+  static constexpr bool repeatable = false;
   inline static bool assigned = false;
+  inline static ValueSource source = ValueSource::Default;
   inline static std::string_view description{};
   inline static type value = false;
   inline static std::function<void()> callback = nullptr;
   inline static constexpr auto typeName = String("");
+
+  template <ParserID NewID>
+  using rebind = FlagArg<Name, NewID>;
 };
 
+struct CountArgTag {};
+
+/*!
+ * Flag which counts its occurrences, -vvv or -v -v -v gives 3
+ */
+template <ArgName Name, ParserID ID>
+struct CountArg : CountArgTag, FlagArgTag {
+  using type = int;
+  using baseType = int;
+  static constexpr auto name = Name;
+  static constexpr auto id = ID;
+  static constexpr bool repeatable = true;
+  inline static bool assigned = false;
+  inline static ValueSource source = ValueSource::Default;
+  inline static std::string_view description{};
+  inline static type value = 0;
+  inline static std::function<void()> callback = nullptr;
+  inline static constexpr auto typeName = String("");
+
+  template <ParserID NewID>
+  using rebind = CountArg<Name, NewID>;
+};
+
+/*!
+ * Same arguments bound to another parser id
+ */
+template <class Tuple, ParserID NewID>
+struct RebindArgs;
+
+template <class... T, ParserID NewID>
+struct RebindArgs<std::tuple<T...>, NewID> {
+  using type = std::tuple<typename T::template rebind<NewID>...>;
+};
+
+template <class Tuple, ParserID NewID>
+using RebindArgs_t = typename RebindArgs<Tuple, NewID>::type;
+
 struct HelpArgTag {};
 
 template <ArgName Name, ParserID ID>
@@ -256,6 +377,7 @@ struct HelpArg : HelpArgTag, FlagArgTag {
   using type = bool;
   using baseType = bool;
   static constexpr auto name = Name;
+  static constexpr bool repeatable = false;
   inline static bool assigned = false;
   inline static std::string_view description = "Print help information";
   inline static type value = false;
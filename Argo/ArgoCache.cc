@@ -0,0 +1,225 @@
+module;
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Cache;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :Arg;
+import :MappedFile;
+import :Config;
+import :Serialize;
+
+// generator start here
+
+namespace Argo {
+
+struct CacheHeader {
+  std::array<char, 4> magic = {'A', 'R', 'G', 'C'};
+  std::uint32_t version = 2;
+  std::uint64_t inputs = 0;
+  std::uint64_t files = 0;
+};
+
+/*!
+ * State of a file the result depends on, size is -1 if it did not exist
+ */
+struct CacheFileState {
+  std::uint64_t dev = 0;
+  std::uint64_t ino = 0;
+  std::int64_t size = -1;
+  std::int64_t mtime = 0;
+
+  static auto of(const char* path) -> CacheFileState {
+    struct ::stat st {};
+    if (::stat(path, &st) != 0) {
+      return {};
+    }
+#ifdef __APPLE__
+    const auto& mtime = st.st_mtimespec;
+#else
+    const auto& mtime = st.st_mtim;
+#endif
+    return {
+        .dev = static_cast<std::uint64_t>(st.st_dev),
+        .ino = static_cast<std::uint64_t>(st.st_ino),
+        .size = static_cast<std::int64_t>(st.st_size),
+        .mtime = static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 +
+                 mtime.tv_nsec,
+    };
+  }
+
+  auto operator==(const CacheFileState&) const -> bool = default;
+};
+
+/*!
+ * Everything the parse result depends on besides files: the schema, argv and
+ * the environment variables read by EnvAssigner
+ */
+template <class Args>
+auto CacheInputs(int argc, char* argv[],
+                 std::optional<std::string_view> env_prefix)
+    -> std::vector<std::byte> {
+  auto writer = SerialWriter();
+  writer.buffer().reserve(4096);
+  writer.write(SchemaHash<Args>());
+  writer.write(static_cast<std::uint64_t>(argc));
+  for (int i = 0; i < argc; i++) {
+    Encode(writer, std::string_view(argv[i]));
+  }
+  if (env_prefix) {
+    auto env_name = std::string();
+    tuple_type_visit<Args>([&]<class T>(T) {
+      EnvName(env_name, *env_prefix, T::type::name.getKey());
+      const char* env = std::getenv(env_name.c_str());
+      Encode(writer, env);
+    });
+  }
+  return std::move(writer.buffer());
+}
+
+/*!
+ * Eight bytes per step, collisions only cost a miss since inputs are compared
+ * on lookup
+ */
+inline auto CacheKey(std::span<const std::byte> inputs) -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  std::size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= inputs.size();
+       i += sizeof(std::uint64_t)) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, inputs.data() + i, sizeof(word));
+    hash = (std::rotl(hash, 5) ^ word) * 0x9e3779b97f4a7c15;
+  }
+  return Fnv1a(hash,
+               std::string_view(reinterpret_cast<const char*>(inputs.data()),
+                                inputs.size())
+                   .substr(i));
+}
+
+inline constexpr std::size_t cache_map_threshold = 64 * 1024;
+
+/*!
+ * Contents of the entry at path, kept alive by storage. Entries smaller than
+ * cache_map_threshold are read, mapping them costs more than the copy
+ */
+inline auto CacheRead(const std::string& path, ConfigStorage& storage)
+    -> std::optional<std::span<const std::byte>> {
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+  auto ret = std::optional<std::span<const std::byte>>();
+  struct ::stat st {};
+  if (::fstat(fd, &st) == 0) {
+    auto size = static_cast<std::size_t>(st.st_size);
+    if (size > cache_map_threshold) {
+      try {
+        ret = storage.files
+                  .emplace_back(
+                      BasicMappedFile<MapAdvice::Sequential>::fromFd(fd))
+                  .bytes();
+      } catch (const InvalidArgument&) {
+        // Treated as a miss
+      }
+    } else {
+      auto& buffer = storage.strings.emplace_back(size, '\0');
+      if (::read(fd, buffer.data(), size) == static_cast<::ssize_t>(size)) {
+        ret = std::as_bytes(std::span(buffer));
+      }
+    }
+  }
+  ::close(fd);
+  return ret;
+}
+
+struct CacheEntry {
+  // Positions in argv of the tokens collected by collectUnknown
+  std::vector<std::uint32_t> unknown;
+  std::span<const std::byte> block;
+};
+
+/*!
+ * Entry layout: CacheHeader, inputs, one path and CacheFileState per file,
+ * the unknown token positions, then the block written by SerializeArgs
+ * Returns the entry when inputs and every file still match
+ */
+inline auto CacheLookup(std::span<const std::byte> entry,
+                        std::span<const std::byte> inputs)
+    -> std::optional<CacheEntry> {
+  try {
+    auto reader = SerialReader(entry);
+    auto header = reader.read<CacheHeader>();
+    if (header.magic != CacheHeader().magic or
+        header.version != CacheHeader().version or
+        header.inputs != inputs.size()) {
+      return std::nullopt;
+    }
+    if (std::memcmp(reader.take(inputs.size()), inputs.data(),
+                    inputs.size()) != 0) {
+      return std::nullopt;
+    }
+    for (std::uint64_t i = 0; i < header.files; i++) {
+      const char* path = nullptr;
+      Decode(reader, path);
+      if (path == nullptr or
+          reader.read<CacheFileState>() != CacheFileState::of(path)) {
+        return std::nullopt;
+      }
+    }
+    auto ret = CacheEntry();
+    Decode(reader, ret.unknown);
+    ret.block = reader.rest();
+    return ret;
+  } catch (const ParseError&) {
+    return std::nullopt;
+  }
+}
+
+/*!
+ * Written to a temporary file renamed over path, concurrent writers of the
+ * same entry never expose a partial one. Errors are ignored, the result was
+ * already parsed.
+ */
+inline auto CacheStore(const std::string& path,
+                       std::span<const std::byte> inputs,
+                       std::span<const std::string> files,
+                       const std::vector<std::uint32_t>& unknown,
+                       std::span<const std::byte> block) -> void {
+  auto writer = SerialWriter();
+  writer.write(CacheHeader{.inputs = inputs.size(), .files = files.size()});
+  writer.write(inputs.data(), inputs.size());
+  for (const auto& file : files) {
+    Encode(writer, file.c_str());
+    writer.write(CacheFileState::of(file.c_str()));
+  }
+  Encode(writer, unknown);
+  writer.write(block.data(), block.size());
+
+  auto tmp = std::format("{}.{}.tmp", path, ::getpid());
+  auto ec = std::error_code();
+  {
+    auto out = std::ofstream(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(writer.buffer().data()),
+              static_cast<std::streamsize>(writer.buffer().size()));
+    if (!out.flush()) {
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+}  // namespace Argo
+
+// generator end here
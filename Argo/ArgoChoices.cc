@@ -0,0 +1,145 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Choices;
+
+import std;
+
+import :Exceptions;
+import :Validation;
+import :Arg;
+
+// generator start here
+
+namespace Argo {
+
+struct ChoicesTag {};
+
+ARGO_ALWAYS_INLINE constexpr auto ChoiceHash(std::string_view str,
+                                             std::uint64_t seed)
+    -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+  for (auto c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash ^ (hash >> 32);
+}
+
+/*!
+ * Search a seed which maps every name to its own slot
+ * Table size is at least N^2 so a seed is found after a few trials.
+ */
+template <std::size_t TableSize, std::size_t N>
+consteval auto BuildChoiceTable(const std::array<std::string_view, N>& names) {
+  std::array<std::uint8_t, TableSize> slots{};
+  for (std::uint64_t seed = 0;; seed++) {
+    slots.fill(0);
+    auto perfect = true;
+    for (std::size_t i = 0; i < N and perfect; i++) {
+      auto& slot = slots[ChoiceHash(names[i], seed) & (TableSize - 1)];
+      perfect = (slot == 0);
+      slot = static_cast<std::uint8_t>(i + 1);
+    }
+    if (perfect) {
+      return std::make_pair(seed, slots);
+    }
+  }
+}
+
+/*!
+ * Choices of string values
+ * Example:
+ *      enum class Mode { Fast, Safe, Debug };
+ *      addArg<"mode", Mode>(choices<"fast", "safe", "debug">())
+ *      addArg<"level", std::string>(choices<"low", "high">())
+ *
+ * For enum arguments the n-th name is converted to static_cast<Enum>(n)
+ * through a compile-time perfect hash, other arguments are validated.
+ */
+export template <String... Names>
+struct Choices final : ChoicesTag, Validation::ValidationBase {
+  static_assert(sizeof...(Names) > 0, "Choices must not be empty");
+  static_assert(sizeof...(Names) < 256, "Too many choices");
+
+  static constexpr auto names = std::array<std::string_view, sizeof...(Names)>{
+      std::string_view(Names)...};
+
+  static_assert(
+      [] {
+        for (std::size_t i = 0; i < names.size(); i++) {
+          for (std::size_t j = i + 1; j < names.size(); j++) {
+            if (names[i] == names[j]) {
+              return false;
+            }
+          }
+        }
+        return true;
+      }(),
+      "Duplicated choice");
+
+  static constexpr auto typeName =
+      (String("{") + ... +
+       (std::remove_cvref_t<decltype(Names)>(Names) + String("|")))
+          .removeTrail() +
+      String("}");
+
+ private:
+  static constexpr std::size_t table_size =
+      std::max<std::size_t>(std::bit_ceil(names.size() * names.size()), 4);
+  static constexpr auto table = BuildChoiceTable<table_size>(names);
+
+ public:
+  /*!
+   * Index of the value in Names or -1
+   */
+  [[nodiscard]] ARGO_ALWAYS_INLINE static constexpr auto indexOf(
+      std::string_view value) -> int {
+    auto slot = table.second[ChoiceHash(value, table.first) & (table_size - 1)];
+    if (slot == 0 or names[slot - 1] != value) {
+      return -1;
+    }
+    return slot - 1;
+  }
+
+  template <class Enum>
+  static auto cast(std::string_view value, std::string_view key) -> Enum {
+    auto index = indexOf(value);
+    if (index < 0) [[unlikely]] {
+      throw InvalidArgument(std::format("Argument {}: {} is not one of {}", key,
+                                        value, std::string_view(typeName)));
+    }
+    return static_cast<Enum>(index);
+  }
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(std::format("Option {} has invalid value {}",
+                                        option_name, values));
+    }
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> /* unused */) const
+      -> bool {
+    if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+      return indexOf(value) >= 0;
+    } else {
+      return std::ranges::all_of(value, [](const auto& elem) {
+        return indexOf(elem) >= 0;
+      });
+    }
+  };
+};
+
+export template <String... Names>
+ARGO_ALWAYS_INLINE constexpr auto choices() -> Choices<Names...> {
+  return {};
+}
+
+}  // namespace Argo
+
+// generator end here
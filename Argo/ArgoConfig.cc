@@ -0,0 +1,432 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Config;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :Arg;
+import :MappedFile;
+import :MetaAssigner;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Memory backing values read from config files, string_view arguments point
+ * into it. It is shared with snapshots and replaced on resetArgs.
+ */
+struct ConfigStorage {
+  std::vector<BasicMappedFile<MapAdvice::Sequential>> files;
+  std::deque<std::string> strings;
+};
+
+/*!
+ * Streaming tokenizer for a subset of INI/TOML
+ *      # comment, ; comment
+ *      [section]            -> following keys are "section.key"
+ *      key = value          -> bare value up to a comment or end of line
+ *      key = "a \"b\""      -> basic string, 'c:\dir' is a literal string
+ *      key = [1, 2, 3]      -> three values, may span lines
+ *
+ * Values are views into the buffer, only strings with escapes are copied.
+ */
+class ConfigReader {
+ private:
+  std::string_view rest_;
+  std::string_view path_;
+  std::deque<std::string>& strings_;
+  std::string_view section_;
+  std::string_view key_;
+  std::string key_buffer_;
+  std::vector<std::string_view> values_;
+  std::size_t line_ = 1;
+  std::size_t entry_line_ = 1;
+
+  [[noreturn]] auto fail(std::string_view what) const -> void {
+    throw InvalidArgument(
+        std::format("{}:{}: {}", this->path_, this->line_, what));
+  }
+
+  ARGO_ALWAYS_INLINE auto skipBlank() -> void {
+    auto pos = this->rest_.find_first_not_of(" \t\r");
+    this->rest_.remove_prefix(std::min(pos, this->rest_.size()));
+  }
+
+  ARGO_ALWAYS_INLINE auto skipLine() -> void {
+    auto pos = this->rest_.find('\n');
+    this->rest_.remove_prefix(std::min(pos, this->rest_.size()));
+  }
+
+  // Blank lines and comments inside an array
+  auto skipSpace() -> void {
+    while (true) {
+      this->skipBlank();
+      if (this->rest_.starts_with('#') or this->rest_.starts_with(';')) {
+        this->skipLine();
+      }
+      if (!this->rest_.starts_with('\n')) {
+        return;
+      }
+      this->rest_.remove_prefix(1);
+      this->line_++;
+    }
+  }
+
+  auto expectLineEnd() -> void {
+    this->skipBlank();
+    if (this->rest_.starts_with('#') or this->rest_.starts_with(';')) {
+      this->skipLine();
+    }
+    if (!this->rest_.empty() and !this->rest_.starts_with('\n')) {
+      this->fail(std::format("unexpected {}", this->rest_.substr(
+                                                  0, this->rest_.find('\n'))));
+    }
+  }
+
+  auto quoted() -> std::string_view {
+    auto quote = this->rest_.front();
+    this->rest_.remove_prefix(1);
+    auto end = this->rest_.find_first_of(quote == '"' ? "\"\\\n" : "'\n");
+    if (end == std::string_view::npos or this->rest_[end] == '\n') {
+      this->fail("unterminated string");
+    }
+    if (this->rest_[end] == quote) {
+      auto ret = this->rest_.substr(0, end);
+      this->rest_.remove_prefix(end + 1);
+      return ret;
+    }
+    auto& ret = this->strings_.emplace_back(this->rest_.substr(0, end));
+    for (auto i = end; i < this->rest_.size(); i++) {
+      auto c = this->rest_[i];
+      if (c == '"') {
+        this->rest_.remove_prefix(i + 1);
+        return ret;
+      }
+      if (c == '\n') {
+        break;
+      }
+      if (c == '\\') {
+        if (++i == this->rest_.size()) {
+          break;
+        }
+        switch (this->rest_[i]) {
+          case 'n':
+            c = '\n';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case '"':
+          case '\\':
+            c = this->rest_[i];
+            break;
+          default:
+            this->fail(std::format("invalid escape \\{}", this->rest_[i]));
+        }
+      }
+      ret.push_back(c);
+    }
+    this->fail("unterminated string");
+  }
+
+  auto scalar(bool in_array) -> std::string_view {
+    if (this->rest_.starts_with('"') or this->rest_.starts_with('\'')) {
+      return this->quoted();
+    }
+    auto end = this->rest_.find_first_of(in_array ? ",]#;\n" : "#;\n");
+    auto ret = this->rest_.substr(0, end);
+    ret = ret.substr(0, ret.find_last_not_of(" \t\r") + 1);
+    if (ret.empty()) {
+      this->fail("missing value");
+    }
+    this->rest_.remove_prefix(ret.size());
+    return ret;
+  }
+
+  auto array() -> void {
+    this->rest_.remove_prefix(1);
+    this->skipSpace();
+    while (!this->rest_.starts_with(']')) {
+      if (this->rest_.empty()) {
+        this->fail("unterminated array");
+      }
+      this->values_.push_back(this->scalar(true));
+      this->skipSpace();
+      if (this->rest_.starts_with(',')) {
+        this->rest_.remove_prefix(1);
+        this->skipSpace();
+      } else if (!this->rest_.starts_with(']')) {
+        this->fail("expected , or ] in array");
+      }
+    }
+    this->rest_.remove_prefix(1);
+  }
+
+ public:
+  ConfigReader(std::string_view buffer, std::string_view path,
+               std::deque<std::string>& strings)
+      : rest_(buffer), path_(path), strings_(strings) {}
+
+  /*!
+   * Advance to the next key, returns false at the end of the buffer
+   */
+  auto next() -> bool {
+    while (true) {
+      this->skipBlank();
+      if (this->rest_.empty()) {
+        return false;
+      }
+      auto c = this->rest_.front();
+      if (c == '\n') {
+        this->rest_.remove_prefix(1);
+        this->line_++;
+        continue;
+      }
+      if (c == '#' or c == ';') {
+        this->skipLine();
+        continue;
+      }
+      if (c == '[') {
+        auto end = this->rest_.find_first_of("]\n");
+        if (end == std::string_view::npos or this->rest_[end] != ']') {
+          this->fail("unterminated section");
+        }
+        this->section_ = this->rest_.substr(1, end - 1);
+        this->rest_.remove_prefix(end + 1);
+        this->expectLineEnd();
+        continue;
+      }
+
+      auto eq = this->rest_.find_first_of("=\n");
+      if (eq == std::string_view::npos or this->rest_[eq] != '=') {
+        this->fail("expected key = value");
+      }
+      auto key = this->rest_.substr(0, eq);
+      key = key.substr(0, key.find_last_not_of(" \t") + 1);
+      this->rest_.remove_prefix(eq + 1);
+      this->entry_line_ = this->line_;
+
+      this->values_.clear();
+      this->skipBlank();
+      if (this->rest_.starts_with('[')) {
+        this->array();
+      } else {
+        this->values_.push_back(this->scalar(false));
+      }
+      this->expectLineEnd();
+
+      if (this->section_.empty()) {
+        this->key_ = key;
+      } else {
+        this->key_buffer_.assign(this->section_);
+        this->key_buffer_.push_back('.');
+        this->key_buffer_.append(key);
+        this->key_ = this->key_buffer_;
+      }
+      return true;
+    }
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto key() const -> std::string_view {
+    return this->key_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto values()
+      -> std::span<std::string_view> {
+    return this->values_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto line() const -> std::size_t {
+    return this->entry_line_;
+  }
+};
+
+/*!
+ * Assign a value coming from a lower layer than the command line, arguments
+ * already set by a higher layer keep their value
+ */
+template <class Arg>
+auto SourceAssign(std::span<std::string_view> values, ValueSource source,
+                  ConfigStorage& storage) -> void {
+  constexpr auto key = Arg::name.getKey();
+  if (Arg::assigned and Arg::source > source) {
+    return;
+  }
+  if constexpr (std::derived_from<Arg, FlagArgTag>) {
+    if (values.size() != 1) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: should take exactly one value", key));
+    }
+    if (!Arg::repeatable and Arg::assigned) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: duplicated argument", key));
+    }
+    if constexpr (std::derived_from<Arg, CountArgTag>) {
+      Arg::value = ArgCaster<int>(values[0], key);
+    } else {
+      Arg::value = ArgCaster<bool>(values[0], key);
+    }
+    MarkAssigned<Arg>();
+    Arg::source = source;
+    if (Arg::value and Arg::callback) {
+      Arg::callback();
+    }
+  } else {
+    if constexpr (std::is_same_v<typename Arg::baseType, const char*>) {
+      // Views into the file are not null terminated
+      for (auto& value : values) {
+        value = storage.strings.emplace_back(value);
+      }
+    }
+    if constexpr (!Arg::repeatable and (Arg::nargs.nargs == 1 or
+                                        Arg::nargs.nargs_char == '?')) {
+      if (values.size() > 1) [[unlikely]] {
+        throw InvalidArgument(std::format(
+            "Argument {}: should take exactly one value but {}", key,
+            values.size()));
+      }
+    }
+    if constexpr (Arg::repeatable and Arg::nargs.nargs == 1) {
+      for (std::size_t i = 0; i < values.size(); i++) {
+        AssignOneArg<Arg, std::tuple<>>(key, values.subspan(i, 1));
+      }
+    } else {
+      AssignOneArg<Arg, std::tuple<>>(key, values);
+    }
+    Arg::source = source;
+  }
+}
+
+/*!
+ * Returns false if no argument has the key
+ */
+template <class Args>
+auto SourceAssigner(std::string_view key, std::span<std::string_view> values,
+                    ValueSource source, ConfigStorage& storage) -> bool {
+  return tuple_type_or_visit<Args>([&]<class T>(T) ARGO_ALWAYS_INLINE {
+    if (T::type::name.getKey() != key) {
+      return false;
+    }
+    SourceAssign<typename T::type>(values, source, storage);
+    return true;
+  });
+}
+
+/*!
+ * PREFIX_KEY, "-" and "." in the key become "_"
+ */
+inline auto EnvName(std::string& env_name, std::string_view prefix,
+                    std::string_view key) -> void {
+  env_name.assign(prefix);
+  env_name.push_back('_');
+  for (auto c : key) {
+    env_name.push_back((c == '-' or c == '.')
+                           ? '_'
+                           : static_cast<char>(std::toupper(c)));
+  }
+}
+
+/*!
+ * Read PREFIX_KEY for every argument not given on the command line. Multi
+ * value arguments are split on ",".
+ */
+template <class Args>
+auto EnvAssigner(std::string_view prefix, ConfigStorage& storage) -> void {
+  auto env_name = std::string();
+  auto values = std::vector<std::string_view>();
+  tuple_type_visit<Args>([&]<class T>(T) {
+    using Arg = typename T::type;
+    if (Arg::assigned) {
+      return;
+    }
+    EnvName(env_name, prefix, Arg::name.getKey());
+    const auto* env = std::getenv(env_name.c_str());
+    if (env == nullptr) {
+      return;
+    }
+    values.clear();
+    auto value = std::string_view(env);
+    if constexpr (std::derived_from<Arg, ArgTag>) {
+      if constexpr (Arg::repeatable or
+                    (Arg::nargs.nargs != 1 and Arg::nargs.nargs_char != '?')) {
+        for (auto part : std::views::split(value, ',')) {
+          values.emplace_back(part.begin(), part.end());
+        }
+      } else {
+        values.push_back(value);
+      }
+    } else {
+      values.push_back(value);
+    }
+    SourceAssign<Arg>(values, ValueSource::Environment, storage);
+  });
+}
+
+/*!
+ * Assign every key of the config file to the argument of the same name
+ * A missing file is skipped unless the path was given explicitly. With copy,
+ * the file is read into memory instead of mapped, for files rewritten while
+ * values still point into them.
+ */
+template <class Args>
+auto ConfigAssigner(std::string_view path, bool must_exist, bool copy,
+                    ConfigStorage& storage) -> void {
+  if (!must_exist and !std::filesystem::exists(path)) {
+    return;
+  }
+  auto buffer = std::string_view();
+  if (copy) {
+    auto file = std::ifstream(std::string(path), std::ios::binary);
+    if (!file) [[unlikely]] {
+      throw InvalidArgument(std::format("Cannot read config file {}", path));
+    }
+    buffer = storage.strings.emplace_back(std::istreambuf_iterator<char>(file),
+                                          std::istreambuf_iterator<char>());
+  } else {
+    buffer = storage.files.emplace_back(path).view();
+  }
+  auto reader = ConfigReader(buffer, path, storage.strings);
+  while (reader.next()) {
+    try {
+      if (!SourceAssigner<Args>(reader.key(), reader.values(),
+                                ValueSource::ConfigFile, storage))
+          [[unlikely]] {
+        throw InvalidArgument(std::format("Invalid argument {}", reader.key()));
+      }
+    } catch (const ValidationError& e) {
+      throw ValidationError(
+          std::format("{}:{}: {}", path, reader.line(), e.what()));
+    } catch (const InvalidArgument& e) {
+      throw InvalidArgument(
+          std::format("{}:{}: {}", path, reader.line(), e.what()));
+    }
+  }
+}
+
+/*!
+ * Path held by the config argument and whether it was given explicitly
+ */
+template <class Args>
+auto ConfigPath(std::string_view key) -> std::pair<std::string_view, bool> {
+  auto ret = std::pair<std::string_view, bool>();
+  tuple_type_visit<Args>([&ret, key]<class T>(T) {
+    if constexpr (std::is_same_v<typename T::type::type, std::string>) {
+      if (T::type::name.getKey() == key) {
+        ret = {T::type::value, T::type::assigned};
+      }
+    }
+  });
+  return ret;
+}
+
+}  // namespace Argo
+
+// generator end here
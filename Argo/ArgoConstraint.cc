@@ -0,0 +1,192 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Constraint;
+
+import std;
+
+import :Exceptions;
+import :ArgName;
+import :Arg;
+import :MetaLookup;
+import :TypeTraits;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Bit n is set for the n-th argument of a parser
+ */
+template <std::size_t N>
+struct ArgMask {
+  std::array<std::uint64_t, (N + 63) / 64> words{};
+
+  ARGO_ALWAYS_INLINE constexpr auto set(std::size_t index, bool value = true)
+      -> void {
+    this->words[index / 64] |= static_cast<std::uint64_t>(value)
+                               << (index % 64);
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto test(std::size_t index) const
+      -> bool {
+    return ((this->words[index / 64] >> (index % 64)) & 1) != 0;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto operator&(
+      const ArgMask& rhs) const -> ArgMask {
+    auto ret = ArgMask();
+    for (std::size_t i = 0; i < this->words.size(); i++) {
+      ret.words[i] = this->words[i] & rhs.words[i];
+    }
+    return ret;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto count() const
+      -> std::size_t {
+    std::size_t ret = 0;
+    for (auto word : this->words) {
+      ret += std::popcount(word);
+    }
+    return ret;
+  }
+
+  constexpr auto operator==(const ArgMask&) const -> bool = default;
+};
+
+/*!
+ * Whether Arg counts as given for constraints. A flag set to false or 0 by a
+ * config file or the environment is assigned, but not given
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto IsGiven() -> bool {
+  if constexpr (std::derived_from<Arg, FlagArgTag>) {
+    return Arg::assigned and static_cast<bool>(Arg::value);
+  } else {
+    return Arg::assigned;
+  }
+}
+
+template <class Args>
+ARGO_ALWAYS_INLINE constexpr auto AssignedMask()
+    -> ArgMask<std::tuple_size_v<Args>> {
+  auto ret = ArgMask<std::tuple_size_v<Args>>();
+  [&ret]<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
+    (..., ret.set(Is, IsGiven<std::tuple_element_t<Is, Args>>()));
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  return ret;
+}
+
+export enum class ConstraintKind {
+  Exclusive,
+  DependsOn,
+  OneOf,
+};
+
+struct ConstraintTag {};
+
+/*!
+ * Constraint between arguments checked at the end of parse
+ *   Exclusive: at most one of Names
+ *   DependsOn: if the first name is given, all the others are required
+ *   OneOf:     at least one of Names
+ */
+template <ConstraintKind Kind, ArgName... Names>
+struct Constraint : ConstraintTag {
+  static_assert(sizeof...(Names) >= 2, "Constraint needs two or more names");
+
+  template <class Args>
+  static consteval auto refersTo() -> bool {
+    return (... && (SearchIndex<Args, Names>() != -1));
+  }
+
+ private:
+  template <class Args>
+  static constexpr auto indices =
+      std::array<int, sizeof...(Names)>{SearchIndex<Args, Names>()...};
+
+  template <class Args, std::size_t Skip>
+  static consteval auto mask() -> ArgMask<std::tuple_size_v<Args>> {
+    auto ret = ArgMask<std::tuple_size_v<Args>>();
+    for (std::size_t i = Skip; i < indices<Args>.size(); i++) {
+      ret.set(indices<Args>[i]);
+    }
+    return ret;
+  }
+
+ public:
+  template <class Args>
+  ARGO_ALWAYS_INLINE static auto check(
+      const ArgMask<std::tuple_size_v<Args>>& assigned) -> void {
+    static constexpr auto group = mask<Args, 0>();
+    static constexpr auto names =
+        std::array<std::string_view, sizeof...(Names)>{Names.getKey()...};
+    auto given = [&assigned](bool want) {
+      auto ret = std::vector<std::string_view>();
+      for (std::size_t i = 0; i < names.size(); i++) {
+        if (assigned.test(indices<Args>[i]) == want) {
+          ret.push_back(names[i]);
+        }
+      }
+      return ret;
+    };
+
+    if constexpr (Kind == ConstraintKind::Exclusive) {
+      if ((assigned & group).count() > 1) [[unlikely]] {
+        throw InvalidArgument(std::format(
+            "Arguments {} are mutually exclusive", given(true)));
+      }
+    } else if constexpr (Kind == ConstraintKind::DependsOn) {
+      static constexpr auto rest = mask<Args, 1>();
+      if (assigned.test(indices<Args>[0]) and (assigned & rest) != rest)
+          [[unlikely]] {
+        throw InvalidArgument(std::format("Argument {} requires {}", names[0],
+                                          given(false)));
+      }
+    } else {
+      if ((assigned & group).count() == 0) [[unlikely]] {
+        throw InvalidArgument(std::format("One of {} is required", names));
+      }
+    }
+  }
+};
+
+export template <ArgName... Names>
+ARGO_ALWAYS_INLINE constexpr auto exclusive()
+    -> Constraint<ConstraintKind::Exclusive, Names...> {
+  return {};
+}
+
+/*!
+ * `requires` is a keyword, dependsOn<"tls-key", "tls-cert">() reads as
+ * "tls-key depends on tls-cert"
+ */
+export template <ArgName... Names>
+ARGO_ALWAYS_INLINE constexpr auto dependsOn()
+    -> Constraint<ConstraintKind::DependsOn, Names...> {
+  return {};
+}
+
+export template <ArgName... Names>
+ARGO_ALWAYS_INLINE constexpr auto oneOf()
+    -> Constraint<ConstraintKind::OneOf, Names...> {
+  return {};
+}
+
+/*!
+ * One mask test per constraint, names are collected only on failure
+ */
+template <class Args, class Constraints>
+ARGO_ALWAYS_INLINE constexpr auto CheckConstraints() -> void {
+  if constexpr (std::tuple_size_v<Constraints> != 0) {
+    auto assigned = AssignedMask<Args>();
+    tuple_type_visit<Constraints>([&assigned]<class T>(T) ARGO_ALWAYS_INLINE {
+      T::type::template check<Args>(assigned);
+    });
+  }
+}
+
+}  // namespace Argo
+
+// generator end here
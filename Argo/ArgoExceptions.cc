@@ -45,6 +45,20 @@ export class ValidationError : public InvalidArgument {
   }
 };
 
+/*!
+ * Thrown after printing help, instead of exiting, by a parser with
+ * exitOnHelp(false)
+ */
+export class HelpRequested : public std::runtime_error {
+ public:
+  explicit HelpRequested(const std::string& msg = "Help requested")
+      : runtime_error(msg) {}
+
+  [[nodiscard]] auto what() const noexcept -> const char* override {
+    return runtime_error::what();
+  }
+};
+
 }  // namespace Argo
 
 // generator end here
@@ -0,0 +1,311 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:IndexSet;
+
+import std;
+
+import :Exceptions;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Set of indices written in range syntax
+ * Example:
+ *      0-31,64-95    -> 0, 1, ..., 31, 64, ..., 95
+ *      0-4095:2      -> 0, 2, ..., 4094
+ *
+ * Small or dense sets are stored as a bitset, others as sorted disjoint
+ * runs (first, last, stride) searched in O(log n).
+ */
+export class IndexSet {
+ public:
+  struct Run {
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::size_t stride = 1;
+  };
+
+  class Iterator {
+   private:
+    const IndexSet* set_ = nullptr;
+    std::size_t pos_ = 0;
+    std::size_t value_ = 0;
+    std::uint64_t word_ = 0;
+
+    ARGO_ALWAYS_INLINE auto loadWord() -> void {
+      const auto& bits = this->set_->bits_;
+      while (this->word_ == 0 and ++this->pos_ < bits.size()) {
+        this->word_ = bits[this->pos_];
+      }
+      this->value_ = (this->word_ == 0)
+                         ? 0
+                         : this->pos_ * 64 + std::countr_zero(this->word_);
+    }
+
+   public:
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+
+    Iterator(const IndexSet* set, bool is_end) : set_(set) {
+      if (set->dense_) {
+        this->pos_ = is_end ? set->bits_.size() : 0;
+        if (!is_end and !set->bits_.empty()) {
+          this->word_ = set->bits_[0];
+          if (this->word_ == 0) {
+            this->loadWord();
+          } else {
+            this->value_ = std::countr_zero(this->word_);
+          }
+        }
+      } else {
+        this->pos_ = is_end ? set->runs_.size() : 0;
+        if (!is_end and !set->runs_.empty()) {
+          this->value_ = set->runs_[0].first;
+        }
+      }
+    }
+
+    [[nodiscard]] auto operator*() const -> std::size_t {
+      return this->value_;
+    }
+
+    auto operator++() -> Iterator& {
+      if (this->set_->dense_) {
+        this->word_ &= this->word_ - 1;
+        this->loadWord();
+      } else {
+        const auto& run = this->set_->runs_[this->pos_];
+        if (this->value_ + run.stride <= run.last) {
+          this->value_ += run.stride;
+        } else if (++this->pos_ < this->set_->runs_.size()) {
+          this->value_ = this->set_->runs_[this->pos_].first;
+        } else {
+          this->value_ = 0;
+        }
+      }
+      return *this;
+    }
+
+    auto operator++(int) -> Iterator {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    auto operator==(const Iterator& rhs) const -> bool {
+      return this->pos_ == rhs.pos_ and this->value_ == rhs.value_ and
+             this->word_ == rhs.word_;
+    }
+  };
+
+ private:
+  std::vector<Run> runs_;
+  std::vector<std::uint64_t> bits_;
+  std::size_t count_ = 0;
+  bool dense_ = false;
+
+  // Bitset is used when it is not larger than the runs, or fits in 4096 bits
+  static constexpr std::size_t dense_words = 64;
+  // Overlapping runs need the bitset, it is limited to 2^26 indices (8 MiB)
+  static constexpr std::size_t max_dense_words = std::size_t(1) << 20;
+
+  auto setBits(const Run& run) -> void {
+    if (run.stride == 1) {
+      for (auto i = run.first; i <= run.last;) {
+        auto offset = i % 64;
+        auto width = std::min<std::size_t>(64 - offset, run.last - i + 1);
+        auto mask = (width == 64) ? ~0ULL : ((1ULL << width) - 1) << offset;
+        this->bits_[i / 64] |= mask;
+        i += width;
+      }
+    } else {
+      for (auto i = run.first; i <= run.last; i += run.stride) {
+        this->bits_[i / 64] |= 1ULL << (i % 64);
+      }
+    }
+  }
+
+  /*!
+   * Merge the runs and pick the representation, false when overlapping runs
+   * would need a bitset larger than max_dense_words
+   */
+  auto normalize() -> bool {
+    std::ranges::sort(this->runs_, {}, &Run::first);
+
+    auto merged = std::vector<Run>();
+    merged.reserve(this->runs_.size());
+    auto disjoint = true;
+    std::size_t max_last = 0;
+    for (const auto& run : this->runs_) {
+      if (!merged.empty()) {
+        auto& back = merged.back();
+        if (back.stride == 1 and run.stride == 1 and
+            run.first <= back.last + 1) {
+          back.last = std::max(back.last, run.last);
+          max_last = std::max(max_last, back.last);
+          continue;
+        }
+        disjoint = disjoint and (run.first > max_last);
+      }
+      merged.push_back(run);
+      max_last = std::max(max_last, run.last);
+    }
+    this->runs_ = std::move(merged);
+
+    auto words = max_last / 64 + 1;
+    if (!disjoint and words > max_dense_words) [[unlikely]] {
+      return false;
+    }
+    // Overlapping strided runs cannot be binary searched, use the bitset
+    this->dense_ = !disjoint or words <= dense_words or
+                   words <= this->runs_.size() * 3;
+    if (this->dense_) {
+      this->bits_.assign(words, 0);
+      for (const auto& run : this->runs_) {
+        this->setBits(run);
+      }
+      this->count_ = 0;
+      for (auto word : this->bits_) {
+        this->count_ += std::popcount(word);
+      }
+      this->runs_ = {};
+    } else {
+      this->count_ = 0;
+      for (const auto& run : this->runs_) {
+        this->count_ += (run.last - run.first) / run.stride + 1;
+      }
+    }
+    return true;
+  }
+
+ public:
+  IndexSet() = default;
+
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> IndexSet {
+    auto fail = [&] {
+      throw InvalidArgument(
+          std::format("Argument {}: invalid index set {}", key, value));
+    };
+    auto number = [](std::string_view& str, std::size_t& out) -> bool {
+      auto [ptr, ec] =
+          std::from_chars(str.data(), str.data() + str.size(), out);
+      if (ec != std::errc() or ptr == str.data()) {
+        return false;
+      }
+      str.remove_prefix(ptr - str.data());
+      return true;
+    };
+
+    auto ret = IndexSet();
+    auto rest = value;
+    while (true) {
+      auto run = Run();
+      if (!number(rest, run.first)) {
+        fail();
+      }
+      run.last = run.first;
+      if (rest.starts_with('-')) {
+        rest.remove_prefix(1);
+        if (!number(rest, run.last)) {
+          fail();
+        }
+      }
+      if (rest.starts_with(':')) {
+        rest.remove_prefix(1);
+        if (!number(rest, run.stride)) {
+          fail();
+        }
+      }
+      if (run.last < run.first or run.stride == 0) {
+        fail();
+      }
+      run.last -= (run.last - run.first) % run.stride;
+      run.stride = (run.first == run.last) ? 1 : run.stride;
+      ret.runs_.push_back(run);
+      if (rest.empty()) {
+        break;
+      }
+      if (!rest.starts_with(',')) {
+        fail();
+      }
+      rest.remove_prefix(1);
+    }
+    if (!ret.normalize()) [[unlikely]] {
+      throw InvalidArgument(std::format(
+          "Argument {}: overlapping runs in {} span too many indices", key,
+          value));
+    }
+    return ret;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto contains(std::size_t index) const
+      -> bool {
+    if (this->dense_) {
+      auto word = index / 64;
+      return word < this->bits_.size() and
+             ((this->bits_[word] >> (index % 64)) & 1) != 0;
+    }
+    auto it = std::ranges::upper_bound(this->runs_, index, {}, &Run::first);
+    if (it == this->runs_.begin()) {
+      return false;
+    }
+    --it;
+    return index <= it->last and (index - it->first) % it->stride == 0;
+  }
+
+  [[nodiscard]] auto size() const -> std::size_t {
+    return this->count_;
+  }
+
+  [[nodiscard]] auto empty() const -> bool {
+    return this->count_ == 0;
+  }
+
+  [[nodiscard]] auto isDense() const -> bool {
+    return this->dense_;
+  }
+
+  [[nodiscard]] auto begin() const -> Iterator {
+    return {this, false};
+  }
+
+  [[nodiscard]] auto end() const -> Iterator {
+    return {this, true};
+  }
+
+  /*!
+   * Write the set as a cpu_set_t style mask, bit n of word n / 64 is index n
+   * Returns false if an index does not fit in the mask.
+   */
+  auto copyTo(std::span<std::uint64_t> mask) const -> bool {
+    std::ranges::fill(mask, 0);
+    for (auto index : *this) {
+      if (index / 64 >= mask.size()) {
+        return false;
+      }
+      mask[index / 64] |= 1ULL << (index % 64);
+    }
+    return true;
+  }
+
+  [[nodiscard]] auto toMask() const -> std::vector<std::uint64_t> {
+    if (this->dense_) {
+      return this->bits_;
+    }
+    auto ret = std::vector<std::uint64_t>(
+        this->runs_.empty() ? 0 : this->runs_.back().last / 64 + 1, 0);
+    this->copyTo(ret);
+    return ret;
+  }
+};
+
+}  // namespace Argo
+
+// generator end here
@@ -7,6 +7,8 @@ export module Argo:Initializer;
 import :Validation;
 import :ArgName;
 import :Arg;
+import :Choices;
+import :TypeTraits;
 
 import std;
 
@@ -50,26 +52,42 @@ ARGO_ALWAYS_INLINE constexpr auto implicitDefault(T value)
 }
 
 template <class Type, ArgName Name, NArgs nargs, bool Required, ParserID ID,
-          class... Args>
+          bool Append, class... Args>
 ARGO_ALWAYS_INLINE constexpr auto ArgInitializer(Args... args) -> void {
   (
       [&args]() ARGO_ALWAYS_INLINE {
-        using Arg = Arg<Type, Name, nargs, Required, ID>;
+        using Arg = Arg<Type, Name, nargs, Required, ID, Append>;
         if constexpr (std::is_same_v<Args, Description>) {
           Arg::description = args.description;
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ChoicesTag>) {
+          Arg::typeName = std::string_view(Args::typeName);
+          if constexpr (std::is_enum_v<typename Arg::baseType>) {
+            Arg::caster = &Args::template cast<typename Arg::baseType>;
+          } else if constexpr (is_lazy_args_v<typename Arg::type>) {
+            ElementValidator<Arg>::validator = args;
+          } else {
+            Arg::validator = args;
+          }
         } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
                                                Validation::ValidationBase>) {
-          static_assert(std::is_invocable_v<Args, typename Arg::type,
-                                            std::span<std::string_view>,
-                                            std::string_view>,
-                        "Invalid validator");
-          Arg::validator = args;
+          if constexpr (is_lazy_args_v<typename Arg::type>) {
+            // Checked on access, element by element
+            ElementValidator<Arg>::validator = args;
+          } else {
+            static_assert(std::is_invocable_v<Args, typename Arg::type,
+                                              std::span<std::string_view>,
+                                              std::string_view>,
+                          "Invalid validator");
+            Arg::validator = args;
+          }
         } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
                                                ImplicitDefaultValueTag>) {
           Arg::defaultValue = static_cast<Type>(args.implicit_default_value);
         } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
                                                ExplicitDefaultValueTag>) {
           Arg::value = static_cast<Type>(args.explicit_default_value);
+          Arg::explicitDefault = Arg::value;
         } else if constexpr (std::is_invocable_v<Args, typename Arg::type&,
                                                  std::span<std::string_view>>) {
           Arg::callback = args;
@@ -80,13 +98,15 @@ ARGO_ALWAYS_INLINE constexpr auto ArgInitializer(Args... args) -> void {
       ...);
 }
 
-template <ArgName Name, ParserID ID, class... Args>
+template <class FlagArg, class... Args>
 ARGO_ALWAYS_INLINE constexpr auto FlagArgInitializer(Args... args) -> void {
   (
       [&args]() ARGO_ALWAYS_INLINE {
-        using FlagArg = FlagArg<Name, ID>;
         if constexpr (std::is_same_v<Args, Description>) {
           FlagArg::description = args.description;
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ChoicesTag>) {
+          static_assert(false, "Flag cannot have choices");
         } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
                                                Validation::ValidationBase>) {
           static_assert(false, "Flag cannot have validator");
@@ -0,0 +1,173 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Lazy;
+
+import std;
+
+import :TypeTraits;
+import :Visit;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Value of a variadic argument left in argv, converted on access
+ * Example:
+ *      addPositionalArg<"files", Argo::LazyArgs<std::string_view>, nargs('+')>()
+ *      addArg<"ids", Argo::LazyArgs<int>, nargs('*')>(Range(0, 1000))
+ *
+ * Elements are converted and validated each time they are read, nothing is
+ * copied by parse. The view points into the argv given to parse, keep it
+ * alive. Values must come from the command line as separate tokens.
+ */
+export template <class T>
+class LazyArgs : public LazyArgsTag {
+ public:
+  using value_type = T;
+  using Validator = std::function<void(
+      const T& value, std::span<std::string_view>, std::string_view)>;
+
+ private:
+  ValueSpan values_;
+  std::string_view key_;
+  T (*cast_)(std::string_view) = nullptr;
+  const Validator* validator_ = nullptr;
+
+ public:
+  class Iterator {
+   private:
+    const LazyArgs* view_ = nullptr;
+    std::ptrdiff_t index_ = 0;
+
+   public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::random_access_iterator_tag;
+
+    Iterator() = default;
+    Iterator(const LazyArgs* view, std::ptrdiff_t index)
+        : view_(view), index_(index) {}
+
+    auto operator*() const -> T {
+      return (*this->view_)[static_cast<std::size_t>(this->index_)];
+    }
+
+    auto operator[](difference_type n) const -> T {
+      return *(*this + n);
+    }
+
+    auto operator++() -> Iterator& {
+      this->index_++;
+      return *this;
+    }
+
+    auto operator++(int) -> Iterator {
+      auto ret = *this;
+      this->index_++;
+      return ret;
+    }
+
+    auto operator--() -> Iterator& {
+      this->index_--;
+      return *this;
+    }
+
+    auto operator--(int) -> Iterator {
+      auto ret = *this;
+      this->index_--;
+      return ret;
+    }
+
+    auto operator+=(difference_type n) -> Iterator& {
+      this->index_ += n;
+      return *this;
+    }
+
+    auto operator-=(difference_type n) -> Iterator& {
+      this->index_ -= n;
+      return *this;
+    }
+
+    friend auto operator+(Iterator it, difference_type n) -> Iterator {
+      return it += n;
+    }
+
+    friend auto operator+(difference_type n, Iterator it) -> Iterator {
+      return it += n;
+    }
+
+    friend auto operator-(Iterator it, difference_type n) -> Iterator {
+      return it -= n;
+    }
+
+    friend auto operator-(const Iterator& lhs, const Iterator& rhs)
+        -> difference_type {
+      return lhs.index_ - rhs.index_;
+    }
+
+    auto operator==(const Iterator& other) const -> bool {
+      return this->index_ == other.index_;
+    }
+
+    auto operator<=>(const Iterator& other) const -> std::strong_ordering {
+      return this->index_ <=> other.index_;
+    }
+  };
+
+  LazyArgs() = default;
+
+  LazyArgs(ValueSpan values, std::string_view key,
+           T (*cast)(std::string_view), const Validator* validator)
+      : values_(values), key_(key), cast_(cast), validator_(validator) {}
+
+  [[nodiscard]] auto size() const -> std::size_t {
+    return this->values_.size();
+  }
+
+  [[nodiscard]] auto empty() const -> bool {
+    return this->values_.empty();
+  }
+
+  /*!
+   * Element i as written on the command line
+   */
+  [[nodiscard]] auto raw(std::size_t i) const -> std::string_view {
+    return this->values_[i];
+  }
+
+  /*!
+   * Element i converted and validated, throws like parse would
+   */
+  [[nodiscard]] auto operator[](std::size_t i) const -> T {
+    auto raw = this->values_[i];
+    auto value = this->cast_(raw);
+    if (this->validator_ != nullptr and *this->validator_) {
+      (*this->validator_)(value, std::span<std::string_view>(&raw, 1),
+                          this->key_);
+    }
+    return value;
+  }
+
+  [[nodiscard]] auto begin() const -> Iterator {
+    return {this, 0};
+  }
+
+  [[nodiscard]] auto end() const -> Iterator {
+    return {this, static_cast<std::ptrdiff_t>(this->size())};
+  }
+};
+
+/*!
+ * Whether one of Args is a LazyArgs
+ */
+template <class Args>
+constexpr bool has_lazy_args_v = []<class... T>(type_sequence<T...>) {
+  return (is_lazy_args_v<typename T::type> || ...);
+}(make_type_sequence_t<Args>());
+
+}  // namespace Argo
+
+// generator end here
@@ -0,0 +1,150 @@
+module;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:MappedFile;
+
+import std;
+
+import :Exceptions;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * madvise hint applied right after the file is mapped
+ */
+export enum class MapAdvice {
+  Normal,
+  Sequential,
+  WillNeed,
+};
+
+struct MappedFileTag {};
+
+/*!
+ * Read-only memory mapping of the file named by the argument value
+ * Example:
+ *      addArg<"dict", Argo::MappedFile>()
+ *      addArg<"model", Argo::BasicMappedFile<Argo::MapAdvice::WillNeed>>()
+ *
+ * Copies share the mapping, it is unmapped when the last copy is destroyed.
+ */
+export template <MapAdvice Advice = MapAdvice::Normal>
+class BasicMappedFile : public MappedFileTag {
+ private:
+  struct Mapping {
+    void* addr = nullptr;
+    std::size_t size = 0;
+
+    Mapping(void* addr, std::size_t size) : addr(addr), size(size) {}
+
+    Mapping(const Mapping&) = delete;
+    Mapping(Mapping&&) = delete;
+    auto operator=(const Mapping&) -> Mapping& = delete;
+    auto operator=(Mapping&&) -> Mapping& = delete;
+
+    ~Mapping() {
+      if (this->addr != nullptr) {
+        ::munmap(this->addr, this->size);
+      }
+    }
+  };
+
+  std::shared_ptr<const Mapping> mapping_ = nullptr;
+
+  [[noreturn]] static auto fail(const std::string& path, int err) -> void {
+    throw InvalidArgument(std::format("Cannot map file {}: {}", path,
+                                      std::system_category().message(err)));
+  }
+
+  auto map(int fd, const std::string& name) -> void {
+    struct ::stat st {};
+    if (::fstat(fd, &st) != 0) [[unlikely]] {
+      fail(name, errno);
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) {
+      this->mapping_ = std::make_shared<const Mapping>(nullptr, 0);
+      return;
+    }
+    auto* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) [[unlikely]] {
+      fail(name, errno);
+    }
+    if constexpr (Advice == MapAdvice::Sequential) {
+      ::madvise(addr, size, MADV_SEQUENTIAL);
+    } else if constexpr (Advice == MapAdvice::WillNeed) {
+      ::madvise(addr, size, MADV_WILLNEED);
+    }
+    this->mapping_ = std::make_shared<const Mapping>(addr, size);
+  }
+
+ public:
+  BasicMappedFile() = default;
+
+  explicit BasicMappedFile(std::string_view path) {
+    // value is not guaranteed to be null terminated, open(2) needs a copy
+    auto path_str = std::string(path);
+    auto fd = ::open(path_str.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) [[unlikely]] {
+      fail(path_str, errno);
+    }
+    try {
+      this->map(fd, path_str);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+  /*!
+   * Map an already open file, fd is left open
+   */
+  [[nodiscard]] static auto fromFd(int fd) -> BasicMappedFile {
+    auto ret = BasicMappedFile();
+    ret.map(fd, std::format("fd {}", fd));
+    return ret;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto bytes() const
+      -> std::span<const std::byte> {
+    if (!this->mapping_) {
+      return {};
+    }
+    return {static_cast<const std::byte*>(this->mapping_->addr),
+            this->mapping_->size};
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto data() const -> const std::byte* {
+    return this->bytes().data();
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto size() const -> std::size_t {
+    return this->mapping_ ? this->mapping_->size : 0;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto view() const -> std::string_view {
+    auto bytes = this->bytes();
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  }
+
+  explicit operator bool() const {
+    return this->mapping_ != nullptr;
+  }
+};
+
+export using MappedFile = BasicMappedFile<>;
+
+}  // namespace Argo
+
+// generator end here
@@ -11,6 +11,12 @@ import :Validation;
 import :TypeTraits;
 import :MetaLookup;
 import :Arg;
+import :MappedFile;
+import :Units;
+import :IndexSet;
+import :Net;
+import :Visit;
+import :Lazy;
 
 // generator start here
 
@@ -38,6 +44,9 @@ ARGO_ALWAYS_INLINE constexpr auto ArgCaster(const std::string_view& value,
     }
     throw InvalidArgument(
         std::format("Argument {}: {} cannot convert bool", key, value));
+  } else if constexpr (std::is_enum_v<Type>) {
+    return static_cast<Type>(
+        ArgCaster<std::underlying_type_t<Type>>(value, key));
   } else if constexpr (std::is_integral_v<Type>) {
     Type ret;
     std::from_chars(value.begin(), value.end(), ret);
@@ -46,11 +55,45 @@ ARGO_ALWAYS_INLINE constexpr auto ArgCaster(const std::string_view& value,
     return static_cast<Type>(std::stod(std::string(value)));
   } else if constexpr (std::is_same_v<Type, const char*>) {
     return value.data();
+  } else if constexpr (std::is_same_v<Type, Bytes>) {
+    return ParseBytes(value, key);
+  } else if constexpr (is_duration_v<Type>) {
+    return ParseDuration<Type>(value, key);
+  } else if constexpr (is_si_v<Type>) {
+    return ParseSI<Type>(value, key);
+  } else if constexpr (is_rate_v<Type>) {
+    return ParseRate<Type>(value, key);
+  } else if constexpr (std::is_same_v<Type, IndexSet>) {
+    return IndexSet::parse(value, key);
+  } else if constexpr (std::is_same_v<Type, IpAddress> or
+                       std::is_same_v<Type, Cidr> or
+                       std::is_same_v<Type, Endpoint>) {
+    return Type::parse(value, key);
+  } else if constexpr (std::derived_from<Type, MappedFileTag>) {
+    try {
+      return Type(value);
+    } catch (const InvalidArgument& e) {
+      throw InvalidArgument(std::format("Argument {}: {}", key, e.what()));
+    }
   } else {
     return static_cast<Type>(value);
   }
 }
 
+/*!
+ * Cast one value of Arg, enums may have a caster set by choices
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto CastValue(const std::string_view& value) ->
+    typename Arg::baseType {
+  if constexpr (std::is_enum_v<typename Arg::baseType>) {
+    if (Arg::caster != nullptr) {
+      return Arg::caster(value, Arg::name.getKey());
+    }
+  }
+  return ArgCaster<typename Arg::baseType>(value, Arg::name.getKey());
+}
+
 template <class... T, std::size_t... N>
 ARGO_ALWAYS_INLINE constexpr auto TupleAssign(
     std::tuple<T...>& t, const std::span<std::string_view>& v,
@@ -60,10 +103,111 @@ ARGO_ALWAYS_INLINE constexpr auto TupleAssign(
    ...);
 }
 
+/*!
+ * Raw values of a repeatable argument, validated once at the end of parse
+ * The storage is kept across parses so repeated parsing does not allocate.
+ */
+template <class Arg>
+struct RawValues {
+  inline static std::vector<std::string_view> values;
+};
+
+/*!
+ * KEY=VALUE pairs of a map argument collected during parse
+ */
+template <class Arg>
+struct MapBuffer {
+  inline static std::vector<std::pair<typename Arg::type::key_type,
+                                      typename Arg::type::mapped_type>>
+      pairs;
+
+  ARGO_ALWAYS_INLINE static auto clear() -> void {
+    pairs.clear();
+    RawValues<Arg>::values.clear();
+  }
+};
+
+/*!
+ * Return Arg to its state before parse, the explicit default included.
+ * Containers keep their capacity unless release is set
+ */
+template <class Arg>
+auto ResetArg(bool release) -> void {
+  using Type = typename Arg::type;
+  if constexpr (std::derived_from<Arg, ArgTag>) {
+    if constexpr (is_vector_v<Type> or std::is_same_v<Type, std::string>) {
+      if (release) {
+        Arg::value = Type(Arg::explicitDefault);
+      } else {
+        Arg::value.assign(Arg::explicitDefault.begin(),
+                          Arg::explicitDefault.end());
+      }
+    } else {
+      Arg::value = Arg::explicitDefault;
+    }
+    if constexpr (Arg::append or is_map_v<Type>) {
+      if (release) {
+        RawValues<Arg>::values = {};
+      } else {
+        RawValues<Arg>::values.clear();
+      }
+    }
+    if constexpr (is_map_v<Type>) {
+      if (release) {
+        MapBuffer<Arg>::pairs = {};
+      } else {
+        MapBuffer<Arg>::pairs.clear();
+      }
+    }
+  } else {
+    Arg::value = Type();
+  }
+  Arg::assigned = false;
+  Arg::source = ValueSource::Default;
+}
+
+struct DirtyArg {
+  void (*reset)(bool release);
+  ValueSource* source;
+};
+
+/*!
+ * Arguments of parser ID assigned since the last reset, so resetting and
+ * tagging sources do not walk every argument
+ */
+template <ParserID ID>
+struct DirtyArgs {
+  inline static std::vector<DirtyArg> args;
+};
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto MarkAssigned() -> void {
+  if (!Arg::assigned) {
+    Arg::assigned = true;
+    DirtyArgs<Arg::id>::args.push_back({&ResetArg<Arg>, &Arg::source});
+  }
+}
+
+/*!
+ * Reset only the arguments of parser ID which were assigned
+ */
+template <ParserID ID>
+auto ResetDirtyArgs(bool release = false) -> void {
+  auto& args = DirtyArgs<ID>::args;
+  for (const auto& arg : args) {
+    arg.reset(release);
+  }
+  if (release) {
+    args = {};
+  } else {
+    args.clear();
+  }
+}
+
 template <class Arg>
 ARGO_ALWAYS_INLINE constexpr auto AfterAssign(
     const std::span<std::string_view>& values) -> void {
-  Arg::assigned = true;
+  MarkAssigned<Arg>();
   if (Arg::validator) {
     Arg::validator(Arg::value, values, Arg::name.getKey());
   }
@@ -72,13 +216,42 @@ ARGO_ALWAYS_INLINE constexpr auto AfterAssign(
   }
 }
 
+/*!
+ * Values of the token parse of parser ID is assigning, lazy arguments keep a
+ * view of it instead of the copies they are given
+ */
+template <ParserID ID>
+struct TokenValues {
+  inline static ValueSpan span;
+};
+
+template <class Arg>
+auto LazyCast(std::string_view value) -> typename Arg::baseType {
+  return CastValue<Arg>(value);
+}
+
 template <class Arg>
 ARGO_ALWAYS_INLINE constexpr auto ValiadicArgAssign(
     const std::span<std::string_view>& values) -> void {
-  Arg::value.resize(values.size());
-  for (std::size_t i = 0; i < values.size(); i++) {
-    Arg::value[i] =
-        ArgCaster<typename Arg::baseType>(values[i], Arg::name.getKey());
+  if constexpr (is_lazy_args_v<typename Arg::type>) {
+    // values is the tail of the token
+    const auto& token = TokenValues<Arg::id>::span;
+    auto offset = token.size() - values.size();
+    if (!values.empty() and (values.size() > token.size() or
+                             token[offset].data() != values[0].data()))
+        [[unlikely]] {
+      throw InvalidArgument(std::format(
+          "Argument {}: values must be separate command line arguments",
+          Arg::name.getKey()));
+    }
+    Arg::value = typename Arg::type(token.subspan(offset), Arg::name.getKey(),
+                                    &LazyCast<Arg>,
+                                    &ElementValidator<Arg>::validator);
+  } else {
+    Arg::value.resize(values.size());
+    for (std::size_t i = 0; i < values.size(); i++) {
+      Arg::value[i] = CastValue<Arg>(values[i]);
+    }
   }
   AfterAssign<Arg>(values);
 }
@@ -92,14 +265,12 @@ ARGO_ALWAYS_INLINE constexpr auto NLengthArgAssign(
   }
   if constexpr (is_array_v<typename Arg::type>) {
     for (std::size_t i = 0; i < Arg::nargs.nargs; i++) {
-      Arg::value[i] =
-          ArgCaster<typename Arg::baseType>(values[i], Arg::name.getKey());
+      Arg::value[i] = CastValue<Arg>(values[i]);
     }
   } else if constexpr (is_vector_v<typename Arg::type>) {
     Arg::value.resize(Arg::nargs.nargs);
     for (std::size_t i = 0; i < Arg::nargs.nargs; i++) {
-      Arg::value[i] =
-          ArgCaster<typename Arg::baseType>(values[i], Arg::name.getKey());
+      Arg::value[i] = CastValue<Arg>(values[i]);
     }
   } else if constexpr (is_tuple_v<typename Arg::type>) {
     TupleAssign(
@@ -119,12 +290,104 @@ ARGO_ALWAYS_INLINE constexpr auto ZeroOrOneArgAssign(
   if (values.empty()) {
     Arg::value = Arg::defaultValue;
   } else {
-    Arg::value = ArgCaster<typename Arg::type>(values[0], Arg::name.getKey());
+    Arg::value = CastValue<Arg>(values[0]);
   }
   AfterAssign<Arg>(values.subspan(0, 1));
   values = values.subspan(1);
 }
 
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto MapArgAssign(
+    std::span<std::string_view>& values) -> void {
+  using Map = typename Arg::type;
+  if (values.empty()) [[unlikely]] {
+    throw Argo::InvalidArgument(
+        std::format("Argument {}: should take at least one KEY=VALUE",
+                    Arg::name.getKey()));
+  }
+  auto count = (Arg::nargs.nargs == 1) ? 1 : values.size();
+  for (std::size_t i = 0; i < count; i++) {
+    auto pos = values[i].find('=');
+    if (pos == std::string_view::npos) [[unlikely]] {
+      throw Argo::InvalidArgument(std::format(
+          "Argument {}: {} is not KEY=VALUE", Arg::name.getKey(), values[i]));
+    }
+    MapBuffer<Arg>::pairs.emplace_back(
+        ArgCaster<typename Map::key_type>(values[i].substr(0, pos),
+                                          Arg::name.getKey()),
+        ArgCaster<typename Map::mapped_type>(values[i].substr(pos + 1),
+                                             Arg::name.getKey()));
+    RawValues<Arg>::values.push_back(values[i]);
+  }
+  MarkAssigned<Arg>();
+  values = values.subspan(count);
+}
+
+/*!
+ * Build the map with one sort, the last value of a duplicated key wins
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto MapArgFinalize() -> void {
+  auto& pairs = MapBuffer<Arg>::pairs;
+  std::ranges::stable_sort(pairs, Arg::value.key_comp(),
+                           &std::ranges::range_value_t<decltype(pairs)>::first);
+  auto out = pairs.begin();
+  for (auto it = pairs.begin(); it != pairs.end(); it++) {
+    auto next = std::next(it);
+    if (next != pairs.end() and
+        !Arg::value.key_comp()(it->first, next->first)) {
+      continue;
+    }
+    if (out != it) {
+      *out = std::move(*it);
+    }
+    out++;
+  }
+  pairs.erase(out, pairs.end());
+
+  if constexpr (requires { Arg::value.keys(); }) {
+    // flat_map: adopt the sorted containers without re-sorting
+    typename Arg::type::key_container_type keys;
+    typename Arg::type::mapped_container_type mapped;
+    keys.reserve(pairs.size());
+    mapped.reserve(pairs.size());
+    for (auto& [key, value] : pairs) {
+      keys.push_back(std::move(key));
+      mapped.push_back(std::move(value));
+    }
+    Arg::value.replace(std::move(keys), std::move(mapped));
+  } else {
+    Arg::value.clear();
+    for (auto& pair : pairs) {
+      Arg::value.emplace_hint(Arg::value.end(), std::move(pair));
+    }
+  }
+  AfterAssign<Arg>(RawValues<Arg>::values);
+  MapBuffer<Arg>::clear();
+}
+
+/*!
+ * Append values of one occurrence, the first occurrence drops the default
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto AppendArgAssign(
+    std::span<std::string_view>& values) -> void {
+  if (values.empty()) [[unlikely]] {
+    throw Argo::InvalidArgument(std::format(
+        "Argument {}: should take at least one value", Arg::name.getKey()));
+  }
+  if (!Arg::assigned) {
+    Arg::value.clear();
+    MarkAssigned<Arg>();
+  }
+  auto count = (Arg::nargs.nargs == 1) ? 1 : values.size();
+  for (std::size_t i = 0; i < count; i++) {
+    Arg::value.push_back(CastValue<Arg>(values[i]));
+    RawValues<Arg>::values.push_back(values[i]);
+  }
+  values = values.subspan(count);
+}
+
 template <class PArgs>
 ARGO_ALWAYS_INLINE constexpr auto PArgAssigner(
     std::span<std::string_view> values) -> bool {
@@ -163,7 +426,7 @@ ARGO_ALWAYS_INLINE constexpr auto PArgAssigner<std::tuple<>>(
 template <class Head, class PArgs>
 ARGO_ALWAYS_INLINE constexpr auto AssignOneArg(
     const std::string_view& key, std::span<std::string_view> values) -> bool {
-  if (Head::assigned) [[unlikely]] {
+  if (!Head::repeatable and Head::assigned) [[unlikely]] {
     throw Argo::InvalidArgument(
         std::format("Argument {}: duplicated argument", key));
   }
@@ -178,14 +441,30 @@ ARGO_ALWAYS_INLINE constexpr auto AssignOneArg(
         PArgAssigner<PArgs>(values);
       }
     }
-    Head::value = true;
-    Head::assigned = true;
+    if constexpr (std::derived_from<Head, CountArgTag>) {
+      Head::value++;
+    } else {
+      Head::value = true;
+    }
+    MarkAssigned<Head>();
     if (Head::callback) {
       Head::callback();
     }
     return true;
   } else {
-    if constexpr (Head::nargs.nargs_char == '?') {
+    if constexpr (is_map_v<typename Head::type>) {
+      MapArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    } else if constexpr (Head::append) {
+      AppendArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    } else if constexpr (Head::nargs.nargs_char == '?') {
       ZeroOrOneArgAssign<Head>(values);
       if (values.empty()) {
         return true;
@@ -194,7 +473,7 @@ ARGO_ALWAYS_INLINE constexpr auto AssignOneArg(
     } else if constexpr (Head::nargs.nargs_char == '*') {
       if (values.empty()) {
         Head::value = Head::defaultValue;
-        Head::assigned = true;
+        MarkAssigned<Head>();
         return true;
       }
       ValiadicArgAssign<Head>(values);
@@ -290,16 +569,33 @@ ARGO_ALWAYS_INLINE constexpr auto ShortArgAssigner(
   return false;
 }
 
+/*!
+ * Complete arguments which are built over the whole command line, wherever
+ * their values came from. std::vector<Cidr> tables are sorted here for
+ * contains().
+ */
 template <class Args>
-ARGO_ALWAYS_INLINE constexpr auto ValueReset() -> void {
-  []<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
-    (..., []<class T>() ARGO_ALWAYS_INLINE {
-      if (T::assigned) {
-        T::value = typename T::type();
-        T::assigned = false;
+ARGO_ALWAYS_INLINE constexpr auto FinalizeArgs() -> void {
+  tuple_type_visit<Args>([]<class T>(T) ARGO_ALWAYS_INLINE {
+    if constexpr (is_map_v<typename T::type::type>) {
+      if (T::type::assigned) {
+        MapArgFinalize<typename T::type>();
+      }
+    } else if constexpr (std::derived_from<typename T::type, ArgTag>) {
+      if constexpr (T::type::append) {
+        if (T::type::assigned) {
+          AfterAssign<typename T::type>(RawValues<typename T::type>::values);
+          RawValues<typename T::type>::values.clear();
+        }
       }
-    }.template operator()<std::tuple_element_t<Is, Args>>());
-  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+      if constexpr (std::is_same_v<typename T::type::type,
+                                   std::vector<Cidr>>) {
+        if (T::type::assigned) {
+          SortPrefixes(T::type::value);
+        }
+      }
+    }
+  });
 }
 
 };  // namespace Argo
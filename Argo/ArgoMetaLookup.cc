@@ -75,6 +75,58 @@ ARGO_ALWAYS_INLINE constexpr auto IsFlag(char c) -> bool {
   }(make_type_sequence_t<Tuple>());
 }
 
+/*!
+ * Whether key is the long key of one of the arguments
+ */
+template <class Tuple>
+ARGO_ALWAYS_INLINE constexpr auto IsKnownKey(std::string_view key) -> bool {
+  return [&key]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+    return ((key == T::name.getKey()) || ...);
+  }(make_type_sequence_t<Tuple>());
+}
+
+/*!
+ * Number of values the option key takes, -1 for any number or when key is
+ * not an option
+ */
+template <class Tuple>
+ARGO_ALWAYS_INLINE constexpr auto ValueCount(std::string_view key) -> int {
+  auto count = -1;
+  [&]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+    return ([&] {
+      if (key != T::name.getKey()) {
+        return false;
+      }
+      if constexpr (std::derived_from<T, FlagArgTag>) {
+        count = 0;
+      } else if constexpr (T::nargs.nargs_char == '?') {
+        count = 1;
+      } else if constexpr (T::nargs.nargs_char == '\0') {
+        count = T::nargs.nargs;
+      }
+      return true;
+    }() || ...);
+  }(make_type_sequence_t<Tuple>());
+  return count;
+}
+
+/*!
+ * Whether the keys of -abc are short keys of the arguments, up to the first
+ * one taking a value since the rest of the token is its value
+ */
+template <class Tuple>
+constexpr auto IsKnownShortKeys(std::string_view keys) -> bool {
+  for (auto c : keys) {
+    if (!IsFlag<Tuple>(c)) {
+      return false;
+    }
+    if (!std::get<1>(GetkeyFromShortKey<Tuple>(c))) {
+      return true;
+    }
+  }
+  return true;
+}
+
 };  // namespace Argo
 
 // generator end here
@@ -0,0 +1,462 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Net;
+
+import std;
+
+import :Exceptions;
+
+// generator start here
+
+namespace Argo {
+
+ARGO_ALWAYS_INLINE constexpr auto HexDigit(char c) -> int {
+  if (c >= '0' and c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' and c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' and c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+/*!
+ * IPv4 or IPv6 address
+ * IPv4 addresses are held as IPv4-mapped IPv6 (::ffff:a.b.c.d), so both
+ * families share one ordering and one prefix space.
+ */
+export class IpAddress {
+ private:
+  std::uint64_t hi_ = 0;
+  std::uint64_t lo_ = 0;
+
+  static constexpr std::uint64_t v4_mapped = 0x0000'FFFF'0000'0000ULL;
+
+  static constexpr auto parseV4(std::string_view str, std::uint32_t& out)
+      -> bool {
+    std::uint32_t addr = 0;
+    std::size_t i = 0;
+    for (int octet = 0; octet < 4; octet++) {
+      if (octet != 0) {
+        if (i >= str.size() or str[i] != '.') {
+          return false;
+        }
+        i++;
+      }
+      auto begin = i;
+      std::uint32_t value = 0;
+      while (i < str.size() and i - begin < 3 and str[i] >= '0' and
+             str[i] <= '9') {
+        value = value * 10 + (str[i] - '0');
+        i++;
+      }
+      // Leading zeros are rejected, some tools read them as octal
+      if (i == begin or value > 255 or (i - begin > 1 and str[begin] == '0')) {
+        return false;
+      }
+      addr = (addr << 8) | value;
+    }
+    if (i != str.size()) {
+      return false;
+    }
+    out = addr;
+    return true;
+  }
+
+  static constexpr auto parseV6(std::string_view str, std::uint64_t& hi,
+                                std::uint64_t& lo) -> bool {
+    constexpr auto no_gap = std::numeric_limits<std::size_t>::max();
+    std::array<std::uint16_t, 8> groups{};
+    std::size_t count = 0;
+    std::size_t gap = no_gap;
+    std::size_t i = 0;
+    if (str.starts_with("::")) {
+      gap = 0;
+      i = 2;
+    }
+    while (i < str.size()) {
+      if (count == 8) {
+        return false;
+      }
+      auto segment = str.substr(i, str.find(':', i) - i);
+      if (segment.contains('.')) {
+        std::uint32_t v4 = 0;
+        if (count > 6 or i + segment.size() != str.size() or
+            !parseV4(segment, v4)) {
+          return false;
+        }
+        groups[count++] = static_cast<std::uint16_t>(v4 >> 16);
+        groups[count++] = static_cast<std::uint16_t>(v4 & 0xFFFF);
+        break;
+      }
+      if (segment.empty() or segment.size() > 4) {
+        return false;
+      }
+      std::uint32_t value = 0;
+      for (auto c : segment) {
+        auto digit = HexDigit(c);
+        if (digit < 0) {
+          return false;
+        }
+        value = value * 16 + digit;
+      }
+      groups[count++] = static_cast<std::uint16_t>(value);
+      i += segment.size();
+      if (i == str.size()) {
+        break;
+      }
+      i++;
+      if (i < str.size() and str[i] == ':') {
+        if (gap != no_gap) {
+          return false;
+        }
+        gap = count;
+        i++;
+      } else if (i == str.size()) {
+        return false;
+      }
+    }
+
+    std::array<std::uint16_t, 8> full{};
+    if (gap == no_gap) {
+      if (count != 8) {
+        return false;
+      }
+      full = groups;
+    } else {
+      if (count == 8) {
+        return false;
+      }
+      auto tail = count - gap;
+      for (std::size_t j = 0; j < gap; j++) {
+        full[j] = groups[j];
+      }
+      for (std::size_t j = 0; j < tail; j++) {
+        full[8 - tail + j] = groups[gap + j];
+      }
+    }
+    hi = 0;
+    lo = 0;
+    for (std::size_t j = 0; j < 4; j++) {
+      hi = (hi << 16) | full[j];
+      lo = (lo << 16) | full[j + 4];
+    }
+    return true;
+  }
+
+ public:
+  constexpr IpAddress() = default;
+
+  constexpr IpAddress(std::uint64_t hi, std::uint64_t lo) : hi_(hi), lo_(lo) {}
+
+  [[nodiscard]] static constexpr auto fromV4(std::uint32_t addr) -> IpAddress {
+    return {0, v4_mapped | addr};
+  }
+
+  /*!
+   * Parse without allocation, returns nullopt on malformed input
+   */
+  [[nodiscard]] static constexpr auto tryParse(std::string_view str)
+      -> std::optional<IpAddress> {
+    if (str.contains(':')) {
+      std::uint64_t hi = 0;
+      std::uint64_t lo = 0;
+      if (!parseV6(str, hi, lo)) {
+        return std::nullopt;
+      }
+      return IpAddress(hi, lo);
+    }
+    std::uint32_t v4 = 0;
+    if (!parseV4(str, v4)) {
+      return std::nullopt;
+    }
+    return fromV4(v4);
+  }
+
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> IpAddress {
+    auto ret = tryParse(value);
+    if (!ret) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is not an IP address", key, value));
+    }
+    return *ret;
+  }
+
+  [[nodiscard]] constexpr auto isV4() const -> bool {
+    return this->hi_ == 0 and (this->lo_ >> 32) == (v4_mapped >> 32);
+  }
+
+  [[nodiscard]] constexpr auto isV6() const -> bool {
+    return !this->isV4();
+  }
+
+  [[nodiscard]] constexpr auto toV4() const -> std::uint32_t {
+    return static_cast<std::uint32_t>(this->lo_);
+  }
+
+  [[nodiscard]] constexpr auto high() const -> std::uint64_t {
+    return this->hi_;
+  }
+
+  [[nodiscard]] constexpr auto low() const -> std::uint64_t {
+    return this->lo_;
+  }
+
+  /*!
+   * Network byte order
+   */
+  [[nodiscard]] constexpr auto bytes() const -> std::array<std::uint8_t, 16> {
+    std::array<std::uint8_t, 16> ret{};
+    for (std::size_t i = 0; i < 8; i++) {
+      ret[i] = static_cast<std::uint8_t>(this->hi_ >> (56 - i * 8));
+      ret[i + 8] = static_cast<std::uint8_t>(this->lo_ >> (56 - i * 8));
+    }
+    return ret;
+  }
+
+  [[nodiscard]] auto toString() const -> std::string {
+    if (this->isV4()) {
+      auto v4 = this->toV4();
+      return std::format("{}.{}.{}.{}", v4 >> 24, (v4 >> 16) & 0xFF,
+                         (v4 >> 8) & 0xFF, v4 & 0xFF);
+    }
+    std::array<std::uint16_t, 8> groups{};
+    for (std::size_t i = 0; i < 4; i++) {
+      groups[i] = static_cast<std::uint16_t>(this->hi_ >> (48 - i * 16));
+      groups[i + 4] = static_cast<std::uint16_t>(this->lo_ >> (48 - i * 16));
+    }
+    // RFC 5952: compress the longest run of two or more zero groups
+    std::size_t best = 8;
+    std::size_t best_len = 1;
+    for (std::size_t i = 0; i < 8;) {
+      auto j = i;
+      while (j < 8 and groups[j] == 0) {
+        j++;
+      }
+      if (j - i > best_len) {
+        best = i;
+        best_len = j - i;
+      }
+      i = (j == i) ? i + 1 : j;
+    }
+    auto ret = std::string();
+    for (std::size_t i = 0; i < 8; i++) {
+      if (i == best) {
+        ret += "::";
+        i += best_len - 1;
+        continue;
+      }
+      if (!ret.empty() and !ret.ends_with(':')) {
+        ret += ':';
+      }
+      ret += std::format("{:x}", groups[i]);
+    }
+    return ret;
+  }
+
+  constexpr auto operator<=>(const IpAddress&) const = default;
+};
+
+/*!
+ * Address prefix such as 10.0.0.0/8 or 2001:db8::/32
+ * Host bits are cleared, an address without /N is a single host prefix.
+ */
+export class Cidr {
+ private:
+  IpAddress network_;
+  // Length in the 128 bit space, IPv4 prefixes are offset by 96
+  std::uint8_t prefix_ = 0;
+
+  [[nodiscard]] static constexpr auto maskHigh(std::size_t prefix)
+      -> std::uint64_t {
+    if (prefix == 0) {
+      return 0;
+    }
+    return prefix >= 64 ? ~0ULL : ~0ULL << (64 - prefix);
+  }
+
+  [[nodiscard]] static constexpr auto maskLow(std::size_t prefix)
+      -> std::uint64_t {
+    if (prefix <= 64) {
+      return 0;
+    }
+    return prefix == 128 ? ~0ULL : ~0ULL << (128 - prefix);
+  }
+
+ public:
+  constexpr Cidr() = default;
+
+  constexpr Cidr(IpAddress address, std::size_t prefix)
+      : network_(address.high() & maskHigh(prefix),
+                 address.low() & maskLow(prefix)),
+        prefix_(static_cast<std::uint8_t>(prefix)) {}
+
+  [[nodiscard]] static constexpr auto tryParse(std::string_view str)
+      -> std::optional<Cidr> {
+    auto slash = str.find('/');
+    auto host = str.substr(0, slash);
+    auto address = IpAddress::tryParse(host);
+    if (!address) {
+      return std::nullopt;
+    }
+    std::size_t offset = host.contains(':') ? 0 : 96;
+    if (slash == std::string_view::npos) {
+      return Cidr(*address, 128);
+    }
+    auto length = str.substr(slash + 1);
+    std::size_t prefix = 0;
+    auto [ptr, ec] =
+        std::from_chars(length.data(), length.data() + length.size(), prefix);
+    if (ec != std::errc() or ptr != length.data() + length.size() or
+        length.empty() or prefix + offset > 128) {
+      return std::nullopt;
+    }
+    return Cidr(*address, prefix + offset);
+  }
+
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> Cidr {
+    auto ret = tryParse(value);
+    if (!ret) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is not a CIDR prefix", key, value));
+    }
+    return *ret;
+  }
+
+  [[nodiscard]] constexpr auto network() const -> IpAddress {
+    return this->network_;
+  }
+
+  /*!
+   * Prefix length in the address family, /8 for 10.0.0.0/8
+   */
+  [[nodiscard]] constexpr auto prefixLength() const -> std::size_t {
+    return this->network_.isV4() ? this->prefix_ - 96 : this->prefix_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto contains(
+      IpAddress address) const -> bool {
+    return (address.high() & maskHigh(this->prefix_)) ==
+               this->network_.high() and
+           (address.low() & maskLow(this->prefix_)) == this->network_.low();
+  }
+
+  [[nodiscard]] constexpr auto contains(const Cidr& other) const -> bool {
+    return other.prefix_ >= this->prefix_ and this->contains(other.network_);
+  }
+
+  constexpr auto operator<=>(const Cidr&) const = default;
+};
+
+/*!
+ * Address and port, written as 1.2.3.4:80, [::1]:80 or :80
+ * ":80" stands for the unspecified address "::".
+ */
+export class Endpoint {
+ private:
+  IpAddress address_;
+  std::uint16_t port_ = 0;
+
+ public:
+  constexpr Endpoint() = default;
+
+  constexpr Endpoint(IpAddress address, std::uint16_t port)
+      : address_(address), port_(port) {}
+
+  [[nodiscard]] static constexpr auto tryParse(std::string_view str)
+      -> std::optional<Endpoint> {
+    auto colon = str.rfind(':');
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
+    }
+    auto host = str.substr(0, colon);
+    auto port_str = str.substr(colon + 1);
+
+    auto address = std::optional<IpAddress>(IpAddress());
+    if (host.starts_with('[')) {
+      if (!host.ends_with(']')) {
+        return std::nullopt;
+      }
+      address = IpAddress::tryParse(host.substr(1, host.size() - 2));
+      if (address and address->isV4()) {
+        return std::nullopt;
+      }
+    } else if (!host.empty()) {
+      // Bare IPv6 is ambiguous with the port separator
+      if (host.contains(':')) {
+        return std::nullopt;
+      }
+      address = IpAddress::tryParse(host);
+    }
+    if (!address) {
+      return std::nullopt;
+    }
+
+    std::uint16_t port = 0;
+    auto [ptr, ec] = std::from_chars(
+        port_str.data(), port_str.data() + port_str.size(), port);
+    if (ec != std::errc() or port_str.empty() or
+        ptr != port_str.data() + port_str.size()) {
+      return std::nullopt;
+    }
+    return Endpoint(*address, port);
+  }
+
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> Endpoint {
+    auto ret = tryParse(value);
+    if (!ret) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is not an endpoint", key, value));
+    }
+    return *ret;
+  }
+
+  [[nodiscard]] constexpr auto address() const -> IpAddress {
+    return this->address_;
+  }
+
+  [[nodiscard]] constexpr auto port() const -> std::uint16_t {
+    return this->port_;
+  }
+
+  constexpr auto operator<=>(const Endpoint&) const = default;
+};
+
+/*!
+ * Sort prefixes and drop the ones covered by another prefix
+ * Remaining prefixes are disjoint, which contains() relies on.
+ */
+export inline auto SortPrefixes(std::vector<Cidr>& table) -> void {
+  std::ranges::sort(table);
+  auto out = table.begin();
+  for (auto it = table.begin(); it != table.end(); it++) {
+    if (out != table.begin() and std::prev(out)->contains(*it)) {
+      continue;
+    }
+    *out++ = *it;
+  }
+  table.erase(out, table.end());
+}
+
+/*!
+ * O(log n) lookup in a table normalized by SortPrefixes
+ * std::vector<Cidr> arguments are normalized at the end of parse, whether
+ * their values came from the command line, a config file or the environment.
+ */
+export ARGO_ALWAYS_INLINE inline auto contains(std::span<const Cidr> table,
+                                               IpAddress address) -> bool {
+  auto it = std::ranges::upper_bound(table, address, {}, &Cidr::network);
+  return it != table.begin() and std::prev(it)->contains(address);
+}
+
+}  // namespace Argo
+
+// generator end here
@@ -13,6 +13,13 @@ import :TypeTraits;
 import :MetaLookup;
 import :ArgName;
 import :Arg;
+import :Constraint;
+import :Config;
+import :Snapshot;
+import :Serialize;
+import :Visit;
+import :Stdin;
+import :MappedFile;
 
 // generator start here
 
@@ -28,6 +35,30 @@ export enum class RequiredFlag : bool {
 export using RequiredFlag::Required;  // NOLINT(misc-unused-using-decls)
 export using RequiredFlag::Optional;  // NOLINT(misc-unused-using-decls)
 
+export enum class RepeatFlag : bool {
+  Once = false,
+  Append = true,
+};
+
+export using RepeatFlag::Append;  // NOLINT(misc-unused-using-decls)
+
+template <class T, auto... Options>
+consteval auto HasOption() -> bool {
+  return (std::is_same_v<std::remove_cvref_t<decltype(Options)>, T> || ...);
+}
+
+/*!
+ * First template option of type T, put a fallback at the end of Options
+ */
+template <class T, auto Option, auto... Options>
+consteval auto GetOption() -> T {
+  if constexpr (std::is_same_v<std::remove_cvref_t<decltype(Option)>, T>) {
+    return Option;
+  } else {
+    return GetOption<T, Options...>();
+  }
+}
+
 /*!
  * Helper function to create nargs
  */
@@ -47,11 +78,33 @@ struct ParserInfo {
   std::optional<std::string_view> subcommand_help = std::nullopt;
   std::optional<std::string_view> options_help = std::nullopt;
   std::optional<std::string_view> positional_argument_help = std::nullopt;
+  std::optional<std::string_view> env_prefix = std::nullopt;
+  std::optional<std::string_view> config_key = std::nullopt;
+  bool copy_config = false;
+  bool exit_on_help = true;
+  std::shared_ptr<ConfigStorage> config = std::make_shared<ConfigStorage>();
+  // Program name taken from a command line string, which resetArgs releases
+  std::string owned_program_name;
+  // argv split from a command line string, reused by the next one
+  std::vector<char*> owned_argv;
+  // Tokens after "--" in the argv given to parse
+  std::span<char*> passthrough;
+  // Tokens of "-" or "--args-from-stdin", set by argsFromStdin
+  std::optional<TokenReader> stdin_args = std::nullopt;
+  // argv given to parse with the tokens of stdin_args in place of "-"
+  std::vector<char*> stdin_argv;
+  bool collect_unknown = false;
+  // Unknown options and their values when collect_unknown is set
+  std::vector<char*> unknown;
 };
 
+export template <class P>
+class Reloader;
+
 export template <ParserID ID = 0, class Args = std::tuple<>,
                  class PArgs = std::tuple<>, class HArg = void,
-                 class SubParsers = std::tuple<>>
+                 class SubParsers = std::tuple<>,
+                 class Constraints = std::tuple<>>
   requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
 class Parser {
  private:
@@ -59,7 +112,18 @@ class Parser {
   std::unique_ptr<ParserInfo> info_ = nullptr;
   SubParsers subParsers;
 
+  template <class P>
+  friend class Reloader;
+
  public:
+  using Arguments =
+      decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+
+  // Same arguments with separate values, used by Reloader
+  using Shadow = Parser<ID.shadowed(), RebindArgs_t<Args, ID.shadowed()>,
+                        RebindArgs_t<PArgs, ID.shadowed()>, void, std::tuple<>,
+                        Constraints>;
+
   constexpr explicit Parser() : info_(std::make_unique<ParserInfo>()){};
 
   constexpr explicit Parser(std::string_view program_name)
@@ -94,52 +158,52 @@ class Parser {
   constexpr ~Parser() = default;
 
   template <class Type, ArgName Name, auto arg1 = Unspecified(),
-            auto arg2 = Unspecified(), bool ISPArgs, class... T>
+            auto arg2 = Unspecified(), auto arg3 = Unspecified(),
+            bool ISPArgs, class... T>
   ARGO_ALWAYS_INLINE constexpr auto createArg(T... args) {
     static_assert(Name.hasValidNameLength(),
                   "Short name can't be more than one charactor");
 
+    static constexpr auto append =
+        GetOption<RepeatFlag, arg1, arg2, arg3, RepeatFlag::Once>() ==
+        RepeatFlag::Append;
+
     static constexpr auto nargs = []() {
-      if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg1)>,
-                                   NArgs>) {
+      if constexpr (HasOption<NArgs, arg1, arg2, arg3>()) {
+        constexpr auto narg = GetOption<NArgs, arg1, arg2, arg3>();
         if constexpr (is_array_v<Type>) {
-          static_assert(array_len_v<Type> == arg1.nargs,
+          static_assert(array_len_v<Type> == narg.nargs,
                         "Array size mismatch with nargs");
         }
         if constexpr (is_vector_v<Type>) {
-          static_assert(arg1.nargs_char != '?' && arg1.nargs != 1,
+          static_assert((narg.nargs_char != '?' && narg.nargs != 1) || append,
                         "Vector size mismatch with nargs");
         }
-        if constexpr (is_tuple_v<Type>) {
-          static_assert(std::tuple_size_v<Type> == arg1.nargs,
-                        "Tuple size mismatch with nargs");
-        }
-        return arg1;
-      } else if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg2)>,
-                                          NArgs>) {
-        if constexpr (is_array_v<Type>) {
-          static_assert(array_len_v<Type> == arg2.nargs,
-                        "Array size mismatch with nargs");
-        }
-        if constexpr (is_vector_v<Type>) {
-          static_assert(arg2.nargs_char != '?' && arg2.nargs != 1,
-                        "Vector size mismatch with nargs");
+        if constexpr (is_map_v<Type>) {
+          static_assert(narg.nargs == 1 || narg.nargs_char == '+',
+                        "Map nargs must be 1 or '+'");
         }
         if constexpr (is_tuple_v<Type>) {
-          static_assert(std::tuple_size_v<Type> == arg2.nargs,
+          static_assert(std::tuple_size_v<Type> == narg.nargs,
                         "Tuple size mismatch with nargs");
         }
-        return arg2;
+        return narg;
       } else {
         if constexpr (is_array_v<Type>) {
           return NArgs{static_cast<int>(array_len_v<Type>)};
         }
+        if constexpr (append) {
+          return NArgs(1);
+        }
         if constexpr (is_vector_v<Type>) {
           return NArgs{'*'};
         }
         if constexpr (is_tuple_v<Type>) {
           return NArgs{static_cast<int>(std::tuple_size_v<Type>)};
         }
+        if constexpr (is_map_v<Type>) {
+          return NArgs(1);
+        }
         if constexpr (ISPArgs) {
           return NArgs(1);
         }
@@ -151,17 +215,14 @@ class Parser {
                   "Array size must be more than one");
     static_assert(!(is_tuple_v<Type> and nargs.nargs == 1),
                   "Tuple size must be more than one");
-    static constexpr auto required = []() {
-      if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg1)>,
-                                   RequiredFlag>) {
-        return static_cast<bool>(arg1);
-      } else if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg2)>,
-                                          RequiredFlag>) {
-        return static_cast<bool>(arg2);
-      } else {
-        return false;
-      }
-    }();
+    static_assert(!append or is_vector_v<Type>,
+                  "Append argument must be std::vector");
+    static_assert(!append or nargs.nargs == 1 or nargs.nargs_char == '+',
+                  "Append argument nargs must be 1 or '+'");
+    static_assert(is_map_v<Type> or !requires { typename Type::mapped_type; },
+                  "Map argument must be ordered, use std::map or std::flat_map");
+    static constexpr auto required = static_cast<bool>(
+        GetOption<RequiredFlag, arg1, arg2, arg3, Optional>());
 
     if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
       static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
@@ -178,23 +239,26 @@ class Parser {
          || nargs.nargs_char == '*'),  //
         "nargs must be '?', '+', '*' or int");
 
-    ArgInitializer<Type, Name, nargs, required, ID>(std::forward<T>(args)...);
-    return std::type_identity<Arg<Type, Name, nargs, required, ID>>();
+    ArgInitializer<Type, Name, nargs, required, ID, append>(
+        std::forward<T>(args)...);
+    return std::type_identity<Arg<Type, Name, nargs, required, ID, append>>();
   }
 
   /*!
    * Name: name of argument
    * Type: type of argument
-   * arg1: Required(bool) or NArgs or Unspecified
-   * arg2: Required(bool) or NArgs or Unspecified
+   * arg1: Required(bool) or NArgs or Append or Unspecified
+   * arg2: Required(bool) or NArgs or Append or Unspecified
+   * arg3: Required(bool) or NArgs or Append or Unspecified
    */
   template <ArgName Name, class Type, auto arg1 = Unspecified(),
-            auto arg2 = Unspecified(), class... T>
+            auto arg2 = Unspecified(), auto arg3 = Unspecified(), class... T>
   constexpr auto addArg(T... args) {
-    auto arg =
-        createArg<Type, Name, arg1, arg2, false>(std::forward<T>(args)...);
+    auto arg = createArg<Type, Name, arg1, arg2, arg3, false>(
+        std::forward<T>(args)...);
     return Parser<ID, tuple_append_t<Args, typename decltype(arg)::type>, PArgs,
-                  HArg, SubParsers>(std::move(this->info_), subParsers);
+                  HArg, SubParsers, Constraints>(std::move(this->info_),
+                                                 subParsers);
   }
 
   /*!
@@ -208,16 +272,35 @@ class Parser {
   constexpr auto addPositionalArg(T... args) {
     static_assert(Name.getShortName() == '\0',
                   "Positional argment cannot have short name");
-    auto arg =
-        createArg<Type, Name, arg1, arg2, true>(std::forward<T>(args)...);
+    auto arg = createArg<Type, Name, arg1, arg2, Unspecified{}, true>(
+        std::forward<T>(args)...);
 
     static_assert(decltype(arg)::type::nargs.nargs_char != '?',
                   "Cannot assign narg: ? to the positional argument");
     static_assert(decltype(arg)::type::nargs.nargs_char != '*',
                   "Cannot assign narg: * to the positional argument");
+    static_assert(!decltype(arg)::type::repeatable,
+                  "Positional argument cannot be repeated");
 
     return Parser<ID, Args, tuple_append_t<PArgs, typename decltype(arg)::type>,
-                  HArg, SubParsers>(std::move(this->info_), subParsers);
+                  HArg, SubParsers, Constraints>(std::move(this->info_),
+                                                 subParsers);
+  }
+
+  /*!
+   * Argument naming a config file, read after the command line and the
+   * environment. A default path is skipped when the file does not exist.
+   * Example:
+   *      addConfig<"config,c">(Argo::explicitDefault(std::string("app.toml")))
+   */
+  template <ArgName Name, class... T>
+  constexpr auto addConfig(T... args) {
+    auto arg = createArg<std::string, Name, NArgs(1), Unspecified{},
+                         Unspecified{}, false>(std::forward<T>(args)...);
+    this->info_->config_key = Name.getKey();
+    return Parser<ID, tuple_append_t<Args, typename decltype(arg)::type>, PArgs,
+                  HArg, SubParsers, Constraints>(std::move(this->info_),
+                                                 subParsers);
   }
 
   template <ArgName Name, class... T>
@@ -230,9 +313,27 @@ class Parser {
             (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
         "Duplicated short name");
     static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
-    FlagArgInitializer<Name, ID>(std::forward<T>(args)...);
+    FlagArgInitializer<FlagArg<Name, ID>>(std::forward<T>(args)...);
     return Parser<ID, tuple_append_t<Args, FlagArg<Name, ID>>, PArgs, HArg,
-                  SubParsers>(std::move(this->info_), subParsers);
+                  SubParsers, Constraints>(std::move(this->info_), subParsers);
+  }
+
+  /*!
+   * Flag which counts how many times it is given, getArg returns int
+   */
+  template <ArgName Name, class... T>
+  constexpr auto addCount(T... args) {
+    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+      static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
+    }
+    static_assert(
+        (Name.getShortName() == '\0') ||
+            (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
+        "Duplicated short name");
+    static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
+    FlagArgInitializer<CountArg<Name, ID>>(std::forward<T>(args)...);
+    return Parser<ID, tuple_append_t<Args, CountArg<Name, ID>>, PArgs, HArg,
+                  SubParsers, Constraints>(std::move(this->info_), subParsers);
   }
 
   template <ArgName Name = "help,h">
@@ -240,8 +341,8 @@ class Parser {
     static_assert((SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
                   "Duplicated short name");
     static_assert(Argo::SearchIndex<Args, Name>() == -1, "Duplicated name");
-    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers>(
-        std::move(this->info_), subParsers);
+    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers,
+                  Constraints>(std::move(this->info_), subParsers);
   }
 
   template <ArgName Name = "help,h">
@@ -252,8 +353,8 @@ class Parser {
     static_assert(Name.hasValidNameLength(),
                   "Short name can't be more than one charactor");
     this->info_->help = help;
-    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers>(
-        std::move(this->info_), subParsers);
+    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers,
+                  Constraints>(std::move(this->info_), subParsers);
   }
 
   template <ArgName Name>
@@ -277,6 +378,58 @@ class Parser {
     }
   }
 
+  /*!
+   * Immutable copy of every value, safe to share between threads
+   */
+  [[nodiscard]] auto freeze() const -> Snapshot<Arguments> {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return Snapshot<Arguments>(std::type_identity<Arguments>(),
+                               this->info_->config);
+  }
+
+  /*!
+   * Parsed values in a binary form for load, readable only by a program built
+   * with the same arguments on the same architecture. Not available with
+   * LazyArgs arguments, which view argv
+   */
+  [[nodiscard]] auto serialize() const -> std::vector<std::byte>
+    requires(is_serializable_args_v<Arguments>)
+  {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return SerializeArgs<Arguments>();
+  }
+
+  /*!
+   * Take the values written by serialize instead of parsing, validators and
+   * callbacks are not run again
+   * string_view and const char* values point into buffer, keep it alive
+   */
+  auto load(std::span<const std::byte> buffer) -> void
+    requires(is_serializable_args_v<Arguments>)
+  {
+    if (this->parsed_) [[unlikely]] {
+      throw ParseError("Cannot parse twice");
+    }
+    DeserializeArgs<Arguments>(buffer);
+    this->parsed_ = true;
+  }
+
+  /*!
+   * Map fd, for example a memfd or shm object inherited from the parent, and
+   * load from it. fd can be closed after this returns
+   */
+  auto load(int fd) -> void
+    requires(is_serializable_args_v<Arguments>)
+  {
+    const auto& file = this->info_->config->files.emplace_back(
+        BasicMappedFile<MapAdvice::Sequential>::fromFd(fd));
+    this->load(file.bytes());
+  }
+
   template <ArgName Name>
   constexpr auto getParser() -> auto& {
     if constexpr (std::is_same_v<SubParsers, std::tuple<>>) {
@@ -287,6 +440,43 @@ class Parser {
     return std::get<SearchIndex<SubParsers, Name>()>(subParsers).parser.get();
   }
 
+  /*!
+   * Tokens after "--", which are neither options nor positional arguments
+   * The span points into the argv given to parse and is null terminated when
+   * argv is, so it can be passed to execvp as is:
+   *      auto rest = parser.getPassthrough();
+   *      execvp(rest[0], rest.data());
+   */
+  [[nodiscard]] auto getPassthrough() const -> std::span<char*> {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return this->info_->passthrough;
+  }
+
+  /*!
+   * Tokens of the unknown options and their values in command line order,
+   * pointing into the argv given to parse. Empty unless collectUnknown is set
+   */
+  [[nodiscard]] auto getUnknown() const -> std::span<char* const> {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return this->info_->unknown;
+  }
+
+  /*!
+   * Tokens of stdin not taken by parse, see argsFromStdin
+   * Example:
+   *      for (auto file : parser.getStdinArgs()) { ... }
+   */
+  [[nodiscard]] auto getStdinArgs() -> TokenReader& {
+    if (!this->info_->stdin_args) [[unlikely]] {
+      throw ParseError("argsFromStdin is not set");
+    }
+    return *this->info_->stdin_args;
+  }
+
   template <ArgName Name>
   constexpr auto isAssigned() {
     if (!this->parsed_) [[unlikely]] {
@@ -302,6 +492,24 @@ class Parser {
                                 AllArguments>::assigned;
   }
 
+  /*!
+   * Source of the value of the argument
+   */
+  template <ArgName Name>
+  constexpr auto getSource() -> ValueSource {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    using AllArguments =
+        decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+
+    static_assert(SearchIndex<AllArguments, Name>() != -1,
+                  "Argument does not exist");
+
+    return std::tuple_element_t<SearchIndex<AllArguments, Name>(),
+                                AllArguments>::source;
+  }
+
   /*!
    * Add subcommand
    */
@@ -311,11 +519,80 @@ class Parser {
     auto s = std::make_tuple(
         SubParser<Name, T>{ref(sub_parser), description.description});
     auto sub_parsers = std::tuple_cat(subParsers, s);
-    return Parser<ID, Args, PArgs, HArg, decltype(sub_parsers)>(
+    return Parser<ID, Args, PArgs, HArg, decltype(sub_parsers), Constraints>(
         std::move(this->info_), sub_parsers);
   }
 
-  ARGO_ALWAYS_INLINE constexpr auto resetArgs() -> void;
+  /*!
+   * Add a constraint between arguments, checked at the end of parse
+   * Example:
+   *      addConstraint(Argo::exclusive<"json", "yaml">())
+   *      addConstraint(Argo::dependsOn<"tls-key", "tls-cert">())
+   *      addConstraint(Argo::oneOf<"file", "url">())
+   */
+  template <class Constraint>
+  constexpr auto addConstraint(Constraint /* unused */) {
+    static_assert(std::derived_from<Constraint, ConstraintTag>,
+                  "Invalid constraint");
+    static_assert(Constraint::template refersTo<decltype(std::tuple_cat(
+                      std::declval<Args>(), std::declval<PArgs>()))>(),
+                  "Constraint refers to an unknown argument");
+    return Parser<ID, Args, PArgs, HArg, SubParsers,
+                  tuple_append_t<Constraints, Constraint>>(
+        std::move(this->info_), subParsers);
+  }
+
+  /*!
+   * Reset the arguments assigned by the last parse to their explicit default.
+   * Containers keep their capacity for the next parse unless release_memory
+   * is set
+   */
+  ARGO_ALWAYS_INLINE constexpr auto resetArgs(bool release_memory = false)
+      -> void;
+
+  /*!
+   * resetArgs for this parser and its sub parsers, the config storage is kept
+   * when the last parse did not use it
+   */
+  auto resetAssigned() -> void;
+
+  /*!
+   * Read arguments not given on the command line from PREFIX_KEY variables
+   */
+  ARGO_ALWAYS_INLINE constexpr auto setEnvPrefix(std::string_view prefix) {
+    this->info_->env_prefix = prefix;
+  }
+
+  /*!
+   * Collect unknown options with the values following them instead of
+   * throwing, see getUnknown. An unknown option takes every value up to the
+   * next option, positional arguments must come before it
+   */
+  ARGO_ALWAYS_INLINE constexpr auto collectUnknown(bool enable = true) {
+    this->info_->collect_unknown = enable;
+  }
+
+  /*!
+   * Take "-" or "--args-from-stdin" on the command line as the tokens read
+   * from fd, delimited by delimiter, in its place
+   * When it is the last token and the last positional argument takes
+   * nargs('+'), nothing is read by parse: the positional argument gets the
+   * values before it and the rest is pulled lazily from getStdinArgs
+   */
+  auto argsFromStdin(char delimiter = '\0', int fd = 0) -> void {
+    this->info_->stdin_args.emplace(fd, delimiter);
+  }
+
+  /*!
+   * With false, --help prints the help and throws HelpRequested instead of
+   * exiting, for this parser and its sub parsers
+   */
+  ARGO_ALWAYS_INLINE constexpr auto exitOnHelp(bool enable = true) -> void {
+    this->info_->exit_on_help = enable;
+    std::apply(
+        [enable](auto&... sub) { (..., sub.parser.get().exitOnHelp(enable)); },
+        this->subParsers);
+  }
 
   ARGO_ALWAYS_INLINE constexpr auto addUsageHelp(std::string_view usage) {
     this->info_->usage = usage;
@@ -337,6 +614,8 @@ class Parser {
   }
 
  private:
+  auto spliceStdinArgs(int argc, char* argv[]) -> std::pair<int, char**>;
+  [[noreturn]] auto exitWithHelp() const -> void;
   ARGO_ALWAYS_INLINE constexpr auto setArg(
       std::string_view key, const std::span<std::string_view>& val) const
       -> void;
@@ -346,6 +625,42 @@ class Parser {
 
  public:
   ARGO_ALWAYS_INLINE constexpr auto parse(int argc, char* argv[]) -> void;
+
+  /*!
+   * parse a whole command line split with POSIX shell quoting, the first
+   * token is the program name. Tokens live in an arena owned by the parser
+   * until resetArgs
+   */
+  auto parse(std::string_view command_line) -> void;
+
+  /*!
+   * parse, reusing the result stored in cache_dir by an earlier run with the
+   * same argv, environment and config file. Returns true on a hit, in which
+   * case validators and callbacks are not run
+   */
+  auto parseCached(int argc, char* argv[], std::string_view cache_dir) -> bool
+    requires(is_serializable_args_v<Arguments>);
+
+  /*!
+   * Tokenize and dispatch like parse, but call
+   * visitor(VisitTag<Arg>, ValueSpan values, int position) for every argument
+   * found instead of storing it. Values are neither converted nor validated
+   * and no argument is written, check runs the required and constraint checks
+   * Tokens after "--" are not visited
+   */
+  template <class Visitor>
+  auto visit(int argc, char* argv[], Visitor&& visitor,
+             bool check = false) const -> void;
+
+  /*!
+   * Parser fed one token at a time, see IncrementalParser
+   */
+  [[nodiscard]] auto incremental() const
+      -> IncrementalParser<Args, PArgs, HArg, Constraints> {
+    static_assert(std::is_same_v<SubParsers, std::tuple<>>,
+                  "incremental does not support sub parsers");
+    return {};
+  }
   [[nodiscard]] constexpr auto formatHelp(bool no_color = false) const
       -> std::string;
 
@@ -14,6 +14,13 @@ import :MetaParse;
 import :HelpGenerator;
 import :Arg;
 import :Exceptions;
+import :Constraint;
+import :Config;
+import :Cache;
+import :Visit;
+import :Shell;
+import :Stdin;
+import :Lazy;
 
 // generator start here
 
@@ -31,61 +38,132 @@ ARGO_ALWAYS_INLINE auto splitStringView(std::string_view str, char delimeter)
   return ret;
 }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
   requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::resetArgs() -> void {
+constexpr auto
+Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::resetArgs(
+    bool release_memory) -> void {
   this->parsed_ = false;
-  ValueReset<decltype(std::tuple_cat(std::declval<Args>(),
-                                     std::declval<PArgs>()))>();
+  this->info_->config = std::make_shared<ConfigStorage>();
+  this->info_->passthrough = {};
+  if (release_memory) {
+    this->info_->owned_argv = {};
+    this->info_->unknown = {};
+  } else {
+    this->info_->unknown.clear();
+  }
+  ResetDirtyArgs<ID>(release_memory);
+}
+
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::resetAssigned()
+    -> void {
+  this->parsed_ = false;
+  this->info_->passthrough = {};
+  this->info_->unknown.clear();
+  ResetDirtyArgs<ID>();
+  const auto& config = *this->info_->config;
+  if (!config.files.empty() or !config.strings.empty()) {
+    this->info_->config = std::make_shared<ConfigStorage>();
+  }
+  std::apply([](auto&... sub) { (..., sub.parser.get().resetAssigned()); },
+             this->subParsers);
 }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
   requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::setArg(
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::spliceStdinArgs(
+    int argc, char* argv[]) -> std::pair<int, char**> {
+  if (argv == this->info_->stdin_argv.data()) {
+    // Already spliced by parseCached
+    return {argc, argv};
+  }
+  const auto options_end = OptionsEnd(argc, argv);
+  const auto index = StdinArgIndex<Args>(options_end, argv);
+  if (index == -1) {
+    return {argc, argv};
+  }
+  auto lazy = false;
+  if constexpr (std::tuple_size_v<PArgs> != 0) {
+    using Last = std::tuple_element_t<std::tuple_size_v<PArgs> - 1, PArgs>;
+    lazy = Last::nargs.nargs_char == '+' and index == options_end - 1;
+  }
+  auto& spliced = this->info_->stdin_argv;
+  spliced.assign(argv, argv + index);
+  if (!lazy) {
+    for (auto token : *this->info_->stdin_args) {
+      // Tokens are null terminated in the arena of the reader
+      spliced.push_back(const_cast<char*>(token.data()));
+    }
+  }
+  spliced.insert(spliced.end(), argv + index + 1, argv + argc);
+  spliced.push_back(nullptr);
+  return {static_cast<int>(spliced.size() - 1), spliced.data()};
+}
+
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::exitWithHelp()
+    const -> void {
+  std::cout << formatHelp() << std::endl;
+  if (!this->info_->exit_on_help) {
+    throw HelpRequested();
+  }
+  std::exit(0);
+}
+
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::setArg(
     std::string_view key, const std::span<std::string_view>& val) const
     -> void {
   if constexpr (!std::is_same_v<HArg, void>) {
     if (key == HArg::name.getKey()) {
-      std::cout << formatHelp() << std::endl;
-      std::exit(0);
+      this->exitWithHelp();
     }
   }
   Assigner<Args, PArgs>(key, val);
 }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
   requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::setShortKeyArg(
+constexpr auto
+Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::setShortKeyArg(
     std::string_view key, const std::span<std::string_view>& val) const
     -> void {
   if (ShortArgAssigner<Args, PArgs, HArg>(key, val)) [[unlikely]] {
-    std::cout << formatHelp() << std::endl;
-    std::exit(0);
+    this->exitWithHelp();
   };
 }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
   requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::parse(int argc,
-                                                                char* argv[])
-    -> void {
+constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::parse(
+    int argc, char* argv[]) -> void {
   if (this->parsed_) [[unlikely]] {
     throw ParseError("Cannot parse twice");
   }
-  auto assigned_keys = std::vector<std::string_view>();
-  tuple_type_visit<decltype(std::tuple_cat(std::declval<Args>(),
-                                           std::declval<PArgs>()))>(
-      [&assigned_keys]<class T>(T) {
-        if (T::type::assigned) {
-          assigned_keys.push_back(T::type::name.getKey());
-        }
-      });
-  if (!assigned_keys.empty()) [[unlikely]] {
+  if (!DirtyArgs<ID>::args.empty()) [[unlikely]] {
+    auto assigned_keys = std::vector<std::string_view>();
+    tuple_type_visit<Arguments>([&assigned_keys]<class T>(T) {
+      if (T::type::assigned) {
+        assigned_keys.push_back(T::type::name.getKey());
+      }
+    });
     throw ParseError(std::format("keys {} already assigned", assigned_keys));
   }
+  if (this->info_->stdin_args) [[unlikely]] {
+    std::tie(argc, argv) = this->spliceStdinArgs(argc, argv);
+  }
 
-  std::string_view key{};
-  std::string_view short_keys{};
   std::vector<std::string_view> values{};
 
   // [[assume(this->info_)]]; // TODO(gen740): add assume when clang supports it
@@ -94,11 +172,13 @@ constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::parse(int argc,
     this->info_->program_name = std::string_view(argv[0]);
   }
 
-  // Search for subcommand
+  const auto options_end = OptionsEnd(argc, argv);
+
+  // Search for subcommand, the tokens after "--" are not searched
   std::int32_t subcmd_found_idx = -1;
-  std::int32_t cmd_end_pos = argc;
+  std::int32_t cmd_end_pos = options_end;
 
-  for (int i = argc - 1; i > 0; i--) {
+  for (int i = options_end - 1; i > 0; i--) {
     if constexpr (!std::is_same_v<SubParsers, std::tuple<>>) {
       if (subcmd_found_idx == -1) {
         subcmd_found_idx = ParserIndex(subParsers, argv[i]);
@@ -108,90 +188,234 @@ constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::parse(int argc,
       }
     }
   }
-  bool is_flag = false;
-  std::string_view arg;
+  // Instantiated twice so the lookup of unknown options costs nothing when
+  // they are not collected
+  auto tokenize = [&]<bool CollectUnknown>() ARGO_ALWAYS_INLINE {
+    Tokenize<Args>(
+        cmd_end_pos, argv,
+        [this, &values, argv](TokenKind kind, std::string_view name,
+                              ValueSpan span,
+                              int position) ARGO_ALWAYS_INLINE {
+          if constexpr (has_lazy_args_v<Arguments>) {
+            TokenValues<ID>::span = span;
+          }
+          if constexpr (CollectUnknown) {
+            using Known = std::conditional_t<std::is_same_v<HArg, void>, Args,
+                                             tuple_append_t<Args, HArg>>;
+            if ((kind == TokenKind::Long and !IsKnownKey<Known>(name)) or
+                (kind == TokenKind::Short and
+                 !IsKnownShortKeys<Known>(name))) {
+              this->info_->unknown.insert(this->info_->unknown.end(),
+                                          argv + position,
+                                          argv + span.index() + span.size());
+              return;
+            }
+          }
+          values.assign(span.begin(), span.end());
+          if (kind == TokenKind::Short) {
+            this->setShortKeyArg(name, values);
+            return;
+          }
+          if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+            if (kind == TokenKind::Positional and !values.empty())
+                [[unlikely]] {
+              throw InvalidArgument(
+                  std::format("Invalid positional argument: {}", values));
+            }
+          }
+          this->setArg(name, values);
+        });
+  };
+  if (this->info_->collect_unknown) [[unlikely]] {
+    tokenize.template operator()<true>();
+  } else {
+    tokenize.template operator()<false>();
+  }
 
-  for (int i = 1; i < cmd_end_pos + 1; i++) {
-    if (i != cmd_end_pos) {
-      arg = argv[i];
-      is_flag = arg.starts_with('-');
-      if (arg.size() > 1 and arg.at(1) >= '0' and arg.at(1) <= '9') {
-        is_flag = IsFlag<Args>(arg.at(1));
-      }
-    } else {
-      is_flag = true;
+  using AllArgs =
+      decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+  for (const auto& arg : DirtyArgs<ID>::args) {
+    *arg.source = ValueSource::CommandLine;
+  }
+  if (this->info_->env_prefix) {
+    EnvAssigner<AllArgs>(*this->info_->env_prefix, *this->info_->config);
+  }
+  if (this->info_->config_key) {
+    auto [path, given] = ConfigPath<AllArgs>(*this->info_->config_key);
+    if (!path.empty()) {
+      ConfigAssigner<AllArgs>(path, given, this->info_->copy_config,
+                              *this->info_->config);
     }
+  }
 
-    if (i != 1 and is_flag) {
-      if (!key.empty()) {
-        goto SetArgSection;  // NOLINT(cppcoreguidelines-avoid-goto)
-      }
-      if (!short_keys.empty()) {
-        goto SetShortArgSection;  // NOLINT(cppcoreguidelines-avoid-goto)
-      }
-      if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-        if (!values.empty()) {
-          goto SetArgSection;  // NOLINT(cppcoreguidelines-avoid-goto)
+  FinalizeArgs<AllArgs>();
+  if (tuple_type_or_visit<AllArgs>([]<class T>(T) ARGO_ALWAYS_INLINE {
+        if constexpr (std::derived_from<typename T::type, ArgTag>) {
+          return T::type::required && !T::type::assigned;
+        } else {
+          return false;
         }
-      } else {
-        if (!values.empty()) [[unlikely]] {
-          throw InvalidArgument(
-              std::format("Invalid positional argument: {}", values));
+      })) [[unlikely]] {
+    auto required_keys = std::vector<std::string_view>();
+    tuple_type_visit<AllArgs>([&required_keys]<class T>(T) {
+      if constexpr (std::derived_from<typename T::type, ArgTag>) {
+        if ((T::type::required && !T::type::assigned)) {
+          required_keys.push_back(T::type::name.getKey());
         }
       }
-    SetArgSection:
-      this->setArg(key, values);
-      key = "";
-      values.clear();
-      goto End;  // NOLINT(cppcoreguidelines-avoid-goto)
-    SetShortArgSection:
-      this->setShortKeyArg(short_keys, values);
-      short_keys = "";
-      values.clear();
-    End:
-    }
+    });
+    throw InvalidArgument(std::format("Requried {}", required_keys));
+  }
+  CheckConstraints<AllArgs, Constraints>();
+  if (subcmd_found_idx != -1) {
+    // The sub parser takes "--" and what follows
+    MetaParse(subParsers, subcmd_found_idx, argc - cmd_end_pos,
+              &argv[cmd_end_pos]);
+  } else if (options_end != argc) {
+    this->info_->passthrough =
+        std::span<char*>(argv + options_end + 1, argv + argc);
+  }
+  this->parsed_ = true;
+}
 
-    if (i == cmd_end_pos) {
-      break;
-    }
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::parse(
+    std::string_view command_line) -> void {
+  auto& arena =
+      this->info_->config->strings.emplace_back(command_line.size() + 1, '\0');
+  auto& argv = this->info_->owned_argv;
+  argv.clear();
+  ShellSplit(command_line, arena.data(), argv);
+  if (argv.empty()) {
+    // Empty program name
+    argv.push_back(arena.data());
+  }
+  if (!this->info_->program_name) {
+    this->info_->owned_program_name = argv[0];
+    this->info_->program_name = this->info_->owned_program_name;
+  }
+  auto argc = static_cast<int>(argv.size());
+  argv.push_back(nullptr);
+  this->parse(argc, argv.data());
+}
 
-    if (is_flag) {
-      if (arg.size() > 1 and arg.at(1) == '-') {
-        if (arg.contains('=')) [[unlikely]] {
-          auto equal_pos = arg.find('=');
-          key = arg.substr(2, equal_pos - 2);
-          values.push_back(arg.substr(equal_pos + 1));
-          is_flag = true;
-        } else {
-          key = arg.substr(2);
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::parseCached(
+    int argc, char* argv[], std::string_view cache_dir) -> bool
+  requires(is_serializable_args_v<Arguments>)
+{
+  static_assert(std::is_same_v<SubParsers, std::tuple<>>,
+                "parseCached does not support sub parsers");
+  if (this->parsed_) [[unlikely]] {
+    throw ParseError("Cannot parse twice");
+  }
+  if (this->info_->stdin_args) [[unlikely]] {
+    // The key covers the tokens read from stdin
+    std::tie(argc, argv) = this->spliceStdinArgs(argc, argv);
+  }
+  const auto inputs =
+      CacheInputs<Arguments>(argc, argv, this->info_->env_prefix);
+  const auto path = std::format("{}/{:016x}.argo", cache_dir, CacheKey(inputs));
+
+  if (auto file = CacheRead(path, *this->info_->config)) {
+    if (auto entry = CacheLookup(*file, inputs)) {
+      try {
+        if (std::ranges::any_of(entry->unknown, [argc](auto i) {
+              return i >= static_cast<std::uint32_t>(argc);
+            })) [[unlikely]] {
+          throw ParseError("Cached unknown option is out of argv");
         }
-      } else {
-        short_keys = arg.substr(1);
+        this->load(entry->block);
+        for (auto i : entry->unknown) {
+          this->info_->unknown.push_back(argv[i]);
+        }
+        if (!this->info_->program_name) {
+          this->info_->program_name = std::string_view(argv[0]);
+        }
+        if (auto end = OptionsEnd(argc, argv); end != argc) {
+          this->info_->passthrough =
+              std::span<char*>(argv + end + 1, argv + argc);
+        }
+        return true;
+      } catch (const ParseError&) {
+        // Written by an incompatible build, replaced below
       }
-    } else {
-      values.push_back(arg);
     }
   }
 
-  auto required_keys = std::vector<std::string_view>();
-  tuple_type_visit<decltype(std::tuple_cat(std::declval<Args>(),
-                                           std::declval<PArgs>()))>(
-      [&required_keys]<class T>(T) {
-        if constexpr (std::derived_from<typename T::type, ArgTag>) {
-          if ((T::type::required && !T::type::assigned)) {
-            required_keys.push_back(T::type::name.getKey());
+  this->parse(argc, argv);
+  auto dependencies = std::vector<std::string>();
+  if (this->info_->config_key) {
+    auto config_path = ConfigPath<Arguments>(*this->info_->config_key).first;
+    if (!config_path.empty()) {
+      dependencies.emplace_back(config_path);
+    }
+  }
+  // Unknown tokens are stored as positions in argv
+  auto unknown = std::vector<std::uint32_t>();
+  unknown.reserve(this->info_->unknown.size());
+  for (int i = 0; const auto* token : this->info_->unknown) {
+    while (i < argc and argv[i] != token) {
+      i++;
+    }
+    if (i == argc) [[unlikely]] {
+      // Not a token of argv, the result cannot be replayed
+      return false;
+    }
+    unknown.push_back(static_cast<std::uint32_t>(i));
+  }
+  CacheStore(path, inputs, dependencies, unknown, this->serialize());
+  return false;
+}
+
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+template <class Visitor>
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::visit(
+    int argc, char* argv[], Visitor&& visitor, bool check) const -> void {
+  static_assert(std::is_same_v<SubParsers, std::tuple<>>,
+                "visit does not support sub parsers");
+  auto visited = ArgMask<std::tuple_size_v<Arguments>>();
+  auto help = [this, argv] {
+    if (!this->info_->program_name) {
+      this->info_->program_name = std::string_view(argv[0]);
+    }
+    this->exitWithHelp();
+  };
+
+  Tokenize<Args>(
+      OptionsEnd(argc, argv), argv,
+      [&](TokenKind kind, std::string_view name, ValueSpan values,
+          int position) ARGO_ALWAYS_INLINE {
+        if (kind == TokenKind::Short) {
+          if (VisitShort<Args, PArgs, HArg>(name, values, position, visitor,
+                                            visited)) [[unlikely]] {
+            help();
           }
+          return;
         }
+        if constexpr (!std::is_same_v<HArg, void>) {
+          if (kind == TokenKind::Long and name == HArg::name.getKey()) {
+            help();
+          }
+        }
+        if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+          if (kind == TokenKind::Positional and !values.empty()) [[unlikely]] {
+            throw InvalidArgument(std::format(
+                "Invalid positional argument: {}",
+                std::vector<std::string_view>(values.begin(), values.end())));
+          }
+        }
+        VisitOption<Args, PArgs>(name, values, position, visitor, visited);
       });
-
-  if (!required_keys.empty()) [[unlikely]] {
-    throw InvalidArgument(std::format("Requried {}", required_keys));
+  if (check) {
+    VisitCheck<Arguments, Constraints>(visited);
   }
-  if (subcmd_found_idx != -1) {
-    MetaParse(subParsers, subcmd_found_idx, argc - cmd_end_pos,
-              &argv[cmd_end_pos]);
-  }
-  this->parsed_ = true;
 }
 
 struct AnsiEscapeCode {
@@ -365,9 +589,11 @@ constexpr auto createPositionalArgumentSection(const auto& ansi,
   return ret;
 }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
   requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::formatHelp(
+constexpr auto
+Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::formatHelp(
     bool no_color) const -> std::string {
   std::string ret;
 
@@ -0,0 +1,309 @@
+module;
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Reload;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :ArgName;
+import :Arg;
+import :MetaLookup;
+import :Config;
+import :Snapshot;
+import :Parser;
+import :ParserImpl;
+
+// generator start here
+
+#ifdef __linux__
+namespace Argo {
+
+/*!
+ * Copy what the initializers set on the live arguments to the shadow ones
+ */
+template <class From, class To>
+auto CopyArgSettings() -> void {
+  []<std::size_t... Is>(std::index_sequence<Is...>) {
+    (..., []<class F, class T>() {
+      T::description = F::description;
+      T::callback = F::callback;
+      if constexpr (std::derived_from<F, ArgTag>) {
+        T::required = F::required;
+        T::defaultValue = F::defaultValue;
+        T::explicitDefault = F::explicitDefault;
+        T::validator = F::validator;
+        T::caster = F::caster;
+        T::typeName = F::typeName;
+      }
+    }.template operator()<std::tuple_element_t<Is, From>,
+                          std::tuple_element_t<Is, To>>());
+  }(std::make_index_sequence<std::tuple_size_v<From>>());
+}
+
+template <class Args>
+auto RestoreDefaults() -> void {
+  tuple_type_visit<Args>([]<class T>(T) {
+    if constexpr (std::derived_from<typename T::type, ArgTag>) {
+      T::type::value = T::type::explicitDefault;
+    }
+  });
+}
+
+/*!
+ * Re-parse the command line, environment and config file when the config file
+ * changes, and publish the result as a new Snapshot
+ * Example:
+ *      auto reloader = Argo::Reloader(parser, argc, argv);
+ *      auto config = reloader.read();     // lock free
+ *      config->get<"threads">();
+ *
+ * Parsing runs on a shadow copy of the parser with its own values, the values
+ * of the parser itself are never written. The shadow has no help argument
+ * and no sub parsers, so parsers with sub commands are not supported.
+ * Validators and callbacks run on the thread calling reload, which is the
+ * watcher thread for file changes.
+ *
+ * Publishing waits until every reader that could see the old snapshot has
+ * dropped its guard, so do not hold a guard while calling reload.
+ */
+export template <class P>
+class Reloader {
+ public:
+  using Snapshot = Argo::Snapshot<typename P::Arguments>;
+
+  class ReadGuard {
+   private:
+    const Snapshot* snapshot_;
+    std::atomic<std::uint64_t>* count_;
+
+   public:
+    ReadGuard(const Snapshot* snapshot, std::atomic<std::uint64_t>* count)
+        : snapshot_(snapshot), count_(count) {}
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard(ReadGuard&&) = delete;
+    auto operator=(const ReadGuard&) -> ReadGuard& = delete;
+    auto operator=(ReadGuard&&) -> ReadGuard& = delete;
+
+    ~ReadGuard() {
+      this->count_->fetch_sub(1);
+    }
+
+    ARGO_ALWAYS_INLINE auto operator->() const -> const Snapshot* {
+      return this->snapshot_;
+    }
+
+    ARGO_ALWAYS_INLINE auto operator*() const -> const Snapshot& {
+      return *this->snapshot_;
+    }
+  };
+
+ private:
+  using Shadow = typename P::Shadow;
+  using ShadowArgs = typename Shadow::Arguments;
+
+  struct alignas(64) ReaderCount {
+    std::atomic<std::uint64_t> count = 0;
+  };
+
+  Shadow shadow_;
+  std::vector<std::string> args_;
+  std::vector<char*> argv_;
+  std::string path_;
+
+  std::atomic<const Snapshot*> current_ = nullptr;
+  mutable std::atomic<std::uint64_t> epoch_ = 0;
+  mutable std::array<ReaderCount, 2> readers_{};
+  std::atomic<std::uint64_t> generation_ = 0;
+
+  std::mutex reload_mutex_;
+  std::function<void(const std::exception&)> on_error_ = nullptr;
+
+  int inotify_fd_ = -1;
+  int stop_fd_ = -1;
+  std::jthread watcher_;
+
+  auto parseSnapshot() -> const Snapshot* {
+    this->shadow_.resetArgs();
+    RestoreDefaults<ShadowArgs>();
+    this->shadow_.parse(static_cast<int>(this->args_.size()),
+                        this->argv_.data());
+    return new Snapshot(std::type_identity<ShadowArgs>(),
+                        this->shadow_.info_->config);
+  }
+
+  auto publish(const Snapshot* next) -> void {
+    const auto* old = this->current_.exchange(next);
+    // Two grace periods, a reader holding old is counted in one of the slots
+    for (int i = 0; i < 2; i++) {
+      auto epoch = this->epoch_.fetch_add(1);
+      while (this->readers_[epoch & 1].count.load() != 0) {
+        std::this_thread::yield();
+      }
+    }
+    delete old;
+    this->generation_++;
+  }
+
+  auto watch(const std::stop_token& token) -> void {
+    auto name = std::filesystem::path(this->path_).filename().string();
+    auto fds = std::array<::pollfd, 2>{
+        {{.fd = this->inotify_fd_, .events = POLLIN, .revents = 0},
+         {.fd = this->stop_fd_, .events = POLLIN, .revents = 0}}};
+    alignas(::inotify_event) std::array<char, 4096> buffer{};
+
+    while (!token.stop_requested()) {
+      if (::poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[1].revents != 0) {
+        return;
+      }
+      auto changed = false;
+      ::ssize_t len = 0;
+      while ((len = ::read(this->inotify_fd_, buffer.data(), buffer.size())) >
+             0) {
+        for (auto* ptr = buffer.data(); ptr < buffer.data() + len;) {
+          const auto* event = reinterpret_cast<const ::inotify_event*>(ptr);
+          if (event->len != 0 and name == event->name) {
+            changed = true;
+          }
+          ptr += sizeof(::inotify_event) + event->len;
+        }
+      }
+      if (changed) {
+        this->reload();
+      }
+    }
+  }
+
+ public:
+  Reloader(const P& parser, int argc, char* argv[], bool watch = true) {
+    static_assert(std::is_same_v<decltype(P::subParsers), std::tuple<>>,
+                  "Reloader does not support sub parsers");
+    CopyArgSettings<typename P::Arguments, ShadowArgs>();
+    this->shadow_.info_->program_name = parser.info_->program_name;
+    this->shadow_.info_->env_prefix = parser.info_->env_prefix;
+    this->shadow_.info_->config_key = parser.info_->config_key;
+    // Snapshots must outlive in place rewrites of the file
+    this->shadow_.info_->copy_config = true;
+    if (!parser.info_->config_key) [[unlikely]] {
+      throw InvalidArgument("Reloader needs a config argument, use addConfig");
+    }
+
+    this->args_.assign(argv, argv + argc);
+    for (auto& arg : this->args_) {
+      this->argv_.push_back(arg.data());
+    }
+    this->argv_.push_back(nullptr);
+
+    this->publish(this->parseSnapshot());
+    this->path_ = ConfigPath<ShadowArgs>(*parser.info_->config_key).first;
+
+    if (!watch or this->path_.empty()) {
+      return;
+    }
+    auto dir = std::filesystem::path(this->path_).parent_path();
+    this->inotify_fd_ = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    this->stop_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (this->inotify_fd_ < 0 or this->stop_fd_ < 0 or
+        ::inotify_add_watch(this->inotify_fd_,
+                            (dir.empty() ? std::filesystem::path(".") : dir)
+                                .c_str(),
+                            IN_CLOSE_WRITE | IN_MOVED_TO) < 0) [[unlikely]] {
+      auto err = errno;
+      this->close();
+      throw InvalidArgument(
+          std::format("Cannot watch {}: {}", this->path_,
+                      std::system_category().message(err)));
+    }
+    this->watcher_ = std::jthread(
+        [this](const std::stop_token& token) { this->watch(token); });
+  }
+
+  Reloader(const Reloader&) = delete;
+  Reloader(Reloader&&) = delete;
+  auto operator=(const Reloader&) -> Reloader& = delete;
+  auto operator=(Reloader&&) -> Reloader& = delete;
+
+  ~Reloader() {
+    this->close();
+    delete this->current_.load();
+  }
+
+  /*!
+   * Snapshot published last, it stays valid while the guard is alive
+   */
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto read() const -> ReadGuard {
+    auto& count = this->readers_[this->epoch_.load() & 1].count;
+    count.fetch_add(1);
+    return {this->current_.load(), &count};
+  }
+
+  /*!
+   * Parse again and publish, the current snapshot is kept on error
+   */
+  auto reload() -> bool {
+    auto lock = std::scoped_lock(this->reload_mutex_);
+    try {
+      this->publish(this->parseSnapshot());
+      return true;
+    } catch (const std::exception& e) {
+      if (this->on_error_) {
+        this->on_error_(e);
+      }
+      return false;
+    }
+  }
+
+  auto onError(std::function<void(const std::exception&)> on_error) -> void {
+    auto lock = std::scoped_lock(this->reload_mutex_);
+    this->on_error_ = std::move(on_error);
+  }
+
+  /*!
+   * Number of snapshots published so far
+   */
+  [[nodiscard]] auto generation() const -> std::uint64_t {
+    return this->generation_.load();
+  }
+
+  /*!
+   * Stop watching the config file, reload can still be called
+   */
+  auto close() -> void {
+    if (this->watcher_.joinable()) {
+      this->watcher_.request_stop();
+      std::uint64_t one = 1;
+      [[maybe_unused]] auto written =
+          ::write(this->stop_fd_, &one, sizeof(one));
+      this->watcher_.join();
+    }
+    for (auto* fd : {&this->inotify_fd_, &this->stop_fd_}) {
+      if (*fd >= 0) {
+        ::close(*fd);
+        *fd = -1;
+      }
+    }
+  }
+};
+
+}  // namespace Argo
+#endif  // __linux__
+
+// generator end here
@@ -0,0 +1,130 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Repl;
+
+import std;
+
+import :Exceptions;
+import :ArgName;
+import :Shell;
+import :Parser;
+import :ParserImpl;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Command loop which parses one line at a time with the same parser and
+ * dispatches to the handler of the sub command found
+ * Example:
+ *      auto repl = Argo::Repl(parser, "admin");
+ *      repl.on<"stats">([](auto& stats) { ... })
+ *          .on<"drain">([](auto& drain) { ... });
+ *      repl.execute("drain --timeout 5s");
+ *
+ * Between lines only the arguments assigned by the previous line are reset,
+ * and the line buffer and argv are reused, so a short command does not
+ * allocate. Values viewing the line, such as string_view arguments, are
+ * valid until the next execute. --help prints the help and returns to the
+ * loop instead of exiting.
+ */
+export template <class P>
+class Repl {
+ private:
+  P* parser_;
+  std::string program_name_;
+  std::string arena_;
+  std::vector<char*> argv_;
+  std::vector<std::function<bool()>> handlers_;
+  std::function<void(P&)> fallback_ = nullptr;
+
+ public:
+  explicit Repl(P& parser, std::string_view program_name = "")
+      : parser_(&parser), program_name_(program_name) {
+    this->parser_->exitOnHelp(false);
+    this->argv_.reserve(16);
+  }
+
+  /*!
+   * Call handler with sub parser Name when a line selects it
+   */
+  template <ArgName Name, class F>
+  auto on(F&& handler) -> Repl& {
+    auto& sub_parser = this->parser_->template getParser<Name>();
+    this->handlers_.emplace_back(
+        [&sub_parser, handler = std::forward<F>(handler)]() mutable {
+          if (!sub_parser) {
+            return false;
+          }
+          handler(sub_parser);
+          return true;
+        });
+    return *this;
+  }
+
+  /*!
+   * Call handler with the parser when no handled sub command was given
+   */
+  template <class F>
+  auto otherwise(F&& handler) -> Repl& {
+    this->fallback_ = std::forward<F>(handler);
+    return *this;
+  }
+
+  /*!
+   * Parse line with shell quoting and run its handler, returns false for a
+   * blank line. Parse errors are thrown as by parse, a line asking for help
+   * prints it and runs no handler
+   */
+  auto execute(std::string_view line) -> bool {
+    this->parser_->resetAssigned();
+    if (this->arena_.size() < line.size() + 1) {
+      this->arena_.resize(line.size() + 1);
+    }
+    this->argv_.assign(1, this->program_name_.data());
+    ShellSplit(line, this->arena_.data(), this->argv_);
+    if (this->argv_.size() == 1) {
+      return false;
+    }
+    auto argc = static_cast<int>(this->argv_.size());
+    this->argv_.push_back(nullptr);
+    try {
+      this->parser_->parse(argc, this->argv_.data());
+    } catch (const HelpRequested&) {
+      return true;
+    }
+
+    for (auto& handler : this->handlers_) {
+      if (handler()) {
+        return true;
+      }
+    }
+    if (this->fallback_) {
+      this->fallback_(*this->parser_);
+    }
+    return true;
+  }
+
+  /*!
+   * execute every line of in, errors are written to err and the loop goes on
+   */
+  auto run(std::istream& in, std::ostream& err) -> void {
+    auto line = std::string();
+    while (std::getline(in, line)) {
+      try {
+        this->execute(line);
+      } catch (const InvalidArgument& e) {
+        err << e.what() << '\n';
+      } catch (const ParseError& e) {
+        err << e.what() << '\n';
+      }
+    }
+  }
+};
+
+}  // namespace Argo
+
+// generator end here
@@ -0,0 +1,313 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Serialize;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :ArgName;
+import :Arg;
+import :MetaAssigner;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Spelling of T chosen by the compiler, stable within one build
+ */
+template <class T>
+consteval auto TypeSignature() -> std::string_view {
+  return std::source_location::current().function_name();
+}
+
+constexpr auto Fnv1a(std::uint64_t hash, std::string_view str)
+    -> std::uint64_t {
+  for (auto c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+/*!
+ * Hash of the names and value types of Args, in order
+ */
+template <class Args>
+consteval auto SchemaHash() -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  [&hash]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (..., (hash = Fnv1a(hash, std::tuple_element_t<Is, Args>::name.getKey()),
+           hash = Fnv1a(hash, "="),
+           hash = Fnv1a(hash, TypeSignature<typename std::tuple_element_t<
+                                  Is, Args>::type>()),
+           hash = Fnv1a(hash, ";")));
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  return hash;
+}
+
+struct SerialHeader {
+  std::array<char, 4> magic = {'A', 'R', 'G', 'O'};
+  std::uint32_t version = 1;
+  std::uint64_t schema = 0;
+  std::uint64_t size = 0;
+};
+
+class SerialWriter {
+ private:
+  std::vector<std::byte> buffer_;
+
+ public:
+  ARGO_ALWAYS_INLINE auto write(const void* data, std::size_t size) -> void {
+    const auto* ptr = static_cast<const std::byte*>(data);
+    this->buffer_.insert(this->buffer_.end(), ptr, ptr + size);
+  }
+
+  template <class T>
+    requires std::is_trivially_copyable_v<T>
+  ARGO_ALWAYS_INLINE auto write(const T& value) -> void {
+    this->write(&value, sizeof(T));
+  }
+
+  auto buffer() -> std::vector<std::byte>& {
+    return this->buffer_;
+  }
+};
+
+class SerialReader {
+ private:
+  std::span<const std::byte> buffer_;
+
+ public:
+  explicit SerialReader(std::span<const std::byte> buffer) : buffer_(buffer) {}
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto take(std::size_t size)
+      -> const std::byte* {
+    if (size > this->buffer_.size()) [[unlikely]] {
+      throw ParseError("Serialized arguments are truncated");
+    }
+    const auto* ret = this->buffer_.data();
+    this->buffer_ = this->buffer_.subspan(size);
+    return ret;
+  }
+
+  template <class T>
+    requires std::is_trivially_copyable_v<T>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto read() -> T {
+    T ret;
+    std::memcpy(&ret, this->take(sizeof(T)), sizeof(T));
+    return ret;
+  }
+
+  [[nodiscard]] auto rest() const -> std::span<const std::byte> {
+    return this->buffer_;
+  }
+};
+
+/*!
+ * Values whose bytes are the whole value, so they can be copied as is
+ * Pointers and views are trivially copyable too, but their bytes are
+ * addresses in the writing process.
+ */
+template <class T>
+struct is_pointer_free
+    : std::bool_constant<std::is_trivially_copyable_v<T> and
+                         !std::is_pointer_v<T> and
+                         !std::is_member_pointer_v<T> and
+                         !std::is_null_pointer_v<T>> {};
+
+template <class CharT, class Traits>
+struct is_pointer_free<std::basic_string_view<CharT, Traits>>
+    : std::false_type {};
+
+template <class T, std::size_t Extent>
+struct is_pointer_free<std::span<T, Extent>> : std::false_type {};
+
+template <class T, std::size_t N>
+struct is_pointer_free<std::array<T, N>> : is_pointer_free<T> {};
+
+template <class T>
+constexpr bool is_pointer_free_v = is_pointer_free<T>::value;
+
+/*!
+ * Elements stored as one block of bytes, vector<bool> is packed
+ */
+template <class T>
+constexpr bool is_flat_vector_v = is_vector_v<T> and
+                                  is_pointer_free_v<vector_base_t<T>> and
+                                  !std::is_same_v<vector_base_t<T>, bool>;
+
+/*!
+ * Whether every argument of Args can be serialized, LazyArgs views the argv
+ * of the writing process
+ */
+template <class Args>
+constexpr bool is_serializable_args_v = []<class... T>(type_sequence<T...>) {
+  return !(is_lazy_args_v<typename T::type> || ...);
+}(make_type_sequence_t<Args>());
+
+template <class T>
+auto Encode(SerialWriter& writer, const T& value) -> void {
+  if constexpr (is_lazy_args_v<T>) {
+    static_assert(false, "LazyArgs cannot be serialized, use std::vector");
+  } else if constexpr (std::is_same_v<T, std::string> or
+                std::is_same_v<T, std::string_view>) {
+    writer.write(static_cast<std::uint64_t>(value.size()));
+    writer.write(value.data(), value.size());
+  } else if constexpr (std::is_same_v<T, const char*>) {
+    // Length with the terminator, 0 is nullptr
+    auto size = value ? std::strlen(value) + 1 : 0;
+    writer.write(static_cast<std::uint64_t>(size));
+    writer.write(value, size);
+  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
+    Encode(writer, value.native());
+  } else if constexpr (is_pointer_free_v<T>) {
+    writer.write(value);
+  } else if constexpr (is_vector_v<T>) {
+    writer.write(static_cast<std::uint64_t>(value.size()));
+    if constexpr (is_flat_vector_v<T>) {
+      writer.write(value.data(), value.size() * sizeof(vector_base_t<T>));
+    } else {
+      for (const auto& elem : value) {
+        Encode(writer, elem);
+      }
+    }
+  } else if constexpr (is_map_v<T>) {
+    writer.write(static_cast<std::uint64_t>(value.size()));
+    for (const auto& [key, elem] : value) {
+      Encode(writer, key);
+      Encode(writer, elem);
+    }
+  } else if constexpr (is_tuple_v<T> or is_array_v<T>) {
+    std::apply(
+        [&writer](const auto&... elems) { (..., Encode(writer, elems)); },
+        value);
+  } else {
+    static_assert(false, "Argument type cannot be serialized");
+  }
+}
+
+/*!
+ * string_view and const char* values point into the buffer of reader
+ */
+template <class T>
+auto Decode(SerialReader& reader, T& value) -> void {
+  if constexpr (is_lazy_args_v<T>) {
+    static_assert(false, "LazyArgs cannot be serialized, use std::vector");
+  } else if constexpr (std::is_same_v<T, std::string> or
+                std::is_same_v<T, std::string_view>) {
+    auto size = reader.read<std::uint64_t>();
+    value = T(reinterpret_cast<const char*>(reader.take(size)), size);
+  } else if constexpr (std::is_same_v<T, const char*>) {
+    auto size = reader.read<std::uint64_t>();
+    const auto* ptr = reinterpret_cast<const char*>(reader.take(size));
+    if (size != 0 and ptr[size - 1] != '\0') [[unlikely]] {
+      throw ParseError("Serialized string is not terminated");
+    }
+    value = size == 0 ? nullptr : ptr;
+  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
+    auto str = std::filesystem::path::string_type();
+    Decode(reader, str);
+    value = std::move(str);
+  } else if constexpr (is_pointer_free_v<T>) {
+    value = reader.read<T>();
+  } else if constexpr (is_vector_v<T>) {
+    using Elem = vector_base_t<T>;
+    auto size = reader.read<std::uint64_t>();
+    if constexpr (is_flat_vector_v<T>) {
+      if (size > std::numeric_limits<std::size_t>::max() / sizeof(Elem))
+          [[unlikely]] {
+        throw ParseError("Serialized arguments are truncated");
+      }
+      const auto* ptr = reader.take(size * sizeof(Elem));
+      value.resize(size);
+      std::memcpy(value.data(), ptr, size * sizeof(Elem));
+    } else {
+      value.clear();
+      // Every element takes at least one byte
+      value.reserve(std::min<std::uint64_t>(size, reader.rest().size()));
+      for (std::uint64_t i = 0; i < size; i++) {
+        auto elem = Elem();
+        Decode(reader, elem);
+        value.push_back(std::move(elem));
+      }
+    }
+  } else if constexpr (is_map_v<T>) {
+    auto size = reader.read<std::uint64_t>();
+    value.clear();
+    for (std::uint64_t i = 0; i < size; i++) {
+      auto key = typename T::key_type();
+      auto elem = typename T::mapped_type();
+      Decode(reader, key);
+      Decode(reader, elem);
+      value.emplace_hint(value.end(), std::move(key), std::move(elem));
+    }
+  } else if constexpr (is_tuple_v<T> or is_array_v<T>) {
+    std::apply([&reader](auto&... elems) { (..., Decode(reader, elems)); },
+               value);
+  } else {
+    static_assert(false, "Argument type cannot be serialized");
+  }
+}
+
+/*!
+ * Header, then assigned, source and value of every argument in order
+ */
+template <class Args>
+auto SerializeArgs() -> std::vector<std::byte> {
+  auto writer = SerialWriter();
+  writer.write(SerialHeader());
+  tuple_type_visit<Args>([&writer]<class T>(T) {
+    writer.write(static_cast<std::uint8_t>(T::type::assigned));
+    writer.write(static_cast<std::uint8_t>(T::type::source));
+    Encode(writer, T::type::value);
+  });
+  auto& buffer = writer.buffer();
+  const auto header = SerialHeader{
+      .schema = SchemaHash<Args>(),
+      .size = buffer.size() - sizeof(SerialHeader),
+  };
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  return std::move(buffer);
+}
+
+/*!
+ * Arguments are written only after the whole buffer decoded
+ */
+template <class Args>
+auto DeserializeArgs(std::span<const std::byte> buffer) -> void {
+  auto reader = SerialReader(buffer);
+  auto header = reader.read<SerialHeader>();
+  if (header.magic != SerialHeader().magic or
+      header.version != SerialHeader().version) [[unlikely]] {
+    throw ParseError("Not serialized arguments");
+  }
+  if (header.schema != SchemaHash<Args>()) [[unlikely]] {
+    throw ParseError("Serialized arguments were written by another schema");
+  }
+  if (header.size != buffer.size() - sizeof(SerialHeader)) [[unlikely]] {
+    throw ParseError("Serialized arguments are truncated");
+  }
+  [&reader]<std::size_t... Is>(std::index_sequence<Is...>) {
+    auto assigned = std::array<bool, sizeof...(Is)>{};
+    auto sources = std::array<ValueSource, sizeof...(Is)>{};
+    auto values =
+        std::tuple<typename std::tuple_element_t<Is, Args>::type...>();
+    (..., (assigned[Is] = reader.read<std::uint8_t>() != 0,
+           sources[Is] = static_cast<ValueSource>(reader.read<std::uint8_t>()),
+           Decode(reader, std::get<Is>(values))));
+    (..., (std::tuple_element_t<Is, Args>::assigned = false,
+           assigned[Is] ? MarkAssigned<std::tuple_element_t<Is, Args>>()
+                        : void(),
+           std::tuple_element_t<Is, Args>::source = sources[Is],
+           std::tuple_element_t<Is, Args>::value =
+               std::move(std::get<Is>(values))));
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+}
+
+}  // namespace Argo
+
+// generator end here
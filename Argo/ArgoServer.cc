@@ -0,0 +1,585 @@
+module;
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Server;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :ArgName;
+import :Parser;
+import :ParserImpl;
+import :Serialize;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Sent by the client with its stdin, stdout and stderr attached, followed by
+ * size bytes of the null terminated cwd and argc arguments. The server
+ * replies with the exit status as a std::int32_t, or server_schema_mismatch
+ * when schema is not the one of its parser.
+ */
+struct ServerRequest {
+  static constexpr std::uint32_t current_magic = 0x4152'4732;  // "ARG2"
+
+  std::uint32_t magic = current_magic;
+  std::uint32_t argc = 0;
+  std::uint64_t size = 0;
+  std::uint64_t schema = 0;
+};
+
+// Never an exit status, those are 0 to 255 or 128 + signal
+constexpr std::int32_t server_schema_mismatch =
+    std::numeric_limits<std::int32_t>::min();
+
+template <class P>
+struct ServerSchemaOf;
+
+template <class S>
+using sub_parser_t = typename decltype(S::parser)::type;
+
+/*!
+ * SchemaHash of the arguments of the parser and of every sub parser, with
+ * the sub command names
+ */
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+struct ServerSchemaOf<Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>> {
+  static consteval auto get() -> std::uint64_t {
+    auto hash = SchemaHash<decltype(std::tuple_cat(std::declval<Args>(),
+                                                   std::declval<PArgs>()))>();
+    [&hash]<class... S>(type_sequence<S...>) {
+      (..., (hash = Fnv1a(hash, S::name.getKey()),
+             hash = (std::rotl(hash, 5) ^
+                     ServerSchemaOf<sub_parser_t<S>>::get()) *
+                    0x9e3779b97f4a7c15));
+    }(make_type_sequence_t<SubParsers>());
+    return hash;
+  }
+};
+
+/*!
+ * Identity of the options P parses, sent by forwardToServer<P> and checked
+ * by Server<P>
+ */
+export template <class P>
+constexpr std::uint64_t server_schema =
+    ServerSchemaOf<std::remove_cvref_t<P>>::get();
+
+[[noreturn]] inline auto ServerFail(std::string_view what, int err) -> void {
+  throw InvalidArgument(
+      std::format("{}: {}", what, std::system_category().message(err)));
+}
+
+// A closed peer is an error, not SIGPIPE. Elsewhere the socket has
+// SO_NOSIGPIPE set by ServerSocket
+#ifdef MSG_NOSIGNAL
+constexpr int server_send_flags = MSG_NOSIGNAL;
+#else
+constexpr int server_send_flags = 0;
+#endif
+
+/*!
+ * Mark fd close on exec and, where MSG_NOSIGNAL is missing, not raising
+ * SIGPIPE, for sockets made without SOCK_CLOEXEC
+ */
+inline auto ServerSocketFlags(int fd) -> void {
+  ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+inline auto ServerSocket() -> int {
+#ifdef __linux__
+  return ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd >= 0) {
+    ServerSocketFlags(fd);
+  }
+  return fd;
+#endif
+}
+
+inline auto ServerAccept(int listen_fd) -> int {
+#ifdef __linux__
+  return ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+  auto fd = ::accept(listen_fd, nullptr, nullptr);
+  if (fd >= 0) {
+    ServerSocketFlags(fd);
+  }
+  return fd;
+#endif
+}
+
+/*!
+ * User id of the process at the other end of the Unix socket conn
+ */
+inline auto PeerUid(int conn) -> std::optional<::uid_t> {
+#ifdef __linux__
+  auto cred = ::ucred{};
+  auto cred_len = static_cast<::socklen_t>(sizeof(cred));
+  if (::getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0) {
+    return std::nullopt;
+  }
+  return cred.uid;
+#else
+  auto uid = ::uid_t();
+  auto gid = ::gid_t();
+  if (::getpeereid(conn, &uid, &gid) != 0) {
+    return std::nullopt;
+  }
+  return uid;
+#endif
+}
+
+inline auto WriteAll(int fd, const void* data, std::size_t size) -> bool {
+  const auto* ptr = static_cast<const char*>(data);
+  while (size != 0) {
+    auto len = ::send(fd, ptr, size, server_send_flags);
+    if (len < 0 and errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      return false;
+    }
+    ptr += len;
+    size -= static_cast<std::size_t>(len);
+  }
+  return true;
+}
+
+inline auto ReadAll(int fd, void* data, std::size_t size) -> bool {
+  auto* ptr = static_cast<char*>(data);
+  while (size != 0) {
+    auto len = ::read(fd, ptr, size);
+    if (len < 0 and errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      return false;
+    }
+    ptr += len;
+    size -= static_cast<std::size_t>(len);
+  }
+  return true;
+}
+
+inline auto SocketAddress(std::string_view path) -> ::sockaddr_un {
+  auto addr = ::sockaddr_un{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) [[unlikely]] {
+    throw InvalidArgument(std::format("Socket path {} is too long", path));
+  }
+  std::memcpy(addr.sun_path, path.data(), path.size());
+  return addr;
+}
+
+/*!
+ * Run argv on the server listening at socket_path, with the stdio and the
+ * working directory of this process, and return its exit status
+ * std::nullopt when no server is listening or the server parses with another
+ * schema, a daemon left running by an older build, so the caller can run the
+ * command itself:
+ *      int main(int argc, char* argv[]) {
+ *        if (auto status = Argo::forwardToServer(path, argc, argv, schema)) {
+ *          return *status;
+ *        }
+ *        ...  // initialize and parse in process
+ *      }
+ *
+ * This needs no parser, a client can be a few kilobytes. schema is
+ * server_schema of the parser type, see the overload taking it.
+ */
+export inline auto forwardToServer(std::string_view socket_path, int argc,
+                                   char* argv[], std::uint64_t schema)
+    -> std::optional<int> {
+  auto addr = SocketAddress(socket_path);
+  auto fd = ServerSocket();
+  if (fd < 0) [[unlikely]] {
+    ServerFail("Cannot create socket", errno);
+  }
+  if (::connect(fd, reinterpret_cast<const ::sockaddr*>(&addr),
+                sizeof(addr)) != 0) {
+    auto err = errno;
+    ::close(fd);
+    if (err == ENOENT or err == ECONNREFUSED) {
+      return std::nullopt;
+    }
+    ServerFail(std::format("Cannot connect to {}", socket_path), err);
+  }
+
+  auto payload = std::filesystem::current_path().native();
+  payload.push_back('\0');
+  for (int i = 0; i < argc; i++) {
+    payload.append(argv[i]);
+    payload.push_back('\0');
+  }
+  auto request = ServerRequest{.argc = static_cast<std::uint32_t>(argc),
+                               .size = payload.size(),
+                               .schema = schema};
+
+  // stdin, stdout and stderr go with the header
+  int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+  alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+  auto iov = ::iovec{.iov_base = &request, .iov_len = sizeof(request)};
+  auto msg = ::msghdr{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ::ssize_t sent = 0;
+  while ((sent = ::sendmsg(fd, &msg, server_send_flags)) < 0 and
+         errno == EINTR) {
+  }
+  if (sent != static_cast<::ssize_t>(sizeof(request)) or
+      !WriteAll(fd, payload.data(), payload.size())) [[unlikely]] {
+    auto err = errno;
+    ::close(fd);
+    ServerFail(std::format("Cannot send to {}", socket_path), err);
+  }
+
+  auto status = std::int32_t();
+  auto received = ReadAll(fd, &status, sizeof(status));
+  ::close(fd);
+  if (!received) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Server {} closed the connection", socket_path));
+  }
+  if (status == server_schema_mismatch) [[unlikely]] {
+    return std::nullopt;
+  }
+  return status;
+}
+
+/*!
+ * forwardToServer with the schema of the parser type P, the parser itself
+ * is never built
+ */
+export template <class P>
+auto forwardToServer(std::string_view socket_path, int argc, char* argv[])
+    -> std::optional<int> {
+  return forwardToServer(socket_path, argc, argv, server_schema<P>);
+}
+
+/*!
+ * Exit status of handler, 0 when it returns void
+ */
+template <class F, class... A>
+auto InvokeForStatus(F& handler, A&... args) -> int {
+  if constexpr (std::is_void_v<std::invoke_result_t<F&, A&...>>) {
+    handler(args...);
+    return 0;
+  } else {
+    return static_cast<int>(handler(args...));
+  }
+}
+
+/*!
+ * Daemon running command lines forwarded by forwardToServer with a parser
+ * initialized once
+ * Example:
+ *      auto models = loadModels();  // slow, done once
+ *      auto server = Argo::Server(parser, "/run/user/1000/analyze.sock");
+ *      server.on<"classify">([&](auto& p) { return classify(models, p); })
+ *            .on<"stats">([&](auto& p) { ... });
+ *      server.serve();
+ *
+ * Every request runs in a process forked from the server, with the stdio
+ * and working directory of the client, so the state built before serve is
+ * shared copy on write and each request starts from it. The child parses
+ * argv and calls the handler of the sub command found, whose return value is
+ * the exit status. Parsing and errors are those of the same program run
+ * directly: --help prints to the client and exits with 0, an uncaught parse
+ * error is printed and the client gets 128 + SIGABRT. The child leaves
+ * through _exit, so the atexit handlers and static destructors of the server
+ * never run in it. The environment is the one of the server.
+ *
+ * Only the user running the server may connect, and only with the
+ * server_schema of P: a client built with other options is refused and
+ * parses in process.
+ */
+export template <class P>
+class Server {
+ private:
+  P* parser_;
+  std::string path_;
+  int listen_fd_ = -1;
+  std::vector<::pid_t> children_;
+  std::vector<std::function<std::optional<int>()>> handlers_;
+  std::function<int(P&)> fallback_ = nullptr;
+
+  /*!
+   * Reap the connection processes which have finished
+   */
+  auto reap() -> void {
+    std::erase_if(this->children_, [](::pid_t pid) {
+      return ::waitpid(pid, nullptr, WNOHANG) != 0;
+    });
+  }
+
+  /*!
+   * Parse and dispatch, in the request process
+   */
+  auto run(int argc, char* argv[]) -> int {
+    this->parser_->parse(argc, argv);
+    for (auto& handler : this->handlers_) {
+      if (auto status = handler()) {
+        return *status;
+      }
+    }
+    if (this->fallback_) {
+      return this->fallback_(*this->parser_);
+    }
+    return 0;
+  }
+
+  /*!
+   * run and leave the request process with its status. It ends with _exit,
+   * exit would run the atexit handlers and static destructors of the server,
+   * and an error nobody caught is reported and aborts like terminate does
+   */
+  [[noreturn]] auto runAndExit(int argc, char* argv[]) noexcept -> void {
+    auto status = 0;
+    auto uncaught = false;
+    try {
+      status = this->run(argc, argv);
+    } catch (const HelpRequested&) {
+      status = 0;
+    } catch (const std::exception& e) {
+      std::cerr << std::format(
+          "terminate called after throwing an exception\n  what():  {}\n",
+          e.what());
+      uncaught = true;
+    } catch (...) {
+      std::cerr << "terminate called after throwing an exception\n";
+      uncaught = true;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    if (uncaught) {
+      // Raises SIGABRT without running exit handlers
+      std::abort();
+    }
+    ::_exit(status);
+  }
+
+  /*!
+   * Receive the request on conn, run it in a child and send back its exit
+   * status. Runs in a process forked for the connection and never returns
+   */
+  [[noreturn]] auto handle(int conn) noexcept -> void {
+    auto request = ServerRequest();
+    int fds[3] = {-1, -1, -1};
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    auto iov = ::iovec{.iov_base = &request, .iov_len = sizeof(request)};
+    auto msg = ::msghdr{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    // Without MSG_CMSG_CLOEXEC the received fds are dup2'ed onto stdio and
+    // closed by the request process before anything can exec
+#ifdef MSG_CMSG_CLOEXEC
+    constexpr int recv_flags = MSG_CMSG_CLOEXEC;
+#else
+    constexpr int recv_flags = 0;
+#endif
+    ::ssize_t len = 0;
+    while ((len = ::recvmsg(conn, &msg, recv_flags)) < 0 and errno == EINTR) {
+    }
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    if (len != static_cast<::ssize_t>(sizeof(request)) or
+        request.magic != ServerRequest::current_magic or cmsg == nullptr or
+        cmsg->cmsg_type != SCM_RIGHTS or
+        cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) [[unlikely]] {
+      ::_exit(1);
+    }
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+    auto payload = std::string(request.size, '\0');
+    if (!ReadAll(conn, payload.data(), payload.size()) or
+        static_cast<std::size_t>(std::ranges::count(payload, '\0')) !=
+            request.argc + 1) [[unlikely]] {
+      ::_exit(1);
+    }
+    if (request.schema != server_schema<P>) [[unlikely]] {
+      auto status = server_schema_mismatch;
+      WriteAll(conn, &status, sizeof(status));
+      ::_exit(0);
+    }
+    auto argv = std::vector<char*>();
+    argv.reserve(request.argc + 1);
+    auto* cwd = payload.data();
+    for (auto* arg = cwd + std::strlen(cwd) + 1;
+         argv.size() < request.argc; arg += std::strlen(arg) + 1) {
+      argv.push_back(arg);
+    }
+    argv.push_back(nullptr);
+
+    auto pid = ::fork();
+    if (pid == 0) {
+      ::close(conn);
+      for (int i = 0; i < 3; i++) {
+        ::dup2(fds[i], i);
+        ::close(fds[i]);
+      }
+      if (::chdir(cwd) != 0) [[unlikely]] {
+        std::cerr << std::format("Cannot change directory to {}: {}\n", cwd,
+                                 std::system_category().message(errno));
+        ::_exit(1);
+      }
+      this->runAndExit(static_cast<int>(request.argc), argv.data());
+    }
+    for (auto fd : fds) {
+      ::close(fd);
+    }
+
+    auto status = std::int32_t(1);
+    auto wstatus = 0;
+    while (pid > 0 and ::waitpid(pid, &wstatus, 0) < 0 and errno == EINTR) {
+    }
+    if (pid > 0 and WIFEXITED(wstatus)) {
+      status = WEXITSTATUS(wstatus);
+    } else if (pid > 0 and WIFSIGNALED(wstatus)) {
+      status = 128 + WTERMSIG(wstatus);
+    }
+    WriteAll(conn, &status, sizeof(status));
+    ::_exit(0);
+  }
+
+ public:
+  /*!
+   * Listen on socket_path, replacing a socket left by an earlier server
+   * --help of parser throws HelpRequested from now on, see exitOnHelp
+   */
+  Server(P& parser, std::string_view socket_path)
+      : parser_(&parser), path_(socket_path) {
+    parser.exitOnHelp(false);
+    auto addr = SocketAddress(socket_path);
+    struct ::stat st {};
+    if (::lstat(this->path_.c_str(), &st) == 0 and S_ISSOCK(st.st_mode)) {
+      ::unlink(this->path_.c_str());
+    }
+    this->listen_fd_ = ServerSocket();
+    if (this->listen_fd_ < 0) [[unlikely]] {
+      ServerFail("Cannot create socket", errno);
+    }
+    if (::bind(this->listen_fd_, reinterpret_cast<const ::sockaddr*>(&addr),
+               sizeof(addr)) != 0 or
+        ::chmod(this->path_.c_str(), S_IRUSR | S_IWUSR) != 0 or
+        ::listen(this->listen_fd_, SOMAXCONN) != 0) [[unlikely]] {
+      auto err = errno;
+      ::close(this->listen_fd_);
+      ServerFail(std::format("Cannot listen on {}", socket_path), err);
+    }
+  }
+
+  Server(const Server&) = delete;
+  Server(Server&&) = delete;
+  auto operator=(const Server&) -> Server& = delete;
+  auto operator=(Server&&) -> Server& = delete;
+
+  ~Server() {
+    ::close(this->listen_fd_);
+    ::unlink(this->path_.c_str());
+    this->reap();
+  }
+
+  /*!
+   * Call handler with sub parser Name when a request selects it, its return
+   * value is the exit status
+   */
+  template <ArgName Name, class F>
+  auto on(F&& handler) -> Server& {
+    auto& sub_parser = this->parser_->template getParser<Name>();
+    this->handlers_.emplace_back(
+        [&sub_parser, handler = std::forward<F>(handler)]() mutable
+        -> std::optional<int> {
+          if (!sub_parser) {
+            return std::nullopt;
+          }
+          return InvokeForStatus(handler, sub_parser);
+        });
+    return *this;
+  }
+
+  /*!
+   * Call handler with the parser when no handled sub command was given
+   */
+  template <class F>
+  auto otherwise(F&& handler) -> Server& {
+    this->fallback_ = [handler = std::forward<F>(handler)](P& parser) mutable {
+      return InvokeForStatus(handler, parser);
+    };
+    return *this;
+  }
+
+  /*!
+   * Accept one request and start it, without waiting for it to finish
+   */
+  auto serveOne() -> void {
+    this->reap();
+    auto conn = -1;
+    while ((conn = ServerAccept(this->listen_fd_)) < 0 and errno == EINTR) {
+    }
+    if (conn < 0) [[unlikely]] {
+      ServerFail(std::format("Cannot accept on {}", this->path_), errno);
+    }
+    if (PeerUid(conn) != ::getuid()) [[unlikely]] {
+      ::close(conn);
+      return;
+    }
+    // Buffered output would be written again by the child
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    auto pid = ::fork();
+    if (pid == 0) {
+      ::close(this->listen_fd_);
+      this->handle(conn);
+    }
+    ::close(conn);
+    if (pid < 0) [[unlikely]] {
+      ServerFail("Cannot fork", errno);
+    }
+    this->children_.push_back(pid);
+  }
+
+  /*!
+   * serveOne forever
+   */
+  [[noreturn]] auto serve() -> void {
+    while (true) {
+      this->serveOne();
+    }
+  }
+};
+
+}  // namespace Argo
+
+// generator end here
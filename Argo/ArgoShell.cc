@@ -0,0 +1,138 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Shell;
+
+import std;
+
+import :Exceptions;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Position of the first of Cs in str from pos, or str.size()
+ * Eight bytes are tested at once, a byte equal to c becomes zero after the
+ * xor and (x - 0x01..) & ~x & 0x80.. sets its high bit. Bytes above a match
+ * can be set by the borrow, the lowest set bit is always a real match.
+ */
+template <char... Cs>
+ARGO_ALWAYS_INLINE constexpr auto FindAny(std::string_view str,
+                                          std::size_t pos) -> std::size_t {
+  constexpr std::uint64_t ones = 0x0101010101010101;
+  constexpr std::uint64_t highs = 0x8080808080808080;
+  if !consteval {
+    for (; pos + sizeof(std::uint64_t) <= str.size();
+         pos += sizeof(std::uint64_t)) {
+      std::uint64_t word = 0;
+      std::memcpy(&word, str.data() + pos, sizeof(word));
+      if constexpr (std::endian::native == std::endian::big) {
+        word = std::byteswap(word);
+      }
+      auto mask = (... | [word] {
+        auto x = word ^ (ones * static_cast<unsigned char>(Cs));
+        return (x - ones) & ~x & highs;
+      }());
+      if (mask != 0) {
+        return pos + (std::countr_zero(mask) / 8);
+      }
+    }
+  }
+  for (; pos < str.size(); pos++) {
+    if (((str[pos] == Cs) or ...)) {
+      return pos;
+    }
+  }
+  return str.size();
+}
+
+ARGO_ALWAYS_INLINE constexpr auto IsShellSpace(char c) -> bool {
+  return c == ' ' or c == '\t' or c == '\n';
+}
+
+/*!
+ * Split line with POSIX shell quoting: 'single' quotes are literal, "double"
+ * quotes keep backslash escapes of $ ` " \ and newline, a backslash outside
+ * quotes escapes any character. There is no expansion of any kind.
+ *
+ * Tokens are written unescaped and null terminated to arena, which needs
+ * line.size() + 1 bytes: a token never grows and its terminator takes the
+ * place of the separator after it. A pointer to every token is appended to
+ * argv.
+ */
+inline auto ShellSplit(std::string_view line, char* arena,
+                       std::vector<char*>& argv) -> void {
+  auto* out = arena;
+  std::size_t pos = 0;
+  auto copy = [&out, line](std::size_t from, std::size_t to) {
+    std::memcpy(out, line.data() + from, to - from);
+    out += to - from;
+  };
+
+  while (true) {
+    while (pos < line.size() and IsShellSpace(line[pos])) {
+      pos++;
+    }
+    if (pos == line.size()) {
+      return;
+    }
+    argv.push_back(out);
+
+    while (pos < line.size() and !IsShellSpace(line[pos])) {
+      auto next = FindAny<' ', '\t', '\n', '\'', '"', '\\'>(line, pos);
+      copy(pos, next);
+      pos = next;
+      if (pos == line.size() or IsShellSpace(line[pos])) {
+        break;
+      }
+      if (line[pos] == '\\') {
+        if (pos + 1 == line.size()) {
+          *out++ = '\\';
+        } else if (line[pos + 1] != '\n') {
+          // A backslash before a newline continues the line
+          *out++ = line[pos + 1];
+        }
+        pos = std::min(pos + 2, line.size());
+      } else if (line[pos] == '\'') {
+        auto end = FindAny<'\''>(line, pos + 1);
+        if (end == line.size()) [[unlikely]] {
+          throw ParseError(std::format("Unterminated quote at {}", pos));
+        }
+        copy(pos + 1, end);
+        pos = end + 1;
+      } else {
+        auto start = pos;
+        pos++;
+        while (true) {
+          auto end = FindAny<'"', '\\'>(line, pos);
+          if (end == line.size()) [[unlikely]] {
+            throw ParseError(std::format("Unterminated quote at {}", start));
+          }
+          copy(pos, end);
+          pos = end + 1;
+          if (line[end] == '"') {
+            break;
+          }
+          if (pos == line.size()) [[unlikely]] {
+            throw ParseError(std::format("Unterminated quote at {}", start));
+          }
+          auto c = line[pos];
+          if (c == '$' or c == '`' or c == '"' or c == '\\') {
+            *out++ = c;
+          } else if (c != '\n') {
+            *out++ = '\\';
+            *out++ = c;
+          }
+          pos++;
+        }
+      }
+    }
+    *out++ = '\0';
+  }
+}
+
+}  // namespace Argo
+
+// generator end here
@@ -0,0 +1,144 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Snapshot;
+
+import std;
+
+import :ArgName;
+import :Arg;
+import :MetaLookup;
+import :Config;
+
+// generator start here
+
+namespace Argo {
+
+inline constexpr std::size_t cache_line_size = 64;
+
+/*!
+ * Offsets of every argument value in one block, fixed at compile time
+ */
+template <class Args>
+struct SnapshotLayout;
+
+template <class... T>
+struct SnapshotLayout<std::tuple<T...>> {
+  static constexpr std::size_t align =
+      std::max({cache_line_size, alignof(typename T::type)...});
+
+  static constexpr auto offsets = [] {
+    auto ret = std::array<std::size_t, sizeof...(T)>{};
+    std::size_t offset = 0;
+    std::size_t i = 0;
+    (..., (offset = (offset + alignof(typename T::type) - 1) /
+                    alignof(typename T::type) * alignof(typename T::type),
+           ret[i++] = offset, offset += sizeof(typename T::type)));
+    return ret;
+  }();
+
+  // Rounded up so that nothing else shares the last cache line
+  static constexpr std::size_t size = [] {
+    std::size_t end = 0;
+    std::size_t i = 0;
+    (..., (end = offsets[i++] + sizeof(typename T::type)));
+    return (end + align - 1) / align * align;
+  }();
+};
+
+/*!
+ * Immutable copy of every argument value, taken by Parser::freeze
+ * Example:
+ *      const auto config = parser.freeze();
+ *      config.get<"threads">();
+ *
+ * Values live in one cache line aligned block at compile time offsets and are
+ * never written after construction, so a snapshot can be read from any number
+ * of threads. Copying a snapshot copies every value, a copy made on a thread
+ * of another NUMA node gets memory local to it. Strings read from config
+ * files are shared between copies.
+ */
+export template <class Args>
+class alignas(SnapshotLayout<Args>::align) Snapshot {
+ private:
+  using Layout = SnapshotLayout<Args>;
+  static constexpr auto count = std::tuple_size_v<Args>;
+
+  template <std::size_t I>
+  using ValueType = typename std::tuple_element_t<I, Args>::type;
+
+  alignas(Layout::align) std::array<std::byte, Layout::size> data_;
+  std::array<ValueSource, count> sources_{};
+  std::shared_ptr<const ConfigStorage> storage_;
+
+  template <std::size_t I>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto at() const -> const ValueType<I>& {
+    return *std::launder(reinterpret_cast<const ValueType<I>*>(
+        this->data_.data() + Layout::offsets[I]));
+  }
+
+  template <std::size_t I>
+  ARGO_ALWAYS_INLINE auto construct(const ValueType<I>& value) -> void {
+    auto* ptr = this->data_.data() + Layout::offsets[I];
+    std::construct_at(reinterpret_cast<ValueType<I>*>(ptr), value);
+  }
+
+ public:
+  /*!
+   * Copy the values of From, which has the same names and types as Args
+   */
+  template <class From>
+  Snapshot(std::type_identity<From> /* unused */,
+           std::shared_ptr<const ConfigStorage> storage)
+      : storage_(std::move(storage)) {
+    static_assert(std::tuple_size_v<From> == count);
+    [this]<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
+      (..., (this->template construct<Is>(
+                 std::tuple_element_t<Is, From>::value),
+             this->sources_[Is] = std::tuple_element_t<Is, From>::source));
+    }(std::make_index_sequence<count>());
+  }
+
+  Snapshot(const Snapshot& other)
+      : sources_(other.sources_), storage_(other.storage_) {
+    [this, &other]<std::size_t... Is>(std::index_sequence<Is...>)
+        ARGO_ALWAYS_INLINE {
+          (..., this->template construct<Is>(other.template at<Is>()));
+        }(std::make_index_sequence<count>());
+  }
+
+  auto operator=(const Snapshot&) -> Snapshot& = delete;
+  auto operator=(Snapshot&&) -> Snapshot& = delete;
+
+  ~Snapshot() {
+    [this]<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
+      (..., std::destroy_at(&this->template at<Is>()));
+    }(std::make_index_sequence<count>());
+  }
+
+  template <ArgName Name>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto get() const -> const auto& {
+    static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+    return this->template at<SearchIndex<Args, Name>()>();
+  }
+
+  template <ArgName Name>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto getSource() const -> ValueSource {
+    static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+    return this->sources_[SearchIndex<Args, Name>()];
+  }
+
+  /*!
+   * Byte offset of the value in the block
+   */
+  template <ArgName Name>
+  static consteval auto offsetOf() -> std::size_t {
+    static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+    return Layout::offsets[SearchIndex<Args, Name>()];
+  }
+};
+
+}  // namespace Argo
+
+// generator end here
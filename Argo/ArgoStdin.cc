@@ -0,0 +1,225 @@
+module;
+
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Stdin;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :Arg;
+import :MetaLookup;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Tokens read from a file descriptor, delimited by '\0' like xargs -0 or by
+ * '\n', as an input range
+ * Example:
+ *      for (auto file : Argo::TokenReader(STDIN_FILENO, '\n')) { ... }
+ *
+ * The input is read in large chunks into an arena owned by the reader and
+ * only as far as the tokens taken so far need, so work can start before the
+ * writer is done. Tokens are views into the arena, null terminated, and stay
+ * valid as long as the reader. A token cut by the end of a chunk is moved to
+ * the start of the next one, nothing else is copied.
+ */
+export class TokenReader {
+ private:
+  static constexpr std::size_t chunk_size = std::size_t(1) << 16;
+
+  int fd_ = STDIN_FILENO;
+  char delimiter_ = '\0';
+  bool eof_ = false;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  // Unread part of the last chunk is [begin_, end_), it ends at limit_
+  char* begin_ = nullptr;
+  char* end_ = nullptr;
+  char* limit_ = nullptr;
+
+  /*!
+   * Start a new chunk holding the unfinished token and room for at least
+   * as much again
+   */
+  auto grow() -> void {
+    auto pending = static_cast<std::size_t>(this->end_ - this->begin_);
+    auto size = std::max(chunk_size, pending * 2 + 1);
+    auto& chunk = this->chunks_.emplace_back(
+        std::make_unique_for_overwrite<char[]>(size));
+    if (pending != 0) {
+      std::memcpy(chunk.get(), this->begin_, pending);
+    }
+    this->begin_ = chunk.get();
+    this->end_ = chunk.get() + pending;
+    this->limit_ = chunk.get() + size;
+  }
+
+  auto fill() -> void {
+    if (this->end_ == this->limit_) {
+      this->grow();
+    }
+    while (true) {
+      auto len = ::read(this->fd_, this->end_,
+                        static_cast<std::size_t>(this->limit_ - this->end_));
+      if (len > 0) {
+        this->end_ += len;
+        return;
+      }
+      if (len == 0) {
+        this->eof_ = true;
+        return;
+      }
+      if (errno != EINTR) [[unlikely]] {
+        throw ParseError(std::format("Cannot read arguments: {}",
+                                     std::system_category().message(errno)));
+      }
+    }
+  }
+
+ public:
+  class Iterator {
+   private:
+    TokenReader* reader_ = nullptr;
+    std::optional<std::string_view> token_;
+
+   public:
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    explicit Iterator(TokenReader* reader)
+        : reader_(reader), token_(reader->next()) {}
+
+    auto operator*() const -> std::string_view {
+      return *this->token_;
+    }
+
+    auto operator++() -> Iterator& {
+      this->token_ = this->reader_->next();
+      return *this;
+    }
+
+    auto operator++(int) -> void {
+      ++*this;
+    }
+
+    auto operator==(std::default_sentinel_t /* unused */) const -> bool {
+      return !this->token_.has_value();
+    }
+  };
+
+  explicit TokenReader(int fd = STDIN_FILENO, char delimiter = '\0')
+      : fd_(fd), delimiter_(delimiter) {}
+
+  TokenReader(const TokenReader&) = delete;
+  TokenReader(TokenReader&&) = default;
+  auto operator=(const TokenReader&) -> TokenReader& = delete;
+  auto operator=(TokenReader&&) -> TokenReader& = default;
+  ~TokenReader() = default;
+
+  /*!
+   * Next token, std::nullopt at the end of the input
+   * The last token does not need a delimiter after it.
+   */
+  auto next() -> std::optional<std::string_view> {
+    while (true) {
+      auto size = static_cast<std::size_t>(this->end_ - this->begin_);
+      auto* found =
+          size == 0 ? nullptr
+                    : static_cast<char*>(
+                          std::memchr(this->begin_, this->delimiter_, size));
+      if (found != nullptr) {
+        *found = '\0';
+        auto token = std::string_view(this->begin_, found);
+        this->begin_ = found + 1;
+        return token;
+      }
+      if (this->eof_) {
+        if (size == 0) {
+          return std::nullopt;
+        }
+        if (this->end_ == this->limit_) {
+          // Room for the terminator
+          this->grow();
+        }
+        *this->end_ = '\0';
+        auto token = std::string_view(this->begin_, this->end_);
+        this->begin_ = this->end_;
+        return token;
+      }
+      this->fill();
+    }
+  }
+
+  [[nodiscard]] auto begin() -> Iterator {
+    return Iterator(this);
+  }
+
+  [[nodiscard]] auto end() const -> std::default_sentinel_t {
+    return {};
+  }
+};
+
+/*!
+ * Position of "--args-from-stdin", or of a "-" taking the place of a
+ * positional argument, in argv[1, end). -1 when there is none
+ * A "-" an option takes as its value, as in --output -, is left alone.
+ */
+template <class Args>
+constexpr auto StdinArgIndex(int end, char* argv[]) -> int {
+  // Values the current option still takes, -1 for any number
+  auto pending = 0;
+  for (int i = 1; i < end; i++) {
+    auto arg = std::string_view(argv[i]);
+    if (arg == "--args-from-stdin") [[unlikely]] {
+      return i;
+    }
+    auto is_flag = arg.size() > 1 and arg[0] == '-';
+    if (is_flag and arg[1] >= '0' and arg[1] <= '9') {
+      is_flag = IsFlag<Args>(arg[1]);
+    }
+    if (!is_flag) {
+      if (arg == "-" and pending == 0) [[unlikely]] {
+        return i;
+      }
+      pending -= (pending > 0) ? 1 : 0;
+      continue;
+    }
+    if (arg[1] == '-') {
+      auto equal_pos = arg.find('=');
+      pending = ValueCount<Args>(arg.substr(2, equal_pos - 2));
+      if (equal_pos != std::string_view::npos and pending > 0) {
+        pending--;
+      }
+      continue;
+    }
+    // -abc: flags up to the first key taking a value, the rest is its value
+    pending = 0;
+    for (std::size_t j = 1; j < arg.size(); j++) {
+      if (!IsFlag<Args>(arg[j])) {
+        pending = -1;
+        break;
+      }
+      auto [key, is_flag_key] = GetkeyFromShortKey<Args>(arg[j]);
+      if (!is_flag_key) {
+        pending = ValueCount<Args>(key);
+        if (j + 1 != arg.size() and pending > 0) {
+          pending--;
+        }
+        break;
+      }
+    }
+  }
+  return -1;
+}
+
+}  // namespace Argo
+
+// generator end here
@@ -37,9 +37,35 @@ struct vector_base<std::vector<T>> {
   using type = T;
 };
 
+/*!
+ * Base of argument types whose value is a view over the command line
+ */
+struct LazyArgsTag {};
+
+template <class T>
+constexpr bool is_lazy_args_v = std::derived_from<T, LazyArgsTag>;
+
+template <class T>
+  requires is_lazy_args_v<T>
+struct vector_base<T> {
+  using type = typename T::value_type;
+};
+
 template <class T>
 using vector_base_t = vector_base<T>::type;
 
+/*!
+ * std::map, std::flat_map or any other ordered associative container with
+ * mapped_type, duplicated keys are merged with key_comp
+ */
+template <class T>
+constexpr bool is_map_v = requires(const T& map) {
+  typename T::key_type;
+  typename T::mapped_type;
+  typename T::key_compare;
+  map.key_comp();
+};
+
 template <class T>
 struct is_array : std::false_type {};
 
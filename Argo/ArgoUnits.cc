@@ -0,0 +1,423 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Units;
+
+import std;
+
+import :Exceptions;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Byte count, accepts decimal (kB, MB, ...) and binary (KiB, MiB, ...)
+ * suffixes. Example: 4GiB, 1.5MB, 512
+ */
+export struct Bytes {
+  std::uint64_t count = 0;
+
+  constexpr auto operator<=>(const Bytes&) const = default;
+};
+
+/*!
+ * Number with an SI suffix (k, M, G, T, P, E or Ki, Mi, Gi, ...)
+ * Example: 10k, 2.5M, -3G
+ */
+export template <class T>
+  requires(std::is_arithmetic_v<T>)
+struct SI {
+  T value = {};
+
+  constexpr auto operator<=>(const SI&) const = default;
+};
+
+/*!
+ * Rate per second, an SI number optionally followed by a time unit
+ * Example: 10k/s, 250/ms, 1M/min
+ */
+export template <class T = double>
+  requires(std::is_floating_point_v<T>)
+struct Rate {
+  T per_second = {};
+
+  constexpr auto operator<=>(const Rate&) const = default;
+};
+
+template <class T>
+struct is_duration : std::false_type {};
+
+template <class Rep, class Period>
+struct is_duration<std::chrono::duration<Rep, Period>> : std::true_type {};
+
+template <class T>
+constexpr bool is_duration_v = is_duration<T>::value;
+
+template <class T>
+struct is_si : std::false_type {};
+
+template <class T>
+struct is_si<SI<T>> : std::true_type {};
+
+template <class T>
+constexpr bool is_si_v = is_si<T>::value;
+
+template <class T>
+struct is_rate : std::false_type {};
+
+template <class T>
+struct is_rate<Rate<T>> : std::true_type {};
+
+template <class T>
+constexpr bool is_rate_v = is_rate<T>::value;
+
+struct UnitScale {
+  std::string_view suffix;
+  std::uint64_t num;
+  std::uint64_t den = 1;
+};
+
+constexpr auto byte_units = std::to_array<UnitScale>({
+    {"", 1},
+    {"B", 1},
+    {"k", 1'000},
+    {"K", 1'000},
+    {"kB", 1'000},
+    {"KB", 1'000},
+    {"M", 1'000'000},
+    {"MB", 1'000'000},
+    {"G", 1'000'000'000},
+    {"GB", 1'000'000'000},
+    {"T", 1'000'000'000'000},
+    {"TB", 1'000'000'000'000},
+    {"P", 1'000'000'000'000'000},
+    {"PB", 1'000'000'000'000'000},
+    {"E", 1'000'000'000'000'000'000},
+    {"EB", 1'000'000'000'000'000'000},
+    {"Ki", 1ULL << 10},
+    {"KiB", 1ULL << 10},
+    {"Mi", 1ULL << 20},
+    {"MiB", 1ULL << 20},
+    {"Gi", 1ULL << 30},
+    {"GiB", 1ULL << 30},
+    {"Ti", 1ULL << 40},
+    {"TiB", 1ULL << 40},
+    {"Pi", 1ULL << 50},
+    {"PiB", 1ULL << 50},
+    {"Ei", 1ULL << 60},
+    {"EiB", 1ULL << 60},
+});
+
+constexpr auto si_units = std::to_array<UnitScale>({
+    {"", 1},
+    {"k", 1'000},
+    {"K", 1'000},
+    {"M", 1'000'000},
+    {"G", 1'000'000'000},
+    {"T", 1'000'000'000'000},
+    {"P", 1'000'000'000'000'000},
+    {"E", 1'000'000'000'000'000'000},
+    {"Ki", 1ULL << 10},
+    {"Mi", 1ULL << 20},
+    {"Gi", 1ULL << 30},
+    {"Ti", 1ULL << 40},
+    {"Pi", 1ULL << 50},
+    {"Ei", 1ULL << 60},
+});
+
+// Scale in seconds
+constexpr auto time_units = std::to_array<UnitScale>({
+    {"ns", 1, 1'000'000'000},
+    {"us", 1, 1'000'000},
+    {"ms", 1, 1'000},
+    {"s", 1},
+    {"m", 60},
+    {"min", 60},
+    {"h", 3'600},
+    {"d", 86'400},
+});
+
+constexpr auto pow10_table = std::to_array<std::uint64_t>({
+    1ULL,
+    10ULL,
+    100ULL,
+    1'000ULL,
+    10'000ULL,
+    100'000ULL,
+    1'000'000ULL,
+    10'000'000ULL,
+    100'000'000ULL,
+    1'000'000'000ULL,
+    10'000'000'000ULL,
+    100'000'000'000ULL,
+    1'000'000'000'000ULL,
+    10'000'000'000'000ULL,
+    100'000'000'000'000ULL,
+    1'000'000'000'000'000ULL,
+    10'000'000'000'000'000ULL,
+    100'000'000'000'000'000ULL,
+    1'000'000'000'000'000'000ULL,
+});
+
+struct DecimalNumber {
+  bool negative = false;
+  std::uint64_t integer = 0;
+  std::uint64_t fraction = 0;
+  std::size_t fraction_digits = 0;
+  std::string_view suffix;
+
+  [[nodiscard]] constexpr auto toFloat() const -> long double {
+    auto ret = static_cast<long double>(this->integer) +
+               static_cast<long double>(this->fraction) /
+                   static_cast<long double>(pow10_table[fraction_digits]);
+    return this->negative ? -ret : ret;
+  }
+};
+
+/*!
+ * Split "[-]digits[.digits]suffix" in one pass without allocation
+ */
+ARGO_ALWAYS_INLINE constexpr auto ParseDecimal(std::string_view value)
+    -> std::optional<DecimalNumber> {
+  DecimalNumber ret;
+  std::size_t i = 0;
+  if (i < value.size() and (value[i] == '-' or value[i] == '+')) {
+    ret.negative = (value[i] == '-');
+    i++;
+  }
+  std::size_t digits = 0;
+  for (; i < value.size() and value[i] >= '0' and value[i] <= '9'; i++) {
+    if (__builtin_mul_overflow(ret.integer, 10ULL, &ret.integer) or
+        __builtin_add_overflow(
+            ret.integer, static_cast<std::uint64_t>(value[i] - '0'),
+            &ret.integer)) [[unlikely]] {
+      return std::nullopt;
+    }
+    digits++;
+  }
+  if (i < value.size() and value[i] == '.') {
+    for (i++; i < value.size() and value[i] >= '0' and value[i] <= '9'; i++) {
+      // Digits beyond the table do not change the result
+      if (ret.fraction_digits < pow10_table.size() - 1) {
+        ret.fraction = ret.fraction * 10 + (value[i] - '0');
+        ret.fraction_digits++;
+      }
+      digits++;
+    }
+  }
+  if (digits == 0) [[unlikely]] {
+    return std::nullopt;
+  }
+  while (i < value.size() and value[i] == ' ') {
+    i++;
+  }
+  ret.suffix = value.substr(i);
+  return ret;
+}
+
+template <std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto FindUnit(
+    const std::array<UnitScale, N>& units, std::string_view suffix)
+    -> const UnitScale* {
+  for (const auto& unit : units) {
+    if (unit.suffix == suffix) {
+      return &unit;
+    }
+  }
+  return nullptr;
+}
+
+/*!
+ * number * multiplier with overflow check, the fraction is rounded down
+ */
+ARGO_ALWAYS_INLINE constexpr auto ScaleExact(const DecimalNumber& number,
+                                             std::uint64_t multiplier)
+    -> std::optional<std::uint64_t> {
+  std::uint64_t ret = 0;
+  if (__builtin_mul_overflow(number.integer, multiplier, &ret)) [[unlikely]] {
+    return std::nullopt;
+  }
+  if (number.fraction_digits != 0) {
+    auto fraction = static_cast<std::uint64_t>(
+        static_cast<long double>(number.fraction) *
+        static_cast<long double>(multiplier) /
+        static_cast<long double>(pow10_table[number.fraction_digits]));
+    if (__builtin_add_overflow(ret, fraction, &ret)) [[unlikely]] {
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+ARGO_ALWAYS_INLINE constexpr auto ParseBytes(std::string_view value,
+                                             std::string_view key) -> Bytes {
+  auto number = ParseDecimal(value);
+  const auto* unit = number ? FindUnit(byte_units, number->suffix) : nullptr;
+  if (unit == nullptr or number->negative) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a byte size", key, value));
+  }
+  auto count = ScaleExact(*number, unit->num);
+  if (!count) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is out of range", key, value));
+  }
+  return {.count = *count};
+}
+
+template <class T>
+ARGO_ALWAYS_INLINE constexpr auto ScaleSI(const DecimalNumber& number,
+                                          std::uint64_t multiplier,
+                                          std::string_view value,
+                                          std::string_view key) -> T {
+  if constexpr (std::is_floating_point_v<T>) {
+    return static_cast<T>(number.toFloat() *
+                          static_cast<long double>(multiplier));
+  } else {
+    auto magnitude = ScaleExact(number, multiplier);
+    // Compare in unsigned space, -min is one larger than max
+    auto limit = static_cast<std::uint64_t>(std::numeric_limits<T>::max()) +
+                 (number.negative ? 1 : 0);
+    if (!magnitude or *magnitude > limit or
+        (number.negative and std::is_unsigned_v<T> and *magnitude != 0))
+        [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is out of range", key, value));
+    }
+    if (number.negative) {
+      return static_cast<T>(0 - *magnitude);
+    }
+    return static_cast<T>(*magnitude);
+  }
+}
+
+template <class Type>
+ARGO_ALWAYS_INLINE constexpr auto ParseSI(std::string_view value,
+                                          std::string_view key) -> Type {
+  using T = decltype(Type::value);
+  auto number = ParseDecimal(value);
+  const auto* unit = number ? FindUnit(si_units, number->suffix) : nullptr;
+  if (unit == nullptr) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a number", key, value));
+  }
+  return {.value = ScaleSI<T>(*number, unit->num, value, key)};
+}
+
+template <class Type>
+ARGO_ALWAYS_INLINE constexpr auto ParseRate(std::string_view value,
+                                            std::string_view key) -> Type {
+  using T = decltype(Type::per_second);
+  auto slash = value.find('/');
+  auto number = ParseDecimal(value.substr(0, slash));
+  const auto* unit = number ? FindUnit(si_units, number->suffix) : nullptr;
+  const auto* per = (slash == std::string_view::npos)
+                        ? FindUnit(time_units, "s")
+                        : FindUnit(time_units, value.substr(slash + 1));
+  if (unit == nullptr or per == nullptr) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a rate", key, value));
+  }
+  auto count = ScaleSI<T>(*number, unit->num, value, key);
+  return {.per_second = count * static_cast<T>(per->den) /
+                        static_cast<T>(per->num)};
+}
+
+/*!
+ * number * num / den as an integer T, throws when it overflows T or is not a
+ * whole number, so a unit finer than T is never silently truncated
+ */
+template <class T>
+ARGO_ALWAYS_INLINE constexpr auto ScaleRatio(const DecimalNumber& number,
+                                             std::uint64_t num,
+                                             std::uint64_t den,
+                                             std::string_view value,
+                                             std::string_view key) -> T {
+  using U128 = unsigned __int128;
+  constexpr auto gcd = [](U128 a, U128 b) {
+    while (b != 0) {
+      a = std::exchange(b, a % b);
+    }
+    return a;
+  };
+  // number = mantissa / 10^fraction_digits, reduce before multiplying
+  auto scale = static_cast<U128>(pow10_table[number.fraction_digits]);
+  auto mantissa = static_cast<U128>(number.integer) * scale + number.fraction;
+  auto divisor = scale * den;
+  auto common = gcd(mantissa, divisor);
+  mantissa /= common;
+  divisor /= common;
+  common = gcd(num, divisor);
+  auto multiplier = static_cast<U128>(num) / common;
+  divisor /= common;
+  if (divisor != 1) [[unlikely]] {
+    throw InvalidArgument(std::format(
+        "Argument {}: {} is not a whole number of ticks", key, value));
+  }
+
+  auto magnitude = U128();
+  auto limit = static_cast<U128>(std::numeric_limits<T>::max()) +
+               (number.negative ? 1 : 0);
+  if (__builtin_mul_overflow(mantissa, multiplier, &magnitude) or
+      magnitude > limit or
+      (number.negative and std::is_unsigned_v<T> and magnitude != 0))
+      [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is out of range", key, value));
+  }
+  if (number.negative) {
+    return static_cast<T>(0 - static_cast<std::uint64_t>(magnitude));
+  }
+  return static_cast<T>(magnitude);
+}
+
+/*!
+ * Parse "250ms", "1.5h", ... into Duration, a bare number is taken in the
+ * unit of Duration itself. With an integral rep the value must be a whole
+ * number of ticks, "250ms" into std::chrono::seconds is an error.
+ */
+template <class Duration>
+ARGO_ALWAYS_INLINE constexpr auto ParseDuration(std::string_view value,
+                                                std::string_view key)
+    -> Duration {
+  using Rep = Duration::rep;
+  using Period = Duration::period;
+  auto number = ParseDecimal(value);
+  auto unit = UnitScale{"", static_cast<std::uint64_t>(Period::num),
+                        static_cast<std::uint64_t>(Period::den)};
+  if (number and !number->suffix.empty()) {
+    const auto* found = FindUnit(time_units, number->suffix);
+    number = found ? number : std::nullopt;
+    unit = found ? *found : unit;
+  }
+  if (!number or (number->negative and std::is_unsigned_v<Rep>)) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a duration", key, value));
+  }
+
+  // ticks = number * unit / Period
+  auto num = unit.num * static_cast<std::uint64_t>(Period::den);
+  auto den = unit.den * static_cast<std::uint64_t>(Period::num);
+  auto gcd = std::gcd(num, den);
+  num /= gcd;
+  den /= gcd;
+
+  if constexpr (std::is_integral_v<Rep>) {
+    return Duration(ScaleRatio<Rep>(*number, num, den, value, key));
+  } else {
+    auto ticks = number->toFloat() * static_cast<long double>(num) /
+                 static_cast<long double>(den);
+    if (std::abs(ticks) > static_cast<long double>(
+                              std::numeric_limits<Rep>::max())) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is out of range", key, value));
+    }
+    return Duration(static_cast<Rep>(ticks));
+  }
+}
+
+}  // namespace Argo
+
+// generator end here
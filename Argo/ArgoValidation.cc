@@ -1,3 +1,7 @@
+module;
+
+#include <unistd.h>
+
 export module Argo:Validation;
 
 import :Exceptions;
@@ -48,10 +52,20 @@ struct AndValidation : ValidationBase {
  public:
   AndValidation(Lhs lhs, Rhs rhs) : lhs_(lhs), rhs_(rhs){};
 
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          std::format("Option {} has invalid value {}", option_name, values));
+    }
+  }
+
   template <class U>
   auto isValid(const U& value, std::span<std::string_view> raw_values) const
       -> bool {
-    return this->lhs_(value, raw_values) && this->lhs_(value, raw_values);
+    return this->lhs_.isValid(value, raw_values) &&
+           this->rhs_.isValid(value, raw_values);
   };
 };
 
@@ -69,10 +83,20 @@ struct OrValidation : ValidationBase {
  public:
   OrValidation(Lhs lhs, Rhs rhs) : lhs_(lhs), rhs_(rhs){};
 
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          std::format("Option {} has invalid value {}", option_name, values));
+    }
+  }
+
   template <class U>
   auto isValid(const U& value, std::span<std::string_view> raw_values) const
       -> bool {
-    return this->lhs_(value, raw_values) || this->lhs_(value, raw_values);
+    return this->lhs_.isValid(value, raw_values) ||
+           this->rhs_.isValid(value, raw_values);
   };
 };
 
@@ -88,10 +112,19 @@ struct InvertValidation : ValidationBase {
  public:
   explicit InvertValidation(Rhs rhs) : rhs_(rhs){};
 
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          std::format("Option {} has invalid value {}", option_name, values));
+    }
+  }
+
   template <class U>
   auto isValid(const U& value, std::span<std::string_view> raw_values) const
       -> bool {
-    return !this->rhs_(value, raw_values);
+    return !this->rhs_.isValid(value, raw_values);
   };
 };
 
@@ -127,6 +160,236 @@ struct Range final : public ValidationBase {
 template <class T>
 Range(T min, T max) -> Range<T>;
 
+template <class T>
+struct is_range_validation : std::false_type {};
+
+template <class T>
+struct is_range_validation<Range<T>> : std::true_type {};
+
+/*!
+ * Element-wise validation for container arguments
+ * Example:
+ *      addArg<"ports", std::vector<int>>(Each(Range(0, 1024)))
+ *
+ * Range over contiguous arithmetic values is checked with a min/max
+ * reduction first, so the per-element scan only runs when it fails.
+ */
+export template <std::derived_from<ValidationBase> Validator>
+struct Each final : public ValidationBase {
+ private:
+  Validator validator_;
+
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  template <class U>
+  [[nodiscard]] auto findInvalid(const U& value,
+                                 std::span<std::string_view> raw_values) const
+      -> std::size_t {
+    using Elem = std::ranges::range_value_t<U>;
+    if constexpr (is_range_validation<Validator>::value and
+                  std::is_arithmetic_v<Elem> and
+                  std::ranges::contiguous_range<U>) {
+      auto elems = std::span<const Elem>(std::ranges::data(value),
+                                         std::ranges::size(value));
+      if (elems.empty()) {
+        return npos;
+      }
+      auto has_nan = false;
+      if constexpr (std::is_floating_point_v<Elem>) {
+        has_nan = std::ranges::any_of(
+            elems, [](Elem elem) { return std::isnan(elem); });
+      }
+      if (!has_nan) {
+        // Branch free reduction, lowered to packed min/max instructions
+        auto min = elems[0];
+        auto max = elems[0];
+        for (auto elem : elems) {
+          min = elem < min ? elem : min;
+          max = max < elem ? elem : max;
+        }
+        // Range is convex, checking both extremes is enough
+        if (this->validator_.isValid(min, {}) and
+            this->validator_.isValid(max, {})) [[likely]] {
+          return npos;
+        }
+      }
+    }
+    std::size_t index = 0;
+    for (const auto& elem : value) {
+      auto raw = index < raw_values.size() ? raw_values.subspan(index, 1)
+                                           : std::span<std::string_view>();
+      if (!this->validator_.isValid(elem, raw)) {
+        return index;
+      }
+      index++;
+    }
+    return npos;
+  }
+
+ public:
+  explicit Each(Validator validator) : validator_(validator){};
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    auto index = this->findInvalid(value, values);
+    if (index == npos) [[likely]] {
+      return;
+    }
+    if (index < values.size()) {
+      throw ValidationError(
+          std::format("Option {} has invalid value {} at index {}",
+                      option_name, values[index], index));
+    }
+    throw ValidationError(std::format(
+        "Option {} has invalid value at index {}", option_name, index));
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> raw_values) const
+      -> bool {
+    return this->findInvalid(value, raw_values) == npos;
+  };
+};
+
+template <std::derived_from<ValidationBase> Validator>
+Each(Validator) -> Each<Validator>;
+
+export enum class PathCheck {
+  Exists,
+  IsFile,
+  IsDir,
+  Readable,
+};
+
+/*!
+ * Filesystem validation for std::filesystem::path and its containers
+ * Lists longer than parallel_threshold are checked concurrently on a bounded
+ * pool of threads, every bad path is reported in one ValidationError.
+ */
+export template <PathCheck Check>
+struct PathValidation final : public ValidationBase {
+ private:
+  static constexpr std::size_t parallel_threshold = 256;
+  static constexpr std::size_t max_threads = 16;
+
+  [[nodiscard]] static auto checkOne(const std::filesystem::path& path)
+      -> bool {
+    auto ec = std::error_code();
+    if constexpr (Check == PathCheck::Exists) {
+      return std::filesystem::exists(path, ec);
+    } else if constexpr (Check == PathCheck::IsFile) {
+      return std::filesystem::is_regular_file(path, ec);
+    } else if constexpr (Check == PathCheck::IsDir) {
+      return std::filesystem::is_directory(path, ec);
+    } else {
+      return ::access(path.c_str(), R_OK) == 0;
+    }
+  }
+
+  [[nodiscard]] static constexpr auto reason() -> std::string_view {
+    if constexpr (Check == PathCheck::Exists) {
+      return "does not exist";
+    } else if constexpr (Check == PathCheck::IsFile) {
+      return "is not a regular file";
+    } else if constexpr (Check == PathCheck::IsDir) {
+      return "is not a directory";
+    } else {
+      return "is not readable";
+    }
+  }
+
+  template <class U>
+  [[nodiscard]] static auto findInvalid(const U& value)
+      -> std::vector<std::size_t> {
+    std::vector<std::size_t> invalid;
+    if constexpr (std::is_same_v<U, std::filesystem::path>) {
+      if (!checkOne(value)) {
+        invalid.push_back(0);
+      }
+    } else {
+      static_assert(
+          std::is_same_v<std::ranges::range_value_t<U>, std::filesystem::path>,
+          "Path validation requires std::filesystem::path");
+      auto paths = std::span<const std::filesystem::path>(
+          std::ranges::data(value), std::ranges::size(value));
+      if (paths.size() < parallel_threshold) {
+        for (std::size_t i = 0; i < paths.size(); i++) {
+          if (!checkOne(paths[i])) {
+            invalid.push_back(i);
+          }
+        }
+        return invalid;
+      }
+      // Stats on network filesystems are latency bound, overlap them
+      auto results = std::vector<char>(paths.size(), 1);
+      auto next = std::atomic<std::size_t>(0);
+      auto num_threads = std::min({
+          max_threads,
+          std::max<std::size_t>(std::thread::hardware_concurrency(), 1),
+          paths.size() / parallel_threshold,
+      });
+      {
+        auto workers = std::vector<std::jthread>();
+        workers.reserve(num_threads);
+        for (std::size_t t = 0; t < num_threads; t++) {
+          workers.emplace_back([&paths, &results, &next] {
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed);
+                 i < paths.size();
+                 i = next.fetch_add(1, std::memory_order_relaxed)) {
+              results[i] = static_cast<char>(checkOne(paths[i]));
+            }
+          });
+        }
+      }
+      for (std::size_t i = 0; i < results.size(); i++) {
+        if (results[i] == 0) {
+          invalid.push_back(i);
+        }
+      }
+    }
+    return invalid;
+  }
+
+  template <class U>
+  [[nodiscard]] static auto pathAt(const U& value, std::size_t index)
+      -> const std::filesystem::path& {
+    if constexpr (std::is_same_v<U, std::filesystem::path>) {
+      return value;
+    } else {
+      return std::ranges::data(value)[index];
+    }
+  }
+
+ public:
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> /* unused */,
+                  std::string_view option_name) -> void {
+    auto invalid = findInvalid(value);
+    if (invalid.empty()) [[likely]] {
+      return;
+    }
+    auto paths = std::string();
+    for (auto i : invalid) {
+      paths.append(std::format("\"{}\", ", pathAt(value, i).string()));
+    }
+    paths.resize(paths.size() - 2);
+    throw ValidationError(
+        std::format("Option {}: {} {}", option_name, paths, reason()));
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> /* unused */) const
+      -> bool {
+    return findInvalid(value).empty();
+  };
+};
+
+export using Exists = PathValidation<PathCheck::Exists>;
+export using IsFile = PathValidation<PathCheck::IsFile>;
+export using IsDir = PathValidation<PathCheck::IsDir>;
+export using Readable = PathValidation<PathCheck::Readable>;
+
 // template <class Type>
 // struct Callback final : public ValidationBase<Type> {
 //  private:
@@ -154,8 +417,7 @@ auto operator|(Lhs lhs, Rhs rhs) {
   return Argo::Validation::OrValidation(lhs, rhs);
 }
 
-export template <std::derived_from<Argo::Validation::ValidationBase> Lhs,
-                 std::derived_from<Argo::Validation::ValidationBase> Rhs>
+export template <std::derived_from<Argo::Validation::ValidationBase> Rhs>
 auto operator!(Rhs rhs) {
   return Argo::Validation::InvertValidation(rhs);
 }
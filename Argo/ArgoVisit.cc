@@ -0,0 +1,664 @@
+module;
+
+#include "Argo/ArgoMacros.hh"
+
+export module Argo:Visit;
+
+import std;
+
+import :Exceptions;
+import :TypeTraits;
+import :ArgName;
+import :Arg;
+import :MetaLookup;
+import :Constraint;
+
+// generator start here
+
+namespace Argo {
+
+/*!
+ * Values of one option as they are in argv, nothing is copied
+ * The value after "=" of --key=value, or after the key of -kvalue, comes
+ * first when present.
+ */
+export class ValueSpan {
+ private:
+  const char* inline_ = nullptr;
+  char* const* argv_ = nullptr;
+  std::size_t size_ = 0;
+  int index_ = 0;
+
+ public:
+  class Iterator {
+   private:
+    const ValueSpan* span_ = nullptr;
+    std::size_t index_ = 0;
+
+   public:
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator() = default;
+    Iterator(const ValueSpan* span, std::size_t index)
+        : span_(span), index_(index) {}
+
+    ARGO_ALWAYS_INLINE auto operator*() const -> std::string_view {
+      return (*this->span_)[this->index_];
+    }
+
+    ARGO_ALWAYS_INLINE auto operator++() -> Iterator& {
+      this->index_++;
+      return *this;
+    }
+
+    ARGO_ALWAYS_INLINE auto operator++(int) -> Iterator {
+      auto ret = *this;
+      this->index_++;
+      return ret;
+    }
+
+    auto operator==(const Iterator&) const -> bool = default;
+  };
+
+  ValueSpan() = default;
+
+  /*!
+   * index is the position of argv[0] in the command line
+   */
+  ValueSpan(const char* inline_value, char* const* argv, std::size_t size,
+            int index)
+      : inline_(inline_value), argv_(argv), size_(size), index_(index) {}
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto size() const -> std::size_t {
+    return this->size_ + (this->inline_ != nullptr ? 1 : 0);
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto empty() const -> bool {
+    return this->size() == 0;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto operator[](std::size_t i) const
+      -> std::string_view {
+    if (this->inline_ != nullptr) {
+      return i == 0 ? this->inline_ : this->argv_[i - 1];
+    }
+    return this->argv_[i];
+  }
+
+  /*!
+   * Position of the first value in the command line
+   */
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto index() const -> int {
+    return this->inline_ != nullptr ? this->index_ - 1 : this->index_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto first(std::size_t count) const
+      -> ValueSpan {
+    if (this->inline_ == nullptr or count == 0) {
+      return {nullptr, this->argv_, count, this->index_};
+    }
+    return {this->inline_, this->argv_, count - 1, this->index_};
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto subspan(std::size_t offset) const
+      -> ValueSpan {
+    if (offset == 0) {
+      return *this;
+    }
+    if (this->inline_ != nullptr) {
+      offset--;
+    }
+    return {nullptr, this->argv_ + offset, this->size_ - offset,
+            this->index_ + static_cast<int>(offset)};
+  }
+
+  [[nodiscard]] auto begin() const -> Iterator {
+    return {this, 0};
+  }
+
+  [[nodiscard]] auto end() const -> Iterator {
+    return {this, this->size()};
+  }
+};
+
+/*!
+ * Compile time tag of the argument passed to a visitor
+ * Example:
+ *      parser.visit(argc, argv, []<class Tag>(Tag, ValueSpan values, int) {
+ *        if constexpr (Tag::key == "threads") { ... }
+ *      });
+ */
+export template <class Arg>
+struct VisitTag {
+  static constexpr std::string_view key = Arg::name.getKey();
+  static constexpr char short_key = Arg::name.getShortName();
+  static constexpr bool is_flag = std::derived_from<Arg, FlagArgTag>;
+  using type = typename Arg::type;
+};
+
+/*!
+ * Tag passed to the incremental parser's visitor for every token after "--",
+ * with the token as the only value
+ */
+export struct PassthroughTag {
+  static constexpr std::string_view key = "--";
+  static constexpr char short_key = '\0';
+  static constexpr bool is_flag = false;
+  using type = std::string_view;
+};
+
+enum class TokenKind {
+  Long,
+  Short,
+  Positional,
+};
+
+/*!
+ * Position of the first "--" in argv[1, argc), argc when there is none
+ * Options end there, the tokens after it are left to the caller.
+ */
+ARGO_ALWAYS_INLINE constexpr auto OptionsEnd(int argc, char* argv[]) -> int {
+  for (int i = 1; i < argc; i++) {
+    const auto* raw = argv[i];
+    if (raw[0] == '-' and raw[1] == '-' and raw[2] == '\0') [[unlikely]] {
+      return i;
+    }
+  }
+  return argc;
+}
+
+/*!
+ * Split argv[1, end) into options and their values
+ * emit(kind, name, values, position) is called for every option, position is
+ * the index of the option in argv. Values before the first option are
+ * Positional.
+ */
+template <class Args, class Emit>
+ARGO_ALWAYS_INLINE constexpr auto Tokenize(int end, char* argv[], Emit&& emit)
+    -> void {
+  auto kind = TokenKind::Positional;
+  auto name = std::string_view();
+  const char* inline_value = nullptr;
+  int position = 0;
+  int first = 1;
+
+  for (int i = 1; i < end + 1; i++) {
+    auto is_flag = true;
+    if (i != end) {
+      const auto* raw = argv[i];
+      // A lone "-" is a value, usually standing for stdin or stdout
+      is_flag = raw[0] == '-' and raw[1] != '\0';
+      if (is_flag and raw[1] >= '0' and raw[1] <= '9') {
+        // Negative number unless it is a short key
+        is_flag = IsFlag<Args>(raw[1]);
+      }
+    }
+
+    if (i != 1 and is_flag) {
+      emit(kind, name,
+           ValueSpan(inline_value, argv + first,
+                     static_cast<std::size_t>(i - first), first),
+           position);
+    }
+
+    if (i == end) {
+      break;
+    }
+
+    if (is_flag) {
+      auto arg = std::string_view(argv[i]);
+      position = i;
+      first = i + 1;
+      inline_value = nullptr;
+      if (arg.size() > 1 and arg[1] == '-') {
+        kind = TokenKind::Long;
+        auto equal_pos = arg.find('=');
+        if (equal_pos != std::string_view::npos) [[unlikely]] {
+          name = arg.substr(2, equal_pos - 2);
+          inline_value = argv[i] + equal_pos + 1;
+        } else {
+          name = arg.substr(2);
+        }
+      } else {
+        kind = TokenKind::Short;
+        name = arg.substr(1);
+      }
+    }
+  }
+}
+
+/*!
+ * Values left after an option go to the positional arguments in order, the
+ * same way PArgAssigner does
+ */
+template <std::size_t Offset, class PArgs, class Visitor, std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto VisitPositional(ValueSpan values,
+                                                  Visitor& visitor,
+                                                  ArgMask<N>& visited)
+    -> void {
+  if constexpr (std::tuple_size_v<PArgs> != 0) {
+    auto done = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      return ([&]<class Arg, std::size_t I>() ARGO_ALWAYS_INLINE {
+        if (visited.test(Offset + I)) {
+          return false;
+        }
+        auto count = values.size();
+        if constexpr (Arg::nargs.nargs_char != '+') {
+          count = Arg::nargs.nargs;
+          if (values.size() < count) [[unlikely]] {
+            throw InvalidArgument(std::format(
+                "Argument {}: should take exactly {} value but {}",
+                Arg::name.getKey(), count, values.size()));
+          }
+        }
+        visited.set(Offset + I);
+        visitor(VisitTag<Arg>(), values.first(count), values.index());
+        values = values.subspan(count);
+        return values.empty();
+      }.template operator()<std::tuple_element_t<Is, PArgs>, Is>() || ...);
+    }(std::make_index_sequence<std::tuple_size_v<PArgs>>());
+    if (!done) [[unlikely]] {
+      throw InvalidArgument("Duplicated positional argument");
+    }
+  }
+}
+
+/*!
+ * Number of values an option takes, the rest are positional
+ */
+template <class Arg, class PArgs>
+ARGO_ALWAYS_INLINE constexpr auto VisitCount(std::string_view key,
+                                             const ValueSpan& values)
+    -> std::size_t {
+  if constexpr (std::derived_from<Arg, FlagArgTag>) {
+    if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+      if (!values.empty()) [[unlikely]] {
+        throw InvalidArgument(std::format("Flag {} can not take value", key));
+      }
+    }
+    return 0;
+  } else if constexpr (is_map_v<typename Arg::type> or Arg::append) {
+    if (values.empty()) [[unlikely]] {
+      throw InvalidArgument(std::format(
+          "Argument {}: should take at least one value", key));
+    }
+    return Arg::nargs.nargs == 1 ? 1 : values.size();
+  } else if constexpr (Arg::nargs.nargs_char == '?') {
+    return std::min<std::size_t>(1, values.size());
+  } else if constexpr (Arg::nargs.nargs_char == '*' or
+                       Arg::nargs.nargs_char == '+') {
+    if (Arg::nargs.nargs_char == '+' and values.empty()) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: should take more than one value", key));
+    }
+    return values.size();
+  } else {
+    if (values.size() < Arg::nargs.nargs) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: should take exactly {} value but {}", key,
+                      Arg::nargs.nargs, values.size()));
+    }
+    return Arg::nargs.nargs;
+  }
+}
+
+template <class Args, class PArgs, class Visitor, std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto VisitOption(std::string_view key,
+                                              ValueSpan values, int position,
+                                              Visitor& visitor,
+                                              ArgMask<N>& visited) -> void {
+  if (key.empty()) {
+    if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+      throw InvalidArgument(std::format("Invalid argument {}", key));
+    }
+    VisitPositional<std::tuple_size_v<Args>, PArgs>(values, visitor, visited);
+    return;
+  }
+  auto found = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    return ([&]<class Arg, std::size_t I>() ARGO_ALWAYS_INLINE {
+      if (Arg::name.getKey() != key) {
+        return false;
+      }
+      if (!Arg::repeatable and visited.test(I)) [[unlikely]] {
+        throw InvalidArgument(
+            std::format("Argument {}: duplicated argument", key));
+      }
+      auto count = VisitCount<Arg, PArgs>(key, values);
+      visited.set(I);
+      visitor(VisitTag<Arg>(), values.first(count), position);
+      if (count != values.size()) {
+        VisitPositional<std::tuple_size_v<Args>, PArgs>(values.subspan(count),
+                                                        visitor, visited);
+      }
+      return true;
+    }.template operator()<std::tuple_element_t<Is, Args>, Is>() || ...);
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  if (!found) [[unlikely]] {
+    throw InvalidArgument(std::format("Invalid argument {}", key));
+  }
+}
+
+/*!
+ * Combined short keys like -abc, the same rules as ShortArgAssigner
+ * Returns true when the help flag was found
+ */
+template <class Args, class PArgs, class HArg, class Visitor, std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto VisitShort(std::string_view keys,
+                                             ValueSpan values, int position,
+                                             Visitor& visitor,
+                                             ArgMask<N>& visited) -> bool {
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    auto [found_key, is_flag] = GetkeyFromShortKey<     //
+        std::conditional_t<std::is_same_v<HArg, void>,  //
+                           Args,                        //
+                           tuple_append_t<Args, HArg>>>(keys[i]);
+    if constexpr (!std::is_same_v<HArg, void>) {
+      if (found_key == HArg::name.getKey()) [[unlikely]] {
+        return true;
+      }
+    }
+    auto last = keys.size() - 1 == i;
+    if (is_flag and last) {
+      VisitOption<Args, PArgs>(found_key, values, position, visitor, visited);
+    } else if (is_flag) {
+      VisitOption<Args, PArgs>(found_key, ValueSpan(), position, visitor,
+                               visited);
+    } else if (last) {
+      if (values.empty()) {
+        values = ValueSpan(keys.data() + i + 1, nullptr, 0, position + 1);
+      }
+      VisitOption<Args, PArgs>(found_key, values, position, visitor, visited);
+      return false;
+    } else [[unlikely]] {
+      throw InvalidArgument(std::format("Invalid Flag argument {} {}",
+                                        keys[i], keys.substr(i + 1)));
+    }
+  }
+  return false;
+}
+
+/*!
+ * Required arguments and constraints, from the visited mask
+ */
+template <class Args, class Constraints, std::size_t N>
+auto VisitCheck(const ArgMask<N>& visited) -> void {
+  auto required_keys = std::vector<std::string_view>();
+  [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (..., [&]<class Arg, std::size_t I>() {
+      if constexpr (std::derived_from<Arg, ArgTag>) {
+        if (Arg::required and !visited.test(I)) {
+          required_keys.push_back(Arg::name.getKey());
+        }
+      }
+    }.template operator()<std::tuple_element_t<Is, Args>, Is>());
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  if (!required_keys.empty()) [[unlikely]] {
+    throw InvalidArgument(std::format("Requried {}", required_keys));
+  }
+  tuple_type_visit<Constraints>([&visited]<class T>(T) {
+    T::type::template check<Args>(visited);
+  });
+}
+
+/*!
+ * Number of values after which the option key is complete, npos if it takes
+ * every value up to the next option
+ */
+template <class Args>
+constexpr auto OptionNeed(std::string_view key) -> std::size_t {
+  auto need = std::size_t();
+  auto found = [&]<class... Arg>(type_sequence<Arg...>) {
+    return ([&] {
+      if (Arg::name.getKey() != key) {
+        return false;
+      }
+      if constexpr (std::derived_from<Arg, FlagArgTag>) {
+        need = 0;
+      } else if constexpr (is_map_v<typename Arg::type> or Arg::append) {
+        need = Arg::nargs.nargs == 1 ? 1 : std::string_view::npos;
+      } else if constexpr (Arg::nargs.nargs_char == '?') {
+        need = 1;
+      } else if constexpr (Arg::nargs.nargs_char == '*' or
+                           Arg::nargs.nargs_char == '+') {
+        need = std::string_view::npos;
+      } else {
+        need = Arg::nargs.nargs;
+      }
+      return true;
+    }() || ...);
+  }(make_type_sequence_t<Args>());
+  if (!found) [[unlikely]] {
+    throw InvalidArgument(std::format("Invalid argument {}", key));
+  }
+  return need;
+}
+
+/*!
+ * Values the next positional argument takes, npos for nargs '+' and 0 when
+ * every positional argument is taken
+ */
+template <std::size_t Offset, class PArgs, std::size_t N>
+constexpr auto PositionalNeed(const ArgMask<N>& visited) -> std::size_t {
+  auto need = std::size_t();
+  [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (... || [&]<class Arg, std::size_t I>() {
+      if (visited.test(Offset + I)) {
+        return false;
+      }
+      need = Arg::nargs.nargs_char == '+' ? std::string_view::npos
+                                          : Arg::nargs.nargs;
+      return true;
+    }.template operator()<std::tuple_element_t<Is, PArgs>, Is>());
+  }(std::make_index_sequence<std::tuple_size_v<PArgs>>());
+  return need;
+}
+
+/*!
+ * Parser fed one token at a time, returned by Parser::incremental
+ * Example:
+ *      auto stream = parser.incremental();
+ *      for (auto token : tokens) {
+ *        stream.push(token, visitor);
+ *      }
+ *      stream.finish(visitor);
+ *
+ * The visitor is called like with Parser::visit as soon as an argument and
+ * its values are known: when it has the number of values it takes, or when
+ * the next option or finish ends it. Positions count pushed tokens from 0.
+ * The help flag is passed to the visitor as VisitTag of the help argument
+ * instead of printing help and exiting. Options end at "--" as in parse, each
+ * token after it is passed on its own with PassthroughTag.
+ *
+ * Only the values of the pending argument are kept, copied into a buffer
+ * reused for the next one. Call reset after an exception.
+ */
+export template <class Args, class PArgs, class HArg, class Constraints>
+class IncrementalParser {
+ private:
+  using Arguments =
+      decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+  static constexpr auto offset = std::tuple_size_v<Args>;
+
+  enum class Pending {
+    None,
+    Option,
+    Positional,
+  };
+
+  Pending pending_ = Pending::None;
+  bool options_end_ = false;
+  std::string key_;
+  std::size_t need_ = 0;
+  bool short_key_ = false;
+  int position_ = 0;
+  int first_ = 0;
+  int count_ = 0;
+  std::string buffer_;
+  std::vector<std::size_t> offsets_;
+  std::vector<char*> values_;
+  ArgMask<std::tuple_size_v<Arguments>> visited_;
+
+  auto add(std::string_view value) -> void {
+    this->offsets_.push_back(this->buffer_.size());
+    this->buffer_.append(value);
+    this->buffer_.push_back('\0');
+  }
+
+  auto values() -> ValueSpan {
+    this->values_.clear();
+    for (auto offset : this->offsets_) {
+      this->values_.push_back(this->buffer_.data() + offset);
+    }
+    return {nullptr, this->values_.data(), this->values_.size(), this->first_};
+  }
+
+  auto clear() -> void {
+    this->pending_ = Pending::None;
+    this->short_key_ = false;
+    this->buffer_.clear();
+    this->offsets_.clear();
+  }
+
+  template <class Visitor>
+  auto flush(Visitor& visitor) -> void {
+    if (this->pending_ == Pending::Option) {
+      if (this->short_key_ and this->offsets_.empty()) {
+        // -k alone takes the empty rest of the token, as in parse
+        this->first_ = this->position_;
+        this->add("");
+      }
+      VisitOption<Args, PArgs>(this->key_, this->values(), this->position_,
+                               visitor, this->visited_);
+    } else if (this->pending_ == Pending::Positional) {
+      VisitPositional<offset, PArgs>(this->values(), visitor, this->visited_);
+    }
+    this->clear();
+  }
+
+  template <class Visitor>
+  auto startOption(std::string_view key, int position, Visitor& visitor)
+      -> void {
+    this->position_ = position;
+    this->first_ = position + 1;
+    this->key_ = key;
+    this->need_ = OptionNeed<Args>(key);
+    this->pending_ = Pending::Option;
+    if (this->need_ == 0) {
+      this->flush(visitor);
+    }
+  }
+
+  template <class Visitor>
+  auto value(std::string_view value, int position, Visitor& visitor) -> void {
+    if (this->pending_ == Pending::None) {
+      if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+        throw InvalidArgument(
+            std::format("Invalid positional argument: {}", value));
+      }
+      this->pending_ = Pending::Positional;
+      this->first_ = position;
+    }
+    this->add(value);
+    auto need = this->pending_ == Pending::Option
+                    ? this->need_
+                    : PositionalNeed<offset, PArgs>(this->visited_);
+    if (this->offsets_.size() >= need) {
+      this->flush(visitor);
+    }
+  }
+
+ public:
+  template <class Visitor>
+  auto push(std::string_view token, Visitor&& visitor) -> void {
+    auto position = this->count_++;
+    if (this->options_end_) [[unlikely]] {
+      this->first_ = position;
+      this->add(token);
+      visitor(PassthroughTag(), this->values(), position);
+      this->clear();
+      return;
+    }
+    if (token == "--") [[unlikely]] {
+      this->flush(visitor);
+      this->options_end_ = true;
+      return;
+    }
+
+    auto is_flag = token.size() > 1 and token[0] == '-';
+    if (is_flag and token[1] >= '0' and token[1] <= '9') {
+      is_flag = IsFlag<Args>(token[1]);
+    }
+    if (!is_flag) {
+      this->value(token, position, visitor);
+      return;
+    }
+
+    this->flush(visitor);
+    if (token.size() > 1 and token[1] == '-') {
+      auto equal_pos = token.find('=');
+      auto key = token.substr(2, equal_pos - 2);
+      if constexpr (!std::is_same_v<HArg, void>) {
+        if (key == HArg::name.getKey()) {
+          visitor(VisitTag<HArg>(), ValueSpan(), position);
+          return;
+        }
+      }
+      this->startOption(key, position, visitor);
+      if (equal_pos != std::string_view::npos) [[unlikely]] {
+        this->first_ = position;
+        this->value(token.substr(equal_pos + 1), position, visitor);
+      }
+      return;
+    }
+
+    auto keys = token.substr(1);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      auto [found_key, is_flag] = GetkeyFromShortKey<     //
+          std::conditional_t<std::is_same_v<HArg, void>,  //
+                             Args,                        //
+                             tuple_append_t<Args, HArg>>>(keys[i]);
+      if constexpr (!std::is_same_v<HArg, void>) {
+        if (found_key == HArg::name.getKey()) {
+          visitor(VisitTag<HArg>(), ValueSpan(), position);
+          return;
+        }
+      }
+      if (is_flag) {
+        VisitOption<Args, PArgs>(found_key, ValueSpan(), position, visitor,
+                                 this->visited_);
+      } else if (i == keys.size() - 1) {
+        this->startOption(found_key, position, visitor);
+        this->short_key_ = true;
+      } else [[unlikely]] {
+        throw InvalidArgument(std::format("Invalid Flag argument {} {}",
+                                          keys[i], keys.substr(i + 1)));
+      }
+    }
+  }
+
+  /*!
+   * End of the command line, check runs the required and constraint checks
+   * The parser is reset afterwards and can take the next command line.
+   */
+  template <class Visitor>
+  auto finish(Visitor&& visitor, bool check = false) -> void {
+    this->flush(visitor);
+    if (check) {
+      VisitCheck<Arguments, Constraints>(this->visited_);
+    }
+    this->reset();
+  }
+
+  auto reset() -> void {
+    this->clear();
+    this->options_end_ = false;
+    this->visited_ = {};
+    this->count_ = 0;
+  }
+};
+
+}  // namespace Argo
+
+// generator end here
@@ -0,0 +1,108 @@
+import Argo;
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using Argo::Append;
+using Argo::Parser;
+
+auto cache_dir = [] {
+  auto dir = std::filesystem::temp_directory_path() / "argo_bench_cache";
+  std::filesystem::create_directories(dir);
+  return dir.string();
+}();
+
+// Options file of a compiler wrapper with 300 include directories
+auto config = [] {
+  auto path = std::filesystem::temp_directory_path() / "argo_bench.toml";
+  auto file = std::ofstream(path);
+  file << "target = \"x86_64-linux-gnu\"\ninclude = [\n";
+  for (int i = 0; i < 300; i++) {
+    file << std::format("  \"/usr/include/lib{}\",\n", i);
+  }
+  file << "]\n";
+  return path.string();
+}();
+
+// Command line with 100 defines
+auto args = [] {
+  auto ret = std::vector<std::string>{"./cc", "--config", config};
+  for (int i = 0; i < 100; i++) {
+    ret.insert(ret.end(), {"--define", std::format("FEATURE_{}=1", i)});
+  }
+  ret.insert(ret.end(), {"--output", "main.o", "--opt-level", "2", "--jobs",
+                         "16", "--source", "main.cc"});
+  return ret;
+}();
+
+auto argv = [] {
+  auto ret = std::vector<char*>();
+  for (auto& arg : args) {
+    ret.push_back(arg.data());
+  }
+  ret.push_back(nullptr);
+  return ret;
+}();
+
+auto argc = static_cast<int>(args.size());
+
+template <Argo::ParserID ID>
+auto createParser() {
+  return Parser<ID>()
+      .template addConfig<"config">()
+      .template addArg<"include", std::vector<std::string>, Append>()
+      .template addArg<"define", std::vector<std::string>, Append>()
+      .template addArg<"output", std::string>()
+      .template addArg<"opt-level", int>()
+      .template addArg<"jobs", int>()
+      .template addArg<"target", std::string>()
+      .template addArg<"source", std::string>();
+}
+
+static void ArgoParse(benchmark::State& state) {
+  auto parser = createParser<"parse">();
+  for (auto _ : state) {
+    parser.resetArgs();
+    parser.parse(argc, argv.data());
+    benchmark::DoNotOptimize(parser.getArg<"include">());
+  }
+}
+
+BENCHMARK(ArgoParse);
+
+static void ArgoCacheMiss(benchmark::State& state) {
+  auto parser = createParser<"cache miss">();
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::filesystem::remove_all(cache_dir);
+    std::filesystem::create_directories(cache_dir);
+    parser.resetArgs();
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(
+        parser.parseCached(argc, argv.data(), cache_dir));
+  }
+}
+
+BENCHMARK(ArgoCacheMiss);
+
+static void ArgoCacheHit(benchmark::State& state) {
+  auto parser = createParser<"cache hit">();
+  parser.parseCached(argc, argv.data(), cache_dir);
+  for (auto _ : state) {
+    parser.resetArgs();
+    if (!parser.parseCached(argc, argv.data(), cache_dir)) {
+      state.SkipWithError("cache miss");
+      break;
+    }
+    benchmark::DoNotOptimize(parser.getArg<"include">());
+  }
+}
+
+BENCHMARK(ArgoCacheHit);
+
+BENCHMARK_MAIN();
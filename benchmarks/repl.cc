@@ -0,0 +1,46 @@
+import Argo;
+
+#include <benchmark/benchmark.h>
+
+#include <string_view>
+
+// Short admin commands as they arrive on a control socket
+constexpr std::string_view lines[] = {
+    "stats -v --fields rps p99",
+    "drain --timeout 5 db1",
+    "stats",
+    "drain db2",
+};
+
+static void ArgoRepl(benchmark::State& state) {
+  auto stats = Argo::Parser<"repl stats">()
+                   .addFlag<"verbose,v">()
+                   .addArg<"fields", std::vector<std::string>,
+                           Argo::nargs('+')>();
+  auto drain = Argo::Parser<"repl drain">()
+                   .addArg<"timeout", int>(Argo::explicitDefault(30))
+                   .addPositionalArg<"backend", std::string>();
+  auto parser = Argo::Parser<"repl">()
+                    .addParser<"stats">(stats)
+                    .addParser<"drain">(drain);
+
+  std::size_t handled = 0;
+  auto repl = Argo::Repl(parser, "admin");
+  repl.on<"stats">([&](auto& p) {
+        handled += p.template getArg<"fields">().size();
+      })
+      .on<"drain">([&](auto& p) {
+        handled += static_cast<std::size_t>(p.template getArg<"timeout">());
+      });
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    repl.execute(lines[i++ % std::size(lines)]);
+  }
+  benchmark::DoNotOptimize(handled);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(ArgoRepl);
+
+BENCHMARK_MAIN();
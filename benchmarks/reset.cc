@@ -0,0 +1,91 @@
+import Argo;
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Each added option instantiates a parser type with all the previous ones,
+// compile time and memory grow quadratically with the count
+constexpr std::size_t option_count = 250;
+
+// o000 to o249
+template <std::size_t I>
+struct OptionName {
+  static constexpr char value[] = {'o', static_cast<char>('0' + I / 100),
+                                   static_cast<char>('0' + I / 10 % 10),
+                                   static_cast<char>('0' + I % 10), '\0'};
+};
+
+template <std::size_t I>
+struct AddOption {};
+
+// Every third option is an int, a string and a list of strings
+template <class P, std::size_t I>
+auto operator|(P&& parser, AddOption<I> /* unused */) {
+  if constexpr (I % 3 == 0) {
+    return parser.template addArg<OptionName<I>::value, int>();
+  } else if constexpr (I % 3 == 1) {
+    return parser.template addArg<OptionName<I>::value, std::string>();
+  } else {
+    return parser.template addArg<OptionName<I>::value,
+                                  std::vector<std::string>, Argo::nargs('+')>();
+  }
+}
+
+template <Argo::ParserID ID>
+auto createParser() {
+  return []<std::size_t... Is>(std::index_sequence<Is...>) {
+    return (Argo::Parser<ID>() | ... | AddOption<Is>());
+  }(std::make_index_sequence<option_count>());
+}
+
+// 25 of the options
+auto args = [] {
+  auto ret = std::vector<std::string>{"./main"};
+  for (std::size_t i = 0; i < option_count; i += 10) {
+    ret.push_back("--o" + std::to_string(1000 + i).substr(1));
+    if (i % 3 == 0) {
+      ret.emplace_back("42");
+    } else if (i % 3 == 1) {
+      ret.emplace_back("a value long enough to be allocated on the heap");
+    } else {
+      ret.insert(ret.end(), {"first", "second", "third", "fourth"});
+    }
+  }
+  return ret;
+}();
+
+auto argv = [] {
+  auto ret = std::vector<char*>();
+  for (auto& arg : args) {
+    ret.push_back(arg.data());
+  }
+  ret.push_back(nullptr);
+  return ret;
+}();
+
+auto argc = static_cast<int>(args.size());
+
+static void ArgoParseReset(benchmark::State& state) {
+  auto parser = createParser<"reset">();
+  for (auto _ : state) {
+    parser.parse(argc, argv.data());
+    parser.resetArgs();
+  }
+}
+
+BENCHMARK(ArgoParseReset);
+
+static void ArgoParseResetRelease(benchmark::State& state) {
+  auto parser = createParser<"reset release">();
+  for (auto _ : state) {
+    parser.parse(argc, argv.data());
+    parser.resetArgs(true);
+  }
+}
+
+BENCHMARK(ArgoParseResetRelease);
+
+BENCHMARK_MAIN();
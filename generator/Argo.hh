@@ -1,22 +1,52 @@
 #pragma once
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cerrno>
 #include <charconv>
+#include <chrono>
+#include <cmath>
+#include <compare>
 #include <concepts>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <format>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <ranges>
+#include <source_location>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -24,14 +54,31 @@
 #define ARGO_ALWAYS_INLINE __attribute__((always_inline))
 
 // fetch { Argo/ArgoExceptions.cc }
+// fetch { Argo/ArgoMappedFile.cc }
+// fetch { Argo/ArgoUnits.cc }
+// fetch { Argo/ArgoIndexSet.cc }
+// fetch { Argo/ArgoNet.cc }
 // fetch { Argo/ArgoTypeTraits.cc }
 // fetch { Argo/ArgoValidation.cc }
 // fetch { Argo/ArgoArgName.cc }
 // fetch { Argo/ArgoArg.cc }
+// fetch { Argo/ArgoChoices.cc }
 // fetch { Argo/ArgoInitializer.cc }
 // fetch { Argo/ArgoHelpGenerator.cc }
 // fetch { Argo/ArgoMetaLookup.cc }
+// fetch { Argo/ArgoConstraint.cc }
+// fetch { Argo/ArgoVisit.cc }
+// fetch { Argo/ArgoLazy.cc }
 // fetch { Argo/ArgoMetaAssigner.cc }
+// fetch { Argo/ArgoConfig.cc }
+// fetch { Argo/ArgoSnapshot.cc }
+// fetch { Argo/ArgoSerialize.cc }
+// fetch { Argo/ArgoCache.cc }
+// fetch { Argo/ArgoShell.cc }
+// fetch { Argo/ArgoStdin.cc }
 // fetch { Argo/ArgoMetaParse.cc }
 // fetch { Argo/ArgoParser.cc }
 // fetch { Argo/ArgoParserImpl.cc }
+// fetch { Argo/ArgoReload.cc }
+// fetch { Argo/ArgoRepl.cc }
+// fetch { Argo/ArgoServer.cc }
@@ -1,22 +1,52 @@
 #pragma once
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cerrno>
 #include <charconv>
+#include <chrono>
+#include <cmath>
+#include <compare>
 #include <concepts>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <format>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <ranges>
+#include <source_location>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -65,1903 +95,7942 @@ class ValidationError : public InvalidArgument {
   }
 };
 
+/*!
+ * Thrown after printing help, instead of exiting, by a parser with
+ * exitOnHelp(false)
+ */
+class HelpRequested : public std::runtime_error {
+ public:
+  explicit HelpRequested(const std::string& msg = "Help requested")
+      : runtime_error(msg) {}
+
+  [[nodiscard]] auto what() const noexcept -> const char* override {
+    return runtime_error::what();
+  }
+};
+
 }  // namespace Argo
 
 
 namespace Argo {
 
-template <class T>
-struct is_tuple : std::false_type {};
+/*!
+ * madvise hint applied right after the file is mapped
+ */
+enum class MapAdvice {
+  Normal,
+  Sequential,
+  WillNeed,
+};
 
-template <class... T>
-struct is_tuple<std::tuple<T...>> : std::true_type {};
+struct MappedFileTag {};
 
-template <class T>
-constexpr bool is_tuple_v = is_tuple<T>::value;
+/*!
+ * Read-only memory mapping of the file named by the argument value
+ * Example:
+ *      addArg<"dict", Argo::MappedFile>()
+ *      addArg<"model", Argo::BasicMappedFile<Argo::MapAdvice::WillNeed>>()
+ *
+ * Copies share the mapping, it is unmapped when the last copy is destroyed.
+ */
+template <MapAdvice Advice = MapAdvice::Normal>
+class BasicMappedFile : public MappedFileTag {
+ private:
+  struct Mapping {
+    void* addr = nullptr;
+    std::size_t size = 0;
 
-template <class T>
-struct is_vector : std::false_type {};
+    Mapping(void* addr, std::size_t size) : addr(addr), size(size) {}
 
-template <class T>
-struct is_vector<std::vector<T>> : std::true_type {};
+    Mapping(const Mapping&) = delete;
+    Mapping(Mapping&&) = delete;
+    auto operator=(const Mapping&) -> Mapping& = delete;
+    auto operator=(Mapping&&) -> Mapping& = delete;
 
-template <class T>
-constexpr bool is_vector_v = is_vector<T>::value;
+    ~Mapping() {
+      if (this->addr != nullptr) {
+        ::munmap(this->addr, this->size);
+      }
+    }
+  };
 
-template <class T>
-struct vector_base {
-  using type = T;
+  std::shared_ptr<const Mapping> mapping_ = nullptr;
+
+  [[noreturn]] static auto fail(const std::string& path, int err) -> void {
+    throw InvalidArgument(std::format("Cannot map file {}: {}", path,
+                                      std::system_category().message(err)));
+  }
+
+  auto map(int fd, const std::string& name) -> void {
+    struct ::stat st {};
+    if (::fstat(fd, &st) != 0) [[unlikely]] {
+      fail(name, errno);
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) {
+      this->mapping_ = std::make_shared<const Mapping>(nullptr, 0);
+      return;
+    }
+    auto* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) [[unlikely]] {
+      fail(name, errno);
+    }
+    if constexpr (Advice == MapAdvice::Sequential) {
+      ::madvise(addr, size, MADV_SEQUENTIAL);
+    } else if constexpr (Advice == MapAdvice::WillNeed) {
+      ::madvise(addr, size, MADV_WILLNEED);
+    }
+    this->mapping_ = std::make_shared<const Mapping>(addr, size);
+  }
+
+ public:
+  BasicMappedFile() = default;
+
+  explicit BasicMappedFile(std::string_view path) {
+    // value is not guaranteed to be null terminated, open(2) needs a copy
+    auto path_str = std::string(path);
+    auto fd = ::open(path_str.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) [[unlikely]] {
+      fail(path_str, errno);
+    }
+    try {
+      this->map(fd, path_str);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+  /*!
+   * Map an already open file, fd is left open
+   */
+  [[nodiscard]] static auto fromFd(int fd) -> BasicMappedFile {
+    auto ret = BasicMappedFile();
+    ret.map(fd, std::format("fd {}", fd));
+    return ret;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto bytes() const
+      -> std::span<const std::byte> {
+    if (!this->mapping_) {
+      return {};
+    }
+    return {static_cast<const std::byte*>(this->mapping_->addr),
+            this->mapping_->size};
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto data() const -> const std::byte* {
+    return this->bytes().data();
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto size() const -> std::size_t {
+    return this->mapping_ ? this->mapping_->size : 0;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto view() const -> std::string_view {
+    auto bytes = this->bytes();
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+  }
+
+  explicit operator bool() const {
+    return this->mapping_ != nullptr;
+  }
 };
 
-template <class T>
-struct vector_base<std::vector<T>> {
-  using type = T;
+using MappedFile = BasicMappedFile<>;
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Byte count, accepts decimal (kB, MB, ...) and binary (KiB, MiB, ...)
+ * suffixes. Example: 4GiB, 1.5MB, 512
+ */
+struct Bytes {
+  std::uint64_t count = 0;
+
+  constexpr auto operator<=>(const Bytes&) const = default;
 };
 
+/*!
+ * Number with an SI suffix (k, M, G, T, P, E or Ki, Mi, Gi, ...)
+ * Example: 10k, 2.5M, -3G
+ */
 template <class T>
-using vector_base_t = vector_base<T>::type;
+  requires(std::is_arithmetic_v<T>)
+struct SI {
+  T value = {};
+
+  constexpr auto operator<=>(const SI&) const = default;
+};
+
+/*!
+ * Rate per second, an SI number optionally followed by a time unit
+ * Example: 10k/s, 250/ms, 1M/min
+ */
+template <class T = double>
+  requires(std::is_floating_point_v<T>)
+struct Rate {
+  T per_second = {};
+
+  constexpr auto operator<=>(const Rate&) const = default;
+};
 
 template <class T>
-struct is_array : std::false_type {};
+struct is_duration : std::false_type {};
 
-template <class T, std::size_t N>
-struct is_array<std::array<T, N>> : std::true_type {};
+template <class Rep, class Period>
+struct is_duration<std::chrono::duration<Rep, Period>> : std::true_type {};
 
 template <class T>
-constexpr bool is_array_v = is_array<T>::value;
+constexpr bool is_duration_v = is_duration<T>::value;
 
 template <class T>
-struct array_len {
-  static constexpr std::size_t value = 0;
-};
+struct is_si : std::false_type {};
 
-template <class T, std::size_t N>
-struct array_len<std::array<T, N>> {
-  static constexpr std::size_t value = N;
-};
+template <class T>
+struct is_si<SI<T>> : std::true_type {};
 
 template <class T>
-constexpr std::size_t array_len_v = array_len<T>::value;
+constexpr bool is_si_v = is_si<T>::value;
 
 template <class T>
-struct array_base {
-  using type = T;
-};
+struct is_rate : std::false_type {};
 
-template <class T, std::size_t N>
-struct array_base<std::array<T, N>> {
-  using type = T;
-};
+template <class T>
+struct is_rate<Rate<T>> : std::true_type {};
 
 template <class T>
-using array_base_t = array_base<T>::type;
+constexpr bool is_rate_v = is_rate<T>::value;
 
-template <class T, class... U>
-struct tuple_append {
-  using type = std::tuple<U..., T>;
+struct UnitScale {
+  std::string_view suffix;
+  std::uint64_t num;
+  std::uint64_t den = 1;
 };
 
-template <class T, class... U>
-struct tuple_append<std::tuple<U...>, T> {
-  using type = std::tuple<U..., T>;
+constexpr auto byte_units = std::to_array<UnitScale>({
+    {"", 1},
+    {"B", 1},
+    {"k", 1'000},
+    {"K", 1'000},
+    {"kB", 1'000},
+    {"KB", 1'000},
+    {"M", 1'000'000},
+    {"MB", 1'000'000},
+    {"G", 1'000'000'000},
+    {"GB", 1'000'000'000},
+    {"T", 1'000'000'000'000},
+    {"TB", 1'000'000'000'000},
+    {"P", 1'000'000'000'000'000},
+    {"PB", 1'000'000'000'000'000},
+    {"E", 1'000'000'000'000'000'000},
+    {"EB", 1'000'000'000'000'000'000},
+    {"Ki", 1ULL << 10},
+    {"KiB", 1ULL << 10},
+    {"Mi", 1ULL << 20},
+    {"MiB", 1ULL << 20},
+    {"Gi", 1ULL << 30},
+    {"GiB", 1ULL << 30},
+    {"Ti", 1ULL << 40},
+    {"TiB", 1ULL << 40},
+    {"Pi", 1ULL << 50},
+    {"PiB", 1ULL << 50},
+    {"Ei", 1ULL << 60},
+    {"EiB", 1ULL << 60},
+});
+
+constexpr auto si_units = std::to_array<UnitScale>({
+    {"", 1},
+    {"k", 1'000},
+    {"K", 1'000},
+    {"M", 1'000'000},
+    {"G", 1'000'000'000},
+    {"T", 1'000'000'000'000},
+    {"P", 1'000'000'000'000'000},
+    {"E", 1'000'000'000'000'000'000},
+    {"Ki", 1ULL << 10},
+    {"Mi", 1ULL << 20},
+    {"Gi", 1ULL << 30},
+    {"Ti", 1ULL << 40},
+    {"Pi", 1ULL << 50},
+    {"Ei", 1ULL << 60},
+});
+
+// Scale in seconds
+constexpr auto time_units = std::to_array<UnitScale>({
+    {"ns", 1, 1'000'000'000},
+    {"us", 1, 1'000'000},
+    {"ms", 1, 1'000},
+    {"s", 1},
+    {"m", 60},
+    {"min", 60},
+    {"h", 3'600},
+    {"d", 86'400},
+});
+
+constexpr auto pow10_table = std::to_array<std::uint64_t>({
+    1ULL,
+    10ULL,
+    100ULL,
+    1'000ULL,
+    10'000ULL,
+    100'000ULL,
+    1'000'000ULL,
+    10'000'000ULL,
+    100'000'000ULL,
+    1'000'000'000ULL,
+    10'000'000'000ULL,
+    100'000'000'000ULL,
+    1'000'000'000'000ULL,
+    10'000'000'000'000ULL,
+    100'000'000'000'000ULL,
+    1'000'000'000'000'000ULL,
+    10'000'000'000'000'000ULL,
+    100'000'000'000'000'000ULL,
+    1'000'000'000'000'000'000ULL,
+});
+
+struct DecimalNumber {
+  bool negative = false;
+  std::uint64_t integer = 0;
+  std::uint64_t fraction = 0;
+  std::size_t fraction_digits = 0;
+  std::string_view suffix;
+
+  [[nodiscard]] constexpr auto toFloat() const -> long double {
+    auto ret = static_cast<long double>(this->integer) +
+               static_cast<long double>(this->fraction) /
+                   static_cast<long double>(pow10_table[fraction_digits]);
+    return this->negative ? -ret : ret;
+  }
 };
 
-template <class... T>
-using tuple_append_t = typename tuple_append<T...>::type;
+/*!
+ * Split "[-]digits[.digits]suffix" in one pass without allocation
+ */
+ARGO_ALWAYS_INLINE constexpr auto ParseDecimal(std::string_view value)
+    -> std::optional<DecimalNumber> {
+  DecimalNumber ret;
+  std::size_t i = 0;
+  if (i < value.size() and (value[i] == '-' or value[i] == '+')) {
+    ret.negative = (value[i] == '-');
+    i++;
+  }
+  std::size_t digits = 0;
+  for (; i < value.size() and value[i] >= '0' and value[i] <= '9'; i++) {
+    if (__builtin_mul_overflow(ret.integer, 10ULL, &ret.integer) or
+        __builtin_add_overflow(
+            ret.integer, static_cast<std::uint64_t>(value[i] - '0'),
+            &ret.integer)) [[unlikely]] {
+      return std::nullopt;
+    }
+    digits++;
+  }
+  if (i < value.size() and value[i] == '.') {
+    for (i++; i < value.size() and value[i] >= '0' and value[i] <= '9'; i++) {
+      // Digits beyond the table do not change the result
+      if (ret.fraction_digits < pow10_table.size() - 1) {
+        ret.fraction = ret.fraction * 10 + (value[i] - '0');
+        ret.fraction_digits++;
+      }
+      digits++;
+    }
+  }
+  if (digits == 0) [[unlikely]] {
+    return std::nullopt;
+  }
+  while (i < value.size() and value[i] == ' ') {
+    i++;
+  }
+  ret.suffix = value.substr(i);
+  return ret;
+}
 
-template <class... T>
-struct type_sequence {};
+template <std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto FindUnit(
+    const std::array<UnitScale, N>& units, std::string_view suffix)
+    -> const UnitScale* {
+  for (const auto& unit : units) {
+    if (unit.suffix == suffix) {
+      return &unit;
+    }
+  }
+  return nullptr;
+}
 
-template <class T>
-struct make_type_sequence {};
+/*!
+ * number * multiplier with overflow check, the fraction is rounded down
+ */
+ARGO_ALWAYS_INLINE constexpr auto ScaleExact(const DecimalNumber& number,
+                                             std::uint64_t multiplier)
+    -> std::optional<std::uint64_t> {
+  std::uint64_t ret = 0;
+  if (__builtin_mul_overflow(number.integer, multiplier, &ret)) [[unlikely]] {
+    return std::nullopt;
+  }
+  if (number.fraction_digits != 0) {
+    auto fraction = static_cast<std::uint64_t>(
+        static_cast<long double>(number.fraction) *
+        static_cast<long double>(multiplier) /
+        static_cast<long double>(pow10_table[number.fraction_digits]));
+    if (__builtin_add_overflow(ret, fraction, &ret)) [[unlikely]] {
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
 
-template <class... T>
-struct make_type_sequence<std::tuple<T...>> {
-  using type = type_sequence<T...>;
-};
+ARGO_ALWAYS_INLINE constexpr auto ParseBytes(std::string_view value,
+                                             std::string_view key) -> Bytes {
+  auto number = ParseDecimal(value);
+  const auto* unit = number ? FindUnit(byte_units, number->suffix) : nullptr;
+  if (unit == nullptr or number->negative) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a byte size", key, value));
+  }
+  auto count = ScaleExact(*number, unit->num);
+  if (!count) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is out of range", key, value));
+  }
+  return {.count = *count};
+}
 
 template <class T>
-using make_type_sequence_t = make_type_sequence<T>::type;
-
-template <class Tuple, class T>
-ARGO_ALWAYS_INLINE constexpr auto tuple_type_visit(T fun) {
-  [&fun]<class... U>(type_sequence<U...>) ARGO_ALWAYS_INLINE {
-    (fun(std::type_identity<U>()), ...);
-  }(make_type_sequence_t<Tuple>());
+ARGO_ALWAYS_INLINE constexpr auto ScaleSI(const DecimalNumber& number,
+                                          std::uint64_t multiplier,
+                                          std::string_view value,
+                                          std::string_view key) -> T {
+  if constexpr (std::is_floating_point_v<T>) {
+    return static_cast<T>(number.toFloat() *
+                          static_cast<long double>(multiplier));
+  } else {
+    auto magnitude = ScaleExact(number, multiplier);
+    // Compare in unsigned space, -min is one larger than max
+    auto limit = static_cast<std::uint64_t>(std::numeric_limits<T>::max()) +
+                 (number.negative ? 1 : 0);
+    if (!magnitude or *magnitude > limit or
+        (number.negative and std::is_unsigned_v<T> and *magnitude != 0))
+        [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is out of range", key, value));
+    }
+    if (number.negative) {
+      return static_cast<T>(0 - *magnitude);
+    }
+    return static_cast<T>(*magnitude);
+  }
 }
 
-template <class Tuple, class T>
-ARGO_ALWAYS_INLINE constexpr auto tuple_type_or_visit(T fun) -> bool {
-  return [&fun]<class... U>(type_sequence<U...>) ARGO_ALWAYS_INLINE {
-    return (fun(std::type_identity<U>()) || ...);
-  }(make_type_sequence_t<Tuple>());
+template <class Type>
+ARGO_ALWAYS_INLINE constexpr auto ParseSI(std::string_view value,
+                                          std::string_view key) -> Type {
+  using T = decltype(Type::value);
+  auto number = ParseDecimal(value);
+  const auto* unit = number ? FindUnit(si_units, number->suffix) : nullptr;
+  if (unit == nullptr) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a number", key, value));
+  }
+  return {.value = ScaleSI<T>(*number, unit->num, value, key)};
 }
 
-template <class Tuple, class T>
-ARGO_ALWAYS_INLINE constexpr auto tuple_type_and_visit(T fun) -> bool {
-  return [&fun]<class... U>(type_sequence<U...>) ARGO_ALWAYS_INLINE {
-    return (fun(std::type_identity<U>()) && ...);
-  }(make_type_sequence_t<Tuple>());
+template <class Type>
+ARGO_ALWAYS_INLINE constexpr auto ParseRate(std::string_view value,
+                                            std::string_view key) -> Type {
+  using T = decltype(Type::per_second);
+  auto slash = value.find('/');
+  auto number = ParseDecimal(value.substr(0, slash));
+  const auto* unit = number ? FindUnit(si_units, number->suffix) : nullptr;
+  const auto* per = (slash == std::string_view::npos)
+                        ? FindUnit(time_units, "s")
+                        : FindUnit(time_units, value.substr(slash + 1));
+  if (unit == nullptr or per == nullptr) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a rate", key, value));
+  }
+  auto count = ScaleSI<T>(*number, unit->num, value, key);
+  return {.per_second = count * static_cast<T>(per->den) /
+                        static_cast<T>(per->num)};
 }
 
-};  // namespace Argo
-
+/*!
+ * number * num / den as an integer T, throws when it overflows T or is not a
+ * whole number, so a unit finer than T is never silently truncated
+ */
+template <class T>
+ARGO_ALWAYS_INLINE constexpr auto ScaleRatio(const DecimalNumber& number,
+                                             std::uint64_t num,
+                                             std::uint64_t den,
+                                             std::string_view value,
+                                             std::string_view key) -> T {
+  using U128 = unsigned __int128;
+  constexpr auto gcd = [](U128 a, U128 b) {
+    while (b != 0) {
+      a = std::exchange(b, a % b);
+    }
+    return a;
+  };
+  // number = mantissa / 10^fraction_digits, reduce before multiplying
+  auto scale = static_cast<U128>(pow10_table[number.fraction_digits]);
+  auto mantissa = static_cast<U128>(number.integer) * scale + number.fraction;
+  auto divisor = scale * den;
+  auto common = gcd(mantissa, divisor);
+  mantissa /= common;
+  divisor /= common;
+  common = gcd(num, divisor);
+  auto multiplier = static_cast<U128>(num) / common;
+  divisor /= common;
+  if (divisor != 1) [[unlikely]] {
+    throw InvalidArgument(std::format(
+        "Argument {}: {} is not a whole number of ticks", key, value));
+  }
 
-namespace Argo::Validation {
+  auto magnitude = U128();
+  auto limit = static_cast<U128>(std::numeric_limits<T>::max()) +
+               (number.negative ? 1 : 0);
+  if (__builtin_mul_overflow(mantissa, multiplier, &magnitude) or
+      magnitude > limit or
+      (number.negative and std::is_unsigned_v<T> and magnitude != 0))
+      [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is out of range", key, value));
+  }
+  if (number.negative) {
+    return static_cast<T>(0 - static_cast<std::uint64_t>(magnitude));
+  }
+  return static_cast<T>(magnitude);
+}
 
-struct ValidationBase {
-  template <class T>
-  auto operator()(const T& value, std::span<std::string_view> values,
-                  std::string_view option_name) -> void {
-    if (!this->isValid(value, values)) [[unlikely]] {
-      throw ValidationError(
-          format("Option {} has invalid value {}", option_name, value));
-    }
+/*!
+ * Parse "250ms", "1.5h", ... into Duration, a bare number is taken in the
+ * unit of Duration itself. With an integral rep the value must be a whole
+ * number of ticks, "250ms" into std::chrono::seconds is an error.
+ */
+template <class Duration>
+ARGO_ALWAYS_INLINE constexpr auto ParseDuration(std::string_view value,
+                                                std::string_view key)
+    -> Duration {
+  using Rep = Duration::rep;
+  using Period = Duration::period;
+  auto number = ParseDecimal(value);
+  auto unit = UnitScale{"", static_cast<std::uint64_t>(Period::num),
+                        static_cast<std::uint64_t>(Period::den)};
+  if (number and !number->suffix.empty()) {
+    const auto* found = FindUnit(time_units, number->suffix);
+    number = found ? number : std::nullopt;
+    unit = found ? *found : unit;
+  }
+  if (!number or (number->negative and std::is_unsigned_v<Rep>)) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Argument {}: {} is not a duration", key, value));
   }
 
-  template <class T>
-  auto operator()(const T& value, std::span<std::string_view> raw_val) {
-    return this->isValid(value, raw_val);
+  // ticks = number * unit / Period
+  auto num = unit.num * static_cast<std::uint64_t>(Period::den);
+  auto den = unit.den * static_cast<std::uint64_t>(Period::num);
+  auto gcd = std::gcd(num, den);
+  num /= gcd;
+  den /= gcd;
+
+  if constexpr (std::is_integral_v<Rep>) {
+    return Duration(ScaleRatio<Rep>(*number, num, den, value, key));
+  } else {
+    auto ticks = number->toFloat() * static_cast<long double>(num) /
+                 static_cast<long double>(den);
+    if (std::abs(ticks) > static_cast<long double>(
+                              std::numeric_limits<Rep>::max())) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is out of range", key, value));
+    }
+    return Duration(static_cast<Rep>(ticks));
   }
+}
 
-  template <class T>
-  [[noreturn]] auto isValid(const T& /* unused */,
-                            std::span<std::string_view> /* unuesd */) const
-      -> bool {
-    static_assert(false, "Invalid validation");
-  };
+}  // namespace Argo
 
-  ValidationBase() = default;
-  ValidationBase(const ValidationBase&) = default;
-  ValidationBase(ValidationBase&&) = default;
-  auto operator=(const ValidationBase&) -> ValidationBase& = default;
-  auto operator=(ValidationBase&&) -> ValidationBase& = default;
-  virtual ~ValidationBase() = default;
-};
 
-template <std::derived_from<ValidationBase> Lhs,
-          std::derived_from<ValidationBase> Rhs>
-struct AndValidation : ValidationBase {
- private:
-  Lhs lhs_;
-  Rhs rhs_;
+namespace Argo {
 
+/*!
+ * Set of indices written in range syntax
+ * Example:
+ *      0-31,64-95    -> 0, 1, ..., 31, 64, ..., 95
+ *      0-4095:2      -> 0, 2, ..., 4094
+ *
+ * Small or dense sets are stored as a bitset, others as sorted disjoint
+ * runs (first, last, stride) searched in O(log n).
+ */
+class IndexSet {
  public:
-  AndValidation(Lhs lhs, Rhs rhs) : lhs_(lhs), rhs_(rhs){};
-
-  template <class U>
-  auto isValid(const U& value, std::span<std::string_view> raw_values) const
-      -> bool {
-    return this->lhs_(value, raw_values) && this->lhs_(value, raw_values);
+  struct Run {
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::size_t stride = 1;
   };
-};
 
-template <std::derived_from<ValidationBase> Lhs,
-          std::derived_from<ValidationBase> Rhs>
-AndValidation(Lhs, Rhs) -> AndValidation<Lhs, Rhs>;
+  class Iterator {
+   private:
+    const IndexSet* set_ = nullptr;
+    std::size_t pos_ = 0;
+    std::size_t value_ = 0;
+    std::uint64_t word_ = 0;
+
+    ARGO_ALWAYS_INLINE auto loadWord() -> void {
+      const auto& bits = this->set_->bits_;
+      while (this->word_ == 0 and ++this->pos_ < bits.size()) {
+        this->word_ = bits[this->pos_];
+      }
+      this->value_ = (this->word_ == 0)
+                         ? 0
+                         : this->pos_ * 64 + std::countr_zero(this->word_);
+    }
 
-template <std::derived_from<ValidationBase> Lhs,
-          std::derived_from<ValidationBase> Rhs>
-struct OrValidation : ValidationBase {
- private:
-  Lhs lhs_;
-  Rhs rhs_;
+   public:
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+
+    Iterator(const IndexSet* set, bool is_end) : set_(set) {
+      if (set->dense_) {
+        this->pos_ = is_end ? set->bits_.size() : 0;
+        if (!is_end and !set->bits_.empty()) {
+          this->word_ = set->bits_[0];
+          if (this->word_ == 0) {
+            this->loadWord();
+          } else {
+            this->value_ = std::countr_zero(this->word_);
+          }
+        }
+      } else {
+        this->pos_ = is_end ? set->runs_.size() : 0;
+        if (!is_end and !set->runs_.empty()) {
+          this->value_ = set->runs_[0].first;
+        }
+      }
+    }
 
- public:
-  OrValidation(Lhs lhs, Rhs rhs) : lhs_(lhs), rhs_(rhs){};
+    [[nodiscard]] auto operator*() const -> std::size_t {
+      return this->value_;
+    }
 
-  template <class U>
-  auto isValid(const U& value, std::span<std::string_view> raw_values) const
-      -> bool {
-    return this->lhs_(value, raw_values) || this->lhs_(value, raw_values);
-  };
-};
+    auto operator++() -> Iterator& {
+      if (this->set_->dense_) {
+        this->word_ &= this->word_ - 1;
+        this->loadWord();
+      } else {
+        const auto& run = this->set_->runs_[this->pos_];
+        if (this->value_ + run.stride <= run.last) {
+          this->value_ += run.stride;
+        } else if (++this->pos_ < this->set_->runs_.size()) {
+          this->value_ = this->set_->runs_[this->pos_].first;
+        } else {
+          this->value_ = 0;
+        }
+      }
+      return *this;
+    }
 
-template <std::derived_from<ValidationBase> Lhs,
-          std::derived_from<ValidationBase> Rhs>
-OrValidation(Lhs, Rhs) -> OrValidation<Lhs, Rhs>;
+    auto operator++(int) -> Iterator {
+      auto ret = *this;
+      ++*this;
+      return ret;
+    }
+
+    auto operator==(const Iterator& rhs) const -> bool {
+      return this->pos_ == rhs.pos_ and this->value_ == rhs.value_ and
+             this->word_ == rhs.word_;
+    }
+  };
 
-template <std::derived_from<ValidationBase> Rhs>
-struct InvertValidation : ValidationBase {
  private:
-  Rhs rhs_;
+  std::vector<Run> runs_;
+  std::vector<std::uint64_t> bits_;
+  std::size_t count_ = 0;
+  bool dense_ = false;
+
+  // Bitset is used when it is not larger than the runs, or fits in 4096 bits
+  static constexpr std::size_t dense_words = 64;
+  // Overlapping runs need the bitset, it is limited to 2^26 indices (8 MiB)
+  static constexpr std::size_t max_dense_words = std::size_t(1) << 20;
+
+  auto setBits(const Run& run) -> void {
+    if (run.stride == 1) {
+      for (auto i = run.first; i <= run.last;) {
+        auto offset = i % 64;
+        auto width = std::min<std::size_t>(64 - offset, run.last - i + 1);
+        auto mask = (width == 64) ? ~0ULL : ((1ULL << width) - 1) << offset;
+        this->bits_[i / 64] |= mask;
+        i += width;
+      }
+    } else {
+      for (auto i = run.first; i <= run.last; i += run.stride) {
+        this->bits_[i / 64] |= 1ULL << (i % 64);
+      }
+    }
+  }
+
+  /*!
+   * Merge the runs and pick the representation, false when overlapping runs
+   * would need a bitset larger than max_dense_words
+   */
+  auto normalize() -> bool {
+    std::ranges::sort(this->runs_, {}, &Run::first);
+
+    auto merged = std::vector<Run>();
+    merged.reserve(this->runs_.size());
+    auto disjoint = true;
+    std::size_t max_last = 0;
+    for (const auto& run : this->runs_) {
+      if (!merged.empty()) {
+        auto& back = merged.back();
+        if (back.stride == 1 and run.stride == 1 and
+            run.first <= back.last + 1) {
+          back.last = std::max(back.last, run.last);
+          max_last = std::max(max_last, back.last);
+          continue;
+        }
+        disjoint = disjoint and (run.first > max_last);
+      }
+      merged.push_back(run);
+      max_last = std::max(max_last, run.last);
+    }
+    this->runs_ = std::move(merged);
+
+    auto words = max_last / 64 + 1;
+    if (!disjoint and words > max_dense_words) [[unlikely]] {
+      return false;
+    }
+    // Overlapping strided runs cannot be binary searched, use the bitset
+    this->dense_ = !disjoint or words <= dense_words or
+                   words <= this->runs_.size() * 3;
+    if (this->dense_) {
+      this->bits_.assign(words, 0);
+      for (const auto& run : this->runs_) {
+        this->setBits(run);
+      }
+      this->count_ = 0;
+      for (auto word : this->bits_) {
+        this->count_ += std::popcount(word);
+      }
+      this->runs_ = {};
+    } else {
+      this->count_ = 0;
+      for (const auto& run : this->runs_) {
+        this->count_ += (run.last - run.first) / run.stride + 1;
+      }
+    }
+    return true;
+  }
 
  public:
-  explicit InvertValidation(Rhs rhs) : rhs_(rhs){};
+  IndexSet() = default;
+
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> IndexSet {
+    auto fail = [&] {
+      throw InvalidArgument(
+          std::format("Argument {}: invalid index set {}", key, value));
+    };
+    auto number = [](std::string_view& str, std::size_t& out) -> bool {
+      auto [ptr, ec] =
+          std::from_chars(str.data(), str.data() + str.size(), out);
+      if (ec != std::errc() or ptr == str.data()) {
+        return false;
+      }
+      str.remove_prefix(ptr - str.data());
+      return true;
+    };
+
+    auto ret = IndexSet();
+    auto rest = value;
+    while (true) {
+      auto run = Run();
+      if (!number(rest, run.first)) {
+        fail();
+      }
+      run.last = run.first;
+      if (rest.starts_with('-')) {
+        rest.remove_prefix(1);
+        if (!number(rest, run.last)) {
+          fail();
+        }
+      }
+      if (rest.starts_with(':')) {
+        rest.remove_prefix(1);
+        if (!number(rest, run.stride)) {
+          fail();
+        }
+      }
+      if (run.last < run.first or run.stride == 0) {
+        fail();
+      }
+      run.last -= (run.last - run.first) % run.stride;
+      run.stride = (run.first == run.last) ? 1 : run.stride;
+      ret.runs_.push_back(run);
+      if (rest.empty()) {
+        break;
+      }
+      if (!rest.starts_with(',')) {
+        fail();
+      }
+      rest.remove_prefix(1);
+    }
+    if (!ret.normalize()) [[unlikely]] {
+      throw InvalidArgument(std::format(
+          "Argument {}: overlapping runs in {} span too many indices", key,
+          value));
+    }
+    return ret;
+  }
 
-  template <class U>
-  auto isValid(const U& value, std::span<std::string_view> raw_values) const
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto contains(std::size_t index) const
       -> bool {
-    return !this->lhs_(value, raw_values);
-  };
-};
+    if (this->dense_) {
+      auto word = index / 64;
+      return word < this->bits_.size() and
+             ((this->bits_[word] >> (index % 64)) & 1) != 0;
+    }
+    auto it = std::ranges::upper_bound(this->runs_, index, {}, &Run::first);
+    if (it == this->runs_.begin()) {
+      return false;
+    }
+    --it;
+    return index <= it->last and (index - it->first) % it->stride == 0;
+  }
 
-template <std::derived_from<ValidationBase> Rhs>
-InvertValidation(Rhs) -> InvertValidation<Rhs>;
+  [[nodiscard]] auto size() const -> std::size_t {
+    return this->count_;
+  }
 
-template <class T>
-struct Range final : public ValidationBase {
- private:
-  T min_;
-  T max_;
+  [[nodiscard]] auto empty() const -> bool {
+    return this->count_ == 0;
+  }
 
- public:
-  Range(T min, T max) : min_(min), max_(max){};
+  [[nodiscard]] auto isDense() const -> bool {
+    return this->dense_;
+  }
 
-  template <class U>
-  auto operator()(const U& value, std::span<std::string_view> values,
-                  std::string_view option_name) -> void {
-    if (!this->isValid(value, values)) [[unlikely]] {
-      throw ValidationError(
-          format("Option {} has invalid value {}", option_name, value));
+  [[nodiscard]] auto begin() const -> Iterator {
+    return {this, false};
+  }
+
+  [[nodiscard]] auto end() const -> Iterator {
+    return {this, true};
+  }
+
+  /*!
+   * Write the set as a cpu_set_t style mask, bit n of word n / 64 is index n
+   * Returns false if an index does not fit in the mask.
+   */
+  auto copyTo(std::span<std::uint64_t> mask) const -> bool {
+    std::ranges::fill(mask, 0);
+    for (auto index : *this) {
+      if (index / 64 >= mask.size()) {
+        return false;
+      }
+      mask[index / 64] |= 1ULL << (index % 64);
     }
+    return true;
   }
 
-  template <class U>
-  auto isValid(const U& value, std::span<std::string_view> /* unused */) const
-      -> bool {
-    return static_cast<U>(this->min_) < value &&
-           value < static_cast<U>(this->max_);
-  };
+  [[nodiscard]] auto toMask() const -> std::vector<std::uint64_t> {
+    if (this->dense_) {
+      return this->bits_;
+    }
+    auto ret = std::vector<std::uint64_t>(
+        this->runs_.empty() ? 0 : this->runs_.back().last / 64 + 1, 0);
+    this->copyTo(ret);
+    return ret;
+  }
 };
 
-template <class T>
-Range(T min, T max) -> Range<T>;
+}  // namespace Argo
 
-// template <class Type>
-// struct Callback final : public ValidationBase<Type> {
-//  private:
-//   function<bool(Type)> callback_;
-//
-//  public:
-//   Callback(function<bool(Type)> callback) : callback_(callback){};
-//
-//   auto isValid(const Type& value) const -> bool {
-//     return this->callback_(value);
-//   };
-// };
 
-}  // namespace Argo::Validation
+namespace Argo {
 
-template <std::derived_from<Argo::Validation::ValidationBase> Lhs,
-                 std::derived_from<Argo::Validation::ValidationBase> Rhs>
-auto operator&(Lhs lhs, Rhs rhs) {
-  return Argo::Validation::AndValidation(lhs, rhs);
+ARGO_ALWAYS_INLINE constexpr auto HexDigit(char c) -> int {
+  if (c >= '0' and c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' and c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' and c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
 }
 
-template <std::derived_from<Argo::Validation::ValidationBase> Lhs,
-                 std::derived_from<Argo::Validation::ValidationBase> Rhs>
-auto operator|(Lhs lhs, Rhs rhs) {
-  return Argo::Validation::OrValidation(lhs, rhs);
-}
+/*!
+ * IPv4 or IPv6 address
+ * IPv4 addresses are held as IPv4-mapped IPv6 (::ffff:a.b.c.d), so both
+ * families share one ordering and one prefix space.
+ */
+class IpAddress {
+ private:
+  std::uint64_t hi_ = 0;
+  std::uint64_t lo_ = 0;
 
-template <std::derived_from<Argo::Validation::ValidationBase> Lhs,
-                 std::derived_from<Argo::Validation::ValidationBase> Rhs>
-auto operator!(Rhs rhs) {
-  return Argo::Validation::InvertValidation(rhs);
-}
+  static constexpr std::uint64_t v4_mapped = 0x0000'FFFF'0000'0000ULL;
 
+  static constexpr auto parseV4(std::string_view str, std::uint32_t& out)
+      -> bool {
+    std::uint32_t addr = 0;
+    std::size_t i = 0;
+    for (int octet = 0; octet < 4; octet++) {
+      if (octet != 0) {
+        if (i >= str.size() or str[i] != '.') {
+          return false;
+        }
+        i++;
+      }
+      auto begin = i;
+      std::uint32_t value = 0;
+      while (i < str.size() and i - begin < 3 and str[i] >= '0' and
+             str[i] <= '9') {
+        value = value * 10 + (str[i] - '0');
+        i++;
+      }
+      // Leading zeros are rejected, some tools read them as octal
+      if (i == begin or value > 255 or (i - begin > 1 and str[begin] == '0')) {
+        return false;
+      }
+      addr = (addr << 8) | value;
+    }
+    if (i != str.size()) {
+      return false;
+    }
+    out = addr;
+    return true;
+  }
 
-namespace Argo {
+  static constexpr auto parseV6(std::string_view str, std::uint64_t& hi,
+                                std::uint64_t& lo) -> bool {
+    constexpr auto no_gap = std::numeric_limits<std::size_t>::max();
+    std::array<std::uint16_t, 8> groups{};
+    std::size_t count = 0;
+    std::size_t gap = no_gap;
+    std::size_t i = 0;
+    if (str.starts_with("::")) {
+      gap = 0;
+      i = 2;
+    }
+    while (i < str.size()) {
+      if (count == 8) {
+        return false;
+      }
+      auto segment = str.substr(i, str.find(':', i) - i);
+      if (segment.contains('.')) {
+        std::uint32_t v4 = 0;
+        if (count > 6 or i + segment.size() != str.size() or
+            !parseV4(segment, v4)) {
+          return false;
+        }
+        groups[count++] = static_cast<std::uint16_t>(v4 >> 16);
+        groups[count++] = static_cast<std::uint16_t>(v4 & 0xFFFF);
+        break;
+      }
+      if (segment.empty() or segment.size() > 4) {
+        return false;
+      }
+      std::uint32_t value = 0;
+      for (auto c : segment) {
+        auto digit = HexDigit(c);
+        if (digit < 0) {
+          return false;
+        }
+        value = value * 16 + digit;
+      }
+      groups[count++] = static_cast<std::uint16_t>(value);
+      i += segment.size();
+      if (i == str.size()) {
+        break;
+      }
+      i++;
+      if (i < str.size() and str[i] == ':') {
+        if (gap != no_gap) {
+          return false;
+        }
+        gap = count;
+        i++;
+      } else if (i == str.size()) {
+        return false;
+      }
+    }
 
-/*!
- * ArgName which holds argument name
- */
-template <std::size_t N>
-struct ArgName {
-  char short_key_ = '\0';
-  char key_[N] = {};
-  std::size_t key_len_ = N;
+    std::array<std::uint16_t, 8> full{};
+    if (gap == no_gap) {
+      if (count != 8) {
+        return false;
+      }
+      full = groups;
+    } else {
+      if (count == 8) {
+        return false;
+      }
+      auto tail = count - gap;
+      for (std::size_t j = 0; j < gap; j++) {
+        full[j] = groups[j];
+      }
+      for (std::size_t j = 0; j < tail; j++) {
+        full[8 - tail + j] = groups[gap + j];
+      }
+    }
+    hi = 0;
+    lo = 0;
+    for (std::size_t j = 0; j < 4; j++) {
+      hi = (hi << 16) | full[j];
+      lo = (lo << 16) | full[j + 4];
+    }
+    return true;
+  }
 
-  // NOLINTNEXTLINE(google-explicit-constructor)
-  consteval ArgName(const char (&lhs)[N + 1]) {
-    for (std::size_t i = 0; i < N; i++) {
-      if (lhs[i] == ',') {
-        this->key_len_ = i;
-        this->short_key_ = lhs[i + 1];
-        return;
+ public:
+  constexpr IpAddress() = default;
+
+  constexpr IpAddress(std::uint64_t hi, std::uint64_t lo) : hi_(hi), lo_(lo) {}
+
+  [[nodiscard]] static constexpr auto fromV4(std::uint32_t addr) -> IpAddress {
+    return {0, v4_mapped | addr};
+  }
+
+  /*!
+   * Parse without allocation, returns nullopt on malformed input
+   */
+  [[nodiscard]] static constexpr auto tryParse(std::string_view str)
+      -> std::optional<IpAddress> {
+    if (str.contains(':')) {
+      std::uint64_t hi = 0;
+      std::uint64_t lo = 0;
+      if (!parseV6(str, hi, lo)) {
+        return std::nullopt;
       }
-      this->key_[i] = lhs[i];
+      return IpAddress(hi, lo);
     }
-  };
+    std::uint32_t v4 = 0;
+    if (!parseV4(str, v4)) {
+      return std::nullopt;
+    }
+    return fromV4(v4);
+  }
 
-  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto getShortName() const {
-    return this->short_key_;
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> IpAddress {
+    auto ret = tryParse(value);
+    if (!ret) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is not an IP address", key, value));
+    }
+    return *ret;
   }
 
-  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto getKey() const {
-    return std::string_view(this->key_, this->key_len_);
+  [[nodiscard]] constexpr auto isV4() const -> bool {
+    return this->hi_ == 0 and (this->lo_ >> 32) == (v4_mapped >> 32);
   }
 
-  [[nodiscard]] constexpr auto getKeyLen() const {
-    return this->key_len_;
+  [[nodiscard]] constexpr auto isV6() const -> bool {
+    return !this->isV4();
   }
 
-  template <std::size_t M>
-  [[nodiscard]] ARGO_ALWAYS_INLINE consteval auto operator==(
-      const ArgName<M>& lhs) const -> bool {
-    return this->getKey() == lhs.getKey();
+  [[nodiscard]] constexpr auto toV4() const -> std::uint32_t {
+    return static_cast<std::uint32_t>(this->lo_);
   }
 
-  [[nodiscard]] ARGO_ALWAYS_INLINE consteval auto hasValidNameLength() const
-      -> bool {
-    if (this->getShortName() == '\0') {
-      return true;
+  [[nodiscard]] constexpr auto high() const -> std::uint64_t {
+    return this->hi_;
+  }
+
+  [[nodiscard]] constexpr auto low() const -> std::uint64_t {
+    return this->lo_;
+  }
+
+  /*!
+   * Network byte order
+   */
+  [[nodiscard]] constexpr auto bytes() const -> std::array<std::uint8_t, 16> {
+    std::array<std::uint8_t, 16> ret{};
+    for (std::size_t i = 0; i < 8; i++) {
+      ret[i] = static_cast<std::uint8_t>(this->hi_ >> (56 - i * 8));
+      ret[i + 8] = static_cast<std::uint8_t>(this->lo_ >> (56 - i * 8));
     }
-    return (N - this->key_len_) == 2;
+    return ret;
   }
-};
 
-template <std::size_t N>
-ArgName(const char (&)[N]) -> ArgName<N - 1>;
+  [[nodiscard]] auto toString() const -> std::string {
+    if (this->isV4()) {
+      auto v4 = this->toV4();
+      return std::format("{}.{}.{}.{}", v4 >> 24, (v4 >> 16) & 0xFF,
+                         (v4 >> 8) & 0xFF, v4 & 0xFF);
+    }
+    std::array<std::uint16_t, 8> groups{};
+    for (std::size_t i = 0; i < 4; i++) {
+      groups[i] = static_cast<std::uint16_t>(this->hi_ >> (48 - i * 16));
+      groups[i + 4] = static_cast<std::uint16_t>(this->lo_ >> (48 - i * 16));
+    }
+    // RFC 5952: compress the longest run of two or more zero groups
+    std::size_t best = 8;
+    std::size_t best_len = 1;
+    for (std::size_t i = 0; i < 8;) {
+      auto j = i;
+      while (j < 8 and groups[j] == 0) {
+        j++;
+      }
+      if (j - i > best_len) {
+        best = i;
+        best_len = j - i;
+      }
+      i = (j == i) ? i + 1 : j;
+    }
+    auto ret = std::string();
+    for (std::size_t i = 0; i < 8; i++) {
+      if (i == best) {
+        ret += "::";
+        i += best_len - 1;
+        continue;
+      }
+      if (!ret.empty() and !ret.ends_with(':')) {
+        ret += ':';
+      }
+      ret += std::format("{:x}", groups[i]);
+    }
+    return ret;
+  }
 
-template <class T>
-concept ArgNameType = requires(T& x) {
-  std::is_same_v<decltype(x.getKey()), std::string_view>;
-  std::is_same_v<decltype(x.getShortName()), char>;
+  constexpr auto operator<=>(const IpAddress&) const = default;
 };
 
-}  // namespace Argo
-
-
-namespace Argo {
-
 /*!
- * ParserID which holds parser id
- * You can set int or string as id
- * Example:
- *      // int id
- *      auto parser = Parser<42>();
- *      // string id
- *      auto parser = Parser<"ID">();
+ * Address prefix such as 10.0.0.0/8 or 2001:db8::/32
+ * Host bits are cleared, an address without /N is a single host prefix.
  */
-template <std::size_t N>
-struct ParserID {
-  union {
-    int idInt = 0;
-    char idName[N];
-  } id;
+class Cidr {
+ private:
+  IpAddress network_;
+  // Length in the 128 bit space, IPv4 prefixes are offset by 96
+  std::uint8_t prefix_ = 0;
+
+  [[nodiscard]] static constexpr auto maskHigh(std::size_t prefix)
+      -> std::uint64_t {
+    if (prefix == 0) {
+      return 0;
+    }
+    return prefix >= 64 ? ~0ULL : ~0ULL << (64 - prefix);
+  }
 
-  // NOLINTNEXTLINE(google-explicit-constructor)
-  consteval ParserID(int id) : id(id){};
+  [[nodiscard]] static constexpr auto maskLow(std::size_t prefix)
+      -> std::uint64_t {
+    if (prefix <= 64) {
+      return 0;
+    }
+    return prefix == 128 ? ~0ULL : ~0ULL << (128 - prefix);
+  }
 
-  // NOLINTNEXTLINE(google-explicit-constructor)
-  consteval ParserID(const char (&id)[N + 1]) {
-    for (std::size_t i = 0; i < N; i++) {
-      this->id.idName[i] = id[i];
+ public:
+  constexpr Cidr() = default;
+
+  constexpr Cidr(IpAddress address, std::size_t prefix)
+      : network_(address.high() & maskHigh(prefix),
+                 address.low() & maskLow(prefix)),
+        prefix_(static_cast<std::uint8_t>(prefix)) {}
+
+  [[nodiscard]] static constexpr auto tryParse(std::string_view str)
+      -> std::optional<Cidr> {
+    auto slash = str.find('/');
+    auto host = str.substr(0, slash);
+    auto address = IpAddress::tryParse(host);
+    if (!address) {
+      return std::nullopt;
     }
-  };
-};
+    std::size_t offset = host.contains(':') ? 0 : 96;
+    if (slash == std::string_view::npos) {
+      return Cidr(*address, 128);
+    }
+    auto length = str.substr(slash + 1);
+    std::size_t prefix = 0;
+    auto [ptr, ec] =
+        std::from_chars(length.data(), length.data() + length.size(), prefix);
+    if (ec != std::errc() or ptr != length.data() + length.size() or
+        length.empty() or prefix + offset > 128) {
+      return std::nullopt;
+    }
+    return Cidr(*address, prefix + offset);
+  }
 
-ParserID(int) -> ParserID<1>;
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> Cidr {
+    auto ret = tryParse(value);
+    if (!ret) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is not a CIDR prefix", key, value));
+    }
+    return *ret;
+  }
 
-template <std::size_t N>
-ParserID(const char (&)[N]) -> ParserID<N - 1>;
+  [[nodiscard]] constexpr auto network() const -> IpAddress {
+    return this->network_;
+  }
 
-/*!
- * NArgs which holds number of argument
- * Available argument:
- *   ?  : If value specified use it else use default -> ValueType
- *   int: Exactly (n > 1)                            -> array<ValueType, N>
- *   *  : Any number of argument if zero use default -> vector<ValueType>
- *   +  : Any number of argument except zero         -> vector<ValueType>
- *
- * Note:
- *   default value is "?".
- */
-struct NArgs {
-  int nargs = -1;
-  char nargs_char = '\0';
+  /*!
+   * Prefix length in the address family, /8 for 10.0.0.0/8
+   */
+  [[nodiscard]] constexpr auto prefixLength() const -> std::size_t {
+    return this->network_.isV4() ? this->prefix_ - 96 : this->prefix_;
+  }
 
-  constexpr explicit NArgs(char arg) : nargs_char(arg) {}
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto contains(
+      IpAddress address) const -> bool {
+    return (address.high() & maskHigh(this->prefix_)) ==
+               this->network_.high() and
+           (address.low() & maskLow(this->prefix_)) == this->network_.low();
+  }
 
-  constexpr explicit NArgs(int arg) : nargs(arg) {}
+  [[nodiscard]] constexpr auto contains(const Cidr& other) const -> bool {
+    return other.prefix_ >= this->prefix_ and this->contains(other.network_);
+  }
+
+  constexpr auto operator<=>(const Cidr&) const = default;
 };
 
 /*!
- * consteval String
+ * Address and port, written as 1.2.3.4:80, [::1]:80 or :80
+ * ":80" stands for the unspecified address "::".
  */
-template <std::size_t N>
-struct String {
-  char str_[N] = {};
+class Endpoint {
+ private:
+  IpAddress address_;
+  std::uint16_t port_ = 0;
 
-  String() = default;
+ public:
+  constexpr Endpoint() = default;
 
-  consteval explicit String(const char (&str)[N + 1]) {
-    for (std::size_t i = 0; i < N; i++) {
-      str_[i] = str[i];
+  constexpr Endpoint(IpAddress address, std::uint16_t port)
+      : address_(address), port_(port) {}
+
+  [[nodiscard]] static constexpr auto tryParse(std::string_view str)
+      -> std::optional<Endpoint> {
+    auto colon = str.rfind(':');
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
     }
-  };
+    auto host = str.substr(0, colon);
+    auto port_str = str.substr(colon + 1);
 
-  consteval explicit operator std::string() const {
-    return std::string(str_, N);
-  }
+    auto address = std::optional<IpAddress>(IpAddress());
+    if (host.starts_with('[')) {
+      if (!host.ends_with(']')) {
+        return std::nullopt;
+      }
+      address = IpAddress::tryParse(host.substr(1, host.size() - 2));
+      if (address and address->isV4()) {
+        return std::nullopt;
+      }
+    } else if (!host.empty()) {
+      // Bare IPv6 is ambiguous with the port separator
+      if (host.contains(':')) {
+        return std::nullopt;
+      }
+      address = IpAddress::tryParse(host);
+    }
+    if (!address) {
+      return std::nullopt;
+    }
 
-  consteval explicit operator std::string_view() const {
-    return std::string_view(str_, N);
+    std::uint16_t port = 0;
+    auto [ptr, ec] = std::from_chars(
+        port_str.data(), port_str.data() + port_str.size(), port);
+    if (ec != std::errc() or port_str.empty() or
+        ptr != port_str.data() + port_str.size()) {
+      return std::nullopt;
+    }
+    return Endpoint(*address, port);
   }
 
-  [[nodiscard]] consteval auto operator[](std::size_t n) const {
-    return str_[n];
+  [[nodiscard]] static auto parse(std::string_view value, std::string_view key)
+      -> Endpoint {
+    auto ret = tryParse(value);
+    if (!ret) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: {} is not an endpoint", key, value));
+    }
+    return *ret;
   }
 
-  consteval auto operator[](std::size_t n) -> char& {
-    return str_[n];
+  [[nodiscard]] constexpr auto address() const -> IpAddress {
+    return this->address_;
   }
 
-  consteval auto removeTrail() {
-    String<N - 1> ret;
-    for (std::size_t i = 0; i < N - 1; i++) {
-      ret[i] = str_[i];
-    }
-    return ret;
+  [[nodiscard]] constexpr auto port() const -> std::uint16_t {
+    return this->port_;
   }
 
-  template <std::size_t M>
-  consteval auto operator+(const String<M>& rhs) -> String<N + M> {
-    String<N + M> ret;
-    for (std::size_t i = 0; i < N; i++) {
-      ret[i] = str_[i];
-    }
-    for (std::size_t i = 0; i < M; i++) {
-      ret[i + N] = rhs[i];
-    }
-    return ret;
-  }
+  constexpr auto operator<=>(const Endpoint&) const = default;
 };
 
-template <std::size_t N>
-String(const char (&)[N]) -> String<N - 1>;
-
 /*!
- * Convert typename to consteval String
+ * Sort prefixes and drop the ones covered by another prefix
+ * Remaining prefixes are disjoint, which contains() relies on.
  */
-template <class T>
-consteval auto get_type_name_base_type([[maybe_unused]] std::size_t n = 0) {
-  if constexpr (std::is_same_v<T, bool>) {
-    return String("BOOL");
-  } else if constexpr (std::is_integral_v<T>) {
-    return String("NUMBER");
-  } else if constexpr (std::is_floating_point_v<T>) {
-    return String("FLOAT");
-  } else if constexpr (std::is_same_v<T, const char*> or
-                       std::is_same_v<T, std::string> or
-                       std::is_same_v<T, std::string_view>) {
-    return String("STRING");
-  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
-    return String("PATH");
-  } else {
-    return String("UNKNOWN");
-  }
-}
-
-template <class T, NArgs TNArgs>
-consteval auto get_base_type_name_form_stl() {
-  if constexpr (is_array_v<T>) {
-    return []<std::size_t... Is>(std::index_sequence<Is...>) consteval {
-      return ((get_type_name_base_type<array_base_t<T>>(Is) + String(",")) +
-              ...);
-    }(std::make_index_sequence<TNArgs.nargs>())
-               .removeTrail();
-  } else if constexpr (is_vector_v<T>) {
-    return []<std::size_t... Is>(std::index_sequence<Is...>) consteval {
-      return ((get_type_name_base_type<vector_base_t<T>>(Is) + String(",")) +
-              ...)
-          .removeTrail();
-    }(std::make_index_sequence<TNArgs.nargs>());
-  } else if constexpr (is_tuple_v<T>) {
-    return []<class... U>(type_sequence<U...>) consteval {
-      return (((get_type_name_base_type<vector_base_t<U>>()) + String(",")) +
-              ...);
-    }(make_type_sequence_t<T>())
-               .removeTrail();
-  } else {
-    return String("UNKNOWN");
-  }
-}
-
-template <class T, NArgs TNArgs>
-consteval auto get_type_name() {
-  if constexpr (is_array_v<T> or TNArgs.nargs > 1) {
-    return String("<") + get_base_type_name_form_stl<T, TNArgs>() + String(">");
-  } else if constexpr (TNArgs.nargs == 1) {
-    if constexpr (is_vector_v<T>) {
-      return get_type_name_base_type<vector_base_t<T>>();
-    } else {
-      return get_type_name_base_type<T>();
-    }
-  } else if constexpr (is_vector_v<T>) {
-    if constexpr (TNArgs.nargs_char == '*') {
-      return String("[<") + get_type_name_base_type<vector_base_t<T>>() +
-             String(",...>]");
-    } else if constexpr (TNArgs.nargs_char == '+') {
-      return String("<") + get_type_name_base_type<vector_base_t<T>>() +
-             String(",...>");
-    }
-  } else {
-    if constexpr (TNArgs.nargs_char == '?') {
-      return String("[<") + get_type_name_base_type<T>() + String(">]");
+inline auto SortPrefixes(std::vector<Cidr>& table) -> void {
+  std::ranges::sort(table);
+  auto out = table.begin();
+  for (auto it = table.begin(); it != table.end(); it++) {
+    if (out != table.begin() and std::prev(out)->contains(*it)) {
+      continue;
     }
+    *out++ = *it;
   }
+  table.erase(out, table.end());
 }
 
-struct ArgTag {};
-
 /*!
- * Arg type this holds argument value
+ * O(log n) lookup in a table normalized by SortPrefixes
+ * std::vector<Cidr> arguments are normalized at the end of parse, whether
+ * their values came from the command line, a config file or the environment.
  */
-template <class Type, ArgName Name, NArgs TNArgs, bool Required, ParserID ID>
-struct Arg : ArgTag {
-  using type =             //
-      std::conditional_t<  //
-          ((TNArgs.nargs <= 1) && (TNArgs.nargs_char != '+') &&
-           (TNArgs.nargs_char != '*'))                              //
-              || is_array_v<Type>                                   //
-              || is_tuple_v<Type>                                   //
-              || is_vector_v<Type>,                                 //
-          Type,                                                     //
-          std::conditional_t<                                       //
-              (TNArgs.nargs > 1),                                   //
-              std::array<Type, static_cast<std::size_t>(TNArgs.nargs)>,  //
-              std::vector<Type>                                     //
-              >                                                     //
-          >;                                                        //
-  using baseType = std::conditional_t<                              //
-      is_array_v<Type>,                                             //
-      array_base_t<Type>,                                           //
-      std::conditional_t<                                           //
-          is_vector_v<Type>,                                        //
-          vector_base_t<Type>,                                      //
-          Type                                                      //
-          >                                                         //
-      >;
-  static constexpr auto name = Name;
-  inline static std::string_view description{};
-  inline static bool assigned = false;
-  inline static bool required = Required;
-  inline static type value = {};
-  inline static type defaultValue = {};
-  inline static constexpr NArgs nargs = TNArgs;
-  inline static std::function<type(std::string_view)> caster = nullptr;
-  inline static std::function<void(
-      const type& value, std::span<std::string_view>, std::string_view)>
-      validator = nullptr;
-  inline static std::function<void(type&, std::span<std::string_view>)>
-      callback = nullptr;
-  inline static constexpr auto typeName = get_type_name<type, TNArgs>();
-};
-
-struct FlagArgTag {};
-
-template <ArgName Name, ParserID ID>
-struct FlagArg : FlagArgTag {
-  using type = bool;
-  using baseType = bool;
-  static constexpr auto name = Name;
-  inline static bool assigned = false;
-  inline static std::string_view description{};
-  inline static type value = false;
-  inline static std::function<void()> callback = nullptr;
-  inline static constexpr auto typeName = String("");
-};
-
-struct HelpArgTag {};
-
-template <ArgName Name, ParserID ID>
-struct HelpArg : HelpArgTag, FlagArgTag {
-  using type = bool;
-  using baseType = bool;
-  static constexpr auto name = Name;
-  inline static bool assigned = false;
-  inline static std::string_view description = "Print help information";
-  inline static type value = false;
-  inline static std::function<void()> callback = nullptr;
-  inline static constexpr auto typeName = String("");
-};
+ARGO_ALWAYS_INLINE inline auto contains(std::span<const Cidr> table,
+                                               IpAddress address) -> bool {
+  auto it = std::ranges::upper_bound(table, address, {}, &Cidr::network);
+  return it != table.begin() and std::prev(it)->contains(address);
+}
 
 }  // namespace Argo
 
 
 namespace Argo {
 
-struct ExplicitDefaultValueTag {};
-
 template <class T>
-struct ExlicitDefaultValue : ExplicitDefaultValueTag {
-  T explicit_default_value;
-};
+struct is_tuple : std::false_type {};
 
-struct ImplicitDefaultValueTag {};
+template <class... T>
+struct is_tuple<std::tuple<T...>> : std::true_type {};
 
 template <class T>
-struct ImplicitDefaultValue : ImplicitDefaultValueTag {
-  T implicit_default_value;
-};
+constexpr bool is_tuple_v = is_tuple<T>::value;
 
-struct Description {
-  std::string_view description;
-};
+template <class T>
+struct is_vector : std::false_type {};
 
-ARGO_ALWAYS_INLINE constexpr auto description(std::string_view desc)
-    -> Description {
-  return {.description = desc};
-}
+template <class T>
+struct is_vector<std::vector<T>> : std::true_type {};
 
 template <class T>
-ARGO_ALWAYS_INLINE constexpr auto explicitDefault(T value)
-    -> ExlicitDefaultValue<T> {
-  return {.explicit_default_value = value};
-}
+constexpr bool is_vector_v = is_vector<T>::value;
 
 template <class T>
-ARGO_ALWAYS_INLINE constexpr auto implicitDefault(T value)
-    -> ImplicitDefaultValue<T> {
-  return {.implicit_default_value = value};
-}
+struct vector_base {
+  using type = T;
+};
 
-template <class Type, ArgName Name, NArgs nargs, bool Required, ParserID ID,
-          class... Args>
-ARGO_ALWAYS_INLINE constexpr auto ArgInitializer(Args... args) -> void {
-  (
-      [&args]() ARGO_ALWAYS_INLINE {
-        using Arg = Arg<Type, Name, nargs, Required, ID>;
-        if constexpr (std::is_same_v<Args, Description>) {
-          Arg::description = args.description;
-        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
-                                               Validation::ValidationBase>) {
-          static_assert(std::is_invocable_v<Args, typename Arg::type,
-                                            std::span<std::string_view>,
-                                            std::string_view>,
-                        "Invalid validator");
-          Arg::validator = args;
-        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
-                                               ImplicitDefaultValueTag>) {
-          Arg::defaultValue = static_cast<Type>(args.implicit_default_value);
-        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
-                                               ExplicitDefaultValueTag>) {
-          Arg::value = static_cast<Type>(args.explicit_default_value);
-        } else if constexpr (std::is_invocable_v<Args, typename Arg::type&,
-                                                 std::span<std::string_view>>) {
-          Arg::callback = args;
-        } else {
-          static_assert(false, "Invalid argument");
-        }
-      }(),
-      ...);
-}
+template <class T>
+struct vector_base<std::vector<T>> {
+  using type = T;
+};
 
-template <ArgName Name, ParserID ID, class... Args>
-ARGO_ALWAYS_INLINE constexpr auto FlagArgInitializer(Args... args) -> void {
-  (
-      [&args]() ARGO_ALWAYS_INLINE {
-        using FlagArg = FlagArg<Name, ID>;
-        if constexpr (std::is_same_v<Args, Description>) {
-          FlagArg::description = args.description;
-        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
-                                               Validation::ValidationBase>) {
-          static_assert(false, "Flag cannot have validator");
-        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
-                                               ImplicitDefaultValueTag>) {
-          static_assert(false, "Flag cannot have implicit default value");
-        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
-                                               ExplicitDefaultValueTag>) {
-          static_assert(false, "Flag cannot have explicit default value");
-        } else if constexpr (std::is_invocable_v<Args>) {
-          FlagArg::callback = args;
-        } else {
-          static_assert(false, "Invalid argument");
-        }
-      }(),
-      ...);
-}
+/*!
+ * Base of argument types whose value is a view over the command line
+ */
+struct LazyArgsTag {};
 
-};  // namespace Argo
+template <class T>
+constexpr bool is_lazy_args_v = std::derived_from<T, LazyArgsTag>;
 
+template <class T>
+  requires is_lazy_args_v<T>
+struct vector_base<T> {
+  using type = typename T::value_type;
+};
 
-namespace Argo {
+template <class T>
+using vector_base_t = vector_base<T>::type;
 
-struct ArgInfo {
-  std::string_view name;
-  char shortName;
-  std::string_view description;
-  bool required;
-  std::string_view typeName;
+/*!
+ * std::map, std::flat_map or any other ordered associative container with
+ * mapped_type, duplicated keys are merged with key_comp
+ */
+template <class T>
+constexpr bool is_map_v = requires(const T& map) {
+  typename T::key_type;
+  typename T::mapped_type;
+  typename T::key_compare;
+  map.key_comp();
 };
 
-template <class Args>
-ARGO_ALWAYS_INLINE constexpr auto HelpGenerator() {
-  std::vector<ArgInfo> ret;
-  tuple_type_visit<Args>([&ret]<class T>(T) {
-    if constexpr (std::derived_from<typename T::type, ArgTag>) {
-      ret.emplace_back(
-          T::type::name.getKey().substr(0, T::type::name.getKeyLen()),  //
-          T::type::name.getShortName(),                                 //
-          T::type::description,                                         //
-          T::type::required,                                            //
-          std::string_view(T::type::typeName));
-    } else {
-      ret.emplace_back(
-          T::type::name.getKey().substr(0, T::type::name.getKeyLen()),  //
-          T::type::name.getShortName(),                                 //
-          T::type::description,                                         //
-          false,                                                        //
-          std::string_view(T::type::typeName));
-    }
-  });
-  return ret;
+template <class T>
+struct is_array : std::false_type {};
+
+template <class T, std::size_t N>
+struct is_array<std::array<T, N>> : std::true_type {};
+
+template <class T>
+constexpr bool is_array_v = is_array<T>::value;
+
+template <class T>
+struct array_len {
+  static constexpr std::size_t value = 0;
 };
 
-struct SubCommandInfo {
-  std::string_view name;
-  std::string_view description;
+template <class T, std::size_t N>
+struct array_len<std::array<T, N>> {
+  static constexpr std::size_t value = N;
 };
 
 template <class T>
-ARGO_ALWAYS_INLINE constexpr auto SubParserInfo(T subparsers) {
-  std::vector<SubCommandInfo> ret{};
-  if constexpr (!std::is_same_v<T, std::tuple<>>) {
-    std::apply(
-        [&ret]<class... Parser>(Parser... parser) ARGO_ALWAYS_INLINE {
-          (..., ret.emplace_back(parser.name.getKey(), parser.description));
-        },
-        subparsers);
-  }
-  return ret;
+constexpr std::size_t array_len_v = array_len<T>::value;
+
+template <class T>
+struct array_base {
+  using type = T;
 };
 
-}  // namespace Argo
+template <class T, std::size_t N>
+struct array_base<std::array<T, N>> {
+  using type = T;
+};
 
+template <class T>
+using array_base_t = array_base<T>::type;
 
-namespace Argo {
+template <class T, class... U>
+struct tuple_append {
+  using type = std::tuple<U..., T>;
+};
 
-template <class Arguments>
-ARGO_ALWAYS_INLINE constexpr auto GetkeyFromShortKey(char key)
-    -> std::tuple<std::string_view, bool> {
-  auto name = std::string_view();
-  auto is_flag = true;
-  if ([&]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
-        return ([&] {
-          if (T::name.getShortName() == key) {
-            name = T::name.getKey();
-            if constexpr (!std::derived_from<T, FlagArgTag>) {
-              is_flag = false;
-            }
-            return true;
-          }
-          return false;
-        }() || ...);
-      }(make_type_sequence_t<Arguments>())) [[likely]] {
-    return std::make_tuple(name, is_flag);
-  }
-  throw ParserInternalError("Fail to lookup");
-}
+template <class T, class... U>
+struct tuple_append<std::tuple<U...>, T> {
+  using type = std::tuple<U..., T>;
+};
 
-/*!
- * Index Search meta function
- */
-template <class Tuple, ArgName Name>
-consteval auto SearchIndex() -> int {
-  int value = -1;
-  if ([&value]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
-        return ((value++, Name == T::name) || ...);
-      }(make_type_sequence_t<Tuple>())) {
-    return value;
-  }
-  return -1;
+template <class... T>
+using tuple_append_t = typename tuple_append<T...>::type;
+
+template <class... T>
+struct type_sequence {};
+
+template <class T>
+struct make_type_sequence {};
+
+template <class... T>
+struct make_type_sequence<std::tuple<T...>> {
+  using type = type_sequence<T...>;
+};
+
+template <class T>
+using make_type_sequence_t = make_type_sequence<T>::type;
+
+template <class Tuple, class T>
+ARGO_ALWAYS_INLINE constexpr auto tuple_type_visit(T fun) {
+  [&fun]<class... U>(type_sequence<U...>) ARGO_ALWAYS_INLINE {
+    (fun(std::type_identity<U>()), ...);
+  }(make_type_sequence_t<Tuple>());
 }
 
-/*!
- * Index Search meta function
- */
-template <class Tuple, char C>
-consteval auto SearchIndexFromShortName() -> int {
-  int value = -1;
-  if ([&value]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
-        return ((value++, C == T::name.getShortName()) || ...);
-      }(make_type_sequence_t<Tuple>())) {
-    return value;
-  }
-  return -1;
+template <class Tuple, class T>
+ARGO_ALWAYS_INLINE constexpr auto tuple_type_or_visit(T fun) -> bool {
+  return [&fun]<class... U>(type_sequence<U...>) ARGO_ALWAYS_INLINE {
+    return (fun(std::type_identity<U>()) || ...);
+  }(make_type_sequence_t<Tuple>());
 }
 
-/*!
- * Index Search meta function
- */
-template <class Tuple>
-ARGO_ALWAYS_INLINE constexpr auto IsFlag(char c) -> bool {
-  return [&c]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
-    return ((c == T::name.getShortName()) || ...);
+template <class Tuple, class T>
+ARGO_ALWAYS_INLINE constexpr auto tuple_type_and_visit(T fun) -> bool {
+  return [&fun]<class... U>(type_sequence<U...>) ARGO_ALWAYS_INLINE {
+    return (fun(std::type_identity<U>()) && ...);
   }(make_type_sequence_t<Tuple>());
 }
 
 };  // namespace Argo
 
 
-namespace Argo {
+namespace Argo::Validation {
 
-/*!
- * Helper class of assigning value
- */
-template <class Type>
-ARGO_ALWAYS_INLINE constexpr auto ArgCaster(const std::string_view& value,
-                                            const std::string_view& key)
-    -> Type {
-  if constexpr (std::is_same_v<Type, bool>) {
-    if ((value == "true")     //
-        || (value == "True")  //
-        || (value == "TRUE")  //
-        || (value == "1")) {
-      return true;
-    }
+struct ValidationBase {
+  template <class T>
+  auto operator()(const T& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          format("Option {} has invalid value {}", option_name, value));
+    }
+  }
+
+  template <class T>
+  auto operator()(const T& value, std::span<std::string_view> raw_val) {
+    return this->isValid(value, raw_val);
+  }
+
+  template <class T>
+  [[noreturn]] auto isValid(const T& /* unused */,
+                            std::span<std::string_view> /* unuesd */) const
+      -> bool {
+    static_assert(false, "Invalid validation");
+  };
+
+  ValidationBase() = default;
+  ValidationBase(const ValidationBase&) = default;
+  ValidationBase(ValidationBase&&) = default;
+  auto operator=(const ValidationBase&) -> ValidationBase& = default;
+  auto operator=(ValidationBase&&) -> ValidationBase& = default;
+  virtual ~ValidationBase() = default;
+};
+
+template <std::derived_from<ValidationBase> Lhs,
+          std::derived_from<ValidationBase> Rhs>
+struct AndValidation : ValidationBase {
+ private:
+  Lhs lhs_;
+  Rhs rhs_;
+
+ public:
+  AndValidation(Lhs lhs, Rhs rhs) : lhs_(lhs), rhs_(rhs){};
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          std::format("Option {} has invalid value {}", option_name, values));
+    }
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> raw_values) const
+      -> bool {
+    return this->lhs_.isValid(value, raw_values) &&
+           this->rhs_.isValid(value, raw_values);
+  };
+};
+
+template <std::derived_from<ValidationBase> Lhs,
+          std::derived_from<ValidationBase> Rhs>
+AndValidation(Lhs, Rhs) -> AndValidation<Lhs, Rhs>;
+
+template <std::derived_from<ValidationBase> Lhs,
+          std::derived_from<ValidationBase> Rhs>
+struct OrValidation : ValidationBase {
+ private:
+  Lhs lhs_;
+  Rhs rhs_;
+
+ public:
+  OrValidation(Lhs lhs, Rhs rhs) : lhs_(lhs), rhs_(rhs){};
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          std::format("Option {} has invalid value {}", option_name, values));
+    }
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> raw_values) const
+      -> bool {
+    return this->lhs_.isValid(value, raw_values) ||
+           this->rhs_.isValid(value, raw_values);
+  };
+};
+
+template <std::derived_from<ValidationBase> Lhs,
+          std::derived_from<ValidationBase> Rhs>
+OrValidation(Lhs, Rhs) -> OrValidation<Lhs, Rhs>;
+
+template <std::derived_from<ValidationBase> Rhs>
+struct InvertValidation : ValidationBase {
+ private:
+  Rhs rhs_;
+
+ public:
+  explicit InvertValidation(Rhs rhs) : rhs_(rhs){};
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          std::format("Option {} has invalid value {}", option_name, values));
+    }
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> raw_values) const
+      -> bool {
+    return !this->rhs_.isValid(value, raw_values);
+  };
+};
+
+template <std::derived_from<ValidationBase> Rhs>
+InvertValidation(Rhs) -> InvertValidation<Rhs>;
+
+template <class T>
+struct Range final : public ValidationBase {
+ private:
+  T min_;
+  T max_;
+
+ public:
+  Range(T min, T max) : min_(min), max_(max){};
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(
+          format("Option {} has invalid value {}", option_name, value));
+    }
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> /* unused */) const
+      -> bool {
+    return static_cast<U>(this->min_) < value &&
+           value < static_cast<U>(this->max_);
+  };
+};
+
+template <class T>
+Range(T min, T max) -> Range<T>;
+
+template <class T>
+struct is_range_validation : std::false_type {};
+
+template <class T>
+struct is_range_validation<Range<T>> : std::true_type {};
+
+/*!
+ * Element-wise validation for container arguments
+ * Example:
+ *      addArg<"ports", std::vector<int>>(Each(Range(0, 1024)))
+ *
+ * Range over contiguous arithmetic values is checked with a min/max
+ * reduction first, so the per-element scan only runs when it fails.
+ */
+template <std::derived_from<ValidationBase> Validator>
+struct Each final : public ValidationBase {
+ private:
+  Validator validator_;
+
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  template <class U>
+  [[nodiscard]] auto findInvalid(const U& value,
+                                 std::span<std::string_view> raw_values) const
+      -> std::size_t {
+    using Elem = std::ranges::range_value_t<U>;
+    if constexpr (is_range_validation<Validator>::value and
+                  std::is_arithmetic_v<Elem> and
+                  std::ranges::contiguous_range<U>) {
+      auto elems = std::span<const Elem>(std::ranges::data(value),
+                                         std::ranges::size(value));
+      if (elems.empty()) {
+        return npos;
+      }
+      auto has_nan = false;
+      if constexpr (std::is_floating_point_v<Elem>) {
+        has_nan = std::ranges::any_of(
+            elems, [](Elem elem) { return std::isnan(elem); });
+      }
+      if (!has_nan) {
+        // Branch free reduction, lowered to packed min/max instructions
+        auto min = elems[0];
+        auto max = elems[0];
+        for (auto elem : elems) {
+          min = elem < min ? elem : min;
+          max = max < elem ? elem : max;
+        }
+        // Range is convex, checking both extremes is enough
+        if (this->validator_.isValid(min, {}) and
+            this->validator_.isValid(max, {})) [[likely]] {
+          return npos;
+        }
+      }
+    }
+    std::size_t index = 0;
+    for (const auto& elem : value) {
+      auto raw = index < raw_values.size() ? raw_values.subspan(index, 1)
+                                           : std::span<std::string_view>();
+      if (!this->validator_.isValid(elem, raw)) {
+        return index;
+      }
+      index++;
+    }
+    return npos;
+  }
+
+ public:
+  explicit Each(Validator validator) : validator_(validator){};
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    auto index = this->findInvalid(value, values);
+    if (index == npos) [[likely]] {
+      return;
+    }
+    if (index < values.size()) {
+      throw ValidationError(
+          std::format("Option {} has invalid value {} at index {}",
+                      option_name, values[index], index));
+    }
+    throw ValidationError(std::format(
+        "Option {} has invalid value at index {}", option_name, index));
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> raw_values) const
+      -> bool {
+    return this->findInvalid(value, raw_values) == npos;
+  };
+};
+
+template <std::derived_from<ValidationBase> Validator>
+Each(Validator) -> Each<Validator>;
+
+enum class PathCheck {
+  Exists,
+  IsFile,
+  IsDir,
+  Readable,
+};
+
+/*!
+ * Filesystem validation for std::filesystem::path and its containers
+ * Lists longer than parallel_threshold are checked concurrently on a bounded
+ * pool of threads, every bad path is reported in one ValidationError.
+ */
+template <PathCheck Check>
+struct PathValidation final : public ValidationBase {
+ private:
+  static constexpr std::size_t parallel_threshold = 256;
+  static constexpr std::size_t max_threads = 16;
+
+  [[nodiscard]] static auto checkOne(const std::filesystem::path& path)
+      -> bool {
+    auto ec = std::error_code();
+    if constexpr (Check == PathCheck::Exists) {
+      return std::filesystem::exists(path, ec);
+    } else if constexpr (Check == PathCheck::IsFile) {
+      return std::filesystem::is_regular_file(path, ec);
+    } else if constexpr (Check == PathCheck::IsDir) {
+      return std::filesystem::is_directory(path, ec);
+    } else {
+      return ::access(path.c_str(), R_OK) == 0;
+    }
+  }
+
+  [[nodiscard]] static constexpr auto reason() -> std::string_view {
+    if constexpr (Check == PathCheck::Exists) {
+      return "does not exist";
+    } else if constexpr (Check == PathCheck::IsFile) {
+      return "is not a regular file";
+    } else if constexpr (Check == PathCheck::IsDir) {
+      return "is not a directory";
+    } else {
+      return "is not readable";
+    }
+  }
+
+  template <class U>
+  [[nodiscard]] static auto findInvalid(const U& value)
+      -> std::vector<std::size_t> {
+    std::vector<std::size_t> invalid;
+    if constexpr (std::is_same_v<U, std::filesystem::path>) {
+      if (!checkOne(value)) {
+        invalid.push_back(0);
+      }
+    } else {
+      static_assert(
+          std::is_same_v<std::ranges::range_value_t<U>, std::filesystem::path>,
+          "Path validation requires std::filesystem::path");
+      auto paths = std::span<const std::filesystem::path>(
+          std::ranges::data(value), std::ranges::size(value));
+      if (paths.size() < parallel_threshold) {
+        for (std::size_t i = 0; i < paths.size(); i++) {
+          if (!checkOne(paths[i])) {
+            invalid.push_back(i);
+          }
+        }
+        return invalid;
+      }
+      // Stats on network filesystems are latency bound, overlap them
+      auto results = std::vector<char>(paths.size(), 1);
+      auto next = std::atomic<std::size_t>(0);
+      auto num_threads = std::min({
+          max_threads,
+          std::max<std::size_t>(std::thread::hardware_concurrency(), 1),
+          paths.size() / parallel_threshold,
+      });
+      {
+        auto workers = std::vector<std::jthread>();
+        workers.reserve(num_threads);
+        for (std::size_t t = 0; t < num_threads; t++) {
+          workers.emplace_back([&paths, &results, &next] {
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed);
+                 i < paths.size();
+                 i = next.fetch_add(1, std::memory_order_relaxed)) {
+              results[i] = static_cast<char>(checkOne(paths[i]));
+            }
+          });
+        }
+      }
+      for (std::size_t i = 0; i < results.size(); i++) {
+        if (results[i] == 0) {
+          invalid.push_back(i);
+        }
+      }
+    }
+    return invalid;
+  }
+
+  template <class U>
+  [[nodiscard]] static auto pathAt(const U& value, std::size_t index)
+      -> const std::filesystem::path& {
+    if constexpr (std::is_same_v<U, std::filesystem::path>) {
+      return value;
+    } else {
+      return std::ranges::data(value)[index];
+    }
+  }
+
+ public:
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> /* unused */,
+                  std::string_view option_name) -> void {
+    auto invalid = findInvalid(value);
+    if (invalid.empty()) [[likely]] {
+      return;
+    }
+    auto paths = std::string();
+    for (auto i : invalid) {
+      paths.append(std::format("\"{}\", ", pathAt(value, i).string()));
+    }
+    paths.resize(paths.size() - 2);
+    throw ValidationError(
+        std::format("Option {}: {} {}", option_name, paths, reason()));
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> /* unused */) const
+      -> bool {
+    return findInvalid(value).empty();
+  };
+};
+
+using Exists = PathValidation<PathCheck::Exists>;
+using IsFile = PathValidation<PathCheck::IsFile>;
+using IsDir = PathValidation<PathCheck::IsDir>;
+using Readable = PathValidation<PathCheck::Readable>;
+
+// template <class Type>
+// struct Callback final : public ValidationBase<Type> {
+//  private:
+//   function<bool(Type)> callback_;
+//
+//  public:
+//   Callback(function<bool(Type)> callback) : callback_(callback){};
+//
+//   auto isValid(const Type& value) const -> bool {
+//     return this->callback_(value);
+//   };
+// };
+
+}  // namespace Argo::Validation
+
+template <std::derived_from<Argo::Validation::ValidationBase> Lhs,
+                 std::derived_from<Argo::Validation::ValidationBase> Rhs>
+auto operator&(Lhs lhs, Rhs rhs) {
+  return Argo::Validation::AndValidation(lhs, rhs);
+}
+
+template <std::derived_from<Argo::Validation::ValidationBase> Lhs,
+                 std::derived_from<Argo::Validation::ValidationBase> Rhs>
+auto operator|(Lhs lhs, Rhs rhs) {
+  return Argo::Validation::OrValidation(lhs, rhs);
+}
+
+template <std::derived_from<Argo::Validation::ValidationBase> Rhs>
+auto operator!(Rhs rhs) {
+  return Argo::Validation::InvertValidation(rhs);
+}
+
+
+namespace Argo {
+
+/*!
+ * ArgName which holds argument name
+ */
+template <std::size_t N>
+struct ArgName {
+  char short_key_ = '\0';
+  char key_[N] = {};
+  std::size_t key_len_ = N;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  consteval ArgName(const char (&lhs)[N + 1]) {
+    for (std::size_t i = 0; i < N; i++) {
+      if (lhs[i] == ',') {
+        this->key_len_ = i;
+        this->short_key_ = lhs[i + 1];
+        return;
+      }
+      this->key_[i] = lhs[i];
+    }
+  };
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto getShortName() const {
+    return this->short_key_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto getKey() const {
+    return std::string_view(this->key_, this->key_len_);
+  }
+
+  [[nodiscard]] constexpr auto getKeyLen() const {
+    return this->key_len_;
+  }
+
+  template <std::size_t M>
+  [[nodiscard]] ARGO_ALWAYS_INLINE consteval auto operator==(
+      const ArgName<M>& lhs) const -> bool {
+    return this->getKey() == lhs.getKey();
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE consteval auto hasValidNameLength() const
+      -> bool {
+    if (this->getShortName() == '\0') {
+      return true;
+    }
+    return (N - this->key_len_) == 2;
+  }
+};
+
+template <std::size_t N>
+ArgName(const char (&)[N]) -> ArgName<N - 1>;
+
+template <class T>
+concept ArgNameType = requires(T& x) {
+  std::is_same_v<decltype(x.getKey()), std::string_view>;
+  std::is_same_v<decltype(x.getShortName()), char>;
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * ParserID which holds parser id
+ * You can set int or string as id
+ * Example:
+ *      // int id
+ *      auto parser = Parser<42>();
+ *      // string id
+ *      auto parser = Parser<"ID">();
+ */
+template <std::size_t N>
+struct ParserID {
+  union {
+    int idInt = 0;
+    char idName[N];
+  } id;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  consteval ParserID(int id) : id(id){};
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  consteval ParserID(const char (&id)[N + 1]) {
+    for (std::size_t i = 0; i < N; i++) {
+      this->id.idName[i] = id[i];
+    }
+  };
+
+  // Set on the copy of a parser used by Reloader, it owns separate values
+  bool shadow = false;
+
+  [[nodiscard]] consteval auto shadowed() const -> ParserID {
+    auto ret = *this;
+    ret.shadow = true;
+    return ret;
+  }
+};
+
+ParserID(int) -> ParserID<1>;
+
+template <std::size_t N>
+ParserID(const char (&)[N]) -> ParserID<N - 1>;
+
+/*!
+ * NArgs which holds number of argument
+ * Available argument:
+ *   ?  : If value specified use it else use default -> ValueType
+ *   int: Exactly (n > 1)                            -> array<ValueType, N>
+ *   *  : Any number of argument if zero use default -> vector<ValueType>
+ *   +  : Any number of argument except zero         -> vector<ValueType>
+ *
+ * Note:
+ *   default value is "?".
+ */
+struct NArgs {
+  int nargs = -1;
+  char nargs_char = '\0';
+
+  constexpr explicit NArgs(char arg) : nargs_char(arg) {}
+
+  constexpr explicit NArgs(int arg) : nargs(arg) {}
+};
+
+/*!
+ * consteval String
+ */
+template <std::size_t N>
+struct String {
+  char str_[N] = {};
+
+  String() = default;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  consteval String(const char (&str)[N + 1]) {
+    for (std::size_t i = 0; i < N; i++) {
+      str_[i] = str[i];
+    }
+  };
+
+  consteval explicit operator std::string() const {
+    return std::string(str_, N);
+  }
+
+  consteval explicit operator std::string_view() const {
+    return std::string_view(str_, N);
+  }
+
+  [[nodiscard]] consteval auto operator[](std::size_t n) const {
+    return str_[n];
+  }
+
+  consteval auto operator[](std::size_t n) -> char& {
+    return str_[n];
+  }
+
+  consteval auto removeTrail() {
+    String<N - 1> ret;
+    for (std::size_t i = 0; i < N - 1; i++) {
+      ret[i] = str_[i];
+    }
+    return ret;
+  }
+
+  template <std::size_t M>
+  consteval auto operator+(const String<M>& rhs) -> String<N + M> {
+    String<N + M> ret;
+    for (std::size_t i = 0; i < N; i++) {
+      ret[i] = str_[i];
+    }
+    for (std::size_t i = 0; i < M; i++) {
+      ret[i + N] = rhs[i];
+    }
+    return ret;
+  }
+};
+
+template <std::size_t N>
+String(const char (&)[N]) -> String<N - 1>;
+
+/*!
+ * Convert typename to consteval String
+ */
+template <class T>
+consteval auto get_type_name_base_type([[maybe_unused]] std::size_t n = 0) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return String("BOOL");
+  } else if constexpr (std::is_integral_v<T> or std::is_enum_v<T>) {
+    return String("NUMBER");
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return String("FLOAT");
+  } else if constexpr (std::is_same_v<T, const char*> or
+                       std::is_same_v<T, std::string> or
+                       std::is_same_v<T, std::string_view>) {
+    return String("STRING");
+  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
+    return String("PATH");
+  } else if constexpr (std::derived_from<T, MappedFileTag>) {
+    return String("FILE");
+  } else if constexpr (std::is_same_v<T, Bytes>) {
+    return String("BYTES");
+  } else if constexpr (is_duration_v<T>) {
+    return String("DURATION");
+  } else if constexpr (is_si_v<T>) {
+    return String("NUMBER");
+  } else if constexpr (is_rate_v<T>) {
+    return String("RATE");
+  } else if constexpr (std::is_same_v<T, IndexSet>) {
+    return String("INDEX_SET");
+  } else if constexpr (std::is_same_v<T, IpAddress>) {
+    return String("ADDRESS");
+  } else if constexpr (std::is_same_v<T, Cidr>) {
+    return String("CIDR");
+  } else if constexpr (std::is_same_v<T, Endpoint>) {
+    return String("HOST:PORT");
+  } else if constexpr (is_map_v<T>) {
+    return String("KEY=VALUE");
+  } else {
+    return String("UNKNOWN");
+  }
+}
+
+template <class T, NArgs TNArgs>
+consteval auto get_base_type_name_form_stl() {
+  if constexpr (is_array_v<T>) {
+    return []<std::size_t... Is>(std::index_sequence<Is...>) consteval {
+      return ((get_type_name_base_type<array_base_t<T>>(Is) + String(",")) +
+              ...);
+    }(std::make_index_sequence<TNArgs.nargs>())
+               .removeTrail();
+  } else if constexpr (is_vector_v<T>) {
+    return []<std::size_t... Is>(std::index_sequence<Is...>) consteval {
+      return ((get_type_name_base_type<vector_base_t<T>>(Is) + String(",")) +
+              ...)
+          .removeTrail();
+    }(std::make_index_sequence<TNArgs.nargs>());
+  } else if constexpr (is_tuple_v<T>) {
+    return []<class... U>(type_sequence<U...>) consteval {
+      return (((get_type_name_base_type<vector_base_t<U>>()) + String(",")) +
+              ...);
+    }(make_type_sequence_t<T>())
+               .removeTrail();
+  } else {
+    return String("UNKNOWN");
+  }
+}
+
+template <class T, NArgs TNArgs>
+consteval auto get_type_name() {
+  if constexpr (is_map_v<T>) {
+    if constexpr (TNArgs.nargs == 1) {
+      return get_type_name_base_type<T>();
+    } else {
+      return String("<") + get_type_name_base_type<T>() + String(",...>");
+    }
+  } else if constexpr (is_array_v<T> or TNArgs.nargs > 1) {
+    return String("<") + get_base_type_name_form_stl<T, TNArgs>() + String(">");
+  } else if constexpr (TNArgs.nargs == 1) {
+    if constexpr (is_vector_v<T>) {
+      return get_type_name_base_type<vector_base_t<T>>();
+    } else {
+      return get_type_name_base_type<T>();
+    }
+  } else if constexpr (is_vector_v<T> or is_lazy_args_v<T>) {
+    if constexpr (TNArgs.nargs_char == '*') {
+      return String("[<") + get_type_name_base_type<vector_base_t<T>>() +
+             String(",...>]");
+    } else if constexpr (TNArgs.nargs_char == '+') {
+      return String("<") + get_type_name_base_type<vector_base_t<T>>() +
+             String(",...>");
+    }
+  } else {
+    if constexpr (TNArgs.nargs_char == '?') {
+      return String("[<") + get_type_name_base_type<T>() + String(">]");
+    }
+  }
+}
+
+/*!
+ * Where the value of an argument came from, later ones take precedence
+ */
+enum class ValueSource {
+  Default,
+  ConfigFile,
+  Environment,
+  CommandLine,
+};
+
+struct ArgTag {};
+
+/*!
+ * Arg type this holds argument value
+ * Append: each occurrence appends to the vector instead of being an error
+ */
+template <class Type, ArgName Name, NArgs TNArgs, bool Required, ParserID ID,
+          bool Append = false>
+struct Arg : ArgTag {
+  using type =             //
+      std::conditional_t<  //
+          ((TNArgs.nargs <= 1) && (TNArgs.nargs_char != '+') &&
+           (TNArgs.nargs_char != '*'))                              //
+              || is_array_v<Type>                                   //
+              || is_tuple_v<Type>                                   //
+              || is_vector_v<Type>                                  //
+              || is_lazy_args_v<Type>                               //
+              || is_map_v<Type>,                                    //
+          Type,                                                     //
+          std::conditional_t<                                       //
+              (TNArgs.nargs > 1),                                   //
+              std::array<Type, static_cast<std::size_t>(TNArgs.nargs)>,  //
+              std::vector<Type>                                     //
+              >                                                     //
+          >;                                                        //
+  using baseType = std::conditional_t<                              //
+      is_array_v<Type>,                                             //
+      array_base_t<Type>,                                           //
+      std::conditional_t<                                           //
+          is_vector_v<Type> || is_lazy_args_v<Type>,                //
+          vector_base_t<Type>,                                      //
+          Type                                                      //
+          >                                                         //
+      >;
+  static_assert(!is_lazy_args_v<Type> or TNArgs.nargs_char == '+' or
+                    TNArgs.nargs_char == '*',
+                "LazyArgs takes nargs('+') or nargs('*')");
+  static constexpr auto name = Name;
+  static constexpr auto id = ID;
+  inline static std::string_view description{};
+  inline static bool assigned = false;
+  inline static ValueSource source = ValueSource::Default;
+  inline static bool required = Required;
+  inline static type value = {};
+  inline static type defaultValue = {};
+  inline static type explicitDefault = {};
+  inline static constexpr NArgs nargs = TNArgs;
+  static constexpr bool append = Append;
+  static constexpr bool repeatable = Append || is_map_v<Type>;
+  inline static baseType (*caster)(std::string_view, std::string_view) =
+      nullptr;
+  inline static std::function<void(
+      const type& value, std::span<std::string_view>, std::string_view)>
+      validator = nullptr;
+  inline static std::function<void(type&, std::span<std::string_view>)>
+      callback = nullptr;
+  inline static constexpr auto defaultTypeName = get_type_name<type, TNArgs>();
+  inline static std::string_view typeName = std::string_view(defaultTypeName);
+
+  template <ParserID NewID>
+  using rebind = Arg<Type, Name, TNArgs, Required, NewID, Append>;
+};
+
+/*!
+ * Validator of each element of a lazy argument, run when it is accessed
+ */
+template <class Arg>
+struct ElementValidator {
+  inline static std::function<void(const typename Arg::baseType& value,
+                                   std::span<std::string_view>,
+                                   std::string_view)>
+      validator = nullptr;
+};
+
+struct FlagArgTag {};
+
+template <ArgName Name, ParserID ID>
+struct FlagArg : FlagArgTag {
+  using type = bool;
+  using baseType = bool;
+  static constexpr auto name = Name;
+  static constexpr auto id = ID;
+  static constexpr bool repeatable = false;
+  inline static bool assigned = false;
+  inline static ValueSource source = ValueSource::Default;
+  inline static std::string_view description{};
+  inline static type value = false;
+  inline static std::function<void()> callback = nullptr;
+  inline static constexpr auto typeName = String("");
+
+  template <ParserID NewID>
+  using rebind = FlagArg<Name, NewID>;
+};
+
+struct CountArgTag {};
+
+/*!
+ * Flag which counts its occurrences, -vvv or -v -v -v gives 3
+ */
+template <ArgName Name, ParserID ID>
+struct CountArg : CountArgTag, FlagArgTag {
+  using type = int;
+  using baseType = int;
+  static constexpr auto name = Name;
+  static constexpr auto id = ID;
+  static constexpr bool repeatable = true;
+  inline static bool assigned = false;
+  inline static ValueSource source = ValueSource::Default;
+  inline static std::string_view description{};
+  inline static type value = 0;
+  inline static std::function<void()> callback = nullptr;
+  inline static constexpr auto typeName = String("");
+
+  template <ParserID NewID>
+  using rebind = CountArg<Name, NewID>;
+};
+
+/*!
+ * Same arguments bound to another parser id
+ */
+template <class Tuple, ParserID NewID>
+struct RebindArgs;
+
+template <class... T, ParserID NewID>
+struct RebindArgs<std::tuple<T...>, NewID> {
+  using type = std::tuple<typename T::template rebind<NewID>...>;
+};
+
+template <class Tuple, ParserID NewID>
+using RebindArgs_t = typename RebindArgs<Tuple, NewID>::type;
+
+struct HelpArgTag {};
+
+template <ArgName Name, ParserID ID>
+struct HelpArg : HelpArgTag, FlagArgTag {
+  using type = bool;
+  using baseType = bool;
+  static constexpr auto name = Name;
+  static constexpr bool repeatable = false;
+  inline static bool assigned = false;
+  inline static std::string_view description = "Print help information";
+  inline static type value = false;
+  inline static std::function<void()> callback = nullptr;
+  inline static constexpr auto typeName = String("");
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+struct ChoicesTag {};
+
+ARGO_ALWAYS_INLINE constexpr auto ChoiceHash(std::string_view str,
+                                             std::uint64_t seed)
+    -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+  for (auto c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash ^ (hash >> 32);
+}
+
+/*!
+ * Search a seed which maps every name to its own slot
+ * Table size is at least N^2 so a seed is found after a few trials.
+ */
+template <std::size_t TableSize, std::size_t N>
+consteval auto BuildChoiceTable(const std::array<std::string_view, N>& names) {
+  std::array<std::uint8_t, TableSize> slots{};
+  for (std::uint64_t seed = 0;; seed++) {
+    slots.fill(0);
+    auto perfect = true;
+    for (std::size_t i = 0; i < N and perfect; i++) {
+      auto& slot = slots[ChoiceHash(names[i], seed) & (TableSize - 1)];
+      perfect = (slot == 0);
+      slot = static_cast<std::uint8_t>(i + 1);
+    }
+    if (perfect) {
+      return std::make_pair(seed, slots);
+    }
+  }
+}
+
+/*!
+ * Choices of string values
+ * Example:
+ *      enum class Mode { Fast, Safe, Debug };
+ *      addArg<"mode", Mode>(choices<"fast", "safe", "debug">())
+ *      addArg<"level", std::string>(choices<"low", "high">())
+ *
+ * For enum arguments the n-th name is converted to static_cast<Enum>(n)
+ * through a compile-time perfect hash, other arguments are validated.
+ */
+template <String... Names>
+struct Choices final : ChoicesTag, Validation::ValidationBase {
+  static_assert(sizeof...(Names) > 0, "Choices must not be empty");
+  static_assert(sizeof...(Names) < 256, "Too many choices");
+
+  static constexpr auto names = std::array<std::string_view, sizeof...(Names)>{
+      std::string_view(Names)...};
+
+  static_assert(
+      [] {
+        for (std::size_t i = 0; i < names.size(); i++) {
+          for (std::size_t j = i + 1; j < names.size(); j++) {
+            if (names[i] == names[j]) {
+              return false;
+            }
+          }
+        }
+        return true;
+      }(),
+      "Duplicated choice");
+
+  static constexpr auto typeName =
+      (String("{") + ... +
+       (std::remove_cvref_t<decltype(Names)>(Names) + String("|")))
+          .removeTrail() +
+      String("}");
+
+ private:
+  static constexpr std::size_t table_size =
+      std::max<std::size_t>(std::bit_ceil(names.size() * names.size()), 4);
+  static constexpr auto table = BuildChoiceTable<table_size>(names);
+
+ public:
+  /*!
+   * Index of the value in Names or -1
+   */
+  [[nodiscard]] ARGO_ALWAYS_INLINE static constexpr auto indexOf(
+      std::string_view value) -> int {
+    auto slot = table.second[ChoiceHash(value, table.first) & (table_size - 1)];
+    if (slot == 0 or names[slot - 1] != value) {
+      return -1;
+    }
+    return slot - 1;
+  }
+
+  template <class Enum>
+  static auto cast(std::string_view value, std::string_view key) -> Enum {
+    auto index = indexOf(value);
+    if (index < 0) [[unlikely]] {
+      throw InvalidArgument(std::format("Argument {}: {} is not one of {}", key,
+                                        value, std::string_view(typeName)));
+    }
+    return static_cast<Enum>(index);
+  }
+
+  template <class U>
+  auto operator()(const U& value, std::span<std::string_view> values,
+                  std::string_view option_name) -> void {
+    if (!this->isValid(value, values)) [[unlikely]] {
+      throw ValidationError(std::format("Option {} has invalid value {}",
+                                        option_name, values));
+    }
+  }
+
+  template <class U>
+  auto isValid(const U& value, std::span<std::string_view> /* unused */) const
+      -> bool {
+    if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+      return indexOf(value) >= 0;
+    } else {
+      return std::ranges::all_of(value, [](const auto& elem) {
+        return indexOf(elem) >= 0;
+      });
+    }
+  };
+};
+
+template <String... Names>
+ARGO_ALWAYS_INLINE constexpr auto choices() -> Choices<Names...> {
+  return {};
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+struct ExplicitDefaultValueTag {};
+
+template <class T>
+struct ExlicitDefaultValue : ExplicitDefaultValueTag {
+  T explicit_default_value;
+};
+
+struct ImplicitDefaultValueTag {};
+
+template <class T>
+struct ImplicitDefaultValue : ImplicitDefaultValueTag {
+  T implicit_default_value;
+};
+
+struct Description {
+  std::string_view description;
+};
+
+ARGO_ALWAYS_INLINE constexpr auto description(std::string_view desc)
+    -> Description {
+  return {.description = desc};
+}
+
+template <class T>
+ARGO_ALWAYS_INLINE constexpr auto explicitDefault(T value)
+    -> ExlicitDefaultValue<T> {
+  return {.explicit_default_value = value};
+}
+
+template <class T>
+ARGO_ALWAYS_INLINE constexpr auto implicitDefault(T value)
+    -> ImplicitDefaultValue<T> {
+  return {.implicit_default_value = value};
+}
+
+template <class Type, ArgName Name, NArgs nargs, bool Required, ParserID ID,
+          bool Append, class... Args>
+ARGO_ALWAYS_INLINE constexpr auto ArgInitializer(Args... args) -> void {
+  (
+      [&args]() ARGO_ALWAYS_INLINE {
+        using Arg = Arg<Type, Name, nargs, Required, ID, Append>;
+        if constexpr (std::is_same_v<Args, Description>) {
+          Arg::description = args.description;
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ChoicesTag>) {
+          Arg::typeName = std::string_view(Args::typeName);
+          if constexpr (std::is_enum_v<typename Arg::baseType>) {
+            Arg::caster = &Args::template cast<typename Arg::baseType>;
+          } else if constexpr (is_lazy_args_v<typename Arg::type>) {
+            ElementValidator<Arg>::validator = args;
+          } else {
+            Arg::validator = args;
+          }
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               Validation::ValidationBase>) {
+          if constexpr (is_lazy_args_v<typename Arg::type>) {
+            // Checked on access, element by element
+            ElementValidator<Arg>::validator = args;
+          } else {
+            static_assert(std::is_invocable_v<Args, typename Arg::type,
+                                              std::span<std::string_view>,
+                                              std::string_view>,
+                          "Invalid validator");
+            Arg::validator = args;
+          }
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ImplicitDefaultValueTag>) {
+          Arg::defaultValue = static_cast<Type>(args.implicit_default_value);
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ExplicitDefaultValueTag>) {
+          Arg::value = static_cast<Type>(args.explicit_default_value);
+          Arg::explicitDefault = Arg::value;
+        } else if constexpr (std::is_invocable_v<Args, typename Arg::type&,
+                                                 std::span<std::string_view>>) {
+          Arg::callback = args;
+        } else {
+          static_assert(false, "Invalid argument");
+        }
+      }(),
+      ...);
+}
+
+template <class FlagArg, class... Args>
+ARGO_ALWAYS_INLINE constexpr auto FlagArgInitializer(Args... args) -> void {
+  (
+      [&args]() ARGO_ALWAYS_INLINE {
+        if constexpr (std::is_same_v<Args, Description>) {
+          FlagArg::description = args.description;
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ChoicesTag>) {
+          static_assert(false, "Flag cannot have choices");
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               Validation::ValidationBase>) {
+          static_assert(false, "Flag cannot have validator");
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ImplicitDefaultValueTag>) {
+          static_assert(false, "Flag cannot have implicit default value");
+        } else if constexpr (std::derived_from<std::remove_cvref_t<Args>,
+                                               ExplicitDefaultValueTag>) {
+          static_assert(false, "Flag cannot have explicit default value");
+        } else if constexpr (std::is_invocable_v<Args>) {
+          FlagArg::callback = args;
+        } else {
+          static_assert(false, "Invalid argument");
+        }
+      }(),
+      ...);
+}
+
+};  // namespace Argo
+
+
+namespace Argo {
+
+struct ArgInfo {
+  std::string_view name;
+  char shortName;
+  std::string_view description;
+  bool required;
+  std::string_view typeName;
+};
+
+template <class Args>
+ARGO_ALWAYS_INLINE constexpr auto HelpGenerator() {
+  std::vector<ArgInfo> ret;
+  tuple_type_visit<Args>([&ret]<class T>(T) {
+    if constexpr (std::derived_from<typename T::type, ArgTag>) {
+      ret.emplace_back(
+          T::type::name.getKey().substr(0, T::type::name.getKeyLen()),  //
+          T::type::name.getShortName(),                                 //
+          T::type::description,                                         //
+          T::type::required,                                            //
+          std::string_view(T::type::typeName));
+    } else {
+      ret.emplace_back(
+          T::type::name.getKey().substr(0, T::type::name.getKeyLen()),  //
+          T::type::name.getShortName(),                                 //
+          T::type::description,                                         //
+          false,                                                        //
+          std::string_view(T::type::typeName));
+    }
+  });
+  return ret;
+};
+
+struct SubCommandInfo {
+  std::string_view name;
+  std::string_view description;
+};
+
+template <class T>
+ARGO_ALWAYS_INLINE constexpr auto SubParserInfo(T subparsers) {
+  std::vector<SubCommandInfo> ret{};
+  if constexpr (!std::is_same_v<T, std::tuple<>>) {
+    std::apply(
+        [&ret]<class... Parser>(Parser... parser) ARGO_ALWAYS_INLINE {
+          (..., ret.emplace_back(parser.name.getKey(), parser.description));
+        },
+        subparsers);
+  }
+  return ret;
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+template <class Arguments>
+ARGO_ALWAYS_INLINE constexpr auto GetkeyFromShortKey(char key)
+    -> std::tuple<std::string_view, bool> {
+  auto name = std::string_view();
+  auto is_flag = true;
+  if ([&]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+        return ([&] {
+          if (T::name.getShortName() == key) {
+            name = T::name.getKey();
+            if constexpr (!std::derived_from<T, FlagArgTag>) {
+              is_flag = false;
+            }
+            return true;
+          }
+          return false;
+        }() || ...);
+      }(make_type_sequence_t<Arguments>())) [[likely]] {
+    return std::make_tuple(name, is_flag);
+  }
+  throw ParserInternalError("Fail to lookup");
+}
+
+/*!
+ * Index Search meta function
+ */
+template <class Tuple, ArgName Name>
+consteval auto SearchIndex() -> int {
+  int value = -1;
+  if ([&value]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+        return ((value++, Name == T::name) || ...);
+      }(make_type_sequence_t<Tuple>())) {
+    return value;
+  }
+  return -1;
+}
+
+/*!
+ * Index Search meta function
+ */
+template <class Tuple, char C>
+consteval auto SearchIndexFromShortName() -> int {
+  int value = -1;
+  if ([&value]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+        return ((value++, C == T::name.getShortName()) || ...);
+      }(make_type_sequence_t<Tuple>())) {
+    return value;
+  }
+  return -1;
+}
+
+/*!
+ * Index Search meta function
+ */
+template <class Tuple>
+ARGO_ALWAYS_INLINE constexpr auto IsFlag(char c) -> bool {
+  return [&c]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+    return ((c == T::name.getShortName()) || ...);
+  }(make_type_sequence_t<Tuple>());
+}
+
+/*!
+ * Whether key is the long key of one of the arguments
+ */
+template <class Tuple>
+ARGO_ALWAYS_INLINE constexpr auto IsKnownKey(std::string_view key) -> bool {
+  return [&key]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+    return ((key == T::name.getKey()) || ...);
+  }(make_type_sequence_t<Tuple>());
+}
+
+/*!
+ * Number of values the option key takes, -1 for any number or when key is
+ * not an option
+ */
+template <class Tuple>
+ARGO_ALWAYS_INLINE constexpr auto ValueCount(std::string_view key) -> int {
+  auto count = -1;
+  [&]<class... T>(type_sequence<T...>) ARGO_ALWAYS_INLINE {
+    return ([&] {
+      if (key != T::name.getKey()) {
+        return false;
+      }
+      if constexpr (std::derived_from<T, FlagArgTag>) {
+        count = 0;
+      } else if constexpr (T::nargs.nargs_char == '?') {
+        count = 1;
+      } else if constexpr (T::nargs.nargs_char == '\0') {
+        count = T::nargs.nargs;
+      }
+      return true;
+    }() || ...);
+  }(make_type_sequence_t<Tuple>());
+  return count;
+}
+
+/*!
+ * Whether the keys of -abc are short keys of the arguments, up to the first
+ * one taking a value since the rest of the token is its value
+ */
+template <class Tuple>
+constexpr auto IsKnownShortKeys(std::string_view keys) -> bool {
+  for (auto c : keys) {
+    if (!IsFlag<Tuple>(c)) {
+      return false;
+    }
+    if (!std::get<1>(GetkeyFromShortKey<Tuple>(c))) {
+      return true;
+    }
+  }
+  return true;
+}
+
+};  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Bit n is set for the n-th argument of a parser
+ */
+template <std::size_t N>
+struct ArgMask {
+  std::array<std::uint64_t, (N + 63) / 64> words{};
+
+  ARGO_ALWAYS_INLINE constexpr auto set(std::size_t index, bool value = true)
+      -> void {
+    this->words[index / 64] |= static_cast<std::uint64_t>(value)
+                               << (index % 64);
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto test(std::size_t index) const
+      -> bool {
+    return ((this->words[index / 64] >> (index % 64)) & 1) != 0;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto operator&(
+      const ArgMask& rhs) const -> ArgMask {
+    auto ret = ArgMask();
+    for (std::size_t i = 0; i < this->words.size(); i++) {
+      ret.words[i] = this->words[i] & rhs.words[i];
+    }
+    return ret;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE constexpr auto count() const
+      -> std::size_t {
+    std::size_t ret = 0;
+    for (auto word : this->words) {
+      ret += std::popcount(word);
+    }
+    return ret;
+  }
+
+  constexpr auto operator==(const ArgMask&) const -> bool = default;
+};
+
+/*!
+ * Whether Arg counts as given for constraints. A flag set to false or 0 by a
+ * config file or the environment is assigned, but not given
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto IsGiven() -> bool {
+  if constexpr (std::derived_from<Arg, FlagArgTag>) {
+    return Arg::assigned and static_cast<bool>(Arg::value);
+  } else {
+    return Arg::assigned;
+  }
+}
+
+template <class Args>
+ARGO_ALWAYS_INLINE constexpr auto AssignedMask()
+    -> ArgMask<std::tuple_size_v<Args>> {
+  auto ret = ArgMask<std::tuple_size_v<Args>>();
+  [&ret]<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
+    (..., ret.set(Is, IsGiven<std::tuple_element_t<Is, Args>>()));
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  return ret;
+}
+
+enum class ConstraintKind {
+  Exclusive,
+  DependsOn,
+  OneOf,
+};
+
+struct ConstraintTag {};
+
+/*!
+ * Constraint between arguments checked at the end of parse
+ *   Exclusive: at most one of Names
+ *   DependsOn: if the first name is given, all the others are required
+ *   OneOf:     at least one of Names
+ */
+template <ConstraintKind Kind, ArgName... Names>
+struct Constraint : ConstraintTag {
+  static_assert(sizeof...(Names) >= 2, "Constraint needs two or more names");
+
+  template <class Args>
+  static consteval auto refersTo() -> bool {
+    return (... && (SearchIndex<Args, Names>() != -1));
+  }
+
+ private:
+  template <class Args>
+  static constexpr auto indices =
+      std::array<int, sizeof...(Names)>{SearchIndex<Args, Names>()...};
+
+  template <class Args, std::size_t Skip>
+  static consteval auto mask() -> ArgMask<std::tuple_size_v<Args>> {
+    auto ret = ArgMask<std::tuple_size_v<Args>>();
+    for (std::size_t i = Skip; i < indices<Args>.size(); i++) {
+      ret.set(indices<Args>[i]);
+    }
+    return ret;
+  }
+
+ public:
+  template <class Args>
+  ARGO_ALWAYS_INLINE static auto check(
+      const ArgMask<std::tuple_size_v<Args>>& assigned) -> void {
+    static constexpr auto group = mask<Args, 0>();
+    static constexpr auto names =
+        std::array<std::string_view, sizeof...(Names)>{Names.getKey()...};
+    auto given = [&assigned](bool want) {
+      auto ret = std::vector<std::string_view>();
+      for (std::size_t i = 0; i < names.size(); i++) {
+        if (assigned.test(indices<Args>[i]) == want) {
+          ret.push_back(names[i]);
+        }
+      }
+      return ret;
+    };
+
+    if constexpr (Kind == ConstraintKind::Exclusive) {
+      if ((assigned & group).count() > 1) [[unlikely]] {
+        throw InvalidArgument(std::format(
+            "Arguments {} are mutually exclusive", given(true)));
+      }
+    } else if constexpr (Kind == ConstraintKind::DependsOn) {
+      static constexpr auto rest = mask<Args, 1>();
+      if (assigned.test(indices<Args>[0]) and (assigned & rest) != rest)
+          [[unlikely]] {
+        throw InvalidArgument(std::format("Argument {} requires {}", names[0],
+                                          given(false)));
+      }
+    } else {
+      if ((assigned & group).count() == 0) [[unlikely]] {
+        throw InvalidArgument(std::format("One of {} is required", names));
+      }
+    }
+  }
+};
+
+template <ArgName... Names>
+ARGO_ALWAYS_INLINE constexpr auto exclusive()
+    -> Constraint<ConstraintKind::Exclusive, Names...> {
+  return {};
+}
+
+/*!
+ * `requires` is a keyword, dependsOn<"tls-key", "tls-cert">() reads as
+ * "tls-key depends on tls-cert"
+ */
+template <ArgName... Names>
+ARGO_ALWAYS_INLINE constexpr auto dependsOn()
+    -> Constraint<ConstraintKind::DependsOn, Names...> {
+  return {};
+}
+
+template <ArgName... Names>
+ARGO_ALWAYS_INLINE constexpr auto oneOf()
+    -> Constraint<ConstraintKind::OneOf, Names...> {
+  return {};
+}
+
+/*!
+ * One mask test per constraint, names are collected only on failure
+ */
+template <class Args, class Constraints>
+ARGO_ALWAYS_INLINE constexpr auto CheckConstraints() -> void {
+  if constexpr (std::tuple_size_v<Constraints> != 0) {
+    auto assigned = AssignedMask<Args>();
+    tuple_type_visit<Constraints>([&assigned]<class T>(T) ARGO_ALWAYS_INLINE {
+      T::type::template check<Args>(assigned);
+    });
+  }
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Values of one option as they are in argv, nothing is copied
+ * The value after "=" of --key=value, or after the key of -kvalue, comes
+ * first when present.
+ */
+class ValueSpan {
+ private:
+  const char* inline_ = nullptr;
+  char* const* argv_ = nullptr;
+  std::size_t size_ = 0;
+  int index_ = 0;
+
+ public:
+  class Iterator {
+   private:
+    const ValueSpan* span_ = nullptr;
+    std::size_t index_ = 0;
+
+   public:
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator() = default;
+    Iterator(const ValueSpan* span, std::size_t index)
+        : span_(span), index_(index) {}
+
+    ARGO_ALWAYS_INLINE auto operator*() const -> std::string_view {
+      return (*this->span_)[this->index_];
+    }
+
+    ARGO_ALWAYS_INLINE auto operator++() -> Iterator& {
+      this->index_++;
+      return *this;
+    }
+
+    ARGO_ALWAYS_INLINE auto operator++(int) -> Iterator {
+      auto ret = *this;
+      this->index_++;
+      return ret;
+    }
+
+    auto operator==(const Iterator&) const -> bool = default;
+  };
+
+  ValueSpan() = default;
+
+  /*!
+   * index is the position of argv[0] in the command line
+   */
+  ValueSpan(const char* inline_value, char* const* argv, std::size_t size,
+            int index)
+      : inline_(inline_value), argv_(argv), size_(size), index_(index) {}
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto size() const -> std::size_t {
+    return this->size_ + (this->inline_ != nullptr ? 1 : 0);
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto empty() const -> bool {
+    return this->size() == 0;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto operator[](std::size_t i) const
+      -> std::string_view {
+    if (this->inline_ != nullptr) {
+      return i == 0 ? this->inline_ : this->argv_[i - 1];
+    }
+    return this->argv_[i];
+  }
+
+  /*!
+   * Position of the first value in the command line
+   */
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto index() const -> int {
+    return this->inline_ != nullptr ? this->index_ - 1 : this->index_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto first(std::size_t count) const
+      -> ValueSpan {
+    if (this->inline_ == nullptr or count == 0) {
+      return {nullptr, this->argv_, count, this->index_};
+    }
+    return {this->inline_, this->argv_, count - 1, this->index_};
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto subspan(std::size_t offset) const
+      -> ValueSpan {
+    if (offset == 0) {
+      return *this;
+    }
+    if (this->inline_ != nullptr) {
+      offset--;
+    }
+    return {nullptr, this->argv_ + offset, this->size_ - offset,
+            this->index_ + static_cast<int>(offset)};
+  }
+
+  [[nodiscard]] auto begin() const -> Iterator {
+    return {this, 0};
+  }
+
+  [[nodiscard]] auto end() const -> Iterator {
+    return {this, this->size()};
+  }
+};
+
+/*!
+ * Compile time tag of the argument passed to a visitor
+ * Example:
+ *      parser.visit(argc, argv, []<class Tag>(Tag, ValueSpan values, int) {
+ *        if constexpr (Tag::key == "threads") { ... }
+ *      });
+ */
+template <class Arg>
+struct VisitTag {
+  static constexpr std::string_view key = Arg::name.getKey();
+  static constexpr char short_key = Arg::name.getShortName();
+  static constexpr bool is_flag = std::derived_from<Arg, FlagArgTag>;
+  using type = typename Arg::type;
+};
+
+/*!
+ * Tag passed to the incremental parser's visitor for every token after "--",
+ * with the token as the only value
+ */
+struct PassthroughTag {
+  static constexpr std::string_view key = "--";
+  static constexpr char short_key = '\0';
+  static constexpr bool is_flag = false;
+  using type = std::string_view;
+};
+
+enum class TokenKind {
+  Long,
+  Short,
+  Positional,
+};
+
+/*!
+ * Position of the first "--" in argv[1, argc), argc when there is none
+ * Options end there, the tokens after it are left to the caller.
+ */
+ARGO_ALWAYS_INLINE constexpr auto OptionsEnd(int argc, char* argv[]) -> int {
+  for (int i = 1; i < argc; i++) {
+    const auto* raw = argv[i];
+    if (raw[0] == '-' and raw[1] == '-' and raw[2] == '\0') [[unlikely]] {
+      return i;
+    }
+  }
+  return argc;
+}
+
+/*!
+ * Split argv[1, end) into options and their values
+ * emit(kind, name, values, position) is called for every option, position is
+ * the index of the option in argv. Values before the first option are
+ * Positional.
+ */
+template <class Args, class Emit>
+ARGO_ALWAYS_INLINE constexpr auto Tokenize(int end, char* argv[], Emit&& emit)
+    -> void {
+  auto kind = TokenKind::Positional;
+  auto name = std::string_view();
+  const char* inline_value = nullptr;
+  int position = 0;
+  int first = 1;
+
+  for (int i = 1; i < end + 1; i++) {
+    auto is_flag = true;
+    if (i != end) {
+      const auto* raw = argv[i];
+      // A lone "-" is a value, usually standing for stdin or stdout
+      is_flag = raw[0] == '-' and raw[1] != '\0';
+      if (is_flag and raw[1] >= '0' and raw[1] <= '9') {
+        // Negative number unless it is a short key
+        is_flag = IsFlag<Args>(raw[1]);
+      }
+    }
+
+    if (i != 1 and is_flag) {
+      emit(kind, name,
+           ValueSpan(inline_value, argv + first,
+                     static_cast<std::size_t>(i - first), first),
+           position);
+    }
+
+    if (i == end) {
+      break;
+    }
+
+    if (is_flag) {
+      auto arg = std::string_view(argv[i]);
+      position = i;
+      first = i + 1;
+      inline_value = nullptr;
+      if (arg.size() > 1 and arg[1] == '-') {
+        kind = TokenKind::Long;
+        auto equal_pos = arg.find('=');
+        if (equal_pos != std::string_view::npos) [[unlikely]] {
+          name = arg.substr(2, equal_pos - 2);
+          inline_value = argv[i] + equal_pos + 1;
+        } else {
+          name = arg.substr(2);
+        }
+      } else {
+        kind = TokenKind::Short;
+        name = arg.substr(1);
+      }
+    }
+  }
+}
+
+/*!
+ * Values left after an option go to the positional arguments in order, the
+ * same way PArgAssigner does
+ */
+template <std::size_t Offset, class PArgs, class Visitor, std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto VisitPositional(ValueSpan values,
+                                                  Visitor& visitor,
+                                                  ArgMask<N>& visited)
+    -> void {
+  if constexpr (std::tuple_size_v<PArgs> != 0) {
+    auto done = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      return ([&]<class Arg, std::size_t I>() ARGO_ALWAYS_INLINE {
+        if (visited.test(Offset + I)) {
+          return false;
+        }
+        auto count = values.size();
+        if constexpr (Arg::nargs.nargs_char != '+') {
+          count = Arg::nargs.nargs;
+          if (values.size() < count) [[unlikely]] {
+            throw InvalidArgument(std::format(
+                "Argument {}: should take exactly {} value but {}",
+                Arg::name.getKey(), count, values.size()));
+          }
+        }
+        visited.set(Offset + I);
+        visitor(VisitTag<Arg>(), values.first(count), values.index());
+        values = values.subspan(count);
+        return values.empty();
+      }.template operator()<std::tuple_element_t<Is, PArgs>, Is>() || ...);
+    }(std::make_index_sequence<std::tuple_size_v<PArgs>>());
+    if (!done) [[unlikely]] {
+      throw InvalidArgument("Duplicated positional argument");
+    }
+  }
+}
+
+/*!
+ * Number of values an option takes, the rest are positional
+ */
+template <class Arg, class PArgs>
+ARGO_ALWAYS_INLINE constexpr auto VisitCount(std::string_view key,
+                                             const ValueSpan& values)
+    -> std::size_t {
+  if constexpr (std::derived_from<Arg, FlagArgTag>) {
+    if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+      if (!values.empty()) [[unlikely]] {
+        throw InvalidArgument(std::format("Flag {} can not take value", key));
+      }
+    }
+    return 0;
+  } else if constexpr (is_map_v<typename Arg::type> or Arg::append) {
+    if (values.empty()) [[unlikely]] {
+      throw InvalidArgument(std::format(
+          "Argument {}: should take at least one value", key));
+    }
+    return Arg::nargs.nargs == 1 ? 1 : values.size();
+  } else if constexpr (Arg::nargs.nargs_char == '?') {
+    return std::min<std::size_t>(1, values.size());
+  } else if constexpr (Arg::nargs.nargs_char == '*' or
+                       Arg::nargs.nargs_char == '+') {
+    if (Arg::nargs.nargs_char == '+' and values.empty()) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: should take more than one value", key));
+    }
+    return values.size();
+  } else {
+    if (values.size() < Arg::nargs.nargs) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: should take exactly {} value but {}", key,
+                      Arg::nargs.nargs, values.size()));
+    }
+    return Arg::nargs.nargs;
+  }
+}
+
+template <class Args, class PArgs, class Visitor, std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto VisitOption(std::string_view key,
+                                              ValueSpan values, int position,
+                                              Visitor& visitor,
+                                              ArgMask<N>& visited) -> void {
+  if (key.empty()) {
+    if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+      throw InvalidArgument(std::format("Invalid argument {}", key));
+    }
+    VisitPositional<std::tuple_size_v<Args>, PArgs>(values, visitor, visited);
+    return;
+  }
+  auto found = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    return ([&]<class Arg, std::size_t I>() ARGO_ALWAYS_INLINE {
+      if (Arg::name.getKey() != key) {
+        return false;
+      }
+      if (!Arg::repeatable and visited.test(I)) [[unlikely]] {
+        throw InvalidArgument(
+            std::format("Argument {}: duplicated argument", key));
+      }
+      auto count = VisitCount<Arg, PArgs>(key, values);
+      visited.set(I);
+      visitor(VisitTag<Arg>(), values.first(count), position);
+      if (count != values.size()) {
+        VisitPositional<std::tuple_size_v<Args>, PArgs>(values.subspan(count),
+                                                        visitor, visited);
+      }
+      return true;
+    }.template operator()<std::tuple_element_t<Is, Args>, Is>() || ...);
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  if (!found) [[unlikely]] {
+    throw InvalidArgument(std::format("Invalid argument {}", key));
+  }
+}
+
+/*!
+ * Combined short keys like -abc, the same rules as ShortArgAssigner
+ * Returns true when the help flag was found
+ */
+template <class Args, class PArgs, class HArg, class Visitor, std::size_t N>
+ARGO_ALWAYS_INLINE constexpr auto VisitShort(std::string_view keys,
+                                             ValueSpan values, int position,
+                                             Visitor& visitor,
+                                             ArgMask<N>& visited) -> bool {
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    auto [found_key, is_flag] = GetkeyFromShortKey<     //
+        std::conditional_t<std::is_same_v<HArg, void>,  //
+                           Args,                        //
+                           tuple_append_t<Args, HArg>>>(keys[i]);
+    if constexpr (!std::is_same_v<HArg, void>) {
+      if (found_key == HArg::name.getKey()) [[unlikely]] {
+        return true;
+      }
+    }
+    auto last = keys.size() - 1 == i;
+    if (is_flag and last) {
+      VisitOption<Args, PArgs>(found_key, values, position, visitor, visited);
+    } else if (is_flag) {
+      VisitOption<Args, PArgs>(found_key, ValueSpan(), position, visitor,
+                               visited);
+    } else if (last) {
+      if (values.empty()) {
+        values = ValueSpan(keys.data() + i + 1, nullptr, 0, position + 1);
+      }
+      VisitOption<Args, PArgs>(found_key, values, position, visitor, visited);
+      return false;
+    } else [[unlikely]] {
+      throw InvalidArgument(std::format("Invalid Flag argument {} {}",
+                                        keys[i], keys.substr(i + 1)));
+    }
+  }
+  return false;
+}
+
+/*!
+ * Required arguments and constraints, from the visited mask
+ */
+template <class Args, class Constraints, std::size_t N>
+auto VisitCheck(const ArgMask<N>& visited) -> void {
+  auto required_keys = std::vector<std::string_view>();
+  [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (..., [&]<class Arg, std::size_t I>() {
+      if constexpr (std::derived_from<Arg, ArgTag>) {
+        if (Arg::required and !visited.test(I)) {
+          required_keys.push_back(Arg::name.getKey());
+        }
+      }
+    }.template operator()<std::tuple_element_t<Is, Args>, Is>());
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  if (!required_keys.empty()) [[unlikely]] {
+    throw InvalidArgument(std::format("Requried {}", required_keys));
+  }
+  tuple_type_visit<Constraints>([&visited]<class T>(T) {
+    T::type::template check<Args>(visited);
+  });
+}
+
+/*!
+ * Number of values after which the option key is complete, npos if it takes
+ * every value up to the next option
+ */
+template <class Args>
+constexpr auto OptionNeed(std::string_view key) -> std::size_t {
+  auto need = std::size_t();
+  auto found = [&]<class... Arg>(type_sequence<Arg...>) {
+    return ([&] {
+      if (Arg::name.getKey() != key) {
+        return false;
+      }
+      if constexpr (std::derived_from<Arg, FlagArgTag>) {
+        need = 0;
+      } else if constexpr (is_map_v<typename Arg::type> or Arg::append) {
+        need = Arg::nargs.nargs == 1 ? 1 : std::string_view::npos;
+      } else if constexpr (Arg::nargs.nargs_char == '?') {
+        need = 1;
+      } else if constexpr (Arg::nargs.nargs_char == '*' or
+                           Arg::nargs.nargs_char == '+') {
+        need = std::string_view::npos;
+      } else {
+        need = Arg::nargs.nargs;
+      }
+      return true;
+    }() || ...);
+  }(make_type_sequence_t<Args>());
+  if (!found) [[unlikely]] {
+    throw InvalidArgument(std::format("Invalid argument {}", key));
+  }
+  return need;
+}
+
+/*!
+ * Values the next positional argument takes, npos for nargs '+' and 0 when
+ * every positional argument is taken
+ */
+template <std::size_t Offset, class PArgs, std::size_t N>
+constexpr auto PositionalNeed(const ArgMask<N>& visited) -> std::size_t {
+  auto need = std::size_t();
+  [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (... || [&]<class Arg, std::size_t I>() {
+      if (visited.test(Offset + I)) {
+        return false;
+      }
+      need = Arg::nargs.nargs_char == '+' ? std::string_view::npos
+                                          : Arg::nargs.nargs;
+      return true;
+    }.template operator()<std::tuple_element_t<Is, PArgs>, Is>());
+  }(std::make_index_sequence<std::tuple_size_v<PArgs>>());
+  return need;
+}
+
+/*!
+ * Parser fed one token at a time, returned by Parser::incremental
+ * Example:
+ *      auto stream = parser.incremental();
+ *      for (auto token : tokens) {
+ *        stream.push(token, visitor);
+ *      }
+ *      stream.finish(visitor);
+ *
+ * The visitor is called like with Parser::visit as soon as an argument and
+ * its values are known: when it has the number of values it takes, or when
+ * the next option or finish ends it. Positions count pushed tokens from 0.
+ * The help flag is passed to the visitor as VisitTag of the help argument
+ * instead of printing help and exiting. Options end at "--" as in parse, each
+ * token after it is passed on its own with PassthroughTag.
+ *
+ * Only the values of the pending argument are kept, copied into a buffer
+ * reused for the next one. Call reset after an exception.
+ */
+template <class Args, class PArgs, class HArg, class Constraints>
+class IncrementalParser {
+ private:
+  using Arguments =
+      decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+  static constexpr auto offset = std::tuple_size_v<Args>;
+
+  enum class Pending {
+    None,
+    Option,
+    Positional,
+  };
+
+  Pending pending_ = Pending::None;
+  bool options_end_ = false;
+  std::string key_;
+  std::size_t need_ = 0;
+  bool short_key_ = false;
+  int position_ = 0;
+  int first_ = 0;
+  int count_ = 0;
+  std::string buffer_;
+  std::vector<std::size_t> offsets_;
+  std::vector<char*> values_;
+  ArgMask<std::tuple_size_v<Arguments>> visited_;
+
+  auto add(std::string_view value) -> void {
+    this->offsets_.push_back(this->buffer_.size());
+    this->buffer_.append(value);
+    this->buffer_.push_back('\0');
+  }
+
+  auto values() -> ValueSpan {
+    this->values_.clear();
+    for (auto offset : this->offsets_) {
+      this->values_.push_back(this->buffer_.data() + offset);
+    }
+    return {nullptr, this->values_.data(), this->values_.size(), this->first_};
+  }
+
+  auto clear() -> void {
+    this->pending_ = Pending::None;
+    this->short_key_ = false;
+    this->buffer_.clear();
+    this->offsets_.clear();
+  }
+
+  template <class Visitor>
+  auto flush(Visitor& visitor) -> void {
+    if (this->pending_ == Pending::Option) {
+      if (this->short_key_ and this->offsets_.empty()) {
+        // -k alone takes the empty rest of the token, as in parse
+        this->first_ = this->position_;
+        this->add("");
+      }
+      VisitOption<Args, PArgs>(this->key_, this->values(), this->position_,
+                               visitor, this->visited_);
+    } else if (this->pending_ == Pending::Positional) {
+      VisitPositional<offset, PArgs>(this->values(), visitor, this->visited_);
+    }
+    this->clear();
+  }
+
+  template <class Visitor>
+  auto startOption(std::string_view key, int position, Visitor& visitor)
+      -> void {
+    this->position_ = position;
+    this->first_ = position + 1;
+    this->key_ = key;
+    this->need_ = OptionNeed<Args>(key);
+    this->pending_ = Pending::Option;
+    if (this->need_ == 0) {
+      this->flush(visitor);
+    }
+  }
+
+  template <class Visitor>
+  auto value(std::string_view value, int position, Visitor& visitor) -> void {
+    if (this->pending_ == Pending::None) {
+      if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+        throw InvalidArgument(
+            std::format("Invalid positional argument: {}", value));
+      }
+      this->pending_ = Pending::Positional;
+      this->first_ = position;
+    }
+    this->add(value);
+    auto need = this->pending_ == Pending::Option
+                    ? this->need_
+                    : PositionalNeed<offset, PArgs>(this->visited_);
+    if (this->offsets_.size() >= need) {
+      this->flush(visitor);
+    }
+  }
+
+ public:
+  template <class Visitor>
+  auto push(std::string_view token, Visitor&& visitor) -> void {
+    auto position = this->count_++;
+    if (this->options_end_) [[unlikely]] {
+      this->first_ = position;
+      this->add(token);
+      visitor(PassthroughTag(), this->values(), position);
+      this->clear();
+      return;
+    }
+    if (token == "--") [[unlikely]] {
+      this->flush(visitor);
+      this->options_end_ = true;
+      return;
+    }
+
+    auto is_flag = token.size() > 1 and token[0] == '-';
+    if (is_flag and token[1] >= '0' and token[1] <= '9') {
+      is_flag = IsFlag<Args>(token[1]);
+    }
+    if (!is_flag) {
+      this->value(token, position, visitor);
+      return;
+    }
+
+    this->flush(visitor);
+    if (token.size() > 1 and token[1] == '-') {
+      auto equal_pos = token.find('=');
+      auto key = token.substr(2, equal_pos - 2);
+      if constexpr (!std::is_same_v<HArg, void>) {
+        if (key == HArg::name.getKey()) {
+          visitor(VisitTag<HArg>(), ValueSpan(), position);
+          return;
+        }
+      }
+      this->startOption(key, position, visitor);
+      if (equal_pos != std::string_view::npos) [[unlikely]] {
+        this->first_ = position;
+        this->value(token.substr(equal_pos + 1), position, visitor);
+      }
+      return;
+    }
+
+    auto keys = token.substr(1);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      auto [found_key, is_flag] = GetkeyFromShortKey<     //
+          std::conditional_t<std::is_same_v<HArg, void>,  //
+                             Args,                        //
+                             tuple_append_t<Args, HArg>>>(keys[i]);
+      if constexpr (!std::is_same_v<HArg, void>) {
+        if (found_key == HArg::name.getKey()) {
+          visitor(VisitTag<HArg>(), ValueSpan(), position);
+          return;
+        }
+      }
+      if (is_flag) {
+        VisitOption<Args, PArgs>(found_key, ValueSpan(), position, visitor,
+                                 this->visited_);
+      } else if (i == keys.size() - 1) {
+        this->startOption(found_key, position, visitor);
+        this->short_key_ = true;
+      } else [[unlikely]] {
+        throw InvalidArgument(std::format("Invalid Flag argument {} {}",
+                                          keys[i], keys.substr(i + 1)));
+      }
+    }
+  }
+
+  /*!
+   * End of the command line, check runs the required and constraint checks
+   * The parser is reset afterwards and can take the next command line.
+   */
+  template <class Visitor>
+  auto finish(Visitor&& visitor, bool check = false) -> void {
+    this->flush(visitor);
+    if (check) {
+      VisitCheck<Arguments, Constraints>(this->visited_);
+    }
+    this->reset();
+  }
+
+  auto reset() -> void {
+    this->clear();
+    this->options_end_ = false;
+    this->visited_ = {};
+    this->count_ = 0;
+  }
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Value of a variadic argument left in argv, converted on access
+ * Example:
+ *      addPositionalArg<"files", Argo::LazyArgs<std::string_view>, nargs('+')>()
+ *      addArg<"ids", Argo::LazyArgs<int>, nargs('*')>(Range(0, 1000))
+ *
+ * Elements are converted and validated each time they are read, nothing is
+ * copied by parse. The view points into the argv given to parse, keep it
+ * alive. Values must come from the command line as separate tokens.
+ */
+template <class T>
+class LazyArgs : public LazyArgsTag {
+ public:
+  using value_type = T;
+  using Validator = std::function<void(
+      const T& value, std::span<std::string_view>, std::string_view)>;
+
+ private:
+  ValueSpan values_;
+  std::string_view key_;
+  T (*cast_)(std::string_view) = nullptr;
+  const Validator* validator_ = nullptr;
+
+ public:
+  class Iterator {
+   private:
+    const LazyArgs* view_ = nullptr;
+    std::ptrdiff_t index_ = 0;
+
+   public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::random_access_iterator_tag;
+
+    Iterator() = default;
+    Iterator(const LazyArgs* view, std::ptrdiff_t index)
+        : view_(view), index_(index) {}
+
+    auto operator*() const -> T {
+      return (*this->view_)[static_cast<std::size_t>(this->index_)];
+    }
+
+    auto operator[](difference_type n) const -> T {
+      return *(*this + n);
+    }
+
+    auto operator++() -> Iterator& {
+      this->index_++;
+      return *this;
+    }
+
+    auto operator++(int) -> Iterator {
+      auto ret = *this;
+      this->index_++;
+      return ret;
+    }
+
+    auto operator--() -> Iterator& {
+      this->index_--;
+      return *this;
+    }
+
+    auto operator--(int) -> Iterator {
+      auto ret = *this;
+      this->index_--;
+      return ret;
+    }
+
+    auto operator+=(difference_type n) -> Iterator& {
+      this->index_ += n;
+      return *this;
+    }
+
+    auto operator-=(difference_type n) -> Iterator& {
+      this->index_ -= n;
+      return *this;
+    }
+
+    friend auto operator+(Iterator it, difference_type n) -> Iterator {
+      return it += n;
+    }
+
+    friend auto operator+(difference_type n, Iterator it) -> Iterator {
+      return it += n;
+    }
+
+    friend auto operator-(Iterator it, difference_type n) -> Iterator {
+      return it -= n;
+    }
+
+    friend auto operator-(const Iterator& lhs, const Iterator& rhs)
+        -> difference_type {
+      return lhs.index_ - rhs.index_;
+    }
+
+    auto operator==(const Iterator& other) const -> bool {
+      return this->index_ == other.index_;
+    }
+
+    auto operator<=>(const Iterator& other) const -> std::strong_ordering {
+      return this->index_ <=> other.index_;
+    }
+  };
+
+  LazyArgs() = default;
+
+  LazyArgs(ValueSpan values, std::string_view key,
+           T (*cast)(std::string_view), const Validator* validator)
+      : values_(values), key_(key), cast_(cast), validator_(validator) {}
+
+  [[nodiscard]] auto size() const -> std::size_t {
+    return this->values_.size();
+  }
+
+  [[nodiscard]] auto empty() const -> bool {
+    return this->values_.empty();
+  }
+
+  /*!
+   * Element i as written on the command line
+   */
+  [[nodiscard]] auto raw(std::size_t i) const -> std::string_view {
+    return this->values_[i];
+  }
+
+  /*!
+   * Element i converted and validated, throws like parse would
+   */
+  [[nodiscard]] auto operator[](std::size_t i) const -> T {
+    auto raw = this->values_[i];
+    auto value = this->cast_(raw);
+    if (this->validator_ != nullptr and *this->validator_) {
+      (*this->validator_)(value, std::span<std::string_view>(&raw, 1),
+                          this->key_);
+    }
+    return value;
+  }
+
+  [[nodiscard]] auto begin() const -> Iterator {
+    return {this, 0};
+  }
+
+  [[nodiscard]] auto end() const -> Iterator {
+    return {this, static_cast<std::ptrdiff_t>(this->size())};
+  }
+};
+
+/*!
+ * Whether one of Args is a LazyArgs
+ */
+template <class Args>
+constexpr bool has_lazy_args_v = []<class... T>(type_sequence<T...>) {
+  return (is_lazy_args_v<typename T::type> || ...);
+}(make_type_sequence_t<Args>());
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Helper class of assigning value
+ */
+template <class Type>
+ARGO_ALWAYS_INLINE constexpr auto ArgCaster(const std::string_view& value,
+                                            const std::string_view& key)
+    -> Type {
+  if constexpr (std::is_same_v<Type, bool>) {
+    if ((value == "true")     //
+        || (value == "True")  //
+        || (value == "TRUE")  //
+        || (value == "1")) {
+      return true;
+    }
     if ((value == "false")     //
         || (value == "False")  //
         || (value == "FALSE")  //
         || (value == "0")) {
       return false;
     }
-    throw InvalidArgument(
-        std::format("Argument {}: {} cannot convert bool", key, value));
-  } else if constexpr (std::is_integral_v<Type>) {
-    Type ret;
-    std::from_chars(value.begin(), value.end(), ret);
-    return ret;
-  } else if constexpr (std::is_floating_point_v<Type>) {
-    return static_cast<Type>(std::stod(std::string(value)));
-  } else if constexpr (std::is_same_v<Type, const char*>) {
-    return value.data();
-  } else {
-    return static_cast<Type>(value);
+    throw InvalidArgument(
+        std::format("Argument {}: {} cannot convert bool", key, value));
+  } else if constexpr (std::is_enum_v<Type>) {
+    return static_cast<Type>(
+        ArgCaster<std::underlying_type_t<Type>>(value, key));
+  } else if constexpr (std::is_integral_v<Type>) {
+    Type ret;
+    std::from_chars(value.begin(), value.end(), ret);
+    return ret;
+  } else if constexpr (std::is_floating_point_v<Type>) {
+    return static_cast<Type>(std::stod(std::string(value)));
+  } else if constexpr (std::is_same_v<Type, const char*>) {
+    return value.data();
+  } else if constexpr (std::is_same_v<Type, Bytes>) {
+    return ParseBytes(value, key);
+  } else if constexpr (is_duration_v<Type>) {
+    return ParseDuration<Type>(value, key);
+  } else if constexpr (is_si_v<Type>) {
+    return ParseSI<Type>(value, key);
+  } else if constexpr (is_rate_v<Type>) {
+    return ParseRate<Type>(value, key);
+  } else if constexpr (std::is_same_v<Type, IndexSet>) {
+    return IndexSet::parse(value, key);
+  } else if constexpr (std::is_same_v<Type, IpAddress> or
+                       std::is_same_v<Type, Cidr> or
+                       std::is_same_v<Type, Endpoint>) {
+    return Type::parse(value, key);
+  } else if constexpr (std::derived_from<Type, MappedFileTag>) {
+    try {
+      return Type(value);
+    } catch (const InvalidArgument& e) {
+      throw InvalidArgument(std::format("Argument {}: {}", key, e.what()));
+    }
+  } else {
+    return static_cast<Type>(value);
+  }
+}
+
+/*!
+ * Cast one value of Arg, enums may have a caster set by choices
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto CastValue(const std::string_view& value) ->
+    typename Arg::baseType {
+  if constexpr (std::is_enum_v<typename Arg::baseType>) {
+    if (Arg::caster != nullptr) {
+      return Arg::caster(value, Arg::name.getKey());
+    }
+  }
+  return ArgCaster<typename Arg::baseType>(value, Arg::name.getKey());
+}
+
+template <class... T, std::size_t... N>
+ARGO_ALWAYS_INLINE constexpr auto TupleAssign(
+    std::tuple<T...>& t, const std::span<std::string_view>& v,
+    std::index_sequence<N...> /* unused */, const std::string_view& key)
+    -> void {
+  ((std::get<N>(t) = ArgCaster<std::remove_cvref_t<decltype(get<N>(t))>>(v[N], key)),
+   ...);
+}
+
+/*!
+ * Raw values of a repeatable argument, validated once at the end of parse
+ * The storage is kept across parses so repeated parsing does not allocate.
+ */
+template <class Arg>
+struct RawValues {
+  inline static std::vector<std::string_view> values;
+};
+
+/*!
+ * KEY=VALUE pairs of a map argument collected during parse
+ */
+template <class Arg>
+struct MapBuffer {
+  inline static std::vector<std::pair<typename Arg::type::key_type,
+                                      typename Arg::type::mapped_type>>
+      pairs;
+
+  ARGO_ALWAYS_INLINE static auto clear() -> void {
+    pairs.clear();
+    RawValues<Arg>::values.clear();
+  }
+};
+
+/*!
+ * Return Arg to its state before parse, the explicit default included.
+ * Containers keep their capacity unless release is set
+ */
+template <class Arg>
+auto ResetArg(bool release) -> void {
+  using Type = typename Arg::type;
+  if constexpr (std::derived_from<Arg, ArgTag>) {
+    if constexpr (is_vector_v<Type> or std::is_same_v<Type, std::string>) {
+      if (release) {
+        Arg::value = Type(Arg::explicitDefault);
+      } else {
+        Arg::value.assign(Arg::explicitDefault.begin(),
+                          Arg::explicitDefault.end());
+      }
+    } else {
+      Arg::value = Arg::explicitDefault;
+    }
+    if constexpr (Arg::append or is_map_v<Type>) {
+      if (release) {
+        RawValues<Arg>::values = {};
+      } else {
+        RawValues<Arg>::values.clear();
+      }
+    }
+    if constexpr (is_map_v<Type>) {
+      if (release) {
+        MapBuffer<Arg>::pairs = {};
+      } else {
+        MapBuffer<Arg>::pairs.clear();
+      }
+    }
+  } else {
+    Arg::value = Type();
+  }
+  Arg::assigned = false;
+  Arg::source = ValueSource::Default;
+}
+
+struct DirtyArg {
+  void (*reset)(bool release);
+  ValueSource* source;
+};
+
+/*!
+ * Arguments of parser ID assigned since the last reset, so resetting and
+ * tagging sources do not walk every argument
+ */
+template <ParserID ID>
+struct DirtyArgs {
+  inline static std::vector<DirtyArg> args;
+};
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto MarkAssigned() -> void {
+  if (!Arg::assigned) {
+    Arg::assigned = true;
+    DirtyArgs<Arg::id>::args.push_back({&ResetArg<Arg>, &Arg::source});
+  }
+}
+
+/*!
+ * Reset only the arguments of parser ID which were assigned
+ */
+template <ParserID ID>
+auto ResetDirtyArgs(bool release = false) -> void {
+  auto& args = DirtyArgs<ID>::args;
+  for (const auto& arg : args) {
+    arg.reset(release);
+  }
+  if (release) {
+    args = {};
+  } else {
+    args.clear();
+  }
+}
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto AfterAssign(
+    const std::span<std::string_view>& values) -> void {
+  MarkAssigned<Arg>();
+  if (Arg::validator) {
+    Arg::validator(Arg::value, values, Arg::name.getKey());
+  }
+  if (Arg::callback) {
+    Arg::callback(Arg::value, values);
+  }
+}
+
+/*!
+ * Values of the token parse of parser ID is assigning, lazy arguments keep a
+ * view of it instead of the copies they are given
+ */
+template <ParserID ID>
+struct TokenValues {
+  inline static ValueSpan span;
+};
+
+template <class Arg>
+auto LazyCast(std::string_view value) -> typename Arg::baseType {
+  return CastValue<Arg>(value);
+}
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto ValiadicArgAssign(
+    const std::span<std::string_view>& values) -> void {
+  if constexpr (is_lazy_args_v<typename Arg::type>) {
+    // values is the tail of the token
+    const auto& token = TokenValues<Arg::id>::span;
+    auto offset = token.size() - values.size();
+    if (!values.empty() and (values.size() > token.size() or
+                             token[offset].data() != values[0].data()))
+        [[unlikely]] {
+      throw InvalidArgument(std::format(
+          "Argument {}: values must be separate command line arguments",
+          Arg::name.getKey()));
+    }
+    Arg::value = typename Arg::type(token.subspan(offset), Arg::name.getKey(),
+                                    &LazyCast<Arg>,
+                                    &ElementValidator<Arg>::validator);
+  } else {
+    Arg::value.resize(values.size());
+    for (std::size_t i = 0; i < values.size(); i++) {
+      Arg::value[i] = CastValue<Arg>(values[i]);
+    }
+  }
+  AfterAssign<Arg>(values);
+}
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto NLengthArgAssign(
+    std::span<std::string_view>& values) -> void {
+  if (Arg::nargs.nargs > values.size()) [[unlikely]] {
+    throw Argo::InvalidArgument(std::format("Argument {}: invalid argument {}",
+                                            Arg::name.getKey(), values));
+  }
+  if constexpr (is_array_v<typename Arg::type>) {
+    for (std::size_t i = 0; i < Arg::nargs.nargs; i++) {
+      Arg::value[i] = CastValue<Arg>(values[i]);
+    }
+  } else if constexpr (is_vector_v<typename Arg::type>) {
+    Arg::value.resize(Arg::nargs.nargs);
+    for (std::size_t i = 0; i < Arg::nargs.nargs; i++) {
+      Arg::value[i] = CastValue<Arg>(values[i]);
+    }
+  } else if constexpr (is_tuple_v<typename Arg::type>) {
+    TupleAssign(
+        Arg::value, values,
+        std::make_index_sequence<std::tuple_size_v<typename Arg::type>>(),
+        Arg::name.getKey());
+  } else {
+    static_assert(false, "Invalid Type");
+  }
+  AfterAssign<Arg>(values.subspan(0, Arg::nargs.nargs));
+  values = values.subspan(Arg::nargs.nargs);
+}
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto ZeroOrOneArgAssign(
+    std::span<std::string_view>& values) -> void {
+  if (values.empty()) {
+    Arg::value = Arg::defaultValue;
+  } else {
+    Arg::value = CastValue<Arg>(values[0]);
+  }
+  AfterAssign<Arg>(values.subspan(0, 1));
+  values = values.subspan(1);
+}
+
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto MapArgAssign(
+    std::span<std::string_view>& values) -> void {
+  using Map = typename Arg::type;
+  if (values.empty()) [[unlikely]] {
+    throw Argo::InvalidArgument(
+        std::format("Argument {}: should take at least one KEY=VALUE",
+                    Arg::name.getKey()));
+  }
+  auto count = (Arg::nargs.nargs == 1) ? 1 : values.size();
+  for (std::size_t i = 0; i < count; i++) {
+    auto pos = values[i].find('=');
+    if (pos == std::string_view::npos) [[unlikely]] {
+      throw Argo::InvalidArgument(std::format(
+          "Argument {}: {} is not KEY=VALUE", Arg::name.getKey(), values[i]));
+    }
+    MapBuffer<Arg>::pairs.emplace_back(
+        ArgCaster<typename Map::key_type>(values[i].substr(0, pos),
+                                          Arg::name.getKey()),
+        ArgCaster<typename Map::mapped_type>(values[i].substr(pos + 1),
+                                             Arg::name.getKey()));
+    RawValues<Arg>::values.push_back(values[i]);
+  }
+  MarkAssigned<Arg>();
+  values = values.subspan(count);
+}
+
+/*!
+ * Build the map with one sort, the last value of a duplicated key wins
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto MapArgFinalize() -> void {
+  auto& pairs = MapBuffer<Arg>::pairs;
+  std::ranges::stable_sort(pairs, Arg::value.key_comp(),
+                           &std::ranges::range_value_t<decltype(pairs)>::first);
+  auto out = pairs.begin();
+  for (auto it = pairs.begin(); it != pairs.end(); it++) {
+    auto next = std::next(it);
+    if (next != pairs.end() and
+        !Arg::value.key_comp()(it->first, next->first)) {
+      continue;
+    }
+    if (out != it) {
+      *out = std::move(*it);
+    }
+    out++;
+  }
+  pairs.erase(out, pairs.end());
+
+  if constexpr (requires { Arg::value.keys(); }) {
+    // flat_map: adopt the sorted containers without re-sorting
+    typename Arg::type::key_container_type keys;
+    typename Arg::type::mapped_container_type mapped;
+    keys.reserve(pairs.size());
+    mapped.reserve(pairs.size());
+    for (auto& [key, value] : pairs) {
+      keys.push_back(std::move(key));
+      mapped.push_back(std::move(value));
+    }
+    Arg::value.replace(std::move(keys), std::move(mapped));
+  } else {
+    Arg::value.clear();
+    for (auto& pair : pairs) {
+      Arg::value.emplace_hint(Arg::value.end(), std::move(pair));
+    }
+  }
+  AfterAssign<Arg>(RawValues<Arg>::values);
+  MapBuffer<Arg>::clear();
+}
+
+/*!
+ * Append values of one occurrence, the first occurrence drops the default
+ */
+template <class Arg>
+ARGO_ALWAYS_INLINE constexpr auto AppendArgAssign(
+    std::span<std::string_view>& values) -> void {
+  if (values.empty()) [[unlikely]] {
+    throw Argo::InvalidArgument(std::format(
+        "Argument {}: should take at least one value", Arg::name.getKey()));
+  }
+  if (!Arg::assigned) {
+    Arg::value.clear();
+    MarkAssigned<Arg>();
+  }
+  auto count = (Arg::nargs.nargs == 1) ? 1 : values.size();
+  for (std::size_t i = 0; i < count; i++) {
+    Arg::value.push_back(CastValue<Arg>(values[i]));
+    RawValues<Arg>::values.push_back(values[i]);
+  }
+  values = values.subspan(count);
+}
+
+template <class PArgs>
+ARGO_ALWAYS_INLINE constexpr auto PArgAssigner(
+    std::span<std::string_view> values) -> bool {
+  return [&values]<class... Arg>(type_sequence<Arg...>) ARGO_ALWAYS_INLINE {
+    return ([&values] ARGO_ALWAYS_INLINE {
+      if (Arg::assigned) {
+        return false;
+      }
+      if constexpr (Arg::nargs.nargs_char == '+') {
+        ValiadicArgAssign<Arg>(values);
+        return true;
+      }
+      if constexpr (Arg::nargs.nargs == 1) {
+        if (values.empty()) [[unlikely]] {
+          throw Argo::InvalidArgument(
+              std::format("Argument {}: should take exactly one value but zero",
+                          Arg::name.getKey()));
+        }
+        ZeroOrOneArgAssign<Arg>(values);
+        return values.empty();
+      }
+      if constexpr (Arg::nargs.nargs > 1) {
+        NLengthArgAssign<Arg>(values);
+        return values.empty();
+      }
+    }() || ...);
+  }(make_type_sequence_t<PArgs>());
+}
+
+template <>
+ARGO_ALWAYS_INLINE constexpr auto PArgAssigner<std::tuple<>>(
+    std::span<std::string_view> /*unused*/) -> bool {
+  return true;
+}
+
+template <class Head, class PArgs>
+ARGO_ALWAYS_INLINE constexpr auto AssignOneArg(
+    const std::string_view& key, std::span<std::string_view> values) -> bool {
+  if (!Head::repeatable and Head::assigned) [[unlikely]] {
+    throw Argo::InvalidArgument(
+        std::format("Argument {}: duplicated argument", key));
+  }
+  if constexpr (std::derived_from<Head, FlagArgTag>) {
+    if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+      if (!values.empty()) [[unlikely]] {
+        throw Argo::InvalidArgument(
+            std::format("Flag {} can not take value", key));
+      }
+    } else {
+      if (!values.empty()) {
+        PArgAssigner<PArgs>(values);
+      }
+    }
+    if constexpr (std::derived_from<Head, CountArgTag>) {
+      Head::value++;
+    } else {
+      Head::value = true;
+    }
+    MarkAssigned<Head>();
+    if (Head::callback) {
+      Head::callback();
+    }
+    return true;
+  } else {
+    if constexpr (is_map_v<typename Head::type>) {
+      MapArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    } else if constexpr (Head::append) {
+      AppendArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    } else if constexpr (Head::nargs.nargs_char == '?') {
+      ZeroOrOneArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    } else if constexpr (Head::nargs.nargs_char == '*') {
+      if (values.empty()) {
+        Head::value = Head::defaultValue;
+        MarkAssigned<Head>();
+        return true;
+      }
+      ValiadicArgAssign<Head>(values);
+      return true;
+    } else if constexpr (Head::nargs.nargs_char == '+') {
+      if (values.empty()) [[unlikely]] {
+        throw Argo::InvalidArgument(
+            std::format("Argument {}: should take more than one value", key));
+      }
+      ValiadicArgAssign<Head>(values);
+      return true;
+    } else if constexpr (Head::nargs.nargs == 1) {
+      if (values.empty()) [[unlikely]] {
+        throw Argo::InvalidArgument(std::format(
+            "Argument {}: should take exactly one value but zero", key));
+      }
+      ZeroOrOneArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    } else {
+      NLengthArgAssign<Head>(values);
+      if (values.empty()) {
+        return true;
+      }
+      return PArgAssigner<PArgs>(values);
+    }
+  }
+  return false;
+}
+
+template <class Args, class PArgs>
+ARGO_ALWAYS_INLINE constexpr auto assignArg(
+    const std::string_view& key, const std::span<std::string_view>& values) {
+  [&key, &values]<std::size_t... Is>(std::index_sequence<Is...>)
+      ARGO_ALWAYS_INLINE -> void {
+        if (!(... || (std::tuple_element_t<Is, Args>::name.getKey() == key and
+                      AssignOneArg<std::tuple_element_t<Is, Args>, PArgs>(
+                          key, values)))) [[unlikely]] {
+          throw Argo::InvalidArgument(std::format("Invalid argument {}", key));
+        }
+      }(std::make_index_sequence<std::tuple_size_v<Args>>());
+}
+
+template <class Arguments, class PArgs>
+ARGO_ALWAYS_INLINE constexpr auto Assigner(
+    std::string_view key, const std::span<std::string_view>& values) -> void {
+  if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+    if (key.empty()) {
+      if (!PArgAssigner<PArgs>(values)) [[unlikely]] {
+        throw InvalidArgument("Duplicated positional argument");
+      }
+      return;
+    }
+  } else {
+    if (key.empty()) [[unlikely]] {
+      throw Argo::InvalidArgument(std::format("Invalid argument {}", key));
+    }
+  }
+  assignArg<Arguments, PArgs>(key, values);
+}
+
+template <class Arguments, class PArgs, class HArg>
+ARGO_ALWAYS_INLINE constexpr auto ShortArgAssigner(
+    std::string_view key, const std::span<std::string_view>& values) {
+  for (std::size_t i = 0; i < key.size(); i++) {
+    auto [found_key, is_flag] = GetkeyFromShortKey<     //
+        std::conditional_t<std::is_same_v<HArg, void>,  //
+                           Arguments,                   //
+                           tuple_append_t<Arguments, HArg>>>(key[i]);
+    if constexpr (!std::is_same_v<HArg, void>) {
+      if (found_key == HArg::name.getKey()) [[unlikely]] {
+        return true;
+      }
+    }
+    if (is_flag and (key.size() - 1 == i) and !values.empty()) {
+      assignArg<Arguments, PArgs>(found_key, values);
+    } else if (is_flag) {
+      assignArg<Arguments, PArgs>(found_key, {});
+    } else if ((key.size() - 1 == i) and !values.empty()) {
+      assignArg<Arguments, PArgs>(found_key, values);
+      return false;
+    } else if ((key.size() - 1 == i) and values.empty()) {
+      auto value = std::vector<std::string_view>{key.substr(i + 1)};
+      assignArg<Arguments, PArgs>(found_key, value);
+      return false;
+    } else [[unlikely]] {
+      throw Argo::InvalidArgument(std::format("Invalid Flag argument {} {}",
+                                              key[i], key.substr(i + 1)));
+    }
+  }
+  return false;
+}
+
+/*!
+ * Complete arguments which are built over the whole command line, wherever
+ * their values came from. std::vector<Cidr> tables are sorted here for
+ * contains().
+ */
+template <class Args>
+ARGO_ALWAYS_INLINE constexpr auto FinalizeArgs() -> void {
+  tuple_type_visit<Args>([]<class T>(T) ARGO_ALWAYS_INLINE {
+    if constexpr (is_map_v<typename T::type::type>) {
+      if (T::type::assigned) {
+        MapArgFinalize<typename T::type>();
+      }
+    } else if constexpr (std::derived_from<typename T::type, ArgTag>) {
+      if constexpr (T::type::append) {
+        if (T::type::assigned) {
+          AfterAssign<typename T::type>(RawValues<typename T::type>::values);
+          RawValues<typename T::type>::values.clear();
+        }
+      }
+      if constexpr (std::is_same_v<typename T::type::type,
+                                   std::vector<Cidr>>) {
+        if (T::type::assigned) {
+          SortPrefixes(T::type::value);
+        }
+      }
+    }
+  });
+}
+
+};  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Memory backing values read from config files, string_view arguments point
+ * into it. It is shared with snapshots and replaced on resetArgs.
+ */
+struct ConfigStorage {
+  std::vector<BasicMappedFile<MapAdvice::Sequential>> files;
+  std::deque<std::string> strings;
+};
+
+/*!
+ * Streaming tokenizer for a subset of INI/TOML
+ *      # comment, ; comment
+ *      [section]            -> following keys are "section.key"
+ *      key = value          -> bare value up to a comment or end of line
+ *      key = "a \"b\""      -> basic string, 'c:\dir' is a literal string
+ *      key = [1, 2, 3]      -> three values, may span lines
+ *
+ * Values are views into the buffer, only strings with escapes are copied.
+ */
+class ConfigReader {
+ private:
+  std::string_view rest_;
+  std::string_view path_;
+  std::deque<std::string>& strings_;
+  std::string_view section_;
+  std::string_view key_;
+  std::string key_buffer_;
+  std::vector<std::string_view> values_;
+  std::size_t line_ = 1;
+  std::size_t entry_line_ = 1;
+
+  [[noreturn]] auto fail(std::string_view what) const -> void {
+    throw InvalidArgument(
+        std::format("{}:{}: {}", this->path_, this->line_, what));
+  }
+
+  ARGO_ALWAYS_INLINE auto skipBlank() -> void {
+    auto pos = this->rest_.find_first_not_of(" \t\r");
+    this->rest_.remove_prefix(std::min(pos, this->rest_.size()));
+  }
+
+  ARGO_ALWAYS_INLINE auto skipLine() -> void {
+    auto pos = this->rest_.find('\n');
+    this->rest_.remove_prefix(std::min(pos, this->rest_.size()));
+  }
+
+  // Blank lines and comments inside an array
+  auto skipSpace() -> void {
+    while (true) {
+      this->skipBlank();
+      if (this->rest_.starts_with('#') or this->rest_.starts_with(';')) {
+        this->skipLine();
+      }
+      if (!this->rest_.starts_with('\n')) {
+        return;
+      }
+      this->rest_.remove_prefix(1);
+      this->line_++;
+    }
+  }
+
+  auto expectLineEnd() -> void {
+    this->skipBlank();
+    if (this->rest_.starts_with('#') or this->rest_.starts_with(';')) {
+      this->skipLine();
+    }
+    if (!this->rest_.empty() and !this->rest_.starts_with('\n')) {
+      this->fail(std::format("unexpected {}", this->rest_.substr(
+                                                  0, this->rest_.find('\n'))));
+    }
+  }
+
+  auto quoted() -> std::string_view {
+    auto quote = this->rest_.front();
+    this->rest_.remove_prefix(1);
+    auto end = this->rest_.find_first_of(quote == '"' ? "\"\\\n" : "'\n");
+    if (end == std::string_view::npos or this->rest_[end] == '\n') {
+      this->fail("unterminated string");
+    }
+    if (this->rest_[end] == quote) {
+      auto ret = this->rest_.substr(0, end);
+      this->rest_.remove_prefix(end + 1);
+      return ret;
+    }
+    auto& ret = this->strings_.emplace_back(this->rest_.substr(0, end));
+    for (auto i = end; i < this->rest_.size(); i++) {
+      auto c = this->rest_[i];
+      if (c == '"') {
+        this->rest_.remove_prefix(i + 1);
+        return ret;
+      }
+      if (c == '\n') {
+        break;
+      }
+      if (c == '\\') {
+        if (++i == this->rest_.size()) {
+          break;
+        }
+        switch (this->rest_[i]) {
+          case 'n':
+            c = '\n';
+            break;
+          case 't':
+            c = '\t';
+            break;
+          case 'r':
+            c = '\r';
+            break;
+          case '"':
+          case '\\':
+            c = this->rest_[i];
+            break;
+          default:
+            this->fail(std::format("invalid escape \\{}", this->rest_[i]));
+        }
+      }
+      ret.push_back(c);
+    }
+    this->fail("unterminated string");
+  }
+
+  auto scalar(bool in_array) -> std::string_view {
+    if (this->rest_.starts_with('"') or this->rest_.starts_with('\'')) {
+      return this->quoted();
+    }
+    auto end = this->rest_.find_first_of(in_array ? ",]#;\n" : "#;\n");
+    auto ret = this->rest_.substr(0, end);
+    ret = ret.substr(0, ret.find_last_not_of(" \t\r") + 1);
+    if (ret.empty()) {
+      this->fail("missing value");
+    }
+    this->rest_.remove_prefix(ret.size());
+    return ret;
+  }
+
+  auto array() -> void {
+    this->rest_.remove_prefix(1);
+    this->skipSpace();
+    while (!this->rest_.starts_with(']')) {
+      if (this->rest_.empty()) {
+        this->fail("unterminated array");
+      }
+      this->values_.push_back(this->scalar(true));
+      this->skipSpace();
+      if (this->rest_.starts_with(',')) {
+        this->rest_.remove_prefix(1);
+        this->skipSpace();
+      } else if (!this->rest_.starts_with(']')) {
+        this->fail("expected , or ] in array");
+      }
+    }
+    this->rest_.remove_prefix(1);
+  }
+
+ public:
+  ConfigReader(std::string_view buffer, std::string_view path,
+               std::deque<std::string>& strings)
+      : rest_(buffer), path_(path), strings_(strings) {}
+
+  /*!
+   * Advance to the next key, returns false at the end of the buffer
+   */
+  auto next() -> bool {
+    while (true) {
+      this->skipBlank();
+      if (this->rest_.empty()) {
+        return false;
+      }
+      auto c = this->rest_.front();
+      if (c == '\n') {
+        this->rest_.remove_prefix(1);
+        this->line_++;
+        continue;
+      }
+      if (c == '#' or c == ';') {
+        this->skipLine();
+        continue;
+      }
+      if (c == '[') {
+        auto end = this->rest_.find_first_of("]\n");
+        if (end == std::string_view::npos or this->rest_[end] != ']') {
+          this->fail("unterminated section");
+        }
+        this->section_ = this->rest_.substr(1, end - 1);
+        this->rest_.remove_prefix(end + 1);
+        this->expectLineEnd();
+        continue;
+      }
+
+      auto eq = this->rest_.find_first_of("=\n");
+      if (eq == std::string_view::npos or this->rest_[eq] != '=') {
+        this->fail("expected key = value");
+      }
+      auto key = this->rest_.substr(0, eq);
+      key = key.substr(0, key.find_last_not_of(" \t") + 1);
+      this->rest_.remove_prefix(eq + 1);
+      this->entry_line_ = this->line_;
+
+      this->values_.clear();
+      this->skipBlank();
+      if (this->rest_.starts_with('[')) {
+        this->array();
+      } else {
+        this->values_.push_back(this->scalar(false));
+      }
+      this->expectLineEnd();
+
+      if (this->section_.empty()) {
+        this->key_ = key;
+      } else {
+        this->key_buffer_.assign(this->section_);
+        this->key_buffer_.push_back('.');
+        this->key_buffer_.append(key);
+        this->key_ = this->key_buffer_;
+      }
+      return true;
+    }
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto key() const -> std::string_view {
+    return this->key_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto values()
+      -> std::span<std::string_view> {
+    return this->values_;
+  }
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto line() const -> std::size_t {
+    return this->entry_line_;
+  }
+};
+
+/*!
+ * Assign a value coming from a lower layer than the command line, arguments
+ * already set by a higher layer keep their value
+ */
+template <class Arg>
+auto SourceAssign(std::span<std::string_view> values, ValueSource source,
+                  ConfigStorage& storage) -> void {
+  constexpr auto key = Arg::name.getKey();
+  if (Arg::assigned and Arg::source > source) {
+    return;
+  }
+  if constexpr (std::derived_from<Arg, FlagArgTag>) {
+    if (values.size() != 1) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: should take exactly one value", key));
+    }
+    if (!Arg::repeatable and Arg::assigned) [[unlikely]] {
+      throw InvalidArgument(
+          std::format("Argument {}: duplicated argument", key));
+    }
+    if constexpr (std::derived_from<Arg, CountArgTag>) {
+      Arg::value = ArgCaster<int>(values[0], key);
+    } else {
+      Arg::value = ArgCaster<bool>(values[0], key);
+    }
+    MarkAssigned<Arg>();
+    Arg::source = source;
+    if (Arg::value and Arg::callback) {
+      Arg::callback();
+    }
+  } else {
+    if constexpr (std::is_same_v<typename Arg::baseType, const char*>) {
+      // Views into the file are not null terminated
+      for (auto& value : values) {
+        value = storage.strings.emplace_back(value);
+      }
+    }
+    if constexpr (!Arg::repeatable and (Arg::nargs.nargs == 1 or
+                                        Arg::nargs.nargs_char == '?')) {
+      if (values.size() > 1) [[unlikely]] {
+        throw InvalidArgument(std::format(
+            "Argument {}: should take exactly one value but {}", key,
+            values.size()));
+      }
+    }
+    if constexpr (Arg::repeatable and Arg::nargs.nargs == 1) {
+      for (std::size_t i = 0; i < values.size(); i++) {
+        AssignOneArg<Arg, std::tuple<>>(key, values.subspan(i, 1));
+      }
+    } else {
+      AssignOneArg<Arg, std::tuple<>>(key, values);
+    }
+    Arg::source = source;
+  }
+}
+
+/*!
+ * Returns false if no argument has the key
+ */
+template <class Args>
+auto SourceAssigner(std::string_view key, std::span<std::string_view> values,
+                    ValueSource source, ConfigStorage& storage) -> bool {
+  return tuple_type_or_visit<Args>([&]<class T>(T) ARGO_ALWAYS_INLINE {
+    if (T::type::name.getKey() != key) {
+      return false;
+    }
+    SourceAssign<typename T::type>(values, source, storage);
+    return true;
+  });
+}
+
+/*!
+ * PREFIX_KEY, "-" and "." in the key become "_"
+ */
+inline auto EnvName(std::string& env_name, std::string_view prefix,
+                    std::string_view key) -> void {
+  env_name.assign(prefix);
+  env_name.push_back('_');
+  for (auto c : key) {
+    env_name.push_back((c == '-' or c == '.')
+                           ? '_'
+                           : static_cast<char>(std::toupper(c)));
+  }
+}
+
+/*!
+ * Read PREFIX_KEY for every argument not given on the command line. Multi
+ * value arguments are split on ",".
+ */
+template <class Args>
+auto EnvAssigner(std::string_view prefix, ConfigStorage& storage) -> void {
+  auto env_name = std::string();
+  auto values = std::vector<std::string_view>();
+  tuple_type_visit<Args>([&]<class T>(T) {
+    using Arg = typename T::type;
+    if (Arg::assigned) {
+      return;
+    }
+    EnvName(env_name, prefix, Arg::name.getKey());
+    const auto* env = std::getenv(env_name.c_str());
+    if (env == nullptr) {
+      return;
+    }
+    values.clear();
+    auto value = std::string_view(env);
+    if constexpr (std::derived_from<Arg, ArgTag>) {
+      if constexpr (Arg::repeatable or
+                    (Arg::nargs.nargs != 1 and Arg::nargs.nargs_char != '?')) {
+        for (auto part : std::views::split(value, ',')) {
+          values.emplace_back(part.begin(), part.end());
+        }
+      } else {
+        values.push_back(value);
+      }
+    } else {
+      values.push_back(value);
+    }
+    SourceAssign<Arg>(values, ValueSource::Environment, storage);
+  });
+}
+
+/*!
+ * Assign every key of the config file to the argument of the same name
+ * A missing file is skipped unless the path was given explicitly. With copy,
+ * the file is read into memory instead of mapped, for files rewritten while
+ * values still point into them.
+ */
+template <class Args>
+auto ConfigAssigner(std::string_view path, bool must_exist, bool copy,
+                    ConfigStorage& storage) -> void {
+  if (!must_exist and !std::filesystem::exists(path)) {
+    return;
+  }
+  auto buffer = std::string_view();
+  if (copy) {
+    auto file = std::ifstream(std::string(path), std::ios::binary);
+    if (!file) [[unlikely]] {
+      throw InvalidArgument(std::format("Cannot read config file {}", path));
+    }
+    buffer = storage.strings.emplace_back(std::istreambuf_iterator<char>(file),
+                                          std::istreambuf_iterator<char>());
+  } else {
+    buffer = storage.files.emplace_back(path).view();
+  }
+  auto reader = ConfigReader(buffer, path, storage.strings);
+  while (reader.next()) {
+    try {
+      if (!SourceAssigner<Args>(reader.key(), reader.values(),
+                                ValueSource::ConfigFile, storage))
+          [[unlikely]] {
+        throw InvalidArgument(std::format("Invalid argument {}", reader.key()));
+      }
+    } catch (const ValidationError& e) {
+      throw ValidationError(
+          std::format("{}:{}: {}", path, reader.line(), e.what()));
+    } catch (const InvalidArgument& e) {
+      throw InvalidArgument(
+          std::format("{}:{}: {}", path, reader.line(), e.what()));
+    }
+  }
+}
+
+/*!
+ * Path held by the config argument and whether it was given explicitly
+ */
+template <class Args>
+auto ConfigPath(std::string_view key) -> std::pair<std::string_view, bool> {
+  auto ret = std::pair<std::string_view, bool>();
+  tuple_type_visit<Args>([&ret, key]<class T>(T) {
+    if constexpr (std::is_same_v<typename T::type::type, std::string>) {
+      if (T::type::name.getKey() == key) {
+        ret = {T::type::value, T::type::assigned};
+      }
+    }
+  });
+  return ret;
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+inline constexpr std::size_t cache_line_size = 64;
+
+/*!
+ * Offsets of every argument value in one block, fixed at compile time
+ */
+template <class Args>
+struct SnapshotLayout;
+
+template <class... T>
+struct SnapshotLayout<std::tuple<T...>> {
+  static constexpr std::size_t align =
+      std::max({cache_line_size, alignof(typename T::type)...});
+
+  static constexpr auto offsets = [] {
+    auto ret = std::array<std::size_t, sizeof...(T)>{};
+    std::size_t offset = 0;
+    std::size_t i = 0;
+    (..., (offset = (offset + alignof(typename T::type) - 1) /
+                    alignof(typename T::type) * alignof(typename T::type),
+           ret[i++] = offset, offset += sizeof(typename T::type)));
+    return ret;
+  }();
+
+  // Rounded up so that nothing else shares the last cache line
+  static constexpr std::size_t size = [] {
+    std::size_t end = 0;
+    std::size_t i = 0;
+    (..., (end = offsets[i++] + sizeof(typename T::type)));
+    return (end + align - 1) / align * align;
+  }();
+};
+
+/*!
+ * Immutable copy of every argument value, taken by Parser::freeze
+ * Example:
+ *      const auto config = parser.freeze();
+ *      config.get<"threads">();
+ *
+ * Values live in one cache line aligned block at compile time offsets and are
+ * never written after construction, so a snapshot can be read from any number
+ * of threads. Copying a snapshot copies every value, a copy made on a thread
+ * of another NUMA node gets memory local to it. Strings read from config
+ * files are shared between copies.
+ */
+template <class Args>
+class alignas(SnapshotLayout<Args>::align) Snapshot {
+ private:
+  using Layout = SnapshotLayout<Args>;
+  static constexpr auto count = std::tuple_size_v<Args>;
+
+  template <std::size_t I>
+  using ValueType = typename std::tuple_element_t<I, Args>::type;
+
+  alignas(Layout::align) std::array<std::byte, Layout::size> data_;
+  std::array<ValueSource, count> sources_{};
+  std::shared_ptr<const ConfigStorage> storage_;
+
+  template <std::size_t I>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto at() const -> const ValueType<I>& {
+    return *std::launder(reinterpret_cast<const ValueType<I>*>(
+        this->data_.data() + Layout::offsets[I]));
+  }
+
+  template <std::size_t I>
+  ARGO_ALWAYS_INLINE auto construct(const ValueType<I>& value) -> void {
+    auto* ptr = this->data_.data() + Layout::offsets[I];
+    std::construct_at(reinterpret_cast<ValueType<I>*>(ptr), value);
+  }
+
+ public:
+  /*!
+   * Copy the values of From, which has the same names and types as Args
+   */
+  template <class From>
+  Snapshot(std::type_identity<From> /* unused */,
+           std::shared_ptr<const ConfigStorage> storage)
+      : storage_(std::move(storage)) {
+    static_assert(std::tuple_size_v<From> == count);
+    [this]<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
+      (..., (this->template construct<Is>(
+                 std::tuple_element_t<Is, From>::value),
+             this->sources_[Is] = std::tuple_element_t<Is, From>::source));
+    }(std::make_index_sequence<count>());
+  }
+
+  Snapshot(const Snapshot& other)
+      : sources_(other.sources_), storage_(other.storage_) {
+    [this, &other]<std::size_t... Is>(std::index_sequence<Is...>)
+        ARGO_ALWAYS_INLINE {
+          (..., this->template construct<Is>(other.template at<Is>()));
+        }(std::make_index_sequence<count>());
+  }
+
+  auto operator=(const Snapshot&) -> Snapshot& = delete;
+  auto operator=(Snapshot&&) -> Snapshot& = delete;
+
+  ~Snapshot() {
+    [this]<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
+      (..., std::destroy_at(&this->template at<Is>()));
+    }(std::make_index_sequence<count>());
+  }
+
+  template <ArgName Name>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto get() const -> const auto& {
+    static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+    return this->template at<SearchIndex<Args, Name>()>();
+  }
+
+  template <ArgName Name>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto getSource() const -> ValueSource {
+    static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+    return this->sources_[SearchIndex<Args, Name>()];
+  }
+
+  /*!
+   * Byte offset of the value in the block
+   */
+  template <ArgName Name>
+  static consteval auto offsetOf() -> std::size_t {
+    static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+    return Layout::offsets[SearchIndex<Args, Name>()];
+  }
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Spelling of T chosen by the compiler, stable within one build
+ */
+template <class T>
+consteval auto TypeSignature() -> std::string_view {
+  return std::source_location::current().function_name();
+}
+
+constexpr auto Fnv1a(std::uint64_t hash, std::string_view str)
+    -> std::uint64_t {
+  for (auto c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+/*!
+ * Hash of the names and value types of Args, in order
+ */
+template <class Args>
+consteval auto SchemaHash() -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  [&hash]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (..., (hash = Fnv1a(hash, std::tuple_element_t<Is, Args>::name.getKey()),
+           hash = Fnv1a(hash, "="),
+           hash = Fnv1a(hash, TypeSignature<typename std::tuple_element_t<
+                                  Is, Args>::type>()),
+           hash = Fnv1a(hash, ";")));
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+  return hash;
+}
+
+struct SerialHeader {
+  std::array<char, 4> magic = {'A', 'R', 'G', 'O'};
+  std::uint32_t version = 1;
+  std::uint64_t schema = 0;
+  std::uint64_t size = 0;
+};
+
+class SerialWriter {
+ private:
+  std::vector<std::byte> buffer_;
+
+ public:
+  ARGO_ALWAYS_INLINE auto write(const void* data, std::size_t size) -> void {
+    const auto* ptr = static_cast<const std::byte*>(data);
+    this->buffer_.insert(this->buffer_.end(), ptr, ptr + size);
+  }
+
+  template <class T>
+    requires std::is_trivially_copyable_v<T>
+  ARGO_ALWAYS_INLINE auto write(const T& value) -> void {
+    this->write(&value, sizeof(T));
+  }
+
+  auto buffer() -> std::vector<std::byte>& {
+    return this->buffer_;
+  }
+};
+
+class SerialReader {
+ private:
+  std::span<const std::byte> buffer_;
+
+ public:
+  explicit SerialReader(std::span<const std::byte> buffer) : buffer_(buffer) {}
+
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto take(std::size_t size)
+      -> const std::byte* {
+    if (size > this->buffer_.size()) [[unlikely]] {
+      throw ParseError("Serialized arguments are truncated");
+    }
+    const auto* ret = this->buffer_.data();
+    this->buffer_ = this->buffer_.subspan(size);
+    return ret;
+  }
+
+  template <class T>
+    requires std::is_trivially_copyable_v<T>
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto read() -> T {
+    T ret;
+    std::memcpy(&ret, this->take(sizeof(T)), sizeof(T));
+    return ret;
+  }
+
+  [[nodiscard]] auto rest() const -> std::span<const std::byte> {
+    return this->buffer_;
+  }
+};
+
+/*!
+ * Values whose bytes are the whole value, so they can be copied as is
+ * Pointers and views are trivially copyable too, but their bytes are
+ * addresses in the writing process.
+ */
+template <class T>
+struct is_pointer_free
+    : std::bool_constant<std::is_trivially_copyable_v<T> and
+                         !std::is_pointer_v<T> and
+                         !std::is_member_pointer_v<T> and
+                         !std::is_null_pointer_v<T>> {};
+
+template <class CharT, class Traits>
+struct is_pointer_free<std::basic_string_view<CharT, Traits>>
+    : std::false_type {};
+
+template <class T, std::size_t Extent>
+struct is_pointer_free<std::span<T, Extent>> : std::false_type {};
+
+template <class T, std::size_t N>
+struct is_pointer_free<std::array<T, N>> : is_pointer_free<T> {};
+
+template <class T>
+constexpr bool is_pointer_free_v = is_pointer_free<T>::value;
+
+/*!
+ * Elements stored as one block of bytes, vector<bool> is packed
+ */
+template <class T>
+constexpr bool is_flat_vector_v = is_vector_v<T> and
+                                  is_pointer_free_v<vector_base_t<T>> and
+                                  !std::is_same_v<vector_base_t<T>, bool>;
+
+/*!
+ * Whether every argument of Args can be serialized, LazyArgs views the argv
+ * of the writing process
+ */
+template <class Args>
+constexpr bool is_serializable_args_v = []<class... T>(type_sequence<T...>) {
+  return !(is_lazy_args_v<typename T::type> || ...);
+}(make_type_sequence_t<Args>());
+
+template <class T>
+auto Encode(SerialWriter& writer, const T& value) -> void {
+  if constexpr (is_lazy_args_v<T>) {
+    static_assert(false, "LazyArgs cannot be serialized, use std::vector");
+  } else if constexpr (std::is_same_v<T, std::string> or
+                std::is_same_v<T, std::string_view>) {
+    writer.write(static_cast<std::uint64_t>(value.size()));
+    writer.write(value.data(), value.size());
+  } else if constexpr (std::is_same_v<T, const char*>) {
+    // Length with the terminator, 0 is nullptr
+    auto size = value ? std::strlen(value) + 1 : 0;
+    writer.write(static_cast<std::uint64_t>(size));
+    writer.write(value, size);
+  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
+    Encode(writer, value.native());
+  } else if constexpr (is_pointer_free_v<T>) {
+    writer.write(value);
+  } else if constexpr (is_vector_v<T>) {
+    writer.write(static_cast<std::uint64_t>(value.size()));
+    if constexpr (is_flat_vector_v<T>) {
+      writer.write(value.data(), value.size() * sizeof(vector_base_t<T>));
+    } else {
+      for (const auto& elem : value) {
+        Encode(writer, elem);
+      }
+    }
+  } else if constexpr (is_map_v<T>) {
+    writer.write(static_cast<std::uint64_t>(value.size()));
+    for (const auto& [key, elem] : value) {
+      Encode(writer, key);
+      Encode(writer, elem);
+    }
+  } else if constexpr (is_tuple_v<T> or is_array_v<T>) {
+    std::apply(
+        [&writer](const auto&... elems) { (..., Encode(writer, elems)); },
+        value);
+  } else {
+    static_assert(false, "Argument type cannot be serialized");
+  }
+}
+
+/*!
+ * string_view and const char* values point into the buffer of reader
+ */
+template <class T>
+auto Decode(SerialReader& reader, T& value) -> void {
+  if constexpr (is_lazy_args_v<T>) {
+    static_assert(false, "LazyArgs cannot be serialized, use std::vector");
+  } else if constexpr (std::is_same_v<T, std::string> or
+                std::is_same_v<T, std::string_view>) {
+    auto size = reader.read<std::uint64_t>();
+    value = T(reinterpret_cast<const char*>(reader.take(size)), size);
+  } else if constexpr (std::is_same_v<T, const char*>) {
+    auto size = reader.read<std::uint64_t>();
+    const auto* ptr = reinterpret_cast<const char*>(reader.take(size));
+    if (size != 0 and ptr[size - 1] != '\0') [[unlikely]] {
+      throw ParseError("Serialized string is not terminated");
+    }
+    value = size == 0 ? nullptr : ptr;
+  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
+    auto str = std::filesystem::path::string_type();
+    Decode(reader, str);
+    value = std::move(str);
+  } else if constexpr (is_pointer_free_v<T>) {
+    value = reader.read<T>();
+  } else if constexpr (is_vector_v<T>) {
+    using Elem = vector_base_t<T>;
+    auto size = reader.read<std::uint64_t>();
+    if constexpr (is_flat_vector_v<T>) {
+      if (size > std::numeric_limits<std::size_t>::max() / sizeof(Elem))
+          [[unlikely]] {
+        throw ParseError("Serialized arguments are truncated");
+      }
+      const auto* ptr = reader.take(size * sizeof(Elem));
+      value.resize(size);
+      std::memcpy(value.data(), ptr, size * sizeof(Elem));
+    } else {
+      value.clear();
+      // Every element takes at least one byte
+      value.reserve(std::min<std::uint64_t>(size, reader.rest().size()));
+      for (std::uint64_t i = 0; i < size; i++) {
+        auto elem = Elem();
+        Decode(reader, elem);
+        value.push_back(std::move(elem));
+      }
+    }
+  } else if constexpr (is_map_v<T>) {
+    auto size = reader.read<std::uint64_t>();
+    value.clear();
+    for (std::uint64_t i = 0; i < size; i++) {
+      auto key = typename T::key_type();
+      auto elem = typename T::mapped_type();
+      Decode(reader, key);
+      Decode(reader, elem);
+      value.emplace_hint(value.end(), std::move(key), std::move(elem));
+    }
+  } else if constexpr (is_tuple_v<T> or is_array_v<T>) {
+    std::apply([&reader](auto&... elems) { (..., Decode(reader, elems)); },
+               value);
+  } else {
+    static_assert(false, "Argument type cannot be serialized");
+  }
+}
+
+/*!
+ * Header, then assigned, source and value of every argument in order
+ */
+template <class Args>
+auto SerializeArgs() -> std::vector<std::byte> {
+  auto writer = SerialWriter();
+  writer.write(SerialHeader());
+  tuple_type_visit<Args>([&writer]<class T>(T) {
+    writer.write(static_cast<std::uint8_t>(T::type::assigned));
+    writer.write(static_cast<std::uint8_t>(T::type::source));
+    Encode(writer, T::type::value);
+  });
+  auto& buffer = writer.buffer();
+  const auto header = SerialHeader{
+      .schema = SchemaHash<Args>(),
+      .size = buffer.size() - sizeof(SerialHeader),
+  };
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  return std::move(buffer);
+}
+
+/*!
+ * Arguments are written only after the whole buffer decoded
+ */
+template <class Args>
+auto DeserializeArgs(std::span<const std::byte> buffer) -> void {
+  auto reader = SerialReader(buffer);
+  auto header = reader.read<SerialHeader>();
+  if (header.magic != SerialHeader().magic or
+      header.version != SerialHeader().version) [[unlikely]] {
+    throw ParseError("Not serialized arguments");
+  }
+  if (header.schema != SchemaHash<Args>()) [[unlikely]] {
+    throw ParseError("Serialized arguments were written by another schema");
+  }
+  if (header.size != buffer.size() - sizeof(SerialHeader)) [[unlikely]] {
+    throw ParseError("Serialized arguments are truncated");
+  }
+  [&reader]<std::size_t... Is>(std::index_sequence<Is...>) {
+    auto assigned = std::array<bool, sizeof...(Is)>{};
+    auto sources = std::array<ValueSource, sizeof...(Is)>{};
+    auto values =
+        std::tuple<typename std::tuple_element_t<Is, Args>::type...>();
+    (..., (assigned[Is] = reader.read<std::uint8_t>() != 0,
+           sources[Is] = static_cast<ValueSource>(reader.read<std::uint8_t>()),
+           Decode(reader, std::get<Is>(values))));
+    (..., (std::tuple_element_t<Is, Args>::assigned = false,
+           assigned[Is] ? MarkAssigned<std::tuple_element_t<Is, Args>>()
+                        : void(),
+           std::tuple_element_t<Is, Args>::source = sources[Is],
+           std::tuple_element_t<Is, Args>::value =
+               std::move(std::get<Is>(values))));
+  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+struct CacheHeader {
+  std::array<char, 4> magic = {'A', 'R', 'G', 'C'};
+  std::uint32_t version = 2;
+  std::uint64_t inputs = 0;
+  std::uint64_t files = 0;
+};
+
+/*!
+ * State of a file the result depends on, size is -1 if it did not exist
+ */
+struct CacheFileState {
+  std::uint64_t dev = 0;
+  std::uint64_t ino = 0;
+  std::int64_t size = -1;
+  std::int64_t mtime = 0;
+
+  static auto of(const char* path) -> CacheFileState {
+    struct ::stat st {};
+    if (::stat(path, &st) != 0) {
+      return {};
+    }
+#ifdef __APPLE__
+    const auto& mtime = st.st_mtimespec;
+#else
+    const auto& mtime = st.st_mtim;
+#endif
+    return {
+        .dev = static_cast<std::uint64_t>(st.st_dev),
+        .ino = static_cast<std::uint64_t>(st.st_ino),
+        .size = static_cast<std::int64_t>(st.st_size),
+        .mtime = static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 +
+                 mtime.tv_nsec,
+    };
+  }
+
+  auto operator==(const CacheFileState&) const -> bool = default;
+};
+
+/*!
+ * Everything the parse result depends on besides files: the schema, argv and
+ * the environment variables read by EnvAssigner
+ */
+template <class Args>
+auto CacheInputs(int argc, char* argv[],
+                 std::optional<std::string_view> env_prefix)
+    -> std::vector<std::byte> {
+  auto writer = SerialWriter();
+  writer.buffer().reserve(4096);
+  writer.write(SchemaHash<Args>());
+  writer.write(static_cast<std::uint64_t>(argc));
+  for (int i = 0; i < argc; i++) {
+    Encode(writer, std::string_view(argv[i]));
+  }
+  if (env_prefix) {
+    auto env_name = std::string();
+    tuple_type_visit<Args>([&]<class T>(T) {
+      EnvName(env_name, *env_prefix, T::type::name.getKey());
+      const char* env = std::getenv(env_name.c_str());
+      Encode(writer, env);
+    });
+  }
+  return std::move(writer.buffer());
+}
+
+/*!
+ * Eight bytes per step, collisions only cost a miss since inputs are compared
+ * on lookup
+ */
+inline auto CacheKey(std::span<const std::byte> inputs) -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325;
+  std::size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= inputs.size();
+       i += sizeof(std::uint64_t)) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, inputs.data() + i, sizeof(word));
+    hash = (std::rotl(hash, 5) ^ word) * 0x9e3779b97f4a7c15;
+  }
+  return Fnv1a(hash,
+               std::string_view(reinterpret_cast<const char*>(inputs.data()),
+                                inputs.size())
+                   .substr(i));
+}
+
+inline constexpr std::size_t cache_map_threshold = 64 * 1024;
+
+/*!
+ * Contents of the entry at path, kept alive by storage. Entries smaller than
+ * cache_map_threshold are read, mapping them costs more than the copy
+ */
+inline auto CacheRead(const std::string& path, ConfigStorage& storage)
+    -> std::optional<std::span<const std::byte>> {
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+  auto ret = std::optional<std::span<const std::byte>>();
+  struct ::stat st {};
+  if (::fstat(fd, &st) == 0) {
+    auto size = static_cast<std::size_t>(st.st_size);
+    if (size > cache_map_threshold) {
+      try {
+        ret = storage.files
+                  .emplace_back(
+                      BasicMappedFile<MapAdvice::Sequential>::fromFd(fd))
+                  .bytes();
+      } catch (const InvalidArgument&) {
+        // Treated as a miss
+      }
+    } else {
+      auto& buffer = storage.strings.emplace_back(size, '\0');
+      if (::read(fd, buffer.data(), size) == static_cast<::ssize_t>(size)) {
+        ret = std::as_bytes(std::span(buffer));
+      }
+    }
+  }
+  ::close(fd);
+  return ret;
+}
+
+struct CacheEntry {
+  // Positions in argv of the tokens collected by collectUnknown
+  std::vector<std::uint32_t> unknown;
+  std::span<const std::byte> block;
+};
+
+/*!
+ * Entry layout: CacheHeader, inputs, one path and CacheFileState per file,
+ * the unknown token positions, then the block written by SerializeArgs
+ * Returns the entry when inputs and every file still match
+ */
+inline auto CacheLookup(std::span<const std::byte> entry,
+                        std::span<const std::byte> inputs)
+    -> std::optional<CacheEntry> {
+  try {
+    auto reader = SerialReader(entry);
+    auto header = reader.read<CacheHeader>();
+    if (header.magic != CacheHeader().magic or
+        header.version != CacheHeader().version or
+        header.inputs != inputs.size()) {
+      return std::nullopt;
+    }
+    if (std::memcmp(reader.take(inputs.size()), inputs.data(),
+                    inputs.size()) != 0) {
+      return std::nullopt;
+    }
+    for (std::uint64_t i = 0; i < header.files; i++) {
+      const char* path = nullptr;
+      Decode(reader, path);
+      if (path == nullptr or
+          reader.read<CacheFileState>() != CacheFileState::of(path)) {
+        return std::nullopt;
+      }
+    }
+    auto ret = CacheEntry();
+    Decode(reader, ret.unknown);
+    ret.block = reader.rest();
+    return ret;
+  } catch (const ParseError&) {
+    return std::nullopt;
+  }
+}
+
+/*!
+ * Written to a temporary file renamed over path, concurrent writers of the
+ * same entry never expose a partial one. Errors are ignored, the result was
+ * already parsed.
+ */
+inline auto CacheStore(const std::string& path,
+                       std::span<const std::byte> inputs,
+                       std::span<const std::string> files,
+                       const std::vector<std::uint32_t>& unknown,
+                       std::span<const std::byte> block) -> void {
+  auto writer = SerialWriter();
+  writer.write(CacheHeader{.inputs = inputs.size(), .files = files.size()});
+  writer.write(inputs.data(), inputs.size());
+  for (const auto& file : files) {
+    Encode(writer, file.c_str());
+    writer.write(CacheFileState::of(file.c_str()));
+  }
+  Encode(writer, unknown);
+  writer.write(block.data(), block.size());
+
+  auto tmp = std::format("{}.{}.tmp", path, ::getpid());
+  auto ec = std::error_code();
+  {
+    auto out = std::ofstream(tmp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(writer.buffer().data()),
+              static_cast<std::streamsize>(writer.buffer().size()));
+    if (!out.flush()) {
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Position of the first of Cs in str from pos, or str.size()
+ * Eight bytes are tested at once, a byte equal to c becomes zero after the
+ * xor and (x - 0x01..) & ~x & 0x80.. sets its high bit. Bytes above a match
+ * can be set by the borrow, the lowest set bit is always a real match.
+ */
+template <char... Cs>
+ARGO_ALWAYS_INLINE constexpr auto FindAny(std::string_view str,
+                                          std::size_t pos) -> std::size_t {
+  constexpr std::uint64_t ones = 0x0101010101010101;
+  constexpr std::uint64_t highs = 0x8080808080808080;
+  if !consteval {
+    for (; pos + sizeof(std::uint64_t) <= str.size();
+         pos += sizeof(std::uint64_t)) {
+      std::uint64_t word = 0;
+      std::memcpy(&word, str.data() + pos, sizeof(word));
+      if constexpr (std::endian::native == std::endian::big) {
+        word = std::byteswap(word);
+      }
+      auto mask = (... | [word] {
+        auto x = word ^ (ones * static_cast<unsigned char>(Cs));
+        return (x - ones) & ~x & highs;
+      }());
+      if (mask != 0) {
+        return pos + (std::countr_zero(mask) / 8);
+      }
+    }
+  }
+  for (; pos < str.size(); pos++) {
+    if (((str[pos] == Cs) or ...)) {
+      return pos;
+    }
+  }
+  return str.size();
+}
+
+ARGO_ALWAYS_INLINE constexpr auto IsShellSpace(char c) -> bool {
+  return c == ' ' or c == '\t' or c == '\n';
+}
+
+/*!
+ * Split line with POSIX shell quoting: 'single' quotes are literal, "double"
+ * quotes keep backslash escapes of $ ` " \ and newline, a backslash outside
+ * quotes escapes any character. There is no expansion of any kind.
+ *
+ * Tokens are written unescaped and null terminated to arena, which needs
+ * line.size() + 1 bytes: a token never grows and its terminator takes the
+ * place of the separator after it. A pointer to every token is appended to
+ * argv.
+ */
+inline auto ShellSplit(std::string_view line, char* arena,
+                       std::vector<char*>& argv) -> void {
+  auto* out = arena;
+  std::size_t pos = 0;
+  auto copy = [&out, line](std::size_t from, std::size_t to) {
+    std::memcpy(out, line.data() + from, to - from);
+    out += to - from;
+  };
+
+  while (true) {
+    while (pos < line.size() and IsShellSpace(line[pos])) {
+      pos++;
+    }
+    if (pos == line.size()) {
+      return;
+    }
+    argv.push_back(out);
+
+    while (pos < line.size() and !IsShellSpace(line[pos])) {
+      auto next = FindAny<' ', '\t', '\n', '\'', '"', '\\'>(line, pos);
+      copy(pos, next);
+      pos = next;
+      if (pos == line.size() or IsShellSpace(line[pos])) {
+        break;
+      }
+      if (line[pos] == '\\') {
+        if (pos + 1 == line.size()) {
+          *out++ = '\\';
+        } else if (line[pos + 1] != '\n') {
+          // A backslash before a newline continues the line
+          *out++ = line[pos + 1];
+        }
+        pos = std::min(pos + 2, line.size());
+      } else if (line[pos] == '\'') {
+        auto end = FindAny<'\''>(line, pos + 1);
+        if (end == line.size()) [[unlikely]] {
+          throw ParseError(std::format("Unterminated quote at {}", pos));
+        }
+        copy(pos + 1, end);
+        pos = end + 1;
+      } else {
+        auto start = pos;
+        pos++;
+        while (true) {
+          auto end = FindAny<'"', '\\'>(line, pos);
+          if (end == line.size()) [[unlikely]] {
+            throw ParseError(std::format("Unterminated quote at {}", start));
+          }
+          copy(pos, end);
+          pos = end + 1;
+          if (line[end] == '"') {
+            break;
+          }
+          if (pos == line.size()) [[unlikely]] {
+            throw ParseError(std::format("Unterminated quote at {}", start));
+          }
+          auto c = line[pos];
+          if (c == '$' or c == '`' or c == '"' or c == '\\') {
+            *out++ = c;
+          } else if (c != '\n') {
+            *out++ = '\\';
+            *out++ = c;
+          }
+          pos++;
+        }
+      }
+    }
+    *out++ = '\0';
+  }
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+/*!
+ * Tokens read from a file descriptor, delimited by '\0' like xargs -0 or by
+ * '\n', as an input range
+ * Example:
+ *      for (auto file : Argo::TokenReader(STDIN_FILENO, '\n')) { ... }
+ *
+ * The input is read in large chunks into an arena owned by the reader and
+ * only as far as the tokens taken so far need, so work can start before the
+ * writer is done. Tokens are views into the arena, null terminated, and stay
+ * valid as long as the reader. A token cut by the end of a chunk is moved to
+ * the start of the next one, nothing else is copied.
+ */
+class TokenReader {
+ private:
+  static constexpr std::size_t chunk_size = std::size_t(1) << 16;
+
+  int fd_ = STDIN_FILENO;
+  char delimiter_ = '\0';
+  bool eof_ = false;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  // Unread part of the last chunk is [begin_, end_), it ends at limit_
+  char* begin_ = nullptr;
+  char* end_ = nullptr;
+  char* limit_ = nullptr;
+
+  /*!
+   * Start a new chunk holding the unfinished token and room for at least
+   * as much again
+   */
+  auto grow() -> void {
+    auto pending = static_cast<std::size_t>(this->end_ - this->begin_);
+    auto size = std::max(chunk_size, pending * 2 + 1);
+    auto& chunk = this->chunks_.emplace_back(
+        std::make_unique_for_overwrite<char[]>(size));
+    if (pending != 0) {
+      std::memcpy(chunk.get(), this->begin_, pending);
+    }
+    this->begin_ = chunk.get();
+    this->end_ = chunk.get() + pending;
+    this->limit_ = chunk.get() + size;
+  }
+
+  auto fill() -> void {
+    if (this->end_ == this->limit_) {
+      this->grow();
+    }
+    while (true) {
+      auto len = ::read(this->fd_, this->end_,
+                        static_cast<std::size_t>(this->limit_ - this->end_));
+      if (len > 0) {
+        this->end_ += len;
+        return;
+      }
+      if (len == 0) {
+        this->eof_ = true;
+        return;
+      }
+      if (errno != EINTR) [[unlikely]] {
+        throw ParseError(std::format("Cannot read arguments: {}",
+                                     std::system_category().message(errno)));
+      }
+    }
+  }
+
+ public:
+  class Iterator {
+   private:
+    TokenReader* reader_ = nullptr;
+    std::optional<std::string_view> token_;
+
+   public:
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    explicit Iterator(TokenReader* reader)
+        : reader_(reader), token_(reader->next()) {}
+
+    auto operator*() const -> std::string_view {
+      return *this->token_;
+    }
+
+    auto operator++() -> Iterator& {
+      this->token_ = this->reader_->next();
+      return *this;
+    }
+
+    auto operator++(int) -> void {
+      ++*this;
+    }
+
+    auto operator==(std::default_sentinel_t /* unused */) const -> bool {
+      return !this->token_.has_value();
+    }
+  };
+
+  explicit TokenReader(int fd = STDIN_FILENO, char delimiter = '\0')
+      : fd_(fd), delimiter_(delimiter) {}
+
+  TokenReader(const TokenReader&) = delete;
+  TokenReader(TokenReader&&) = default;
+  auto operator=(const TokenReader&) -> TokenReader& = delete;
+  auto operator=(TokenReader&&) -> TokenReader& = default;
+  ~TokenReader() = default;
+
+  /*!
+   * Next token, std::nullopt at the end of the input
+   * The last token does not need a delimiter after it.
+   */
+  auto next() -> std::optional<std::string_view> {
+    while (true) {
+      auto size = static_cast<std::size_t>(this->end_ - this->begin_);
+      auto* found =
+          size == 0 ? nullptr
+                    : static_cast<char*>(
+                          std::memchr(this->begin_, this->delimiter_, size));
+      if (found != nullptr) {
+        *found = '\0';
+        auto token = std::string_view(this->begin_, found);
+        this->begin_ = found + 1;
+        return token;
+      }
+      if (this->eof_) {
+        if (size == 0) {
+          return std::nullopt;
+        }
+        if (this->end_ == this->limit_) {
+          // Room for the terminator
+          this->grow();
+        }
+        *this->end_ = '\0';
+        auto token = std::string_view(this->begin_, this->end_);
+        this->begin_ = this->end_;
+        return token;
+      }
+      this->fill();
+    }
+  }
+
+  [[nodiscard]] auto begin() -> Iterator {
+    return Iterator(this);
+  }
+
+  [[nodiscard]] auto end() const -> std::default_sentinel_t {
+    return {};
+  }
+};
+
+/*!
+ * Position of "--args-from-stdin", or of a "-" taking the place of a
+ * positional argument, in argv[1, end). -1 when there is none
+ * A "-" an option takes as its value, as in --output -, is left alone.
+ */
+template <class Args>
+constexpr auto StdinArgIndex(int end, char* argv[]) -> int {
+  // Values the current option still takes, -1 for any number
+  auto pending = 0;
+  for (int i = 1; i < end; i++) {
+    auto arg = std::string_view(argv[i]);
+    if (arg == "--args-from-stdin") [[unlikely]] {
+      return i;
+    }
+    auto is_flag = arg.size() > 1 and arg[0] == '-';
+    if (is_flag and arg[1] >= '0' and arg[1] <= '9') {
+      is_flag = IsFlag<Args>(arg[1]);
+    }
+    if (!is_flag) {
+      if (arg == "-" and pending == 0) [[unlikely]] {
+        return i;
+      }
+      pending -= (pending > 0) ? 1 : 0;
+      continue;
+    }
+    if (arg[1] == '-') {
+      auto equal_pos = arg.find('=');
+      pending = ValueCount<Args>(arg.substr(2, equal_pos - 2));
+      if (equal_pos != std::string_view::npos and pending > 0) {
+        pending--;
+      }
+      continue;
+    }
+    // -abc: flags up to the first key taking a value, the rest is its value
+    pending = 0;
+    for (std::size_t j = 1; j < arg.size(); j++) {
+      if (!IsFlag<Args>(arg[j])) {
+        pending = -1;
+        break;
+      }
+      auto [key, is_flag_key] = GetkeyFromShortKey<Args>(arg[j]);
+      if (!is_flag_key) {
+        pending = ValueCount<Args>(key);
+        if (j + 1 != arg.size() and pending > 0) {
+          pending--;
+        }
+        break;
+      }
+    }
+  }
+  return -1;
+}
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+template <ArgName Name, class Parser>
+struct SubParser {
+  static constexpr auto name = Name;
+  std::reference_wrapper<Parser> parser;
+  std::string_view description;
+};
+
+template <class SubParsers>
+  requires(is_tuple_v<SubParsers>)
+ARGO_ALWAYS_INLINE constexpr auto MetaParse(SubParsers sub_parsers, int index,
+                                            int argc, char** argv) -> bool {
+  return std::apply(
+      [&](auto&&... s) ARGO_ALWAYS_INLINE {
+        std::int64_t idx = -1;
+        return (... || (idx++, idx == index &&
+                                   (s.parser.get().parse(argc, argv), true)));
+      },
+      sub_parsers);
+};
+
+template <class SubParsers>
+  requires(is_tuple_v<SubParsers>)
+ARGO_ALWAYS_INLINE constexpr auto ParserIndex(SubParsers sub_parsers,  //
+                                              std::string_view key)
+    -> std::int64_t {
+  return std::apply(
+      [&](auto&&... s) ARGO_ALWAYS_INLINE {
+        std::int64_t index = -1;
+        bool found = (... || (index++, s.name.getKey() == key));
+        return found ? index : -1;
+      },
+      sub_parsers);
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+struct Unspecified {};
+
+enum class RequiredFlag : bool {
+  Optional = false,
+  Required = true,
+};
+
+using RequiredFlag::Required;  // NOLINT(misc-unused-using-decls)
+using RequiredFlag::Optional;  // NOLINT(misc-unused-using-decls)
+
+enum class RepeatFlag : bool {
+  Once = false,
+  Append = true,
+};
+
+using RepeatFlag::Append;  // NOLINT(misc-unused-using-decls)
+
+template <class T, auto... Options>
+consteval auto HasOption() -> bool {
+  return (std::is_same_v<std::remove_cvref_t<decltype(Options)>, T> || ...);
+}
+
+/*!
+ * First template option of type T, put a fallback at the end of Options
+ */
+template <class T, auto Option, auto... Options>
+consteval auto GetOption() -> T {
+  if constexpr (std::is_same_v<std::remove_cvref_t<decltype(Option)>, T>) {
+    return Option;
+  } else {
+    return GetOption<T, Options...>();
+  }
+}
+
+/*!
+ * Helper function to create nargs
+ */
+consteval auto nargs(char narg) -> NArgs {
+  return NArgs(narg);
+}
+
+consteval auto nargs(int narg) -> NArgs {
+  return NArgs(narg);
+}
+
+struct ParserInfo {
+  std::optional<std::string_view> help = std::nullopt;
+  std::optional<std::string_view> program_name = std::nullopt;
+  std::optional<std::string_view> description = std::nullopt;
+  std::optional<std::string_view> usage = std::nullopt;
+  std::optional<std::string_view> subcommand_help = std::nullopt;
+  std::optional<std::string_view> options_help = std::nullopt;
+  std::optional<std::string_view> positional_argument_help = std::nullopt;
+  std::optional<std::string_view> env_prefix = std::nullopt;
+  std::optional<std::string_view> config_key = std::nullopt;
+  bool copy_config = false;
+  bool exit_on_help = true;
+  std::shared_ptr<ConfigStorage> config = std::make_shared<ConfigStorage>();
+  // Program name taken from a command line string, which resetArgs releases
+  std::string owned_program_name;
+  // argv split from a command line string, reused by the next one
+  std::vector<char*> owned_argv;
+  // Tokens after "--" in the argv given to parse
+  std::span<char*> passthrough;
+  // Tokens of "-" or "--args-from-stdin", set by argsFromStdin
+  std::optional<TokenReader> stdin_args = std::nullopt;
+  // argv given to parse with the tokens of stdin_args in place of "-"
+  std::vector<char*> stdin_argv;
+  bool collect_unknown = false;
+  // Unknown options and their values when collect_unknown is set
+  std::vector<char*> unknown;
+};
+
+template <class P>
+class Reloader;
+
+template <ParserID ID = 0, class Args = std::tuple<>,
+                 class PArgs = std::tuple<>, class HArg = void,
+                 class SubParsers = std::tuple<>,
+                 class Constraints = std::tuple<>>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+class Parser {
+ private:
+  bool parsed_ = false;
+  std::unique_ptr<ParserInfo> info_ = nullptr;
+  SubParsers subParsers;
+
+  template <class P>
+  friend class Reloader;
+
+ public:
+  using Arguments =
+      decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+
+  // Same arguments with separate values, used by Reloader
+  using Shadow = Parser<ID.shadowed(), RebindArgs_t<Args, ID.shadowed()>,
+                        RebindArgs_t<PArgs, ID.shadowed()>, void, std::tuple<>,
+                        Constraints>;
+
+  constexpr explicit Parser() : info_(std::make_unique<ParserInfo>()){};
+
+  constexpr explicit Parser(std::string_view program_name)
+      : info_(std::make_unique<ParserInfo>()) {
+    this->info_->program_name = program_name;
+  };
+
+  constexpr explicit Parser(std::string_view program_name,
+                            std::string_view description)
+      : info_(std::make_unique<ParserInfo>()) {
+    this->info_->program_name = program_name;
+    this->info_->description = description;
+  };
+
+  constexpr explicit Parser(std::string_view program_name,
+                            Argo::Description description)
+      : info_(std::make_unique<ParserInfo>()) {
+    this->info_->program_name = program_name;
+    this->info_->description = description.description;
+  };
+
+  constexpr explicit Parser(SubParsers tuple) : subParsers(tuple) {}
+
+  constexpr explicit Parser(std::unique_ptr<ParserInfo> info, SubParsers tuple)
+      : info_(std::move(info)), subParsers(tuple){};
+
+  Parser(const Parser&) = delete;
+  Parser(Parser&&) = delete;
+
+  constexpr auto operator=(const Parser&) -> Parser& = delete;
+  constexpr auto operator=(Parser&&) -> Parser& = delete;
+  constexpr ~Parser() = default;
+
+  template <class Type, ArgName Name, auto arg1 = Unspecified(),
+            auto arg2 = Unspecified(), auto arg3 = Unspecified(),
+            bool ISPArgs, class... T>
+  ARGO_ALWAYS_INLINE constexpr auto createArg(T... args) {
+    static_assert(Name.hasValidNameLength(),
+                  "Short name can't be more than one charactor");
+
+    static constexpr auto append =
+        GetOption<RepeatFlag, arg1, arg2, arg3, RepeatFlag::Once>() ==
+        RepeatFlag::Append;
+
+    static constexpr auto nargs = []() {
+      if constexpr (HasOption<NArgs, arg1, arg2, arg3>()) {
+        constexpr auto narg = GetOption<NArgs, arg1, arg2, arg3>();
+        if constexpr (is_array_v<Type>) {
+          static_assert(array_len_v<Type> == narg.nargs,
+                        "Array size mismatch with nargs");
+        }
+        if constexpr (is_vector_v<Type>) {
+          static_assert((narg.nargs_char != '?' && narg.nargs != 1) || append,
+                        "Vector size mismatch with nargs");
+        }
+        if constexpr (is_map_v<Type>) {
+          static_assert(narg.nargs == 1 || narg.nargs_char == '+',
+                        "Map nargs must be 1 or '+'");
+        }
+        if constexpr (is_tuple_v<Type>) {
+          static_assert(std::tuple_size_v<Type> == narg.nargs,
+                        "Tuple size mismatch with nargs");
+        }
+        return narg;
+      } else {
+        if constexpr (is_array_v<Type>) {
+          return NArgs{static_cast<int>(array_len_v<Type>)};
+        }
+        if constexpr (append) {
+          return NArgs(1);
+        }
+        if constexpr (is_vector_v<Type>) {
+          return NArgs{'*'};
+        }
+        if constexpr (is_tuple_v<Type>) {
+          return NArgs{static_cast<int>(std::tuple_size_v<Type>)};
+        }
+        if constexpr (is_map_v<Type>) {
+          return NArgs(1);
+        }
+        if constexpr (ISPArgs) {
+          return NArgs(1);
+        }
+        return NArgs('?');
+      }
+    }();
+
+    static_assert(!(is_array_v<Type> and nargs.nargs == 1),
+                  "Array size must be more than one");
+    static_assert(!(is_tuple_v<Type> and nargs.nargs == 1),
+                  "Tuple size must be more than one");
+    static_assert(!append or is_vector_v<Type>,
+                  "Append argument must be std::vector");
+    static_assert(!append or nargs.nargs == 1 or nargs.nargs_char == '+',
+                  "Append argument nargs must be 1 or '+'");
+    static_assert(is_map_v<Type> or !requires { typename Type::mapped_type; },
+                  "Map argument must be ordered, use std::map or std::flat_map");
+    static constexpr auto required = static_cast<bool>(
+        GetOption<RequiredFlag, arg1, arg2, arg3, Optional>());
+
+    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+      static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
+    }
+    static_assert(
+        (Name.getShortName() == '\0') ||
+            (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
+        "Duplicated short name");
+    static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
+    static_assert(                     //
+        (nargs.nargs > 0               //
+         || nargs.nargs_char == '?'    //
+         || nargs.nargs_char == '+'    //
+         || nargs.nargs_char == '*'),  //
+        "nargs must be '?', '+', '*' or int");
+
+    ArgInitializer<Type, Name, nargs, required, ID, append>(
+        std::forward<T>(args)...);
+    return std::type_identity<Arg<Type, Name, nargs, required, ID, append>>();
+  }
+
+  /*!
+   * Name: name of argument
+   * Type: type of argument
+   * arg1: Required(bool) or NArgs or Append or Unspecified
+   * arg2: Required(bool) or NArgs or Append or Unspecified
+   * arg3: Required(bool) or NArgs or Append or Unspecified
+   */
+  template <ArgName Name, class Type, auto arg1 = Unspecified(),
+            auto arg2 = Unspecified(), auto arg3 = Unspecified(), class... T>
+  constexpr auto addArg(T... args) {
+    auto arg = createArg<Type, Name, arg1, arg2, arg3, false>(
+        std::forward<T>(args)...);
+    return Parser<ID, tuple_append_t<Args, typename decltype(arg)::type>, PArgs,
+                  HArg, SubParsers, Constraints>(std::move(this->info_),
+                                                 subParsers);
+  }
+
+  /*!
+   * Name: name of argument
+   * Type: type of argument
+   * arg1: Required(bool) or NArgs or Unspecified
+   * arg2: Required(bool) or NArgs or Unspecified
+   */
+  template <ArgName Name, class Type, auto arg1 = Unspecified(),
+            auto arg2 = Unspecified(), class... T>
+  constexpr auto addPositionalArg(T... args) {
+    static_assert(Name.getShortName() == '\0',
+                  "Positional argment cannot have short name");
+    auto arg = createArg<Type, Name, arg1, arg2, Unspecified{}, true>(
+        std::forward<T>(args)...);
+
+    static_assert(decltype(arg)::type::nargs.nargs_char != '?',
+                  "Cannot assign narg: ? to the positional argument");
+    static_assert(decltype(arg)::type::nargs.nargs_char != '*',
+                  "Cannot assign narg: * to the positional argument");
+    static_assert(!decltype(arg)::type::repeatable,
+                  "Positional argument cannot be repeated");
+
+    return Parser<ID, Args, tuple_append_t<PArgs, typename decltype(arg)::type>,
+                  HArg, SubParsers, Constraints>(std::move(this->info_),
+                                                 subParsers);
+  }
+
+  /*!
+   * Argument naming a config file, read after the command line and the
+   * environment. A default path is skipped when the file does not exist.
+   * Example:
+   *      addConfig<"config,c">(Argo::explicitDefault(std::string("app.toml")))
+   */
+  template <ArgName Name, class... T>
+  constexpr auto addConfig(T... args) {
+    auto arg = createArg<std::string, Name, NArgs(1), Unspecified{},
+                         Unspecified{}, false>(std::forward<T>(args)...);
+    this->info_->config_key = Name.getKey();
+    return Parser<ID, tuple_append_t<Args, typename decltype(arg)::type>, PArgs,
+                  HArg, SubParsers, Constraints>(std::move(this->info_),
+                                                 subParsers);
+  }
+
+  template <ArgName Name, class... T>
+  constexpr auto addFlag(T... args) {
+    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+      static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
+    }
+    static_assert(
+        (Name.getShortName() == '\0') ||
+            (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
+        "Duplicated short name");
+    static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
+    FlagArgInitializer<FlagArg<Name, ID>>(std::forward<T>(args)...);
+    return Parser<ID, tuple_append_t<Args, FlagArg<Name, ID>>, PArgs, HArg,
+                  SubParsers, Constraints>(std::move(this->info_), subParsers);
+  }
+
+  /*!
+   * Flag which counts how many times it is given, getArg returns int
+   */
+  template <ArgName Name, class... T>
+  constexpr auto addCount(T... args) {
+    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+      static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
+    }
+    static_assert(
+        (Name.getShortName() == '\0') ||
+            (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
+        "Duplicated short name");
+    static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
+    FlagArgInitializer<CountArg<Name, ID>>(std::forward<T>(args)...);
+    return Parser<ID, tuple_append_t<Args, CountArg<Name, ID>>, PArgs, HArg,
+                  SubParsers, Constraints>(std::move(this->info_), subParsers);
+  }
+
+  template <ArgName Name = "help,h">
+  constexpr auto addHelp() {
+    static_assert((SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
+                  "Duplicated short name");
+    static_assert(Argo::SearchIndex<Args, Name>() == -1, "Duplicated name");
+    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers,
+                  Constraints>(std::move(this->info_), subParsers);
+  }
+
+  template <ArgName Name = "help,h">
+  constexpr auto addHelp(std::string_view help) {
+    static_assert((SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
+                  "Duplicated short name");
+    static_assert(Argo::SearchIndex<Args, Name>() == -1, "Duplicated name");
+    static_assert(Name.hasValidNameLength(),
+                  "Short name can't be more than one charactor");
+    this->info_->help = help;
+    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers,
+                  Constraints>(std::move(this->info_), subParsers);
+  }
+
+  template <ArgName Name>
+  constexpr auto getArg() {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+      if constexpr (SearchIndex<PArgs, Name>() != -1) {
+        return std::tuple_element_t<SearchIndex<PArgs, Name>(), PArgs>::value;
+      } else {
+        static_assert(SearchIndex<Args, Name>() != -1,
+                      "Argument does not exist");
+        return std::remove_cvref_t<decltype(std::get<SearchIndex<Args, Name>()>(
+            std::declval<Args>()))>::value;
+      }
+    } else {
+      static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
+      return std::remove_cvref_t<decltype(std::get<SearchIndex<Args, Name>()>(
+          std::declval<Args>()))>::value;
+    }
+  }
+
+  /*!
+   * Immutable copy of every value, safe to share between threads
+   */
+  [[nodiscard]] auto freeze() const -> Snapshot<Arguments> {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return Snapshot<Arguments>(std::type_identity<Arguments>(),
+                               this->info_->config);
+  }
+
+  /*!
+   * Parsed values in a binary form for load, readable only by a program built
+   * with the same arguments on the same architecture. Not available with
+   * LazyArgs arguments, which view argv
+   */
+  [[nodiscard]] auto serialize() const -> std::vector<std::byte>
+    requires(is_serializable_args_v<Arguments>)
+  {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return SerializeArgs<Arguments>();
+  }
+
+  /*!
+   * Take the values written by serialize instead of parsing, validators and
+   * callbacks are not run again
+   * string_view and const char* values point into buffer, keep it alive
+   */
+  auto load(std::span<const std::byte> buffer) -> void
+    requires(is_serializable_args_v<Arguments>)
+  {
+    if (this->parsed_) [[unlikely]] {
+      throw ParseError("Cannot parse twice");
+    }
+    DeserializeArgs<Arguments>(buffer);
+    this->parsed_ = true;
+  }
+
+  /*!
+   * Map fd, for example a memfd or shm object inherited from the parent, and
+   * load from it. fd can be closed after this returns
+   */
+  auto load(int fd) -> void
+    requires(is_serializable_args_v<Arguments>)
+  {
+    const auto& file = this->info_->config->files.emplace_back(
+        BasicMappedFile<MapAdvice::Sequential>::fromFd(fd));
+    this->load(file.bytes());
+  }
+
+  template <ArgName Name>
+  constexpr auto getParser() -> auto& {
+    if constexpr (std::is_same_v<SubParsers, std::tuple<>>) {
+      static_assert(false, "Parser has no sub parser");
+    }
+    static_assert(!(SearchIndex<SubParsers, Name>() == -1),
+                  "Could not find subparser");
+    return std::get<SearchIndex<SubParsers, Name>()>(subParsers).parser.get();
+  }
+
+  /*!
+   * Tokens after "--", which are neither options nor positional arguments
+   * The span points into the argv given to parse and is null terminated when
+   * argv is, so it can be passed to execvp as is:
+   *      auto rest = parser.getPassthrough();
+   *      execvp(rest[0], rest.data());
+   */
+  [[nodiscard]] auto getPassthrough() const -> std::span<char*> {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return this->info_->passthrough;
+  }
+
+  /*!
+   * Tokens of the unknown options and their values in command line order,
+   * pointing into the argv given to parse. Empty unless collectUnknown is set
+   */
+  [[nodiscard]] auto getUnknown() const -> std::span<char* const> {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    return this->info_->unknown;
+  }
+
+  /*!
+   * Tokens of stdin not taken by parse, see argsFromStdin
+   * Example:
+   *      for (auto file : parser.getStdinArgs()) { ... }
+   */
+  [[nodiscard]] auto getStdinArgs() -> TokenReader& {
+    if (!this->info_->stdin_args) [[unlikely]] {
+      throw ParseError("argsFromStdin is not set");
+    }
+    return *this->info_->stdin_args;
+  }
+
+  template <ArgName Name>
+  constexpr auto isAssigned() {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    using AllArguments =
+        decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+
+    static_assert(SearchIndex<AllArguments, Name>() != -1,
+                  "Argument does not exist");
+
+    return std::tuple_element_t<SearchIndex<AllArguments, Name>(),
+                                AllArguments>::assigned;
+  }
+
+  /*!
+   * Source of the value of the argument
+   */
+  template <ArgName Name>
+  constexpr auto getSource() -> ValueSource {
+    if (!this->parsed_) [[unlikely]] {
+      throw ParseError("Parser did not parse argument, call parse first");
+    }
+    using AllArguments =
+        decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+
+    static_assert(SearchIndex<AllArguments, Name>() != -1,
+                  "Argument does not exist");
+
+    return std::tuple_element_t<SearchIndex<AllArguments, Name>(),
+                                AllArguments>::source;
+  }
+
+  /*!
+   * Add subcommand
+   */
+  template <ArgName Name, class T>
+  ARGO_ALWAYS_INLINE constexpr auto addParser(T& sub_parser,
+                                              Description description = {""}) {
+    auto s = std::make_tuple(
+        SubParser<Name, T>{ref(sub_parser), description.description});
+    auto sub_parsers = std::tuple_cat(subParsers, s);
+    return Parser<ID, Args, PArgs, HArg, decltype(sub_parsers), Constraints>(
+        std::move(this->info_), sub_parsers);
+  }
+
+  /*!
+   * Add a constraint between arguments, checked at the end of parse
+   * Example:
+   *      addConstraint(Argo::exclusive<"json", "yaml">())
+   *      addConstraint(Argo::dependsOn<"tls-key", "tls-cert">())
+   *      addConstraint(Argo::oneOf<"file", "url">())
+   */
+  template <class Constraint>
+  constexpr auto addConstraint(Constraint /* unused */) {
+    static_assert(std::derived_from<Constraint, ConstraintTag>,
+                  "Invalid constraint");
+    static_assert(Constraint::template refersTo<decltype(std::tuple_cat(
+                      std::declval<Args>(), std::declval<PArgs>()))>(),
+                  "Constraint refers to an unknown argument");
+    return Parser<ID, Args, PArgs, HArg, SubParsers,
+                  tuple_append_t<Constraints, Constraint>>(
+        std::move(this->info_), subParsers);
+  }
+
+  /*!
+   * Reset the arguments assigned by the last parse to their explicit default.
+   * Containers keep their capacity for the next parse unless release_memory
+   * is set
+   */
+  ARGO_ALWAYS_INLINE constexpr auto resetArgs(bool release_memory = false)
+      -> void;
+
+  /*!
+   * resetArgs for this parser and its sub parsers, the config storage is kept
+   * when the last parse did not use it
+   */
+  auto resetAssigned() -> void;
+
+  /*!
+   * Read arguments not given on the command line from PREFIX_KEY variables
+   */
+  ARGO_ALWAYS_INLINE constexpr auto setEnvPrefix(std::string_view prefix) {
+    this->info_->env_prefix = prefix;
+  }
+
+  /*!
+   * Collect unknown options with the values following them instead of
+   * throwing, see getUnknown. An unknown option takes every value up to the
+   * next option, positional arguments must come before it
+   */
+  ARGO_ALWAYS_INLINE constexpr auto collectUnknown(bool enable = true) {
+    this->info_->collect_unknown = enable;
+  }
+
+  /*!
+   * Take "-" or "--args-from-stdin" on the command line as the tokens read
+   * from fd, delimited by delimiter, in its place
+   * When it is the last token and the last positional argument takes
+   * nargs('+'), nothing is read by parse: the positional argument gets the
+   * values before it and the rest is pulled lazily from getStdinArgs
+   */
+  auto argsFromStdin(char delimiter = '\0', int fd = 0) -> void {
+    this->info_->stdin_args.emplace(fd, delimiter);
+  }
+
+  /*!
+   * With false, --help prints the help and throws HelpRequested instead of
+   * exiting, for this parser and its sub parsers
+   */
+  ARGO_ALWAYS_INLINE constexpr auto exitOnHelp(bool enable = true) -> void {
+    this->info_->exit_on_help = enable;
+    std::apply(
+        [enable](auto&... sub) { (..., sub.parser.get().exitOnHelp(enable)); },
+        this->subParsers);
+  }
+
+  ARGO_ALWAYS_INLINE constexpr auto addUsageHelp(std::string_view usage) {
+    this->info_->usage = usage;
+  }
+
+  ARGO_ALWAYS_INLINE constexpr auto addSubcommandHelp(
+      std::string_view subcommand_help) {
+    this->info_->subcommand_help = subcommand_help;
+  }
+
+  ARGO_ALWAYS_INLINE constexpr auto addPositionalArgumentHelp(
+      std::string_view positional_argument_help) {
+    this->info_->positional_argument_help = positional_argument_help;
+  }
+
+  ARGO_ALWAYS_INLINE constexpr auto addOptionsHelp(
+      std::string_view options_help) {
+    this->info_->options_help = options_help;
   }
-}
 
-template <class... T, std::size_t... N>
-ARGO_ALWAYS_INLINE constexpr auto TupleAssign(
-    std::tuple<T...>& t, const std::span<std::string_view>& v,
-    std::index_sequence<N...> /* unused */, const std::string_view& key)
-    -> void {
-  ((std::get<N>(t) = ArgCaster<std::remove_cvref_t<decltype(get<N>(t))>>(v[N], key)),
-   ...);
-}
+ private:
+  auto spliceStdinArgs(int argc, char* argv[]) -> std::pair<int, char**>;
+  [[noreturn]] auto exitWithHelp() const -> void;
+  ARGO_ALWAYS_INLINE constexpr auto setArg(
+      std::string_view key, const std::span<std::string_view>& val) const
+      -> void;
+  ARGO_ALWAYS_INLINE constexpr auto setShortKeyArg(
+      std::string_view short_key, const std::span<std::string_view>& val) const
+      -> void;
 
-template <class Arg>
-ARGO_ALWAYS_INLINE constexpr auto AfterAssign(
-    const std::span<std::string_view>& values) -> void {
-  Arg::assigned = true;
-  if (Arg::validator) {
-    Arg::validator(Arg::value, values, Arg::name.getKey());
+ public:
+  ARGO_ALWAYS_INLINE constexpr auto parse(int argc, char* argv[]) -> void;
+
+  /*!
+   * parse a whole command line split with POSIX shell quoting, the first
+   * token is the program name. Tokens live in an arena owned by the parser
+   * until resetArgs
+   */
+  auto parse(std::string_view command_line) -> void;
+
+  /*!
+   * parse, reusing the result stored in cache_dir by an earlier run with the
+   * same argv, environment and config file. Returns true on a hit, in which
+   * case validators and callbacks are not run
+   */
+  auto parseCached(int argc, char* argv[], std::string_view cache_dir) -> bool
+    requires(is_serializable_args_v<Arguments>);
+
+  /*!
+   * Tokenize and dispatch like parse, but call
+   * visitor(VisitTag<Arg>, ValueSpan values, int position) for every argument
+   * found instead of storing it. Values are neither converted nor validated
+   * and no argument is written, check runs the required and constraint checks
+   * Tokens after "--" are not visited
+   */
+  template <class Visitor>
+  auto visit(int argc, char* argv[], Visitor&& visitor,
+             bool check = false) const -> void;
+
+  /*!
+   * Parser fed one token at a time, see IncrementalParser
+   */
+  [[nodiscard]] auto incremental() const
+      -> IncrementalParser<Args, PArgs, HArg, Constraints> {
+    static_assert(std::is_same_v<SubParsers, std::tuple<>>,
+                  "incremental does not support sub parsers");
+    return {};
   }
-  if (Arg::callback) {
-    Arg::callback(Arg::value, values);
+  [[nodiscard]] constexpr auto formatHelp(bool no_color = false) const
+      -> std::string;
+
+  explicit constexpr operator bool() const {
+    return this->parsed_;
+  }
+};
+
+}  // namespace Argo
+
+
+namespace Argo {
+
+ARGO_ALWAYS_INLINE auto splitStringView(std::string_view str, char delimeter)
+    -> std::vector<std::string_view> {
+  std::vector<std::string_view> ret;
+  while (str.contains(delimeter)) {
+    auto pos = str.find(delimeter);
+    ret.push_back(str.substr(0, pos));
+    str = str.substr(pos + 1);
   }
+  ret.push_back(str);
+  return ret;
 }
 
-template <class Arg>
-ARGO_ALWAYS_INLINE constexpr auto ValiadicArgAssign(
-    const std::span<std::string_view>& values) -> void {
-  Arg::value.resize(values.size());
-  for (std::size_t i = 0; i < values.size(); i++) {
-    Arg::value[i] =
-        ArgCaster<typename Arg::baseType>(values[i], Arg::name.getKey());
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+constexpr auto
+Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::resetArgs(
+    bool release_memory) -> void {
+  this->parsed_ = false;
+  this->info_->config = std::make_shared<ConfigStorage>();
+  this->info_->passthrough = {};
+  if (release_memory) {
+    this->info_->owned_argv = {};
+    this->info_->unknown = {};
+  } else {
+    this->info_->unknown.clear();
   }
-  AfterAssign<Arg>(values);
+  ResetDirtyArgs<ID>(release_memory);
 }
 
-template <class Arg>
-ARGO_ALWAYS_INLINE constexpr auto NLengthArgAssign(
-    std::span<std::string_view>& values) -> void {
-  if (Arg::nargs.nargs > values.size()) [[unlikely]] {
-    throw Argo::InvalidArgument(std::format("Argument {}: invalid argument {}",
-                                            Arg::name.getKey(), values));
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::resetAssigned()
+    -> void {
+  this->parsed_ = false;
+  this->info_->passthrough = {};
+  this->info_->unknown.clear();
+  ResetDirtyArgs<ID>();
+  const auto& config = *this->info_->config;
+  if (!config.files.empty() or !config.strings.empty()) {
+    this->info_->config = std::make_shared<ConfigStorage>();
   }
-  if constexpr (is_array_v<typename Arg::type>) {
-    for (std::size_t i = 0; i < Arg::nargs.nargs; i++) {
-      Arg::value[i] =
-          ArgCaster<typename Arg::baseType>(values[i], Arg::name.getKey());
-    }
-  } else if constexpr (is_vector_v<typename Arg::type>) {
-    Arg::value.resize(Arg::nargs.nargs);
-    for (std::size_t i = 0; i < Arg::nargs.nargs; i++) {
-      Arg::value[i] =
-          ArgCaster<typename Arg::baseType>(values[i], Arg::name.getKey());
+  std::apply([](auto&... sub) { (..., sub.parser.get().resetAssigned()); },
+             this->subParsers);
+}
+
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::spliceStdinArgs(
+    int argc, char* argv[]) -> std::pair<int, char**> {
+  if (argv == this->info_->stdin_argv.data()) {
+    // Already spliced by parseCached
+    return {argc, argv};
+  }
+  const auto options_end = OptionsEnd(argc, argv);
+  const auto index = StdinArgIndex<Args>(options_end, argv);
+  if (index == -1) {
+    return {argc, argv};
+  }
+  auto lazy = false;
+  if constexpr (std::tuple_size_v<PArgs> != 0) {
+    using Last = std::tuple_element_t<std::tuple_size_v<PArgs> - 1, PArgs>;
+    lazy = Last::nargs.nargs_char == '+' and index == options_end - 1;
+  }
+  auto& spliced = this->info_->stdin_argv;
+  spliced.assign(argv, argv + index);
+  if (!lazy) {
+    for (auto token : *this->info_->stdin_args) {
+      // Tokens are null terminated in the arena of the reader
+      spliced.push_back(const_cast<char*>(token.data()));
     }
-  } else if constexpr (is_tuple_v<typename Arg::type>) {
-    TupleAssign(
-        Arg::value, values,
-        std::make_index_sequence<std::tuple_size_v<typename Arg::type>>(),
-        Arg::name.getKey());
-  } else {
-    static_assert(false, "Invalid Type");
   }
-  AfterAssign<Arg>(values.subspan(0, Arg::nargs.nargs));
-  values = values.subspan(Arg::nargs.nargs);
+  spliced.insert(spliced.end(), argv + index + 1, argv + argc);
+  spliced.push_back(nullptr);
+  return {static_cast<int>(spliced.size() - 1), spliced.data()};
 }
 
-template <class Arg>
-ARGO_ALWAYS_INLINE constexpr auto ZeroOrOneArgAssign(
-    std::span<std::string_view>& values) -> void {
-  if (values.empty()) {
-    Arg::value = Arg::defaultValue;
-  } else {
-    Arg::value = ArgCaster<typename Arg::type>(values[0], Arg::name.getKey());
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::exitWithHelp()
+    const -> void {
+  std::cout << formatHelp() << std::endl;
+  if (!this->info_->exit_on_help) {
+    throw HelpRequested();
   }
-  AfterAssign<Arg>(values.subspan(0, 1));
-  values = values.subspan(1);
+  std::exit(0);
 }
 
-template <class PArgs>
-ARGO_ALWAYS_INLINE constexpr auto PArgAssigner(
-    std::span<std::string_view> values) -> bool {
-  return [&values]<class... Arg>(type_sequence<Arg...>) ARGO_ALWAYS_INLINE {
-    return ([&values] ARGO_ALWAYS_INLINE {
-      if (Arg::assigned) {
-        return false;
-      }
-      if constexpr (Arg::nargs.nargs_char == '+') {
-        ValiadicArgAssign<Arg>(values);
-        return true;
-      }
-      if constexpr (Arg::nargs.nargs == 1) {
-        if (values.empty()) [[unlikely]] {
-          throw Argo::InvalidArgument(
-              std::format("Argument {}: should take exactly one value but zero",
-                          Arg::name.getKey()));
-        }
-        ZeroOrOneArgAssign<Arg>(values);
-        return values.empty();
-      }
-      if constexpr (Arg::nargs.nargs > 1) {
-        NLengthArgAssign<Arg>(values);
-        return values.empty();
-      }
-    }() || ...);
-  }(make_type_sequence_t<PArgs>());
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::setArg(
+    std::string_view key, const std::span<std::string_view>& val) const
+    -> void {
+  if constexpr (!std::is_same_v<HArg, void>) {
+    if (key == HArg::name.getKey()) {
+      this->exitWithHelp();
+    }
+  }
+  Assigner<Args, PArgs>(key, val);
 }
 
-template <>
-ARGO_ALWAYS_INLINE constexpr auto PArgAssigner<std::tuple<>>(
-    std::span<std::string_view> /*unused*/) -> bool {
-  return true;
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+constexpr auto
+Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::setShortKeyArg(
+    std::string_view key, const std::span<std::string_view>& val) const
+    -> void {
+  if (ShortArgAssigner<Args, PArgs, HArg>(key, val)) [[unlikely]] {
+    this->exitWithHelp();
+  };
 }
 
-template <class Head, class PArgs>
-ARGO_ALWAYS_INLINE constexpr auto AssignOneArg(
-    const std::string_view& key, std::span<std::string_view> values) -> bool {
-  if (Head::assigned) [[unlikely]] {
-    throw Argo::InvalidArgument(
-        std::format("Argument {}: duplicated argument", key));
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::parse(
+    int argc, char* argv[]) -> void {
+  if (this->parsed_) [[unlikely]] {
+    throw ParseError("Cannot parse twice");
   }
-  if constexpr (std::derived_from<Head, FlagArgTag>) {
-    if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
-      if (!values.empty()) [[unlikely]] {
-        throw Argo::InvalidArgument(
-            std::format("Flag {} can not take value", key));
+  if (!DirtyArgs<ID>::args.empty()) [[unlikely]] {
+    auto assigned_keys = std::vector<std::string_view>();
+    tuple_type_visit<Arguments>([&assigned_keys]<class T>(T) {
+      if (T::type::assigned) {
+        assigned_keys.push_back(T::type::name.getKey());
       }
-    } else {
-      if (!values.empty()) {
-        PArgAssigner<PArgs>(values);
+    });
+    throw ParseError(std::format("keys {} already assigned", assigned_keys));
+  }
+  if (this->info_->stdin_args) [[unlikely]] {
+    std::tie(argc, argv) = this->spliceStdinArgs(argc, argv);
+  }
+
+  std::vector<std::string_view> values{};
+
+  // [[assume(this->info_)]]; // TODO(gen740): add assume when clang supports it
+
+  if (!this->info_->program_name) {
+    this->info_->program_name = std::string_view(argv[0]);
+  }
+
+  const auto options_end = OptionsEnd(argc, argv);
+
+  // Search for subcommand, the tokens after "--" are not searched
+  std::int32_t subcmd_found_idx = -1;
+  std::int32_t cmd_end_pos = options_end;
+
+  for (int i = options_end - 1; i > 0; i--) {
+    if constexpr (!std::is_same_v<SubParsers, std::tuple<>>) {
+      if (subcmd_found_idx == -1) {
+        subcmd_found_idx = ParserIndex(subParsers, argv[i]);
+        if (subcmd_found_idx != -1) {
+          cmd_end_pos = i;
+        }
       }
     }
-    Head::value = true;
-    Head::assigned = true;
-    if (Head::callback) {
-      Head::callback();
-    }
-    return true;
+  }
+  // Instantiated twice so the lookup of unknown options costs nothing when
+  // they are not collected
+  auto tokenize = [&]<bool CollectUnknown>() ARGO_ALWAYS_INLINE {
+    Tokenize<Args>(
+        cmd_end_pos, argv,
+        [this, &values, argv](TokenKind kind, std::string_view name,
+                              ValueSpan span,
+                              int position) ARGO_ALWAYS_INLINE {
+          if constexpr (has_lazy_args_v<Arguments>) {
+            TokenValues<ID>::span = span;
+          }
+          if constexpr (CollectUnknown) {
+            using Known = std::conditional_t<std::is_same_v<HArg, void>, Args,
+                                             tuple_append_t<Args, HArg>>;
+            if ((kind == TokenKind::Long and !IsKnownKey<Known>(name)) or
+                (kind == TokenKind::Short and
+                 !IsKnownShortKeys<Known>(name))) {
+              this->info_->unknown.insert(this->info_->unknown.end(),
+                                          argv + position,
+                                          argv + span.index() + span.size());
+              return;
+            }
+          }
+          values.assign(span.begin(), span.end());
+          if (kind == TokenKind::Short) {
+            this->setShortKeyArg(name, values);
+            return;
+          }
+          if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+            if (kind == TokenKind::Positional and !values.empty())
+                [[unlikely]] {
+              throw InvalidArgument(
+                  std::format("Invalid positional argument: {}", values));
+            }
+          }
+          this->setArg(name, values);
+        });
+  };
+  if (this->info_->collect_unknown) [[unlikely]] {
+    tokenize.template operator()<true>();
   } else {
-    if constexpr (Head::nargs.nargs_char == '?') {
-      ZeroOrOneArgAssign<Head>(values);
-      if (values.empty()) {
-        return true;
-      }
-      return PArgAssigner<PArgs>(values);
-    } else if constexpr (Head::nargs.nargs_char == '*') {
-      if (values.empty()) {
-        Head::value = Head::defaultValue;
-        Head::assigned = true;
-        return true;
-      }
-      ValiadicArgAssign<Head>(values);
-      return true;
-    } else if constexpr (Head::nargs.nargs_char == '+') {
-      if (values.empty()) [[unlikely]] {
-        throw Argo::InvalidArgument(
-            std::format("Argument {}: should take more than one value", key));
-      }
-      ValiadicArgAssign<Head>(values);
-      return true;
-    } else if constexpr (Head::nargs.nargs == 1) {
-      if (values.empty()) [[unlikely]] {
-        throw Argo::InvalidArgument(std::format(
-            "Argument {}: should take exactly one value but zero", key));
-      }
-      ZeroOrOneArgAssign<Head>(values);
-      if (values.empty()) {
-        return true;
-      }
-      return PArgAssigner<PArgs>(values);
-    } else {
-      NLengthArgAssign<Head>(values);
-      if (values.empty()) {
-        return true;
-      }
-      return PArgAssigner<PArgs>(values);
+    tokenize.template operator()<false>();
+  }
+
+  using AllArgs =
+      decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
+  for (const auto& arg : DirtyArgs<ID>::args) {
+    *arg.source = ValueSource::CommandLine;
+  }
+  if (this->info_->env_prefix) {
+    EnvAssigner<AllArgs>(*this->info_->env_prefix, *this->info_->config);
+  }
+  if (this->info_->config_key) {
+    auto [path, given] = ConfigPath<AllArgs>(*this->info_->config_key);
+    if (!path.empty()) {
+      ConfigAssigner<AllArgs>(path, given, this->info_->copy_config,
+                              *this->info_->config);
     }
   }
-  return false;
-}
 
-template <class Args, class PArgs>
-ARGO_ALWAYS_INLINE constexpr auto assignArg(
-    const std::string_view& key, const std::span<std::string_view>& values) {
-  [&key, &values]<std::size_t... Is>(std::index_sequence<Is...>)
-      ARGO_ALWAYS_INLINE -> void {
-        if (!(... || (std::tuple_element_t<Is, Args>::name.getKey() == key and
-                      AssignOneArg<std::tuple_element_t<Is, Args>, PArgs>(
-                          key, values)))) [[unlikely]] {
-          throw Argo::InvalidArgument(std::format("Invalid argument {}", key));
+  FinalizeArgs<AllArgs>();
+  if (tuple_type_or_visit<AllArgs>([]<class T>(T) ARGO_ALWAYS_INLINE {
+        if constexpr (std::derived_from<typename T::type, ArgTag>) {
+          return T::type::required && !T::type::assigned;
+        } else {
+          return false;
         }
-      }(std::make_index_sequence<std::tuple_size_v<Args>>());
+      })) [[unlikely]] {
+    auto required_keys = std::vector<std::string_view>();
+    tuple_type_visit<AllArgs>([&required_keys]<class T>(T) {
+      if constexpr (std::derived_from<typename T::type, ArgTag>) {
+        if ((T::type::required && !T::type::assigned)) {
+          required_keys.push_back(T::type::name.getKey());
+        }
+      }
+    });
+    throw InvalidArgument(std::format("Requried {}", required_keys));
+  }
+  CheckConstraints<AllArgs, Constraints>();
+  if (subcmd_found_idx != -1) {
+    // The sub parser takes "--" and what follows
+    MetaParse(subParsers, subcmd_found_idx, argc - cmd_end_pos,
+              &argv[cmd_end_pos]);
+  } else if (options_end != argc) {
+    this->info_->passthrough =
+        std::span<char*>(argv + options_end + 1, argv + argc);
+  }
+  this->parsed_ = true;
 }
 
-template <class Arguments, class PArgs>
-ARGO_ALWAYS_INLINE constexpr auto Assigner(
-    std::string_view key, const std::span<std::string_view>& values) -> void {
-  if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-    if (key.empty()) {
-      if (!PArgAssigner<PArgs>(values)) [[unlikely]] {
-        throw InvalidArgument("Duplicated positional argument");
-      }
-      return;
-    }
-  } else {
-    if (key.empty()) [[unlikely]] {
-      throw Argo::InvalidArgument(std::format("Invalid argument {}", key));
-    }
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::parse(
+    std::string_view command_line) -> void {
+  auto& arena =
+      this->info_->config->strings.emplace_back(command_line.size() + 1, '\0');
+  auto& argv = this->info_->owned_argv;
+  argv.clear();
+  ShellSplit(command_line, arena.data(), argv);
+  if (argv.empty()) {
+    // Empty program name
+    argv.push_back(arena.data());
   }
-  assignArg<Arguments, PArgs>(key, values);
+  if (!this->info_->program_name) {
+    this->info_->owned_program_name = argv[0];
+    this->info_->program_name = this->info_->owned_program_name;
+  }
+  auto argc = static_cast<int>(argv.size());
+  argv.push_back(nullptr);
+  this->parse(argc, argv.data());
 }
 
-template <class Arguments, class PArgs, class HArg>
-ARGO_ALWAYS_INLINE constexpr auto ShortArgAssigner(
-    std::string_view key, const std::span<std::string_view>& values) {
-  for (std::size_t i = 0; i < key.size(); i++) {
-    auto [found_key, is_flag] = GetkeyFromShortKey<     //
-        std::conditional_t<std::is_same_v<HArg, void>,  //
-                           Arguments,                   //
-                           tuple_append_t<Arguments, HArg>>>(key[i]);
-    if constexpr (!std::is_same_v<HArg, void>) {
-      if (found_key == HArg::name.getKey()) [[unlikely]] {
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::parseCached(
+    int argc, char* argv[], std::string_view cache_dir) -> bool
+  requires(is_serializable_args_v<Arguments>)
+{
+  static_assert(std::is_same_v<SubParsers, std::tuple<>>,
+                "parseCached does not support sub parsers");
+  if (this->parsed_) [[unlikely]] {
+    throw ParseError("Cannot parse twice");
+  }
+  if (this->info_->stdin_args) [[unlikely]] {
+    // The key covers the tokens read from stdin
+    std::tie(argc, argv) = this->spliceStdinArgs(argc, argv);
+  }
+  const auto inputs =
+      CacheInputs<Arguments>(argc, argv, this->info_->env_prefix);
+  const auto path = std::format("{}/{:016x}.argo", cache_dir, CacheKey(inputs));
+
+  if (auto file = CacheRead(path, *this->info_->config)) {
+    if (auto entry = CacheLookup(*file, inputs)) {
+      try {
+        if (std::ranges::any_of(entry->unknown, [argc](auto i) {
+              return i >= static_cast<std::uint32_t>(argc);
+            })) [[unlikely]] {
+          throw ParseError("Cached unknown option is out of argv");
+        }
+        this->load(entry->block);
+        for (auto i : entry->unknown) {
+          this->info_->unknown.push_back(argv[i]);
+        }
+        if (!this->info_->program_name) {
+          this->info_->program_name = std::string_view(argv[0]);
+        }
+        if (auto end = OptionsEnd(argc, argv); end != argc) {
+          this->info_->passthrough =
+              std::span<char*>(argv + end + 1, argv + argc);
+        }
         return true;
+      } catch (const ParseError&) {
+        // Written by an incompatible build, replaced below
       }
     }
-    if (is_flag and (key.size() - 1 == i) and !values.empty()) {
-      assignArg<Arguments, PArgs>(found_key, values);
-    } else if (is_flag) {
-      assignArg<Arguments, PArgs>(found_key, {});
-    } else if ((key.size() - 1 == i) and !values.empty()) {
-      assignArg<Arguments, PArgs>(found_key, values);
-      return false;
-    } else if ((key.size() - 1 == i) and values.empty()) {
-      auto value = std::vector<std::string_view>{key.substr(i + 1)};
-      assignArg<Arguments, PArgs>(found_key, value);
+  }
+
+  this->parse(argc, argv);
+  auto dependencies = std::vector<std::string>();
+  if (this->info_->config_key) {
+    auto config_path = ConfigPath<Arguments>(*this->info_->config_key).first;
+    if (!config_path.empty()) {
+      dependencies.emplace_back(config_path);
+    }
+  }
+  // Unknown tokens are stored as positions in argv
+  auto unknown = std::vector<std::uint32_t>();
+  unknown.reserve(this->info_->unknown.size());
+  for (int i = 0; const auto* token : this->info_->unknown) {
+    while (i < argc and argv[i] != token) {
+      i++;
+    }
+    if (i == argc) [[unlikely]] {
+      // Not a token of argv, the result cannot be replayed
       return false;
-    } else [[unlikely]] {
-      throw Argo::InvalidArgument(std::format("Invalid Flag argument {} {}",
-                                              key[i], key.substr(i + 1)));
     }
+    unknown.push_back(static_cast<std::uint32_t>(i));
   }
+  CacheStore(path, inputs, dependencies, unknown, this->serialize());
   return false;
 }
 
-template <class Args>
-ARGO_ALWAYS_INLINE constexpr auto ValueReset() -> void {
-  []<std::size_t... Is>(std::index_sequence<Is...>) ARGO_ALWAYS_INLINE {
-    (..., []<class T>() ARGO_ALWAYS_INLINE {
-      if (T::assigned) {
-        T::value = typename T::type();
-        T::assigned = false;
-      }
-    }.template operator()<std::tuple_element_t<Is, Args>>());
-  }(std::make_index_sequence<std::tuple_size_v<Args>>());
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+template <class Visitor>
+auto Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::visit(
+    int argc, char* argv[], Visitor&& visitor, bool check) const -> void {
+  static_assert(std::is_same_v<SubParsers, std::tuple<>>,
+                "visit does not support sub parsers");
+  auto visited = ArgMask<std::tuple_size_v<Arguments>>();
+  auto help = [this, argv] {
+    if (!this->info_->program_name) {
+      this->info_->program_name = std::string_view(argv[0]);
+    }
+    this->exitWithHelp();
+  };
+
+  Tokenize<Args>(
+      OptionsEnd(argc, argv), argv,
+      [&](TokenKind kind, std::string_view name, ValueSpan values,
+          int position) ARGO_ALWAYS_INLINE {
+        if (kind == TokenKind::Short) {
+          if (VisitShort<Args, PArgs, HArg>(name, values, position, visitor,
+                                            visited)) [[unlikely]] {
+            help();
+          }
+          return;
+        }
+        if constexpr (!std::is_same_v<HArg, void>) {
+          if (kind == TokenKind::Long and name == HArg::name.getKey()) {
+            help();
+          }
+        }
+        if constexpr (std::is_same_v<PArgs, std::tuple<>>) {
+          if (kind == TokenKind::Positional and !values.empty()) [[unlikely]] {
+            throw InvalidArgument(std::format(
+                "Invalid positional argument: {}",
+                std::vector<std::string_view>(values.begin(), values.end())));
+          }
+        }
+        VisitOption<Args, PArgs>(name, values, position, visitor, visited);
+      });
+  if (check) {
+    VisitCheck<Arguments, Constraints>(visited);
+  }
 }
 
-};  // namespace Argo
+struct AnsiEscapeCode {
+  bool isEnabled;
 
+  std::string bold = "\x1B[1m";
+  std::string underline = "\x1B[4m";
+  std::string reset = "\x1B[0m";
 
-namespace Argo {
+  [[nodiscard]] auto getBold() const {
+    return isEnabled ? bold : "";
+  }
 
-template <ArgName Name, class Parser>
-struct SubParser {
-  static constexpr auto name = Name;
-  std::reference_wrapper<Parser> parser;
-  std::string_view description;
-};
+  [[nodiscard]] auto getUnderline() const {
+    return isEnabled ? underline : "";
+  }
 
-template <class SubParsers>
-  requires(is_tuple_v<SubParsers>)
-ARGO_ALWAYS_INLINE constexpr auto MetaParse(SubParsers sub_parsers, int index,
-                                            int argc, char** argv) -> bool {
-  return std::apply(
-      [&](auto&&... s) ARGO_ALWAYS_INLINE {
-        std::int64_t idx = -1;
-        return (... || (idx++, idx == index &&
-                                   (s.parser.get().parse(argc, argv), true)));
-      },
-      sub_parsers);
-};
+  [[nodiscard]] auto getReset() const {
+    return isEnabled ? reset : "";
+  }
 
-template <class SubParsers>
-  requires(is_tuple_v<SubParsers>)
-ARGO_ALWAYS_INLINE constexpr auto ParserIndex(SubParsers sub_parsers,  //
-                                              std::string_view key)
-    -> std::int64_t {
-  return std::apply(
-      [&](auto&&... s) ARGO_ALWAYS_INLINE {
-        std::int64_t index = -1;
-        bool found = (... || (index++, s.name.getKey() == key));
-        return found ? index : -1;
-      },
-      sub_parsers);
+  [[nodiscard]] auto getBoldUnderline() const {
+    return isEnabled ? this->getBold() + this->getUnderline() : "";
+  }
 };
 
-}  // namespace Argo
+constexpr std::size_t max_option_width = 26;
+
+constexpr auto createUsageSection(const auto& program_name,
+                                  const auto& help_info, const auto& pargs_info,
+                                  const auto& sub_commands) {
+  std::string ret;
+  ret.append(program_name);
+  for (const auto& i : help_info) {
+    if (i.required) {
+      ret.append(std::format(" {} {}",
+                             i.shortName != '\0'
+                                 ? std::format("-{}", i.shortName)
+                                 : std::format("--{}", i.name),
+                             i.typeName));
+    }
+  }
+  ret.append(" [options...]");
+  for (const auto& i : pargs_info) {
+    if (i.required) {
+      ret.append(std::format(" {}", i.name));
+    } else {
+      ret.append(std::format(" [{}]", i.name));
+    }
+  }
+  if (!sub_commands.empty()) {
+    ret.append(" {");
+    for (const auto& command : sub_commands) {
+      ret.append(command.name);
+      ret.push_back(',');
+    }
+    ret.pop_back();
+    ret.push_back('}');
+  }
+  ret.push_back('\n');
+  return ret;
+}
 
+constexpr auto createSubcommandSection(const auto& ansi,
+                                       const auto& sub_commands) {
+  std::string ret;
+  ret.push_back('\n');
+  for (const auto& command : sub_commands) {
+    auto description = splitStringView(command.description, '\n');
+    if (command.name.size() < max_option_width - 2 and description[0] != "") {
+      ret.append(std::format(
+          "  {0}{1}{2}{3}{4}\n",
+          ansi.getBold(),                                                // 1
+          command.name,                                                  // 2
+          ansi.getReset(),                                               // 3
+          std::string(max_option_width - 2 - command.name.size(), ' '),  // 4
+          description[0]));
+    } else {
+      ret.append(std::format("  {0}{1}{2}\n", ansi.getBold(), command.name,
+                             ansi.getReset()));
+      if (description[0] != "") {
+        ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
+                               description[0]));
+      }
+    }
+    for (std::size_t i = 1; i < description.size(); i++) {
+      ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
+                             description[i]));
+    }
+  }
+  return ret;
+}
 
-namespace Argo {
+constexpr auto createOptionsSection(const auto& ansi, const auto& help_info) {
+  std::string ret;
 
-struct Unspecified {};
+  ret.push_back('\n');
+  for (const auto& option : help_info) {
+    auto description = splitStringView(option.description, '\n');
+    std::string option_string =
+        std::format("{0}{1}--{2}{3} {4}",
+                    ansi.getBold(),  // 0
+                    (option.shortName == '\0')
+                        ? "   "                                   //
+                        : std::format("-{},", option.shortName),  // 1
+                    option.name,                                  // 2
+                    ansi.getReset(),                              // 3
+                    option.typeName                               // 4
+        );
 
-enum class RequiredFlag : bool {
-  Optional = false,
-  Required = true,
-};
+    if (option_string.size() - ansi.getBold().size() - ansi.getReset().size() <
+            max_option_width - 2 and
+        description[0] != "") {
+      ret.append(std::format(
+          "  {0}{1}{2}\n",
+          option_string,  // 1
+          std::string(max_option_width - option_string.size() +
+                          ansi.getBold().size() + ansi.getReset().size() - 2,
+                      ' '),  // 3
+          description[0]     // 4
+          ));
+    } else {
+      ret.append(std::format("  {0}{1}{2}\n",
+                             ansi.getBold(),  // 0
+                             option_string,   // 1
+                             ansi.getReset()  // 2
+                             ));
+      if (description[0] != "") {
+        ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
+                               description[0]));
+      }
+    }
+    for (std::size_t i = 1; i < description.size(); i++) {
+      ret.append(std::format("{0}{1}\n",                          //
+                             std::string(max_option_width, ' '),  // 0
+                             description[i]                       // 1
+                             ));
+    }
+  }
+  return ret;
+}
+
+constexpr auto createPositionalArgumentSection(const auto& ansi,
+                                               const auto& pargs_info) {
+  std::string ret;
+  ret.push_back('\n');
+  for (const auto& i : pargs_info) {
+    auto description = splitStringView(i.description, '\n');
+
+    if (i.name.size() < max_option_width - 2 and description[0] != "") {
+      ret.append(std::format(
+          "  {0}{1}{2}{3}{4}\n",
+          ansi.getBold(),                                          // 1
+          i.name,                                                  // 2
+          ansi.getReset(),                                         // 3
+          std::string(max_option_width - 2 - i.name.size(), ' '),  // 4
+          description[0]));
+    } else {
+      ret.append(std::format("  {0}{1}{2}\n", ansi.getBold(), i.name,
+                             ansi.getReset()));
+      if (description[0] != "") {
+        ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
+                               description[0]));
+      }
+    }
+    for (std::size_t i = 1; i < description.size(); i++) {
+      ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
+                             description[i]));
+    }
+  }
+  return ret;
+}
 
-using RequiredFlag::Required;  // NOLINT(misc-unused-using-decls)
-using RequiredFlag::Optional;  // NOLINT(misc-unused-using-decls)
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
+constexpr auto
+Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>::formatHelp(
+    bool no_color) const -> std::string {
+  std::string ret;
 
-/*!
- * Helper function to create nargs
- */
-consteval auto nargs(char narg) -> NArgs {
-  return NArgs(narg);
-}
+  AnsiEscapeCode ansi(true and !no_color);
+  // AnsiEscapeCode ansi((::isatty(1) != 0) and !no_color);
 
-consteval auto nargs(int narg) -> NArgs {
-  return NArgs(narg);
-}
+  std::vector<ArgInfo> help_info;
+  if constexpr (std::is_same_v<HArg, void>) {
+    help_info = HelpGenerator<Args>();
+  } else {
+    help_info = HelpGenerator<tuple_append_t<Args, HArg>>();
+  }
+  std::vector<ArgInfo> pargs_info = HelpGenerator<PArgs>();
 
-struct ParserInfo {
-  std::optional<std::string_view> help = std::nullopt;
-  std::optional<std::string_view> program_name = std::nullopt;
-  std::optional<std::string_view> description = std::nullopt;
-  std::optional<std::string_view> usage = std::nullopt;
-  std::optional<std::string_view> subcommand_help = std::nullopt;
-  std::optional<std::string_view> options_help = std::nullopt;
-  std::optional<std::string_view> positional_argument_help = std::nullopt;
-};
+  auto sub_commands = SubParserInfo(subParsers);
 
-template <ParserID ID = 0, class Args = std::tuple<>,
-                 class PArgs = std::tuple<>, class HArg = void,
-                 class SubParsers = std::tuple<>>
-  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-class Parser {
- private:
-  bool parsed_ = false;
-  std::unique_ptr<ParserInfo> info_ = nullptr;
-  SubParsers subParsers;
+  // [[assume(this->info_)]]; // TODO(gen740): add assume when clang supports it
 
- public:
-  constexpr explicit Parser() : info_(std::make_unique<ParserInfo>()){};
+  if (this->info_->help) {
+    ret.append(this->info_->help.value());
+    ret.push_back('\n');
+  } else {
+    // Description Section
+    if (this->info_->description) {
+      ret.append(this->info_->description.value());
+      ret.push_back('\n');
+    }
 
-  constexpr explicit Parser(std::string_view program_name)
-      : info_(std::make_unique<ParserInfo>()) {
-    this->info_->program_name = program_name;
-  };
+    // Usage Section
+    ret.push_back('\n');
+    ret.append(ansi.getBoldUnderline() + "Usage:" + ansi.getReset() + "\n");
+    ret.append("  ");
 
-  constexpr explicit Parser(std::string_view program_name,
-                            std::string_view description)
-      : info_(std::make_unique<ParserInfo>()) {
-    this->info_->program_name = program_name;
-    this->info_->description = description;
-  };
+    ret.append(this->info_->usage.value_or(
+        createUsageSection(this->info_->program_name.value_or("no_name"),
+                           help_info, pargs_info, sub_commands)));
 
-  constexpr explicit Parser(std::string_view program_name,
-                            Argo::Description description)
-      : info_(std::make_unique<ParserInfo>()) {
-    this->info_->program_name = program_name;
-    this->info_->description = description.description;
-  };
+    // Subcommand Section
+    if constexpr (!std::is_same_v<SubParsers, std::tuple<>>) {
+      ret.push_back('\n');
+      ret.append(ansi.getBoldUnderline() + "Subcommands:" + ansi.getReset());
+      ret.append(this->info_->subcommand_help.value_or(
+          createSubcommandSection(ansi, sub_commands)));
+    }
 
-  constexpr explicit Parser(SubParsers tuple) : subParsers(tuple) {}
+    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
+      ret.push_back('\n');
+      ret.append(ansi.getBoldUnderline() +
+                 "Positional Argument:" + ansi.getReset());
+      ret.append(this->info_->positional_argument_help.value_or(
+          createPositionalArgumentSection(ansi, pargs_info)));
+    }
 
-  constexpr explicit Parser(std::unique_ptr<ParserInfo> info, SubParsers tuple)
-      : info_(std::move(info)), subParsers(tuple){};
+    // Options section
+    if (!help_info.empty()) {
+      ret.push_back('\n');
+      ret.append(ansi.getBoldUnderline() + "Options:" + ansi.getReset());
+      ret.append(this->info_->options_help.value_or(
+          createOptionsSection(ansi, help_info)));
+    }
+  }
 
-  Parser(const Parser&) = delete;
-  Parser(Parser&&) = delete;
+  return ret;
+}
 
-  constexpr auto operator=(const Parser&) -> Parser& = delete;
-  constexpr auto operator=(Parser&&) -> Parser& = delete;
-  constexpr ~Parser() = default;
+}  // namespace Argo
 
-  template <class Type, ArgName Name, auto arg1 = Unspecified(),
-            auto arg2 = Unspecified(), bool ISPArgs, class... T>
-  ARGO_ALWAYS_INLINE constexpr auto createArg(T... args) {
-    static_assert(Name.hasValidNameLength(),
-                  "Short name can't be more than one charactor");
 
-    static constexpr auto nargs = []() {
-      if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg1)>,
-                                   NArgs>) {
-        if constexpr (is_array_v<Type>) {
-          static_assert(array_len_v<Type> == arg1.nargs,
-                        "Array size mismatch with nargs");
-        }
-        if constexpr (is_vector_v<Type>) {
-          static_assert(arg1.nargs_char != '?' && arg1.nargs != 1,
-                        "Vector size mismatch with nargs");
-        }
-        if constexpr (is_tuple_v<Type>) {
-          static_assert(std::tuple_size_v<Type> == arg1.nargs,
-                        "Tuple size mismatch with nargs");
-        }
-        return arg1;
-      } else if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg2)>,
-                                          NArgs>) {
-        if constexpr (is_array_v<Type>) {
-          static_assert(array_len_v<Type> == arg2.nargs,
-                        "Array size mismatch with nargs");
-        }
-        if constexpr (is_vector_v<Type>) {
-          static_assert(arg2.nargs_char != '?' && arg2.nargs != 1,
-                        "Vector size mismatch with nargs");
-        }
-        if constexpr (is_tuple_v<Type>) {
-          static_assert(std::tuple_size_v<Type> == arg2.nargs,
-                        "Tuple size mismatch with nargs");
-        }
-        return arg2;
-      } else {
-        if constexpr (is_array_v<Type>) {
-          return NArgs{static_cast<int>(array_len_v<Type>)};
-        }
-        if constexpr (is_vector_v<Type>) {
-          return NArgs{'*'};
-        }
-        if constexpr (is_tuple_v<Type>) {
-          return NArgs{static_cast<int>(std::tuple_size_v<Type>)};
-        }
-        if constexpr (ISPArgs) {
-          return NArgs(1);
-        }
-        return NArgs('?');
-      }
-    }();
+#ifdef __linux__
+namespace Argo {
 
-    static_assert(!(is_array_v<Type> and nargs.nargs == 1),
-                  "Array size must be more than one");
-    static_assert(!(is_tuple_v<Type> and nargs.nargs == 1),
-                  "Tuple size must be more than one");
-    static constexpr auto required = []() {
-      if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg1)>,
-                                   RequiredFlag>) {
-        return static_cast<bool>(arg1);
-      } else if constexpr (std::is_same_v<std::remove_cvref_t<decltype(arg2)>,
-                                          RequiredFlag>) {
-        return static_cast<bool>(arg2);
-      } else {
-        return false;
+/*!
+ * Copy what the initializers set on the live arguments to the shadow ones
+ */
+template <class From, class To>
+auto CopyArgSettings() -> void {
+  []<std::size_t... Is>(std::index_sequence<Is...>) {
+    (..., []<class F, class T>() {
+      T::description = F::description;
+      T::callback = F::callback;
+      if constexpr (std::derived_from<F, ArgTag>) {
+        T::required = F::required;
+        T::defaultValue = F::defaultValue;
+        T::explicitDefault = F::explicitDefault;
+        T::validator = F::validator;
+        T::caster = F::caster;
+        T::typeName = F::typeName;
       }
-    }();
+    }.template operator()<std::tuple_element_t<Is, From>,
+                          std::tuple_element_t<Is, To>>());
+  }(std::make_index_sequence<std::tuple_size_v<From>>());
+}
 
-    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-      static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
+template <class Args>
+auto RestoreDefaults() -> void {
+  tuple_type_visit<Args>([]<class T>(T) {
+    if constexpr (std::derived_from<typename T::type, ArgTag>) {
+      T::type::value = T::type::explicitDefault;
     }
-    static_assert(
-        (Name.getShortName() == '\0') ||
-            (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
-        "Duplicated short name");
-    static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
-    static_assert(                     //
-        (nargs.nargs > 0               //
-         || nargs.nargs_char == '?'    //
-         || nargs.nargs_char == '+'    //
-         || nargs.nargs_char == '*'),  //
-        "nargs must be '?', '+', '*' or int");
-
-    ArgInitializer<Type, Name, nargs, required, ID>(std::forward<T>(args)...);
-    return std::type_identity<Arg<Type, Name, nargs, required, ID>>();
-  }
+  });
+}
 
-  /*!
-   * Name: name of argument
-   * Type: type of argument
-   * arg1: Required(bool) or NArgs or Unspecified
-   * arg2: Required(bool) or NArgs or Unspecified
-   */
-  template <ArgName Name, class Type, auto arg1 = Unspecified(),
-            auto arg2 = Unspecified(), class... T>
-  constexpr auto addArg(T... args) {
-    auto arg =
-        createArg<Type, Name, arg1, arg2, false>(std::forward<T>(args)...);
-    return Parser<ID, tuple_append_t<Args, typename decltype(arg)::type>, PArgs,
-                  HArg, SubParsers>(std::move(this->info_), subParsers);
-  }
+/*!
+ * Re-parse the command line, environment and config file when the config file
+ * changes, and publish the result as a new Snapshot
+ * Example:
+ *      auto reloader = Argo::Reloader(parser, argc, argv);
+ *      auto config = reloader.read();     // lock free
+ *      config->get<"threads">();
+ *
+ * Parsing runs on a shadow copy of the parser with its own values, the values
+ * of the parser itself are never written. The shadow has no help argument
+ * and no sub parsers, so parsers with sub commands are not supported.
+ * Validators and callbacks run on the thread calling reload, which is the
+ * watcher thread for file changes.
+ *
+ * Publishing waits until every reader that could see the old snapshot has
+ * dropped its guard, so do not hold a guard while calling reload.
+ */
+template <class P>
+class Reloader {
+ public:
+  using Snapshot = Argo::Snapshot<typename P::Arguments>;
 
-  /*!
-   * Name: name of argument
-   * Type: type of argument
-   * arg1: Required(bool) or NArgs or Unspecified
-   * arg2: Required(bool) or NArgs or Unspecified
-   */
-  template <ArgName Name, class Type, auto arg1 = Unspecified(),
-            auto arg2 = Unspecified(), class... T>
-  constexpr auto addPositionalArg(T... args) {
-    static_assert(Name.getShortName() == '\0',
-                  "Positional argment cannot have short name");
-    auto arg =
-        createArg<Type, Name, arg1, arg2, true>(std::forward<T>(args)...);
+  class ReadGuard {
+   private:
+    const Snapshot* snapshot_;
+    std::atomic<std::uint64_t>* count_;
 
-    static_assert(decltype(arg)::type::nargs.nargs_char != '?',
-                  "Cannot assign narg: ? to the positional argument");
-    static_assert(decltype(arg)::type::nargs.nargs_char != '*',
-                  "Cannot assign narg: * to the positional argument");
+   public:
+    ReadGuard(const Snapshot* snapshot, std::atomic<std::uint64_t>* count)
+        : snapshot_(snapshot), count_(count) {}
 
-    return Parser<ID, Args, tuple_append_t<PArgs, typename decltype(arg)::type>,
-                  HArg, SubParsers>(std::move(this->info_), subParsers);
-  }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard(ReadGuard&&) = delete;
+    auto operator=(const ReadGuard&) -> ReadGuard& = delete;
+    auto operator=(ReadGuard&&) -> ReadGuard& = delete;
 
-  template <ArgName Name, class... T>
-  constexpr auto addFlag(T... args) {
-    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-      static_assert(SearchIndex<PArgs, Name>() == -1, "Duplicated name");
+    ~ReadGuard() {
+      this->count_->fetch_sub(1);
     }
-    static_assert(
-        (Name.getShortName() == '\0') ||
-            (SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
-        "Duplicated short name");
-    static_assert(SearchIndex<Args, Name>() == -1, "Duplicated name");
-    FlagArgInitializer<Name, ID>(std::forward<T>(args)...);
-    return Parser<ID, tuple_append_t<Args, FlagArg<Name, ID>>, PArgs, HArg,
-                  SubParsers>(std::move(this->info_), subParsers);
-  }
 
-  template <ArgName Name = "help,h">
-  constexpr auto addHelp() {
-    static_assert((SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
-                  "Duplicated short name");
-    static_assert(Argo::SearchIndex<Args, Name>() == -1, "Duplicated name");
-    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers>(
-        std::move(this->info_), subParsers);
-  }
+    ARGO_ALWAYS_INLINE auto operator->() const -> const Snapshot* {
+      return this->snapshot_;
+    }
 
-  template <ArgName Name = "help,h">
-  constexpr auto addHelp(std::string_view help) {
-    static_assert((SearchIndexFromShortName<Args, Name.getShortName()>() == -1),
-                  "Duplicated short name");
-    static_assert(Argo::SearchIndex<Args, Name>() == -1, "Duplicated name");
-    static_assert(Name.hasValidNameLength(),
-                  "Short name can't be more than one charactor");
-    this->info_->help = help;
-    return Parser<ID, Args, PArgs, HelpArg<Name, ID>, SubParsers>(
-        std::move(this->info_), subParsers);
+    ARGO_ALWAYS_INLINE auto operator*() const -> const Snapshot& {
+      return *this->snapshot_;
+    }
+  };
+
+ private:
+  using Shadow = typename P::Shadow;
+  using ShadowArgs = typename Shadow::Arguments;
+
+  struct alignas(64) ReaderCount {
+    std::atomic<std::uint64_t> count = 0;
+  };
+
+  Shadow shadow_;
+  std::vector<std::string> args_;
+  std::vector<char*> argv_;
+  std::string path_;
+
+  std::atomic<const Snapshot*> current_ = nullptr;
+  mutable std::atomic<std::uint64_t> epoch_ = 0;
+  mutable std::array<ReaderCount, 2> readers_{};
+  std::atomic<std::uint64_t> generation_ = 0;
+
+  std::mutex reload_mutex_;
+  std::function<void(const std::exception&)> on_error_ = nullptr;
+
+  int inotify_fd_ = -1;
+  int stop_fd_ = -1;
+  std::jthread watcher_;
+
+  auto parseSnapshot() -> const Snapshot* {
+    this->shadow_.resetArgs();
+    RestoreDefaults<ShadowArgs>();
+    this->shadow_.parse(static_cast<int>(this->args_.size()),
+                        this->argv_.data());
+    return new Snapshot(std::type_identity<ShadowArgs>(),
+                        this->shadow_.info_->config);
   }
 
-  template <ArgName Name>
-  constexpr auto getArg() {
-    if (!this->parsed_) [[unlikely]] {
-      throw ParseError("Parser did not parse argument, call parse first");
-    }
-    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-      if constexpr (SearchIndex<PArgs, Name>() != -1) {
-        return std::tuple_element_t<SearchIndex<PArgs, Name>(), PArgs>::value;
-      } else {
-        static_assert(SearchIndex<Args, Name>() != -1,
-                      "Argument does not exist");
-        return std::remove_cvref_t<decltype(std::get<SearchIndex<Args, Name>()>(
-            std::declval<Args>()))>::value;
+  auto publish(const Snapshot* next) -> void {
+    const auto* old = this->current_.exchange(next);
+    // Two grace periods, a reader holding old is counted in one of the slots
+    for (int i = 0; i < 2; i++) {
+      auto epoch = this->epoch_.fetch_add(1);
+      while (this->readers_[epoch & 1].count.load() != 0) {
+        std::this_thread::yield();
       }
-    } else {
-      static_assert(SearchIndex<Args, Name>() != -1, "Argument does not exist");
-      return std::remove_cvref_t<decltype(std::get<SearchIndex<Args, Name>()>(
-          std::declval<Args>()))>::value;
     }
+    delete old;
+    this->generation_++;
   }
 
-  template <ArgName Name>
-  constexpr auto getParser() -> auto& {
-    if constexpr (std::is_same_v<SubParsers, std::tuple<>>) {
-      static_assert(false, "Parser has no sub parser");
+  auto watch(const std::stop_token& token) -> void {
+    auto name = std::filesystem::path(this->path_).filename().string();
+    auto fds = std::array<::pollfd, 2>{
+        {{.fd = this->inotify_fd_, .events = POLLIN, .revents = 0},
+         {.fd = this->stop_fd_, .events = POLLIN, .revents = 0}}};
+    alignas(::inotify_event) std::array<char, 4096> buffer{};
+
+    while (!token.stop_requested()) {
+      if (::poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[1].revents != 0) {
+        return;
+      }
+      auto changed = false;
+      ::ssize_t len = 0;
+      while ((len = ::read(this->inotify_fd_, buffer.data(), buffer.size())) >
+             0) {
+        for (auto* ptr = buffer.data(); ptr < buffer.data() + len;) {
+          const auto* event = reinterpret_cast<const ::inotify_event*>(ptr);
+          if (event->len != 0 and name == event->name) {
+            changed = true;
+          }
+          ptr += sizeof(::inotify_event) + event->len;
+        }
+      }
+      if (changed) {
+        this->reload();
+      }
     }
-    static_assert(!(SearchIndex<SubParsers, Name>() == -1),
-                  "Could not find subparser");
-    return std::get<SearchIndex<SubParsers, Name>()>(subParsers).parser.get();
   }
 
-  template <ArgName Name>
-  constexpr auto isAssigned() {
-    if (!this->parsed_) [[unlikely]] {
-      throw ParseError("Parser did not parse argument, call parse first");
+ public:
+  Reloader(const P& parser, int argc, char* argv[], bool watch = true) {
+    static_assert(std::is_same_v<decltype(P::subParsers), std::tuple<>>,
+                  "Reloader does not support sub parsers");
+    CopyArgSettings<typename P::Arguments, ShadowArgs>();
+    this->shadow_.info_->program_name = parser.info_->program_name;
+    this->shadow_.info_->env_prefix = parser.info_->env_prefix;
+    this->shadow_.info_->config_key = parser.info_->config_key;
+    // Snapshots must outlive in place rewrites of the file
+    this->shadow_.info_->copy_config = true;
+    if (!parser.info_->config_key) [[unlikely]] {
+      throw InvalidArgument("Reloader needs a config argument, use addConfig");
     }
-    using AllArguments =
-        decltype(std::tuple_cat(std::declval<Args>(), std::declval<PArgs>()));
 
-    static_assert(SearchIndex<AllArguments, Name>() != -1,
-                  "Argument does not exist");
+    this->args_.assign(argv, argv + argc);
+    for (auto& arg : this->args_) {
+      this->argv_.push_back(arg.data());
+    }
+    this->argv_.push_back(nullptr);
 
-    return std::tuple_element_t<SearchIndex<AllArguments, Name>(),
-                                AllArguments>::assigned;
-  }
+    this->publish(this->parseSnapshot());
+    this->path_ = ConfigPath<ShadowArgs>(*parser.info_->config_key).first;
 
-  /*!
-   * Add subcommand
-   */
-  template <ArgName Name, class T>
-  ARGO_ALWAYS_INLINE constexpr auto addParser(T& sub_parser,
-                                              Description description = {""}) {
-    auto s = std::make_tuple(
-        SubParser<Name, T>{ref(sub_parser), description.description});
-    auto sub_parsers = std::tuple_cat(subParsers, s);
-    return Parser<ID, Args, PArgs, HArg, decltype(sub_parsers)>(
-        std::move(this->info_), sub_parsers);
+    if (!watch or this->path_.empty()) {
+      return;
+    }
+    auto dir = std::filesystem::path(this->path_).parent_path();
+    this->inotify_fd_ = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    this->stop_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (this->inotify_fd_ < 0 or this->stop_fd_ < 0 or
+        ::inotify_add_watch(this->inotify_fd_,
+                            (dir.empty() ? std::filesystem::path(".") : dir)
+                                .c_str(),
+                            IN_CLOSE_WRITE | IN_MOVED_TO) < 0) [[unlikely]] {
+      auto err = errno;
+      this->close();
+      throw InvalidArgument(
+          std::format("Cannot watch {}: {}", this->path_,
+                      std::system_category().message(err)));
+    }
+    this->watcher_ = std::jthread(
+        [this](const std::stop_token& token) { this->watch(token); });
   }
 
-  ARGO_ALWAYS_INLINE constexpr auto resetArgs() -> void;
+  Reloader(const Reloader&) = delete;
+  Reloader(Reloader&&) = delete;
+  auto operator=(const Reloader&) -> Reloader& = delete;
+  auto operator=(Reloader&&) -> Reloader& = delete;
 
-  ARGO_ALWAYS_INLINE constexpr auto addUsageHelp(std::string_view usage) {
-    this->info_->usage = usage;
+  ~Reloader() {
+    this->close();
+    delete this->current_.load();
   }
 
-  ARGO_ALWAYS_INLINE constexpr auto addSubcommandHelp(
-      std::string_view subcommand_help) {
-    this->info_->subcommand_help = subcommand_help;
+  /*!
+   * Snapshot published last, it stays valid while the guard is alive
+   */
+  [[nodiscard]] ARGO_ALWAYS_INLINE auto read() const -> ReadGuard {
+    auto& count = this->readers_[this->epoch_.load() & 1].count;
+    count.fetch_add(1);
+    return {this->current_.load(), &count};
   }
 
-  ARGO_ALWAYS_INLINE constexpr auto addPositionalArgumentHelp(
-      std::string_view positional_argument_help) {
-    this->info_->positional_argument_help = positional_argument_help;
+  /*!
+   * Parse again and publish, the current snapshot is kept on error
+   */
+  auto reload() -> bool {
+    auto lock = std::scoped_lock(this->reload_mutex_);
+    try {
+      this->publish(this->parseSnapshot());
+      return true;
+    } catch (const std::exception& e) {
+      if (this->on_error_) {
+        this->on_error_(e);
+      }
+      return false;
+    }
   }
 
-  ARGO_ALWAYS_INLINE constexpr auto addOptionsHelp(
-      std::string_view options_help) {
-    this->info_->options_help = options_help;
+  auto onError(std::function<void(const std::exception&)> on_error) -> void {
+    auto lock = std::scoped_lock(this->reload_mutex_);
+    this->on_error_ = std::move(on_error);
   }
 
- private:
-  ARGO_ALWAYS_INLINE constexpr auto setArg(
-      std::string_view key, const std::span<std::string_view>& val) const
-      -> void;
-  ARGO_ALWAYS_INLINE constexpr auto setShortKeyArg(
-      std::string_view short_key, const std::span<std::string_view>& val) const
-      -> void;
-
- public:
-  ARGO_ALWAYS_INLINE constexpr auto parse(int argc, char* argv[]) -> void;
-  [[nodiscard]] constexpr auto formatHelp(bool no_color = false) const
-      -> std::string;
+  /*!
+   * Number of snapshots published so far
+   */
+  [[nodiscard]] auto generation() const -> std::uint64_t {
+    return this->generation_.load();
+  }
 
-  explicit constexpr operator bool() const {
-    return this->parsed_;
+  /*!
+   * Stop watching the config file, reload can still be called
+   */
+  auto close() -> void {
+    if (this->watcher_.joinable()) {
+      this->watcher_.request_stop();
+      std::uint64_t one = 1;
+      [[maybe_unused]] auto written =
+          ::write(this->stop_fd_, &one, sizeof(one));
+      this->watcher_.join();
+    }
+    for (auto* fd : {&this->inotify_fd_, &this->stop_fd_}) {
+      if (*fd >= 0) {
+        ::close(*fd);
+        *fd = -1;
+      }
+    }
   }
 };
 
 }  // namespace Argo
+#endif  // __linux__
 
 
 namespace Argo {
 
-ARGO_ALWAYS_INLINE auto splitStringView(std::string_view str, char delimeter)
-    -> std::vector<std::string_view> {
-  std::vector<std::string_view> ret;
-  while (str.contains(delimeter)) {
-    auto pos = str.find(delimeter);
-    ret.push_back(str.substr(0, pos));
-    str = str.substr(pos + 1);
+/*!
+ * Command loop which parses one line at a time with the same parser and
+ * dispatches to the handler of the sub command found
+ * Example:
+ *      auto repl = Argo::Repl(parser, "admin");
+ *      repl.on<"stats">([](auto& stats) { ... })
+ *          .on<"drain">([](auto& drain) { ... });
+ *      repl.execute("drain --timeout 5s");
+ *
+ * Between lines only the arguments assigned by the previous line are reset,
+ * and the line buffer and argv are reused, so a short command does not
+ * allocate. Values viewing the line, such as string_view arguments, are
+ * valid until the next execute. --help prints the help and returns to the
+ * loop instead of exiting.
+ */
+template <class P>
+class Repl {
+ private:
+  P* parser_;
+  std::string program_name_;
+  std::string arena_;
+  std::vector<char*> argv_;
+  std::vector<std::function<bool()>> handlers_;
+  std::function<void(P&)> fallback_ = nullptr;
+
+ public:
+  explicit Repl(P& parser, std::string_view program_name = "")
+      : parser_(&parser), program_name_(program_name) {
+    this->parser_->exitOnHelp(false);
+    this->argv_.reserve(16);
   }
-  ret.push_back(str);
-  return ret;
-}
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
-  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::resetArgs() -> void {
-  this->parsed_ = false;
-  ValueReset<decltype(std::tuple_cat(std::declval<Args>(),
-                                     std::declval<PArgs>()))>();
-}
+  /*!
+   * Call handler with sub parser Name when a line selects it
+   */
+  template <ArgName Name, class F>
+  auto on(F&& handler) -> Repl& {
+    auto& sub_parser = this->parser_->template getParser<Name>();
+    this->handlers_.emplace_back(
+        [&sub_parser, handler = std::forward<F>(handler)]() mutable {
+          if (!sub_parser) {
+            return false;
+          }
+          handler(sub_parser);
+          return true;
+        });
+    return *this;
+  }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
-  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::setArg(
-    std::string_view key, const std::span<std::string_view>& val) const
-    -> void {
-  if constexpr (!std::is_same_v<HArg, void>) {
-    if (key == HArg::name.getKey()) {
-      std::cout << formatHelp() << std::endl;
-      std::exit(0);
-    }
+  /*!
+   * Call handler with the parser when no handled sub command was given
+   */
+  template <class F>
+  auto otherwise(F&& handler) -> Repl& {
+    this->fallback_ = std::forward<F>(handler);
+    return *this;
   }
-  Assigner<Args, PArgs>(key, val);
-}
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
-  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::setShortKeyArg(
-    std::string_view key, const std::span<std::string_view>& val) const
-    -> void {
-  if (ShortArgAssigner<Args, PArgs, HArg>(key, val)) [[unlikely]] {
-    std::cout << formatHelp() << std::endl;
-    std::exit(0);
-  };
-}
+  /*!
+   * Parse line with shell quoting and run its handler, returns false for a
+   * blank line. Parse errors are thrown as by parse, a line asking for help
+   * prints it and runs no handler
+   */
+  auto execute(std::string_view line) -> bool {
+    this->parser_->resetAssigned();
+    if (this->arena_.size() < line.size() + 1) {
+      this->arena_.resize(line.size() + 1);
+    }
+    this->argv_.assign(1, this->program_name_.data());
+    ShellSplit(line, this->arena_.data(), this->argv_);
+    if (this->argv_.size() == 1) {
+      return false;
+    }
+    auto argc = static_cast<int>(this->argv_.size());
+    this->argv_.push_back(nullptr);
+    try {
+      this->parser_->parse(argc, this->argv_.data());
+    } catch (const HelpRequested&) {
+      return true;
+    }
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
-  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::parse(int argc,
-                                                                char* argv[])
-    -> void {
-  if (this->parsed_) [[unlikely]] {
-    throw ParseError("Cannot parse twice");
+    for (auto& handler : this->handlers_) {
+      if (handler()) {
+        return true;
+      }
+    }
+    if (this->fallback_) {
+      this->fallback_(*this->parser_);
+    }
+    return true;
   }
-  auto assigned_keys = std::vector<std::string_view>();
-  tuple_type_visit<decltype(std::tuple_cat(std::declval<Args>(),
-                                           std::declval<PArgs>()))>(
-      [&assigned_keys]<class T>(T) {
-        if (T::type::assigned) {
-          assigned_keys.push_back(T::type::name.getKey());
-        }
-      });
-  if (!assigned_keys.empty()) [[unlikely]] {
-    throw ParseError(std::format("keys {} already assigned", assigned_keys));
+
+  /*!
+   * execute every line of in, errors are written to err and the loop goes on
+   */
+  auto run(std::istream& in, std::ostream& err) -> void {
+    auto line = std::string();
+    while (std::getline(in, line)) {
+      try {
+        this->execute(line);
+      } catch (const InvalidArgument& e) {
+        err << e.what() << '\n';
+      } catch (const ParseError& e) {
+        err << e.what() << '\n';
+      }
+    }
   }
+};
 
-  std::string_view key{};
-  std::string_view short_keys{};
-  std::vector<std::string_view> values{};
+}  // namespace Argo
 
-  // [[assume(this->info_)]]; // TODO(gen740): add assume when clang supports it
 
-  if (!this->info_->program_name) {
-    this->info_->program_name = std::string_view(argv[0]);
-  }
+namespace Argo {
 
-  // Search for subcommand
-  std::int32_t subcmd_found_idx = -1;
-  std::int32_t cmd_end_pos = argc;
+/*!
+ * Sent by the client with its stdin, stdout and stderr attached, followed by
+ * size bytes of the null terminated cwd and argc arguments. The server
+ * replies with the exit status as a std::int32_t, or server_schema_mismatch
+ * when schema is not the one of its parser.
+ */
+struct ServerRequest {
+  static constexpr std::uint32_t current_magic = 0x4152'4732;  // "ARG2"
 
-  for (int i = argc - 1; i > 0; i--) {
-    if constexpr (!std::is_same_v<SubParsers, std::tuple<>>) {
-      if (subcmd_found_idx == -1) {
-        subcmd_found_idx = ParserIndex(subParsers, argv[i]);
-        if (subcmd_found_idx != -1) {
-          cmd_end_pos = i;
-        }
-      }
-    }
+  std::uint32_t magic = current_magic;
+  std::uint32_t argc = 0;
+  std::uint64_t size = 0;
+  std::uint64_t schema = 0;
+};
+
+// Never an exit status, those are 0 to 255 or 128 + signal
+constexpr std::int32_t server_schema_mismatch =
+    std::numeric_limits<std::int32_t>::min();
+
+template <class P>
+struct ServerSchemaOf;
+
+template <class S>
+using sub_parser_t = typename decltype(S::parser)::type;
+
+/*!
+ * SchemaHash of the arguments of the parser and of every sub parser, with
+ * the sub command names
+ */
+template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers,
+          class Constraints>
+struct ServerSchemaOf<Parser<ID, Args, PArgs, HArg, SubParsers, Constraints>> {
+  static consteval auto get() -> std::uint64_t {
+    auto hash = SchemaHash<decltype(std::tuple_cat(std::declval<Args>(),
+                                                   std::declval<PArgs>()))>();
+    [&hash]<class... S>(type_sequence<S...>) {
+      (..., (hash = Fnv1a(hash, S::name.getKey()),
+             hash = (std::rotl(hash, 5) ^
+                     ServerSchemaOf<sub_parser_t<S>>::get()) *
+                    0x9e3779b97f4a7c15));
+    }(make_type_sequence_t<SubParsers>());
+    return hash;
   }
-  bool is_flag = false;
-  std::string_view arg;
+};
 
-  for (int i = 1; i < cmd_end_pos + 1; i++) {
-    if (i != cmd_end_pos) {
-      arg = argv[i];
-      is_flag = arg.starts_with('-');
-      if (arg.size() > 1 and arg.at(1) >= '0' and arg.at(1) <= '9') {
-        is_flag = IsFlag<Args>(arg.at(1));
-      }
-    } else {
-      is_flag = true;
-    }
+/*!
+ * Identity of the options P parses, sent by forwardToServer<P> and checked
+ * by Server<P>
+ */
+template <class P>
+constexpr std::uint64_t server_schema =
+    ServerSchemaOf<std::remove_cvref_t<P>>::get();
 
-    if (i != 1 and is_flag) {
-      if (!key.empty()) {
-        goto SetArgSection;  // NOLINT(cppcoreguidelines-avoid-goto)
-      }
-      if (!short_keys.empty()) {
-        goto SetShortArgSection;  // NOLINT(cppcoreguidelines-avoid-goto)
-      }
-      if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-        if (!values.empty()) {
-          goto SetArgSection;  // NOLINT(cppcoreguidelines-avoid-goto)
-        }
-      } else {
-        if (!values.empty()) [[unlikely]] {
-          throw InvalidArgument(
-              std::format("Invalid positional argument: {}", values));
-        }
-      }
-    SetArgSection:
-      this->setArg(key, values);
-      key = "";
-      values.clear();
-      goto End;  // NOLINT(cppcoreguidelines-avoid-goto)
-    SetShortArgSection:
-      this->setShortKeyArg(short_keys, values);
-      short_keys = "";
-      values.clear();
-    End:
-    }
+[[noreturn]] inline auto ServerFail(std::string_view what, int err) -> void {
+  throw InvalidArgument(
+      std::format("{}: {}", what, std::system_category().message(err)));
+}
 
-    if (i == cmd_end_pos) {
-      break;
-    }
+// A closed peer is an error, not SIGPIPE. Elsewhere the socket has
+// SO_NOSIGPIPE set by ServerSocket
+#ifdef MSG_NOSIGNAL
+constexpr int server_send_flags = MSG_NOSIGNAL;
+#else
+constexpr int server_send_flags = 0;
+#endif
 
-    if (is_flag) {
-      if (arg.size() > 1 and arg.at(1) == '-') {
-        if (arg.contains('=')) [[unlikely]] {
-          auto equal_pos = arg.find('=');
-          key = arg.substr(2, equal_pos - 2);
-          values.push_back(arg.substr(equal_pos + 1));
-          is_flag = true;
-        } else {
-          key = arg.substr(2);
-        }
-      } else {
-        short_keys = arg.substr(1);
-      }
-    } else {
-      values.push_back(arg);
-    }
+/*!
+ * Mark fd close on exec and, where MSG_NOSIGNAL is missing, not raising
+ * SIGPIPE, for sockets made without SOCK_CLOEXEC
+ */
+inline auto ServerSocketFlags(int fd) -> void {
+  ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+inline auto ServerSocket() -> int {
+#ifdef __linux__
+  return ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd >= 0) {
+    ServerSocketFlags(fd);
   }
+  return fd;
+#endif
+}
 
-  auto required_keys = std::vector<std::string_view>();
-  tuple_type_visit<decltype(std::tuple_cat(std::declval<Args>(),
-                                           std::declval<PArgs>()))>(
-      [&required_keys]<class T>(T) {
-        if constexpr (std::derived_from<typename T::type, ArgTag>) {
-          if ((T::type::required && !T::type::assigned)) {
-            required_keys.push_back(T::type::name.getKey());
-          }
-        }
-      });
+inline auto ServerAccept(int listen_fd) -> int {
+#ifdef __linux__
+  return ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+  auto fd = ::accept(listen_fd, nullptr, nullptr);
+  if (fd >= 0) {
+    ServerSocketFlags(fd);
+  }
+  return fd;
+#endif
+}
 
-  if (!required_keys.empty()) [[unlikely]] {
-    throw InvalidArgument(std::format("Requried {}", required_keys));
+/*!
+ * User id of the process at the other end of the Unix socket conn
+ */
+inline auto PeerUid(int conn) -> std::optional<::uid_t> {
+#ifdef __linux__
+  auto cred = ::ucred{};
+  auto cred_len = static_cast<::socklen_t>(sizeof(cred));
+  if (::getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0) {
+    return std::nullopt;
   }
-  if (subcmd_found_idx != -1) {
-    MetaParse(subParsers, subcmd_found_idx, argc - cmd_end_pos,
-              &argv[cmd_end_pos]);
+  return cred.uid;
+#else
+  auto uid = ::uid_t();
+  auto gid = ::gid_t();
+  if (::getpeereid(conn, &uid, &gid) != 0) {
+    return std::nullopt;
   }
-  this->parsed_ = true;
+  return uid;
+#endif
 }
 
-struct AnsiEscapeCode {
-  bool isEnabled;
+inline auto WriteAll(int fd, const void* data, std::size_t size) -> bool {
+  const auto* ptr = static_cast<const char*>(data);
+  while (size != 0) {
+    auto len = ::send(fd, ptr, size, server_send_flags);
+    if (len < 0 and errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      return false;
+    }
+    ptr += len;
+    size -= static_cast<std::size_t>(len);
+  }
+  return true;
+}
+
+inline auto ReadAll(int fd, void* data, std::size_t size) -> bool {
+  auto* ptr = static_cast<char*>(data);
+  while (size != 0) {
+    auto len = ::read(fd, ptr, size);
+    if (len < 0 and errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      return false;
+    }
+    ptr += len;
+    size -= static_cast<std::size_t>(len);
+  }
+  return true;
+}
 
-  std::string bold = "\x1B[1m";
-  std::string underline = "\x1B[4m";
-  std::string reset = "\x1B[0m";
+inline auto SocketAddress(std::string_view path) -> ::sockaddr_un {
+  auto addr = ::sockaddr_un{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) [[unlikely]] {
+    throw InvalidArgument(std::format("Socket path {} is too long", path));
+  }
+  std::memcpy(addr.sun_path, path.data(), path.size());
+  return addr;
+}
 
-  [[nodiscard]] auto getBold() const {
-    return isEnabled ? bold : "";
+/*!
+ * Run argv on the server listening at socket_path, with the stdio and the
+ * working directory of this process, and return its exit status
+ * std::nullopt when no server is listening or the server parses with another
+ * schema, a daemon left running by an older build, so the caller can run the
+ * command itself:
+ *      int main(int argc, char* argv[]) {
+ *        if (auto status = Argo::forwardToServer(path, argc, argv, schema)) {
+ *          return *status;
+ *        }
+ *        ...  // initialize and parse in process
+ *      }
+ *
+ * This needs no parser, a client can be a few kilobytes. schema is
+ * server_schema of the parser type, see the overload taking it.
+ */
+inline auto forwardToServer(std::string_view socket_path, int argc,
+                                   char* argv[], std::uint64_t schema)
+    -> std::optional<int> {
+  auto addr = SocketAddress(socket_path);
+  auto fd = ServerSocket();
+  if (fd < 0) [[unlikely]] {
+    ServerFail("Cannot create socket", errno);
+  }
+  if (::connect(fd, reinterpret_cast<const ::sockaddr*>(&addr),
+                sizeof(addr)) != 0) {
+    auto err = errno;
+    ::close(fd);
+    if (err == ENOENT or err == ECONNREFUSED) {
+      return std::nullopt;
+    }
+    ServerFail(std::format("Cannot connect to {}", socket_path), err);
   }
 
-  [[nodiscard]] auto getUnderline() const {
-    return isEnabled ? underline : "";
+  auto payload = std::filesystem::current_path().native();
+  payload.push_back('\0');
+  for (int i = 0; i < argc; i++) {
+    payload.append(argv[i]);
+    payload.push_back('\0');
+  }
+  auto request = ServerRequest{.argc = static_cast<std::uint32_t>(argc),
+                               .size = payload.size(),
+                               .schema = schema};
+
+  // stdin, stdout and stderr go with the header
+  int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+  alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+  auto iov = ::iovec{.iov_base = &request, .iov_len = sizeof(request)};
+  auto msg = ::msghdr{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ::ssize_t sent = 0;
+  while ((sent = ::sendmsg(fd, &msg, server_send_flags)) < 0 and
+         errno == EINTR) {
+  }
+  if (sent != static_cast<::ssize_t>(sizeof(request)) or
+      !WriteAll(fd, payload.data(), payload.size())) [[unlikely]] {
+    auto err = errno;
+    ::close(fd);
+    ServerFail(std::format("Cannot send to {}", socket_path), err);
   }
 
-  [[nodiscard]] auto getReset() const {
-    return isEnabled ? reset : "";
+  auto status = std::int32_t();
+  auto received = ReadAll(fd, &status, sizeof(status));
+  ::close(fd);
+  if (!received) [[unlikely]] {
+    throw InvalidArgument(
+        std::format("Server {} closed the connection", socket_path));
+  }
+  if (status == server_schema_mismatch) [[unlikely]] {
+    return std::nullopt;
   }
+  return status;
+}
 
-  [[nodiscard]] auto getBoldUnderline() const {
-    return isEnabled ? this->getBold() + this->getUnderline() : "";
+/*!
+ * forwardToServer with the schema of the parser type P, the parser itself
+ * is never built
+ */
+template <class P>
+auto forwardToServer(std::string_view socket_path, int argc, char* argv[])
+    -> std::optional<int> {
+  return forwardToServer(socket_path, argc, argv, server_schema<P>);
+}
+
+/*!
+ * Exit status of handler, 0 when it returns void
+ */
+template <class F, class... A>
+auto InvokeForStatus(F& handler, A&... args) -> int {
+  if constexpr (std::is_void_v<std::invoke_result_t<F&, A&...>>) {
+    handler(args...);
+    return 0;
+  } else {
+    return static_cast<int>(handler(args...));
   }
-};
+}
 
-constexpr std::size_t max_option_width = 26;
+/*!
+ * Daemon running command lines forwarded by forwardToServer with a parser
+ * initialized once
+ * Example:
+ *      auto models = loadModels();  // slow, done once
+ *      auto server = Argo::Server(parser, "/run/user/1000/analyze.sock");
+ *      server.on<"classify">([&](auto& p) { return classify(models, p); })
+ *            .on<"stats">([&](auto& p) { ... });
+ *      server.serve();
+ *
+ * Every request runs in a process forked from the server, with the stdio
+ * and working directory of the client, so the state built before serve is
+ * shared copy on write and each request starts from it. The child parses
+ * argv and calls the handler of the sub command found, whose return value is
+ * the exit status. Parsing and errors are those of the same program run
+ * directly: --help prints to the client and exits with 0, an uncaught parse
+ * error is printed and the client gets 128 + SIGABRT. The child leaves
+ * through _exit, so the atexit handlers and static destructors of the server
+ * never run in it. The environment is the one of the server.
+ *
+ * Only the user running the server may connect, and only with the
+ * server_schema of P: a client built with other options is refused and
+ * parses in process.
+ */
+template <class P>
+class Server {
+ private:
+  P* parser_;
+  std::string path_;
+  int listen_fd_ = -1;
+  std::vector<::pid_t> children_;
+  std::vector<std::function<std::optional<int>()>> handlers_;
+  std::function<int(P&)> fallback_ = nullptr;
 
-constexpr auto createUsageSection(const auto& program_name,
-                                  const auto& help_info, const auto& pargs_info,
-                                  const auto& sub_commands) {
-  std::string ret;
-  ret.append(program_name);
-  for (const auto& i : help_info) {
-    if (i.required) {
-      ret.append(std::format(" {} {}",
-                             i.shortName != '\0'
-                                 ? std::format("-{}", i.shortName)
-                                 : std::format("--{}", i.name),
-                             i.typeName));
-    }
+  /*!
+   * Reap the connection processes which have finished
+   */
+  auto reap() -> void {
+    std::erase_if(this->children_, [](::pid_t pid) {
+      return ::waitpid(pid, nullptr, WNOHANG) != 0;
+    });
   }
-  ret.append(" [options...]");
-  for (const auto& i : pargs_info) {
-    if (i.required) {
-      ret.append(std::format(" {}", i.name));
-    } else {
-      ret.append(std::format(" [{}]", i.name));
+
+  /*!
+   * Parse and dispatch, in the request process
+   */
+  auto run(int argc, char* argv[]) -> int {
+    this->parser_->parse(argc, argv);
+    for (auto& handler : this->handlers_) {
+      if (auto status = handler()) {
+        return *status;
+      }
     }
-  }
-  if (!sub_commands.empty()) {
-    ret.append(" {");
-    for (const auto& command : sub_commands) {
-      ret.append(command.name);
-      ret.push_back(',');
+    if (this->fallback_) {
+      return this->fallback_(*this->parser_);
     }
-    ret.pop_back();
-    ret.push_back('}');
+    return 0;
   }
-  ret.push_back('\n');
-  return ret;
-}
 
-constexpr auto createSubcommandSection(const auto& ansi,
-                                       const auto& sub_commands) {
-  std::string ret;
-  ret.push_back('\n');
-  for (const auto& command : sub_commands) {
-    auto description = splitStringView(command.description, '\n');
-    if (command.name.size() < max_option_width - 2 and description[0] != "") {
-      ret.append(std::format(
-          "  {0}{1}{2}{3}{4}\n",
-          ansi.getBold(),                                                // 1
-          command.name,                                                  // 2
-          ansi.getReset(),                                               // 3
-          std::string(max_option_width - 2 - command.name.size(), ' '),  // 4
-          description[0]));
-    } else {
-      ret.append(std::format("  {0}{1}{2}\n", ansi.getBold(), command.name,
-                             ansi.getReset()));
-      if (description[0] != "") {
-        ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
-                               description[0]));
-      }
+  /*!
+   * run and leave the request process with its status. It ends with _exit,
+   * exit would run the atexit handlers and static destructors of the server,
+   * and an error nobody caught is reported and aborts like terminate does
+   */
+  [[noreturn]] auto runAndExit(int argc, char* argv[]) noexcept -> void {
+    auto status = 0;
+    auto uncaught = false;
+    try {
+      status = this->run(argc, argv);
+    } catch (const HelpRequested&) {
+      status = 0;
+    } catch (const std::exception& e) {
+      std::cerr << std::format(
+          "terminate called after throwing an exception\n  what():  {}\n",
+          e.what());
+      uncaught = true;
+    } catch (...) {
+      std::cerr << "terminate called after throwing an exception\n";
+      uncaught = true;
     }
-    for (std::size_t i = 1; i < description.size(); i++) {
-      ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
-                             description[i]));
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    if (uncaught) {
+      // Raises SIGABRT without running exit handlers
+      std::abort();
     }
+    ::_exit(status);
   }
-  return ret;
-}
-
-constexpr auto createOptionsSection(const auto& ansi, const auto& help_info) {
-  std::string ret;
 
-  ret.push_back('\n');
-  for (const auto& option : help_info) {
-    auto description = splitStringView(option.description, '\n');
-    std::string option_string =
-        std::format("{0}{1}--{2}{3} {4}",
-                    ansi.getBold(),  // 0
-                    (option.shortName == '\0')
-                        ? "   "                                   //
-                        : std::format("-{},", option.shortName),  // 1
-                    option.name,                                  // 2
-                    ansi.getReset(),                              // 3
-                    option.typeName                               // 4
-        );
+  /*!
+   * Receive the request on conn, run it in a child and send back its exit
+   * status. Runs in a process forked for the connection and never returns
+   */
+  [[noreturn]] auto handle(int conn) noexcept -> void {
+    auto request = ServerRequest();
+    int fds[3] = {-1, -1, -1};
+    alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    auto iov = ::iovec{.iov_base = &request, .iov_len = sizeof(request)};
+    auto msg = ::msghdr{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    // Without MSG_CMSG_CLOEXEC the received fds are dup2'ed onto stdio and
+    // closed by the request process before anything can exec
+#ifdef MSG_CMSG_CLOEXEC
+    constexpr int recv_flags = MSG_CMSG_CLOEXEC;
+#else
+    constexpr int recv_flags = 0;
+#endif
+    ::ssize_t len = 0;
+    while ((len = ::recvmsg(conn, &msg, recv_flags)) < 0 and errno == EINTR) {
+    }
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    if (len != static_cast<::ssize_t>(sizeof(request)) or
+        request.magic != ServerRequest::current_magic or cmsg == nullptr or
+        cmsg->cmsg_type != SCM_RIGHTS or
+        cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) [[unlikely]] {
+      ::_exit(1);
+    }
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
 
-    if (option_string.size() - ansi.getBold().size() - ansi.getReset().size() <
-            max_option_width - 2 and
-        description[0] != "") {
-      ret.append(std::format(
-          "  {0}{1}{2}\n",
-          option_string,  // 1
-          std::string(max_option_width - option_string.size() +
-                          ansi.getBold().size() + ansi.getReset().size() - 2,
-                      ' '),  // 3
-          description[0]     // 4
-          ));
-    } else {
-      ret.append(std::format("  {0}{1}{2}\n",
-                             ansi.getBold(),  // 0
-                             option_string,   // 1
-                             ansi.getReset()  // 2
-                             ));
-      if (description[0] != "") {
-        ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
-                               description[0]));
+    auto payload = std::string(request.size, '\0');
+    if (!ReadAll(conn, payload.data(), payload.size()) or
+        static_cast<std::size_t>(std::ranges::count(payload, '\0')) !=
+            request.argc + 1) [[unlikely]] {
+      ::_exit(1);
+    }
+    if (request.schema != server_schema<P>) [[unlikely]] {
+      auto status = server_schema_mismatch;
+      WriteAll(conn, &status, sizeof(status));
+      ::_exit(0);
+    }
+    auto argv = std::vector<char*>();
+    argv.reserve(request.argc + 1);
+    auto* cwd = payload.data();
+    for (auto* arg = cwd + std::strlen(cwd) + 1;
+         argv.size() < request.argc; arg += std::strlen(arg) + 1) {
+      argv.push_back(arg);
+    }
+    argv.push_back(nullptr);
+
+    auto pid = ::fork();
+    if (pid == 0) {
+      ::close(conn);
+      for (int i = 0; i < 3; i++) {
+        ::dup2(fds[i], i);
+        ::close(fds[i]);
       }
+      if (::chdir(cwd) != 0) [[unlikely]] {
+        std::cerr << std::format("Cannot change directory to {}: {}\n", cwd,
+                                 std::system_category().message(errno));
+        ::_exit(1);
+      }
+      this->runAndExit(static_cast<int>(request.argc), argv.data());
     }
-    for (std::size_t i = 1; i < description.size(); i++) {
-      ret.append(std::format("{0}{1}\n",                          //
-                             std::string(max_option_width, ' '),  // 0
-                             description[i]                       // 1
-                             ));
+    for (auto fd : fds) {
+      ::close(fd);
     }
-  }
-  return ret;
-}
-
-constexpr auto createPositionalArgumentSection(const auto& ansi,
-                                               const auto& pargs_info) {
-  std::string ret;
-  ret.push_back('\n');
-  for (const auto& i : pargs_info) {
-    auto description = splitStringView(i.description, '\n');
 
-    if (i.name.size() < max_option_width - 2 and description[0] != "") {
-      ret.append(std::format(
-          "  {0}{1}{2}{3}{4}\n",
-          ansi.getBold(),                                          // 1
-          i.name,                                                  // 2
-          ansi.getReset(),                                         // 3
-          std::string(max_option_width - 2 - i.name.size(), ' '),  // 4
-          description[0]));
-    } else {
-      ret.append(std::format("  {0}{1}{2}\n", ansi.getBold(), i.name,
-                             ansi.getReset()));
-      if (description[0] != "") {
-        ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
-                               description[0]));
-      }
+    auto status = std::int32_t(1);
+    auto wstatus = 0;
+    while (pid > 0 and ::waitpid(pid, &wstatus, 0) < 0 and errno == EINTR) {
     }
-    for (std::size_t i = 1; i < description.size(); i++) {
-      ret.append(std::format("{0}{1}\n", std::string(max_option_width, ' '),
-                             description[i]));
+    if (pid > 0 and WIFEXITED(wstatus)) {
+      status = WEXITSTATUS(wstatus);
+    } else if (pid > 0 and WIFSIGNALED(wstatus)) {
+      status = 128 + WTERMSIG(wstatus);
     }
+    WriteAll(conn, &status, sizeof(status));
+    ::_exit(0);
   }
-  return ret;
-}
 
-template <ParserID ID, class Args, class PArgs, class HArg, class SubParsers>
-  requires(is_tuple_v<Args> && is_tuple_v<SubParsers>)
-constexpr auto Parser<ID, Args, PArgs, HArg, SubParsers>::formatHelp(
-    bool no_color) const -> std::string {
-  std::string ret;
+ public:
+  /*!
+   * Listen on socket_path, replacing a socket left by an earlier server
+   * --help of parser throws HelpRequested from now on, see exitOnHelp
+   */
+  Server(P& parser, std::string_view socket_path)
+      : parser_(&parser), path_(socket_path) {
+    parser.exitOnHelp(false);
+    auto addr = SocketAddress(socket_path);
+    struct ::stat st {};
+    if (::lstat(this->path_.c_str(), &st) == 0 and S_ISSOCK(st.st_mode)) {
+      ::unlink(this->path_.c_str());
+    }
+    this->listen_fd_ = ServerSocket();
+    if (this->listen_fd_ < 0) [[unlikely]] {
+      ServerFail("Cannot create socket", errno);
+    }
+    if (::bind(this->listen_fd_, reinterpret_cast<const ::sockaddr*>(&addr),
+               sizeof(addr)) != 0 or
+        ::chmod(this->path_.c_str(), S_IRUSR | S_IWUSR) != 0 or
+        ::listen(this->listen_fd_, SOMAXCONN) != 0) [[unlikely]] {
+      auto err = errno;
+      ::close(this->listen_fd_);
+      ServerFail(std::format("Cannot listen on {}", socket_path), err);
+    }
+  }
 
-  AnsiEscapeCode ansi((::isatty(1) != 0) and !no_color);
+  Server(const Server&) = delete;
+  Server(Server&&) = delete;
+  auto operator=(const Server&) -> Server& = delete;
+  auto operator=(Server&&) -> Server& = delete;
 
-  std::vector<ArgInfo> help_info;
-  if constexpr (std::is_same_v<HArg, void>) {
-    help_info = HelpGenerator<Args>();
-  } else {
-    help_info = HelpGenerator<tuple_append_t<Args, HArg>>();
+  ~Server() {
+    ::close(this->listen_fd_);
+    ::unlink(this->path_.c_str());
+    this->reap();
   }
-  std::vector<ArgInfo> pargs_info = HelpGenerator<PArgs>();
 
-  auto sub_commands = SubParserInfo(subParsers);
+  /*!
+   * Call handler with sub parser Name when a request selects it, its return
+   * value is the exit status
+   */
+  template <ArgName Name, class F>
+  auto on(F&& handler) -> Server& {
+    auto& sub_parser = this->parser_->template getParser<Name>();
+    this->handlers_.emplace_back(
+        [&sub_parser, handler = std::forward<F>(handler)]() mutable
+        -> std::optional<int> {
+          if (!sub_parser) {
+            return std::nullopt;
+          }
+          return InvokeForStatus(handler, sub_parser);
+        });
+    return *this;
+  }
 
-  // [[assume(this->info_)]]; // TODO(gen740): add assume when clang supports it
+  /*!
+   * Call handler with the parser when no handled sub command was given
+   */
+  template <class F>
+  auto otherwise(F&& handler) -> Server& {
+    this->fallback_ = [handler = std::forward<F>(handler)](P& parser) mutable {
+      return InvokeForStatus(handler, parser);
+    };
+    return *this;
+  }
 
-  if (this->info_->help) {
-    ret.append(this->info_->help.value());
-    ret.push_back('\n');
-  } else {
-    // Description Section
-    if (this->info_->description) {
-      ret.append(this->info_->description.value());
-      ret.push_back('\n');
+  /*!
+   * Accept one request and start it, without waiting for it to finish
+   */
+  auto serveOne() -> void {
+    this->reap();
+    auto conn = -1;
+    while ((conn = ServerAccept(this->listen_fd_)) < 0 and errno == EINTR) {
     }
-
-    // Usage Section
-    ret.push_back('\n');
-    ret.append(ansi.getBoldUnderline() + "Usage:" + ansi.getReset() + "\n");
-    ret.append("  ");
-
-    ret.append(this->info_->usage.value_or(
-        createUsageSection(this->info_->program_name.value_or("no_name"),
-                           help_info, pargs_info, sub_commands)));
-
-    // Subcommand Section
-    if constexpr (!std::is_same_v<SubParsers, std::tuple<>>) {
-      ret.push_back('\n');
-      ret.append(ansi.getBoldUnderline() + "Subcommands:" + ansi.getReset());
-      ret.append(this->info_->subcommand_help.value_or(
-          createSubcommandSection(ansi, sub_commands)));
+    if (conn < 0) [[unlikely]] {
+      ServerFail(std::format("Cannot accept on {}", this->path_), errno);
     }
-
-    if constexpr (!std::is_same_v<PArgs, std::tuple<>>) {
-      ret.push_back('\n');
-      ret.append(ansi.getBoldUnderline() +
-                 "Positional Argument:" + ansi.getReset());
-      ret.append(this->info_->positional_argument_help.value_or(
-          createPositionalArgumentSection(ansi, pargs_info)));
+    if (PeerUid(conn) != ::getuid()) [[unlikely]] {
+      ::close(conn);
+      return;
     }
-
-    // Options section
-    if (!help_info.empty()) {
-      ret.push_back('\n');
-      ret.append(ansi.getBoldUnderline() + "Options:" + ansi.getReset());
-      ret.append(this->info_->options_help.value_or(
-          createOptionsSection(ansi, help_info)));
+    // Buffered output would be written again by the child
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    auto pid = ::fork();
+    if (pid == 0) {
+      ::close(this->listen_fd_);
+      this->handle(conn);
     }
+    ::close(conn);
+    if (pid < 0) [[unlikely]] {
+      ServerFail("Cannot fork", errno);
+    }
+    this->children_.push_back(pid);
   }
 
-  return ret;
-}
+  /*!
+   * serveOne forever
+   */
+  [[noreturn]] auto serve() -> void {
+    while (true) {
+      this->serveOne();
+    }
+  }
+};
 
 }  // namespace Argo
 
@@ -3,8 +3,13 @@ import Argo;
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "TestHelper.h"
 
@@ -50,3 +55,237 @@ TEST(ArgoTest, AllTypes) {
   EXPECT_TRUE((  //
       std::is_same_v<decltype(parser.getArg<"arg6">()), const char*>));
 }
+
+TEST(ArgoTest, MappedFile) {
+  auto path = std::filesystem::temp_directory_path() / "argo_mapped_file";
+  std::ofstream(path) << "Hello,Mapped";
+
+  auto [argc, argv] = createArgcArgv(  //
+      "./main",                        //
+      "--dict", path.c_str(),          //
+      "--tables", path.c_str(), path.c_str());
+
+  auto argo = Argo::Parser<"MappedFile">();
+  auto parser =
+      argo.addArg<"dict", Argo::MappedFile>()
+          .addArg<"tables",
+                  std::vector<Argo::BasicMappedFile<Argo::MapAdvice::WillNeed>>,
+                  Argo::nargs('+')>()
+          .addArg<"missing", Argo::MappedFile>();
+
+  parser.parse(argc, argv.get());
+
+  EXPECT_EQ(parser.getArg<"dict">().view(), "Hello,Mapped");
+  EXPECT_EQ(parser.getArg<"dict">().size(), 12U);
+  EXPECT_EQ(parser.getArg<"tables">().size(), 2U);
+  EXPECT_EQ(parser.getArg<"tables">()[1].view(), "Hello,Mapped");
+  EXPECT_FALSE(parser.getArg<"missing">());
+
+  std::filesystem::remove(path);
+}
+
+enum class Mode { Fast, Safe, Debug };
+
+TEST(ArgoTest, Choices) {
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main",                        //
+        "--mode", "debug",               //
+        "--level", "high"                //
+    );
+
+    auto argo = Argo::Parser<"Choices 1">();
+    auto parser =
+        argo.addArg<"mode", Mode>(Argo::choices<"fast", "safe", "debug">())
+            .addArg<"level", std::string>(Argo::choices<"low", "high">());
+
+    parser.parse(argc, argv.get());
+
+    EXPECT_EQ(parser.getArg<"mode">(), Mode::Debug);
+    EXPECT_EQ(parser.getArg<"level">(), "high");
+    EXPECT_THAT(parser.formatHelp(true),
+                testing::HasSubstr("--mode {fast|safe|debug}"));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--mode", "fastest");
+
+    auto argo = Argo::Parser<"Choices 2">();
+    auto parser =
+        argo.addArg<"mode", Mode>(Argo::choices<"fast", "safe", "debug">());
+
+    EXPECT_THAT(
+        [&]() { parser.parse(argc, argv.get()); },
+        testing::ThrowsMessage<Argo::InvalidArgument>(testing::HasSubstr(
+            "Argument mode: fastest is not one of {fast|safe|debug}")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--level", "medium");
+
+    auto argo = Argo::Parser<"Choices 3">();
+    auto parser =
+        argo.addArg<"level", std::string>(Argo::choices<"low", "high">());
+
+    EXPECT_THROW(parser.parse(argc, argv.get()), Argo::ValidationError);
+  }
+}
+
+TEST(ArgoTest, Units) {
+  using namespace std::chrono_literals;
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main",                        //
+        "--cache", "4GiB",               //
+        "--block", "1.5KiB",             //
+        "--timeout", "250ms",            //
+        "--interval", "1.5s",            //
+        "--rate", "10k/s",               //
+        "--count", "2.5M",               //
+        "--offset", "-3k"                //
+    );
+
+    auto argo = Argo::Parser<"Units 1">();
+    auto parser = argo.addArg<"cache", Argo::Bytes>()
+                      .addArg<"block", Argo::Bytes>()
+                      .addArg<"timeout", std::chrono::milliseconds>()
+                      .addArg<"interval", std::chrono::microseconds>()
+                      .addArg<"rate", Argo::Rate<>>()
+                      .addArg<"count", Argo::SI<int>>()
+                      .addArg<"offset", Argo::SI<std::int64_t>>();
+
+    parser.parse(argc, argv.get());
+
+    EXPECT_EQ(parser.getArg<"cache">().count, 4ULL << 30);
+    EXPECT_EQ(parser.getArg<"block">().count, 1536U);
+    EXPECT_EQ(parser.getArg<"timeout">(), 250ms);
+    EXPECT_EQ(parser.getArg<"interval">(), 1500000us);
+    EXPECT_DOUBLE_EQ(parser.getArg<"rate">().per_second, 10000.0);
+    EXPECT_EQ(parser.getArg<"count">().value, 2500000);
+    EXPECT_EQ(parser.getArg<"offset">().value, -3000);
+    EXPECT_THAT(parser.formatHelp(true),
+                testing::HasSubstr("--cache [<BYTES>]"));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--cache", "20EiB");
+
+    auto argo = Argo::Parser<"Units 2">();
+    auto parser = argo.addArg<"cache", Argo::Bytes>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<Argo::InvalidArgument>(
+                    testing::HasSubstr("Argument cache: 20EiB is out of range")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--count", "3000M");
+
+    auto argo = Argo::Parser<"Units 3">();
+    auto parser = argo.addArg<"count", Argo::SI<int>>();
+
+    EXPECT_THROW(parser.parse(argc, argv.get()), Argo::InvalidArgument);
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--timeout", "1.5min");
+
+    auto argo = Argo::Parser<"Units 4">();
+    auto parser = argo.addArg<"timeout", std::chrono::seconds>();
+
+    parser.parse(argc, argv.get());
+    EXPECT_EQ(parser.getArg<"timeout">(), 90s);
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--timeout", "250ms");
+
+    auto argo = Argo::Parser<"Units 5">();
+    auto parser = argo.addArg<"timeout", std::chrono::seconds>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<Argo::InvalidArgument>(testing::HasSubstr(
+                    "Argument timeout: 250ms is not a whole number of ticks")));
+  }
+}
+
+TEST(ArgoTest, NetTypes) {
+  {
+    auto [argc, argv] = createArgcArgv(             //
+        "./main",                                   //
+        "--peer", "2001:db8::1",                    //
+        "--listen", "[::1]:8443",                   //
+        "--admin", "127.0.0.1:9000",                //
+        "--allow", "10.1.0.0/16", "10.0.0.0/8",     //
+        "192.168.1.7", "2001:db8::/32", "10.2.3.0/24");
+
+    auto argo = Argo::Parser<"NetTypes 1">();
+    auto parser = argo.addArg<"peer", Argo::IpAddress>()
+                      .addArg<"listen", Argo::Endpoint>()
+                      .addArg<"admin", Argo::Endpoint>()
+                      .addArg<"allow", std::vector<Argo::Cidr>,
+                              Argo::nargs('+')>();
+
+    parser.parse(argc, argv.get());
+
+    auto peer = parser.getArg<"peer">();
+    EXPECT_TRUE(peer.isV6());
+    EXPECT_EQ(peer.toString(), "2001:db8::1");
+
+    EXPECT_EQ(parser.getArg<"listen">().address().toString(), "::1");
+    EXPECT_EQ(parser.getArg<"listen">().port(), 8443);
+    EXPECT_TRUE(parser.getArg<"admin">().address().isV4());
+    EXPECT_EQ(parser.getArg<"admin">().address().toV4(), 0x7F000001U);
+    EXPECT_EQ(parser.getArg<"admin">().port(), 9000);
+
+    // Nested prefixes are folded into 10.0.0.0/8
+    const auto& allow = parser.getArg<"allow">();
+    ASSERT_EQ(allow.size(), 3U);
+    EXPECT_EQ(allow[0].prefixLength(), 8U);
+    EXPECT_TRUE(Argo::contains(allow, *Argo::IpAddress::tryParse("10.9.8.7")));
+    EXPECT_TRUE(
+        Argo::contains(allow, *Argo::IpAddress::tryParse("192.168.1.7")));
+    EXPECT_FALSE(
+        Argo::contains(allow, *Argo::IpAddress::tryParse("192.168.1.8")));
+    EXPECT_TRUE(
+        Argo::contains(allow, *Argo::IpAddress::tryParse("2001:db8:ff::2")));
+    EXPECT_FALSE(Argo::contains(allow, *Argo::IpAddress::tryParse("::1")));
+  }
+  {
+    EXPECT_FALSE(Argo::IpAddress::tryParse("1.2.3"));
+    EXPECT_FALSE(Argo::IpAddress::tryParse("01.2.3.4"));
+    EXPECT_FALSE(Argo::IpAddress::tryParse("1::2::3"));
+    EXPECT_FALSE(Argo::Cidr::tryParse("10.0.0.0/33"));
+    EXPECT_FALSE(Argo::Endpoint::tryParse("::1:80"));
+    EXPECT_EQ(Argo::IpAddress::tryParse("::ffff:1.2.3.4"),
+              Argo::IpAddress::tryParse("1.2.3.4"));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--peer", "256.0.0.1");
+
+    auto argo = Argo::Parser<"NetTypes 2">();
+    auto parser = argo.addArg<"peer", Argo::IpAddress>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<Argo::InvalidArgument>(testing::HasSubstr(
+                    "Argument peer: 256.0.0.1 is not an IP address")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main",                        //
+        "--allow", "192.168.0.0/16",     //
+        "--allow", "10.2.0.0/16",        //
+        "--allow", "10.0.0.0/8",         //
+        "--allow", "172.16.0.0/12");
+
+    auto argo = Argo::Parser<"NetTypes 3">();
+    auto parser =
+        argo.addArg<"allow", std::vector<Argo::Cidr>, Argo::Append>();
+
+    parser.parse(argc, argv.get());
+
+    const auto& allow = parser.getArg<"allow">();
+    ASSERT_EQ(allow.size(), 3U);
+    EXPECT_TRUE(std::ranges::is_sorted(allow));
+    EXPECT_TRUE(Argo::contains(allow, *Argo::IpAddress::tryParse("10.2.3.4")));
+    EXPECT_TRUE(
+        Argo::contains(allow, *Argo::IpAddress::tryParse("172.20.0.1")));
+    EXPECT_TRUE(
+        Argo::contains(allow, *Argo::IpAddress::tryParse("192.168.9.9")));
+    EXPECT_FALSE(Argo::contains(allow, *Argo::IpAddress::tryParse("11.0.0.1")));
+  }
+}
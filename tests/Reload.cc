@@ -0,0 +1,70 @@
+import Argo;
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "TestHelper.h"
+
+using Argo::Parser;
+
+#ifdef __linux__
+TEST(ArgoTest, Reload) {
+  auto dir = std::filesystem::temp_directory_path() / "argo_reload";
+  std::filesystem::create_directories(dir);
+  auto path = dir / "app.toml";
+  auto write = [&](std::string_view content) {
+    // Replace the file like editors do
+    auto tmp = dir / "app.toml.tmp";
+    std::ofstream(tmp) << content;
+    std::filesystem::rename(tmp, path);
+  };
+  write("threads = 4\nname = \"first\"\n");
+
+  auto [argc, argv] = createArgcArgv(  //
+      "./main", "--config", path.c_str(), "--mode", "fast");
+
+  auto argo = Parser<"Reload">();
+  auto parser = argo.addConfig<"config">()
+                    .addArg<"threads", int>(Argo::explicitDefault(1))
+                    .addArg<"name", std::string_view>()
+                    .addArg<"mode", std::string>();
+  parser.parse(argc, argv.get());
+
+  auto reloader = Argo::Reloader(parser, argc, argv.get());
+  {
+    auto config = reloader.read();
+    EXPECT_EQ(config->get<"threads">(), 4);
+    EXPECT_EQ(config->get<"name">(), "first");
+    EXPECT_EQ(config->getSource<"mode">(), Argo::ValueSource::CommandLine);
+  }
+
+  write("name = \"second\"\n");
+  for (int i = 0; i < 500 and reloader.generation() < 2; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  {
+    auto config = reloader.read();
+    EXPECT_EQ(config->get<"threads">(), 1);
+    EXPECT_EQ(config->get<"name">(), "second");
+    EXPECT_EQ(config->get<"mode">(), "fast");
+  }
+  // The parser itself is not touched
+  EXPECT_EQ(parser.getArg<"threads">(), 4);
+
+  auto error = std::string();
+  reloader.onError([&error](const std::exception& e) { error = e.what(); });
+  reloader.close();
+  std::ofstream(path) << "threads = [1, 2]\n";
+  EXPECT_FALSE(reloader.reload());
+  EXPECT_THAT(error, testing::HasSubstr("app.toml:1"));
+  EXPECT_EQ(reloader.read()->get<"name">(), "second");
+
+  std::filesystem::remove_all(dir);
+}
+#endif
@@ -3,6 +3,15 @@ import Argo;
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <map>
+#include <string>
+#include <string_view>
+#include <version>
+
+#ifdef __cpp_lib_flat_map
+#include <flat_map>
+#endif
+
 #include "TestHelper.h"
 
 using Argo::nargs;
@@ -46,3 +55,124 @@ TEST(ArgoTest, STLTypes) {
     EXPECT_EQ(a3, "Hello,World");
   }
 }
+
+TEST(ArgoTest, IndexSet) {
+  auto [argc, argv] = createArgcArgv(  //
+      "./main",                        //
+      "--cpus", "0-31,64-95",          //
+      "--shards", "0-4095:2",          //
+      "--ids", "2000000000,5,1000000-1000003");
+
+  auto argo = Parser<"IndexSet">();
+  auto parser = argo.addArg<"cpus", Argo::IndexSet>()
+                    .addArg<"shards", Argo::IndexSet>()
+                    .addArg<"ids", Argo::IndexSet>();
+  parser.parse(argc, argv.get());
+
+  auto cpus = parser.getArg<"cpus">();
+  EXPECT_TRUE(cpus.isDense());
+  EXPECT_EQ(cpus.size(), 64U);
+  EXPECT_TRUE(cpus.contains(31));
+  EXPECT_FALSE(cpus.contains(32));
+  EXPECT_TRUE(cpus.contains(95));
+  EXPECT_THAT(cpus.toMask(),
+              testing::ElementsAre(0xFFFFFFFFULL, 0xFFFFFFFFULL));
+
+  auto shards = parser.getArg<"shards">();
+  EXPECT_EQ(shards.size(), 2048U);
+  EXPECT_TRUE(shards.contains(4094));
+  EXPECT_FALSE(shards.contains(4095));
+
+  auto ids = parser.getArg<"ids">();
+  EXPECT_FALSE(ids.isDense());
+  EXPECT_TRUE(ids.contains(1000002));
+  EXPECT_FALSE(ids.contains(6));
+  EXPECT_THAT(std::vector<std::size_t>(ids.begin(), ids.end()),
+              testing::ElementsAre(5, 1000000, 1000001, 1000002, 1000003,
+                                   2000000000));
+}
+
+TEST(ArgoTest, IndexSetOverlap) {
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--ids", "0-1000:2,5-6,7-8");
+
+    auto argo = Parser<"IndexSetOverlap 1">();
+    auto parser = argo.addArg<"ids", Argo::IndexSet>();
+    parser.parse(argc, argv.get());
+
+    auto ids = parser.getArg<"ids">();
+    EXPECT_TRUE(ids.isDense());
+    EXPECT_EQ(ids.size(), 503U);
+    EXPECT_TRUE(ids.contains(7));
+    EXPECT_TRUE(ids.contains(1000));
+    EXPECT_FALSE(ids.contains(9));
+    EXPECT_EQ(ids.toMask().size(), 16U);
+  }
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "--ids", "0-100000000000:2,1-100000000000:3");
+
+    auto argo = Parser<"IndexSetOverlap 2">();
+    auto parser = argo.addArg<"ids", Argo::IndexSet>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<Argo::InvalidArgument>(
+                    testing::HasSubstr("span too many indices")));
+  }
+}
+
+TEST(ArgoTest, MapArgument) {
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main",                        //
+        "-D", "b=2",                     //
+        "-D", "a=1",                     //
+        "--define", "c=x=y",             //
+        "--define=b=3",                  //
+        "--limit", "cpu=4", "mem=16");
+
+    auto argo = Parser<"MapArgument 1">();
+    auto parser =
+        argo.addArg<"define,D", std::map<std::string_view, std::string_view>>()
+            .addArg<"limit", std::map<std::string, int>, nargs('+')>();
+
+    parser.parse(argc, argv.get());
+
+    EXPECT_THAT(parser.getArg<"define">(),
+                testing::ElementsAre(testing::Pair("a", "1"),
+                                     testing::Pair("b", "3"),
+                                     testing::Pair("c", "x=y")));
+    EXPECT_THAT(parser.getArg<"limit">(),
+                testing::ElementsAre(testing::Pair("cpu", 4),
+                                     testing::Pair("mem", 16)));
+    EXPECT_THAT(parser.formatHelp(true),
+                testing::HasSubstr("-D,--define KEY=VALUE"));
+  }
+#ifdef __cpp_lib_flat_map
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "-D", "z=26", "-D", "y=25", "-D", "z=0");
+
+    auto argo = Parser<"MapArgument 2">();
+    auto parser = argo.addArg<
+        "define,D", std::flat_map<std::string_view, std::string_view>>();
+
+    parser.parse(argc, argv.get());
+
+    EXPECT_THAT(parser.getArg<"define">(),
+                testing::ElementsAre(testing::Pair("y", "25"),
+                                     testing::Pair("z", "0")));
+  }
+#endif
+  {
+    auto [argc, argv] = createArgcArgv("./main", "-D", "novalue");
+
+    auto argo = Parser<"MapArgument 3">();
+    auto parser =
+        argo.addArg<"define,D", std::map<std::string_view, std::string_view>>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<Argo::InvalidArgument>(testing::HasSubstr(
+                    "Argument define: novalue is not KEY=VALUE")));
+  }
+}
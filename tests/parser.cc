@@ -3,6 +3,16 @@ import Argo;
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 #include "TestHelper.h"
 
 using Argo::implicitDefault;
@@ -10,8 +20,12 @@ using Argo::InvalidArgument;
 using Argo::nargs;
 using Argo::Parser;
 using Argo::ValidationError;
+using Argo::Validation::Each;
 using Argo::Validation::Range;
 
+template <class P>
+concept Serializable = requires(const P& parser) { parser.serialize(); };
+
 TEST(ArgoTest, EqualAssign) {
   auto [argc, argv] =
       createArgcArgv("./main", "--arg1=42", "--arg2=Hello,World");
@@ -177,6 +191,90 @@ TEST(ArgoTest, Validation) {
   //   }
 }
 
+TEST(ArgoTest, EachValidation) {
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "--arg", "1", "2", "1023"  //
+    );
+
+    auto argo = Parser<"Each validation 1">();
+    auto parser = argo  //
+                      .addArg<"arg", std::vector<int>, nargs('+')>(
+                          Each(Range(0, 1024)));
+
+    parser.parse(argc, argv.get());
+    EXPECT_THAT(parser.getArg<"arg">(), testing::ElementsAre(1, 2, 1023));
+  }
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "--arg", "1", "2048", "3", "4096"  //
+    );
+
+    auto argo = Parser<"Each validation 2">();
+    auto parser = argo  //
+                      .addArg<"arg", std::vector<int>, nargs('+')>(
+                          Each(Range(0, 1024)));
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<ValidationError>(testing::HasSubstr(
+                    "Option arg has invalid value 2048 at index 1")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "--arg", "0.5", "1.5"  //
+    );
+
+    auto argo = Parser<"Each validation 3">();
+    auto parser = argo  //
+                      .addArg<"arg", std::array<double, 2>>(
+                          Each(Range(0.0, 1.0)));
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<ValidationError>(testing::HasSubstr(
+                    "Option arg has invalid value 1.5 at index 1")));
+  }
+}
+
+TEST(ArgoTest, PathValidation) {
+  namespace fs = std::filesystem;
+  auto dir = fs::temp_directory_path() / "argo_path_validation";
+  fs::create_directories(dir);
+  std::vector<std::string> names;
+  constexpr std::size_t file_count = 300;
+  for (std::size_t i = 0; i < file_count; i++) {
+    names.push_back((dir / std::format("file{}", i)).string());
+    if (i != 7 and i != 211) {
+      std::ofstream(names.back()) << i;
+    }
+  }
+  {
+    auto [argc, argv] = [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return createArgcArgv("./main", "--inputs", names[I].c_str()...);
+    }(std::make_index_sequence<file_count>());
+    auto argo = Parser<"Path validation 1">();
+    auto parser = argo.addArg<"inputs", std::vector<fs::path>, nargs('+')>(
+        Argo::Validation::Exists());
+
+    EXPECT_THAT(
+        [&]() { parser.parse(argc, argv.get()); },
+        testing::ThrowsMessage<ValidationError>(testing::AllOf(
+            testing::HasSubstr(names[7]), testing::HasSubstr(names[211]),
+            testing::HasSubstr("does not exist"))));
+  }
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "--path", dir.c_str()  //
+    );
+    auto argo = Parser<"Path validation 2">();
+    auto parser = argo.addArg<"path", fs::path>(Argo::Validation::IsFile() |
+                                                Argo::Validation::IsDir());
+
+    parser.parse(argc, argv.get());
+    EXPECT_EQ(parser.getArg<"path">(), dir);
+  }
+  fs::remove_all(dir);
+}
+
 TEST(ArgoTest, Narg) {
   {
     auto [argc, argv] = createArgcArgv(  //
@@ -315,3 +413,909 @@ TEST(ArgoTest, CallBack) {
     EXPECT_THAT(parser.getArg<"arg1">(), testing::ElementsAre(7, 9, 11));
   }
 }
+
+TEST(ArgoTest, RepeatedArgument) {
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main",                        //
+        "-vvx",                          //
+        "--include", "a",                //
+        "-I", "b",                       //
+        "-v",                            //
+        "--include=c",                   //
+        "--tag", "x", "y",               //
+        "--tag", "z");
+
+    auto argo = Parser<"RepeatedArgument 1">();
+    auto parser =
+        argo.addCount<"verbose,v">()
+            .addFlag<"extra,x">()
+            .addArg<"include,I", std::vector<std::string>, Argo::Append>(
+                Argo::explicitDefault(std::vector<std::string>{"default"}))
+            .addArg<"tag", std::vector<std::string_view>, nargs('+'),
+                    Argo::Append>();
+
+    parser.parse(argc, argv.get());
+
+    EXPECT_EQ(parser.getArg<"verbose">(), 3);
+    EXPECT_TRUE(parser.getArg<"extra">());
+    EXPECT_THAT(parser.getArg<"include">(),
+                testing::ElementsAre("a", "b", "c"));
+    EXPECT_THAT(parser.getArg<"tag">(), testing::ElementsAre("x", "y", "z"));
+
+    parser.resetArgs();
+    auto [argc2, argv2] = createArgcArgv("./main", "-I", "d");
+    parser.parse(argc2, argv2.get());
+    EXPECT_EQ(parser.getArg<"verbose">(), 0);
+    EXPECT_THAT(parser.getArg<"include">(), testing::ElementsAre("d"));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--arg", "1", "--arg", "2");
+
+    auto argo = Parser<"RepeatedArgument 2">();
+    auto parser = argo.addArg<"arg", int>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<InvalidArgument>(
+                    testing::HasSubstr("Argument arg: duplicated argument")));
+  }
+}
+
+TEST(ArgoTest, Constraint) {
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--json", "--yaml");
+
+    auto argo = Parser<"Constraint 1">();
+    auto parser =
+        argo.addFlag<"json">()
+            .addFlag<"yaml">()
+            .addFlag<"toml">()
+            .addConstraint(Argo::exclusive<"json", "yaml", "toml">());
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<InvalidArgument>(testing::HasSubstr(
+                    R"(Arguments ["json", "yaml"] are mutually exclusive)")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "--tls-key", "a.key");
+
+    auto argo = Parser<"Constraint 2">();
+    auto parser =
+        argo.addArg<"tls-key", std::string>()
+            .addArg<"tls-cert", std::string>()
+            .addArg<"tls-ca", std::string>()
+            .addConstraint(Argo::dependsOn<"tls-key", "tls-cert", "tls-ca">());
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<InvalidArgument>(testing::HasSubstr(
+                    R"(Argument tls-key requires ["tls-cert", "tls-ca"])")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv("./main", "-v");
+
+    auto argo = Parser<"Constraint 3">();
+    auto parser = argo.addFlag<"verbose,v">()
+                      .addArg<"file", std::string>()
+                      .addArg<"url", std::string>()
+                      .addConstraint(Argo::oneOf<"file", "url">());
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<InvalidArgument>(testing::HasSubstr(
+                    R"(One of ["file", "url"] is required)")));
+  }
+  {
+    auto [argc, argv] = createArgcArgv(  //
+        "./main", "--yaml", "--tls-key", "a.key", "--tls-cert", "a.crt",
+        "--url", "https://example.com");
+
+    auto argo = Parser<"Constraint 4">();
+    auto parser = argo.addFlag<"json">()
+                      .addFlag<"yaml">()
+                      .addArg<"tls-key", std::string>()
+                      .addArg<"tls-cert", std::string>()
+                      .addArg<"file", std::string>()
+                      .addArg<"url", std::string>()
+                      .addConstraint(Argo::exclusive<"json", "yaml">())
+                      .addConstraint(Argo::dependsOn<"tls-key", "tls-cert">())
+                      .addConstraint(Argo::oneOf<"file", "url">());
+
+    parser.parse(argc, argv.get());
+    EXPECT_TRUE(parser.getArg<"yaml">());
+    EXPECT_EQ(parser.getArg<"url">(), "https://example.com");
+  }
+}
+
+TEST(ArgoTest, ConfigFile) {
+  auto path = std::filesystem::temp_directory_path() / "argo_config.toml";
+  std::ofstream(path) << R"(# production defaults
+port = 8080
+host = "example.com"   # trailing comment
+verbose = 2
+debug = true
+include = ["a",
+           'b']        # spans lines
+
+[tls]
+cert = "dir\\a.crt"
+)";
+  ::setenv("ARGO_TEST_HOST", "env.example.com", 1);
+  ::setenv("ARGO_TEST_LEVEL", "3", 1);
+
+  {
+    auto [argc, argv] =
+        createArgcArgv("./main", "--config", path.c_str(), "--port", "9000");
+
+    auto argo = Parser<"ConfigFile 1">();
+    auto parser =
+        argo.addConfig<"config">()
+            .addArg<"port", int>()
+            .addArg<"host", std::string>()
+            .addArg<"level", int>(Argo::explicitDefault(1))
+            .addArg<"name", std::string>(Argo::explicitDefault(
+                std::string("default")))
+            .addArg<"include", std::vector<std::string>, Argo::Append>()
+            .addArg<"tls.cert", std::string_view, Argo::Required>()
+            .addCount<"verbose,v">()
+            .addFlag<"debug">();
+    parser.setEnvPrefix("ARGO_TEST");
+
+    parser.parse(argc, argv.get());
+
+    EXPECT_EQ(parser.getArg<"port">(), 9000);
+    EXPECT_EQ(parser.getSource<"port">(), Argo::ValueSource::CommandLine);
+    EXPECT_EQ(parser.getArg<"host">(), "env.example.com");
+    EXPECT_EQ(parser.getSource<"host">(), Argo::ValueSource::Environment);
+    EXPECT_EQ(parser.getArg<"level">(), 3);
+    EXPECT_EQ(parser.getArg<"name">(), "default");
+    EXPECT_EQ(parser.getSource<"name">(), Argo::ValueSource::Default);
+    EXPECT_THAT(parser.getArg<"include">(), testing::ElementsAre("a", "b"));
+    EXPECT_EQ(parser.getArg<"tls.cert">(), "dir\\a.crt");
+    EXPECT_EQ(parser.getSource<"tls.cert">(), Argo::ValueSource::ConfigFile);
+    EXPECT_EQ(parser.getArg<"verbose">(), 2);
+    EXPECT_TRUE(parser.getArg<"debug">());
+  }
+  {
+    std::ofstream(path) << "port = 80\nunknown = 1\n";
+    auto [argc, argv] = createArgcArgv("./main");
+
+    auto argo = Parser<"ConfigFile 2">();
+    auto parser = argo.addConfig<"config">(Argo::explicitDefault(path.string()))
+                      .addArg<"port", int>();
+
+    EXPECT_THAT([&]() { parser.parse(argc, argv.get()); },
+                testing::ThrowsMessage<InvalidArgument>(
+                    testing::HasSubstr(":2: Invalid argument unknown")));
+  }
+  {
+    std::filesystem::remove(path);
+    auto [argc, argv] = createArgcArgv("./main");
+
+    auto argo = Parser<"ConfigFile 3">();
+    auto parser = argo.addConfig<"config">(Argo::explicitDefault(path.string()))
+                      .addArg<"port", int>(Argo::explicitDefault(1));
+
+    parser.parse(argc, argv.get());
+    EXPECT_EQ(parser.getArg<"port">(), 1);
+  }
+  {
+    std::ofstream(path) << R"(; comments start with ; too
+port = 4 ; note
+host = example.com; note
+ids = [1, 2 ; two
+       3]
+)";
+    auto [argc, argv] = createArgcArgv("./main");
+
+    auto argo = Parser<"ConfigFile 4">();
+    auto parser = argo.addConfig<"config">(Argo::explicitDefault(path.string()))
+                      .addArg<"port", int>()
+                      .addArg<"host", std::string>()
+                      .addArg<"ids", int, nargs('+')>();
+
+    parser.parse(argc, argv.get());
+    EXPECT_EQ(parser.getArg<"port">(), 4);
+    EXPECT_EQ(parser.getArg<"host">(), "example.com");
+    EXPECT_THAT(parser.getArg<"ids">(), testing::ElementsAre(1, 2, 3));
+  }
+  {
+    // A flag turned off in the config file is not given
+    std::ofstream(path) << "verbose = false\ndebug = 0\n";
+    auto [argc, argv] = createArgcArgv("./main", "--quiet");
+
+    auto argo = Parser<"ConfigFile 5">();
+    auto parser =
+        argo.addConfig<"config">(Argo::explicitDefault(path.string()))
+            .addFlag<"verbose">()
+            .addFlag<"quiet">()
+            .addCount<"debug">()
+            .addConstraint(Argo::exclusive<"verbose", "quiet">())
+            .addConstraint(Argo::exclusive<"debug", "quiet">());
+
+    parser.parse(argc, argv.get());
+    EXPECT_FALSE(parser.getArg<"verbose">());
+    EXPECT_EQ(parser.getSource<"verbose">(), Argo::ValueSource::ConfigFile);
+    EXPECT_TRUE(parser.getArg<"quiet">());
+  }
+  ::unsetenv("ARGO_TEST_HOST");
+  ::unsetenv("ARGO_TEST_LEVEL");
+}
+
+TEST(ArgoTest, Freeze) {
+  auto [argc, argv] = createArgcArgv(  //
+      "./main", "--threads", "8", "--name", "worker", "-v");
+
+  auto argo = Parser<"Freeze">();
+  auto parser = argo.addArg<"threads", int>()
+                    .addArg<"name", std::string>()
+                    .addArg<"ratio", double>(Argo::explicitDefault(0.5))
+                    .addFlag<"verbose,v">();
+  parser.parse(argc, argv.get());
+
+  const auto config = parser.freeze();
+  using Snapshot = std::remove_cvref_t<decltype(config)>;
+  static_assert(alignof(Snapshot) == 64);
+  static_assert(Snapshot::offsetOf<"threads">() == 0);
+  static_assert(Snapshot::offsetOf<"ratio">() % alignof(double) == 0);
+
+  parser.resetArgs();
+  auto [argc2, argv2] = createArgcArgv("./main", "--threads", "1");
+  parser.parse(argc2, argv2.get());
+
+  auto threads = std::vector<std::thread>();
+  auto sum = std::atomic<int>(0);
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&config, &sum] {
+      // A local copy for this thread
+      auto local = config;
+      sum += local.get<"threads">();
+      EXPECT_EQ(local.get<"name">(), "worker");
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(sum, 32);
+  EXPECT_DOUBLE_EQ(config.get<"ratio">(), 0.5);
+  EXPECT_TRUE(config.get<"verbose">());
+  EXPECT_EQ(config.getSource<"name">(), Argo::ValueSource::CommandLine);
+  EXPECT_EQ(parser.getArg<"threads">(), 1);
+}
+
+TEST(ArgoTest, Serialize) {
+  auto [argc, argv] = createArgcArgv(  //
+      "./main", "--threads", "8", "--name", "worker", "--ports", "80", "443",
+      "-v", "input.txt");
+
+  auto argo = Parser<"Serialize master">();
+  auto parser = argo.addArg<"threads", int>()
+                    .addArg<"name", std::string>()
+                    .addArg<"ports", int, nargs('+')>()
+                    .addFlag<"verbose,v">()
+                    .addPositionalArg<"file", std::string_view>();
+  parser.parse(argc, argv.get());
+  static_assert(Serializable<decltype(parser)>);
+  const auto buffer = parser.serialize();
+
+  auto worker_argo = Parser<"Serialize worker">();
+  auto worker = worker_argo.addArg<"threads", int>()
+                    .addArg<"name", std::string>()
+                    .addArg<"ports", int, nargs('+')>()
+                    .addFlag<"verbose,v">()
+                    .addPositionalArg<"file", std::string_view>();
+  worker.load(buffer);
+  EXPECT_EQ(worker.getArg<"threads">(), 8);
+  EXPECT_EQ(worker.getArg<"name">(), "worker");
+  EXPECT_THAT(worker.getArg<"ports">(), testing::ElementsAre(80, 443));
+  EXPECT_TRUE(worker.getArg<"verbose">());
+  EXPECT_EQ(worker.getArg<"file">(), "input.txt");
+  EXPECT_TRUE(worker.isAssigned<"name">());
+  EXPECT_EQ(worker.getSource<"ports">(), Argo::ValueSource::CommandLine);
+  EXPECT_THROW(worker.load(buffer), Argo::ParseError);
+
+  // Inherited fd
+  auto path = std::filesystem::temp_directory_path() / "argo_serialize.bin";
+  {
+    auto file = std::ofstream(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(buffer.data()),
+               static_cast<std::streamsize>(buffer.size()));
+  }
+  auto fd_argo = Parser<"Serialize fd">();
+  auto fd_parser = fd_argo.addArg<"threads", int>()
+                       .addArg<"name", std::string>()
+                       .addArg<"ports", int, nargs('+')>()
+                       .addFlag<"verbose,v">()
+                       .addPositionalArg<"file", std::string_view>();
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  fd_parser.load(fd);
+  ::close(fd);
+  std::filesystem::remove(path);
+  EXPECT_EQ(fd_parser.getArg<"file">(), "input.txt");
+  EXPECT_THAT(fd_parser.getArg<"ports">(), testing::ElementsAre(80, 443));
+
+  // Type of threads differs
+  auto other_argo = Parser<"Serialize other">();
+  auto other = other_argo.addArg<"threads", long>()
+                   .addArg<"name", std::string>()
+                   .addArg<"ports", int, nargs('+')>()
+                   .addFlag<"verbose,v">()
+                   .addPositionalArg<"file", std::string_view>();
+  EXPECT_THROW(other.load(buffer), Argo::ParseError);
+
+  auto truncated = std::span(buffer).first(buffer.size() - 1);
+  auto short_argo = Parser<"Serialize truncated">();
+  auto short_parser = short_argo.addArg<"threads", int>()
+                          .addArg<"name", std::string>()
+                          .addArg<"ports", int, nargs('+')>()
+                          .addFlag<"verbose,v">()
+                          .addPositionalArg<"file", std::string_view>();
+  EXPECT_THROW(short_parser.load(truncated), Argo::ParseError);
+
+  // Views are written as their characters, not as addresses into argv
+  auto [view_argc, view_argv] = createArgcArgv(  //
+      "./main", "--tag", "red", "--tag", "blue", "--pair", "x", "y");
+  auto view_argo = Parser<"Serialize views">();
+  auto view_parser =
+      view_argo.addArg<"tag", std::vector<std::string_view>, Argo::Append>()
+          .addArg<"pair", std::array<std::string_view, 2>>();
+  view_parser.parse(view_argc, view_argv.get());
+  const auto view_buffer = view_parser.serialize();
+  for (int i = 1; i < view_argc; i++) {
+    view_argv[i][0] = '?';
+  }
+
+  auto view_worker_argo = Parser<"Serialize views worker">();
+  auto view_worker =
+      view_worker_argo
+          .addArg<"tag", std::vector<std::string_view>, Argo::Append>()
+          .addArg<"pair", std::array<std::string_view, 2>>();
+  view_worker.load(view_buffer);
+  EXPECT_THAT(view_worker.getArg<"tag">(), testing::ElementsAre("red", "blue"));
+  EXPECT_THAT(view_worker.getArg<"pair">(), testing::ElementsAre("x", "y"));
+}
+
+TEST(ArgoTest, ParseCached) {
+  auto dir = std::filesystem::temp_directory_path() / "argo_cache";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  auto config = dir / "config.toml";
+  std::ofstream(config) << "port = 80\n";
+
+  auto [argc, argv] = createArgcArgv(  //
+      "./main", "--config", config.c_str(), "--name", "worker", "--ids", "1",
+      "2", "3");
+
+  auto argo = Parser<"ParseCached">();
+  auto parser = argo.addConfig<"config">()
+                    .addArg<"port", int>()
+                    .addArg<"name", std::string>()
+                    .addArg<"ids", int, nargs('+')>();
+
+  EXPECT_FALSE(parser.parseCached(argc, argv.get(), dir.string()));
+  EXPECT_EQ(parser.getArg<"port">(), 80);
+
+  parser.resetArgs();
+  EXPECT_TRUE(parser.parseCached(argc, argv.get(), dir.string()));
+  EXPECT_EQ(parser.getArg<"port">(), 80);
+  EXPECT_EQ(parser.getSource<"port">(), Argo::ValueSource::ConfigFile);
+  EXPECT_EQ(parser.getArg<"name">(), "worker");
+  EXPECT_THAT(parser.getArg<"ids">(), testing::ElementsAre(1, 2, 3));
+  EXPECT_THROW(parser.parseCached(argc, argv.get(), dir.string()),
+               Argo::ParseError);
+
+  // The config file changed
+  std::ofstream(config) << "port = 8080\n";
+  parser.resetArgs();
+  EXPECT_FALSE(parser.parseCached(argc, argv.get(), dir.string()));
+  EXPECT_EQ(parser.getArg<"port">(), 8080);
+  parser.resetArgs();
+  EXPECT_TRUE(parser.parseCached(argc, argv.get(), dir.string()));
+  EXPECT_EQ(parser.getArg<"port">(), 8080);
+
+  // Another command line
+  auto [argc2, argv2] = createArgcArgv(  //
+      "./main", "--config", config.c_str(), "--name", "other", "--ids", "4");
+  parser.resetArgs();
+  EXPECT_FALSE(parser.parseCached(argc2, argv2.get(), dir.string()));
+  EXPECT_EQ(parser.getArg<"name">(), "other");
+  EXPECT_THAT(parser.getArg<"ids">(), testing::ElementsAre(4));
+
+  auto entries = std::distance(std::filesystem::directory_iterator(dir),
+                               std::filesystem::directory_iterator());
+  EXPECT_EQ(entries, 3);
+
+  // Unknown options are replayed on a hit
+  auto [argc3, argv3] = createArgcArgv(  //
+      "./main", "--name", "x", "--color", "always", "-q");
+  auto unknown_argo = Parser<"ParseCached unknown">();
+  auto unknown_parser = unknown_argo.addArg<"name", std::string>();
+  unknown_parser.collectUnknown();
+  EXPECT_FALSE(unknown_parser.parseCached(argc3, argv3.get(), dir.string()));
+  EXPECT_THAT(unknown_parser.getUnknown(),
+              testing::ElementsAre(argv3[3], argv3[4], argv3[5]));
+  unknown_parser.resetArgs();
+  EXPECT_TRUE(unknown_parser.parseCached(argc3, argv3.get(), dir.string()));
+  EXPECT_EQ(unknown_parser.getArg<"name">(), "x");
+  EXPECT_THAT(unknown_parser.getUnknown(),
+              testing::ElementsAre(argv3[3], argv3[4], argv3[5]));
+  std::filesystem::remove_all(dir);
+}
+
+TEST(ArgoTest, Visit) {
+  auto [argc, argv] = createArgcArgv(  //
+      "./main", "--threads=8", "-vl", "3", "--ids", "1", "2", "--name",
+      "worker", "input.txt");
+
+  auto argo = Parser<"Visit">();
+  auto parser = argo.addArg<"threads,t", int>()
+                    .addFlag<"verbose,v">()
+                    .addArg<"level,l", int>()
+                    .addArg<"ids", int, nargs('+')>()
+                    .addArg<"name", std::string>()
+                    .addArg<"tag", std::string, Argo::Required>()
+                    .addPositionalArg<"file", std::string>();
+
+  auto visited = std::vector<std::tuple<std::string_view, std::string, int>>();
+  auto threads = 0;
+  parser.visit(
+      argc, argv.get(),
+      [&]<class Tag>(Tag, Argo::ValueSpan values, int position) {
+        if constexpr (Tag::key == "threads") {
+          std::from_chars(values[0].data(),
+                          values[0].data() + values[0].size(), threads);
+        }
+        auto joined = std::string();
+        for (auto value : values) {
+          joined += value;
+          joined += ';';
+        }
+        visited.emplace_back(Tag::key, joined, position);
+      });
+
+  EXPECT_EQ(threads, 8);
+  EXPECT_THAT(visited, testing::ElementsAre(
+                           std::tuple("threads", "8;", 1),
+                           std::tuple("verbose", "", 2),
+                           std::tuple("level", "3;", 2),
+                           std::tuple("ids", "1;2;", 4),
+                           std::tuple("name", "worker;", 7),
+                           std::tuple("file", "input.txt;", 9)));
+
+  EXPECT_THAT(
+      [&]() { parser.visit(argc, argv.get(), [](auto...) {}, true); },
+      testing::ThrowsMessage<InvalidArgument>(testing::HasSubstr("tag")));
+
+  // Nothing was stored, parse sees fresh arguments
+  auto [argc2, argv2] =
+      createArgcArgv("./main", "--tag", "a", "-t", "2", "input.txt");
+  parser.parse(argc2, argv2.get());
+  EXPECT_EQ(parser.getArg<"threads">(), 2);
+  EXPECT_FALSE(parser.isAssigned<"verbose">());
+  EXPECT_FALSE(parser.isAssigned<"ids">());
+}
+
+TEST(ArgoTest, Incremental) {
+  auto argo = Parser<"Incremental">();
+  auto parser = argo.addArg<"threads,t", int>()
+                    .addFlag<"verbose,v">()
+                    .addArg<"ids", int, nargs('+')>()
+                    .addArg<"name", std::string>()
+                    .addArg<"tag", std::string, Argo::Required>()
+                    .addPositionalArg<"file", std::string>()
+                    .addHelp<"help,h">();
+
+  auto events = std::vector<std::tuple<std::string_view, std::string, int>>();
+  auto visitor = [&]<class Tag>(Tag, Argo::ValueSpan values, int position) {
+    auto joined = std::string();
+    for (auto value : values) {
+      joined += value;
+      joined += ';';
+    }
+    events.emplace_back(Tag::key, joined, position);
+  };
+
+  auto stream = parser.incremental();
+  auto pushed = [&](std::string_view token) {
+    stream.push(token, visitor);
+    return events.size();
+  };
+  EXPECT_EQ(pushed("--threads"), 0U);
+  EXPECT_EQ(pushed("8"), 1U);
+  EXPECT_EQ(pushed("-v"), 2U);
+  EXPECT_EQ(pushed("--ids"), 2U);
+  EXPECT_EQ(pushed("1"), 2U);
+  EXPECT_EQ(pushed("2"), 2U);
+  EXPECT_EQ(pushed("--name=worker"), 4U);
+  EXPECT_EQ(pushed("input.txt"), 5U);
+  stream.finish(visitor);
+
+  EXPECT_THAT(events,
+              testing::ElementsAre(std::tuple("threads", "8;", 0),
+                                   std::tuple("verbose", "", 2),
+                                   std::tuple("ids", "1;2;", 3),
+                                   std::tuple("name", "worker;", 6),
+                                   std::tuple("file", "input.txt;", 7)));
+
+  events.clear();
+  EXPECT_EQ(pushed("-h"), 1U);
+  EXPECT_EQ(std::get<0>(events[0]), "help");
+  EXPECT_THROW(pushed("--unknown"), InvalidArgument);
+  stream.reset();
+
+  // Options end at "--", as in parse
+  events.clear();
+  EXPECT_EQ(pushed("--threads"), 0U);
+  EXPECT_EQ(pushed("2"), 1U);
+  EXPECT_EQ(pushed("in.txt"), 2U);
+  EXPECT_EQ(pushed("--"), 2U);
+  EXPECT_EQ(pushed("--threads"), 3U);
+  EXPECT_EQ(pushed("-h"), 4U);
+  stream.finish(visitor);
+  EXPECT_THAT(events,
+              testing::ElementsAre(std::tuple("threads", "2;", 0),
+                                   std::tuple("file", "in.txt;", 2),
+                                   std::tuple("--", "--threads;", 4),
+                                   std::tuple("--", "-h;", 5)));
+  EXPECT_EQ(pushed("-v"), 5U);
+  EXPECT_EQ(std::get<0>(events[4]), "verbose");
+  stream.reset();
+  EXPECT_THAT(
+      [&]() { stream.finish(visitor, true); },
+      testing::ThrowsMessage<InvalidArgument>(testing::HasSubstr("tag")));
+}
+
+TEST(ArgoTest, CommandLine) {
+  auto parser = Argo::Parser<"CommandLine">()
+                    .addArg<"name", std::string>()
+                    .addArg<"message", std::string>()
+                    .addArg<"path", std::string>()
+                    .addFlag<"verbose,v">()
+                    .addPositionalArg<"files", std::vector<std::string>, nargs(2)>();
+  parser.parse(
+      R"(  ./job --name 'it''s "here"' --message="a \"b\" \$c \d"  -v)"
+      "\t--path /very/long/path/with\\ space/to/file.txt first\\\nline ''");
+  EXPECT_EQ(parser.getArg<"name">(), R"(its "here")");
+  EXPECT_EQ(parser.getArg<"message">(), R"(a "b" $c \d)");
+  EXPECT_EQ(parser.getArg<"path">(), "/very/long/path/with space/to/file.txt");
+  EXPECT_TRUE(parser.getArg<"verbose">());
+  EXPECT_THAT(parser.getArg<"files">(), testing::ElementsAre("firstline", ""));
+
+  parser.resetArgs();
+  EXPECT_THAT(
+      [&]() { parser.parse(R"(./job --name "unterminated)"); },
+      testing::ThrowsMessage<Argo::ParseError>(
+          testing::HasSubstr("Unterminated")));
+  parser.resetArgs();
+  EXPECT_THROW(parser.parse("./job --name 'abc"), Argo::ParseError);
+  parser.resetArgs();
+  parser.parse("");
+  EXPECT_FALSE(parser.getArg<"verbose">());
+}
+
+TEST(ArgoTest, ResetArgs) {
+  auto parser =
+      Argo::Parser<"ResetArgs">()
+          .addArg<"level", int>(Argo::explicitDefault(2))
+          .addArg<"name", std::string>(Argo::explicitDefault("anonymous"))
+          .addArg<"files", std::vector<std::string>, nargs('+')>()
+          .addArg<"tag", std::vector<std::string>, nargs(1), Argo::Append>();
+
+  auto [argc, argv] = createArgcArgv("./main", "--level", "5", "--name", "x",
+                                     "--files", "a", "b", "c", "--tag", "t");
+  parser.parse(argc, argv.get());
+  auto capacity = parser.getArg<"files">().capacity();
+
+  parser.resetArgs();
+  EXPECT_EQ(parser.getArg<"level">(), 2);
+  EXPECT_EQ(parser.getArg<"name">(), "anonymous");
+  EXPECT_TRUE(parser.getArg<"files">().empty());
+  EXPECT_EQ(parser.getArg<"files">().capacity(), capacity);
+  EXPECT_TRUE(parser.getArg<"tag">().empty());
+
+  auto [argc2, argv2] = createArgcArgv("./main", "--tag", "u");
+  parser.parse(argc2, argv2.get());
+  EXPECT_EQ(parser.getArg<"level">(), 2);
+  EXPECT_THAT(parser.getArg<"tag">(), testing::ElementsAre("u"));
+
+  parser.resetArgs(true);
+  EXPECT_EQ(parser.getArg<"files">().capacity(), 0U);
+  EXPECT_TRUE(parser.getArg<"tag">().empty());
+  parser.parse(argc, argv.get());
+  EXPECT_THAT(parser.getArg<"files">(), testing::ElementsAre("a", "b", "c"));
+}
+
+TEST(ArgoTest, Passthrough) {
+  auto parser = Argo::Parser<"Passthrough">()
+                    .addArg<"cpu", int>()
+                    .addFlag<"verbose,v">()
+                    .addPositionalArg<"input", std::string>();
+  auto [argc, argv] = createArgcArgv("./launcher", "--cpu", "2", "input", "-v",
+                                     "--", "./child", "--cpu", "--", "8");
+  parser.parse(argc, argv.get());
+  EXPECT_EQ(parser.getArg<"cpu">(), 2);
+  EXPECT_EQ(parser.getArg<"input">(), "input");
+  EXPECT_TRUE(parser.getArg<"verbose">());
+  auto rest = parser.getPassthrough();
+  ASSERT_EQ(rest.size(), 4U);
+  EXPECT_EQ(rest.data(), argv.get() + 6);
+  EXPECT_STREQ(rest[0], "./child");
+  EXPECT_STREQ(rest[2], "--");
+
+  parser.resetArgs();
+  parser.parse("./launcher input --");
+  EXPECT_TRUE(parser.getPassthrough().empty());
+  EXPECT_FALSE(parser.getArg<"verbose">());
+
+  auto child = Argo::Parser<"Passthrough_child">().addArg<"cpu", int>();
+  auto wrapper = Argo::Parser<"Passthrough_wrapper">()
+                     .addFlag<"dry">()
+                     .addParser<"run">(child);
+  wrapper.parse("./wrapper --dry run --cpu 4 -- ./tool run");
+  EXPECT_TRUE(wrapper.getArg<"dry">());
+  EXPECT_TRUE(wrapper.getPassthrough().empty());
+  EXPECT_EQ(child.getArg<"cpu">(), 4);
+  EXPECT_THAT(std::vector<std::string_view>(child.getPassthrough().begin(),
+                                            child.getPassthrough().end()),
+              testing::ElementsAre("./tool", "run"));
+}
+
+TEST(ArgoTest, CollectUnknown) {
+  auto parser = Argo::Parser<"CollectUnknown">()
+                    .addArg<"jobs,j", int>()
+                    .addFlag<"verbose,v">()
+                    .addPositionalArg<"input", std::string>();
+  parser.collectUnknown();
+  auto [argc, argv] = createArgcArgv(
+      "./driver", "input", "--engine-cache", "1G", "-O2", "-vx",
+      "--engine-mode=fast", "extra", "-j8", "--verbose");
+  parser.parse(argc, argv.get());
+  EXPECT_EQ(parser.getArg<"input">(), "input");
+  EXPECT_EQ(parser.getArg<"jobs">(), 8);
+  EXPECT_TRUE(parser.getArg<"verbose">());
+  EXPECT_THAT(std::vector<std::string_view>(parser.getUnknown().begin(),
+                                            parser.getUnknown().end()),
+              testing::ElementsAre("--engine-cache", "1G", "-O2", "-vx",
+                                   "--engine-mode=fast", "extra"));
+  EXPECT_EQ(parser.getUnknown()[0], argv[2]);
+
+  parser.resetArgs();
+  parser.collectUnknown(false);
+  EXPECT_THROW(parser.parse(argc, argv.get()), InvalidArgument);
+}
+
+TEST(ArgoTest, ArgsFromStdin) {
+  auto pipe_with = [](std::string_view input) {
+    int fds[2];
+    EXPECT_EQ(::pipe(fds), 0);
+    EXPECT_EQ(::write(fds[1], input.data(), input.size()),
+              static_cast<::ssize_t>(input.size()));
+    ::close(fds[1]);
+    return fds[0];
+  };
+
+  auto parser =
+      Argo::Parser<"ArgsFromStdin">()
+          .addArg<"name", std::string>()
+          .addPositionalArg<"files", std::vector<std::string>, nargs('+')>();
+
+  // Spliced in place
+  auto fd = pipe_with(std::string_view("f1\0f2 with space\0", 17));
+  parser.argsFromStdin('\0', fd);
+  auto [argc, argv] = createArgcArgv("./tool", "-", "--name", "x");
+  parser.parse(argc, argv.get());
+  EXPECT_EQ(parser.getArg<"name">(), "x");
+  EXPECT_THAT(parser.getArg<"files">(),
+              testing::ElementsAre("f1", "f2 with space"));
+  ::close(fd);
+
+  // Last token, read lazily
+  parser.resetArgs();
+  fd = pipe_with("b\nc\n\nd");
+  parser.argsFromStdin('\n', fd);
+  auto [argc2, argv2] =
+      createArgcArgv("./tool", "--name", "y", "a", "--args-from-stdin");
+  parser.parse(argc2, argv2.get());
+  EXPECT_THAT(parser.getArg<"files">(), testing::ElementsAre("a"));
+  auto rest = std::vector<std::string_view>();
+  for (auto token : parser.getStdinArgs()) {
+    rest.push_back(token);
+  }
+  EXPECT_THAT(rest, testing::ElementsAre("b", "c", "", "d"));
+  ::close(fd);
+
+  // Cache entries are keyed on the tokens read from stdin
+  auto dir = std::filesystem::temp_directory_path() / "argo_stdin_cache";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  auto [argc3, argv3] = createArgcArgv("./tool", "-", "--name", "z");
+  for (auto [input, hit] : {std::pair{"a.txt\n", false},
+                            std::pair{"b.txt\n", false},
+                            std::pair{"a.txt\n", true}}) {
+    parser.resetArgs();
+    fd = pipe_with(input);
+    parser.argsFromStdin('\n', fd);
+    EXPECT_EQ(parser.parseCached(argc3, argv3.get(), dir.string()), hit);
+    EXPECT_THAT(parser.getArg<"files">(),
+                testing::ElementsAre(std::string_view(input).substr(0, 5)));
+    ::close(fd);
+  }
+  std::filesystem::remove_all(dir);
+
+  // "-" as the value of an option is not read from stdin
+  auto out_parser =
+      Argo::Parser<"ArgsFromStdin out">()
+          .addArg<"out", std::string>()
+          .addPositionalArg<"files", std::vector<std::string>, nargs('+')>();
+  fd = pipe_with("f1\n");
+  out_parser.argsFromStdin('\n', fd);
+  auto [argc4, argv4] =
+      createArgcArgv("./tool", "--out", "-", "-", "extra");
+  out_parser.parse(argc4, argv4.get());
+  EXPECT_EQ(out_parser.getArg<"out">(), "-");
+  EXPECT_THAT(out_parser.getArg<"files">(),
+              testing::ElementsAre("f1", "extra"));
+  ::close(fd);
+}
+
+TEST(ArgoTest, TokenReader) {
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+  // Larger than a chunk and than the pipe buffer, with a token longer than a
+  // chunk
+  auto writer = std::thread([fd = fds[1]] {
+    auto out = std::string();
+    for (int i = 0; i < 20000; i++) {
+      out += std::format("token{}", i);
+      out.push_back('\0');
+    }
+    out += std::string(200000, 'x');
+    std::size_t written = 0;
+    while (written < out.size()) {
+      auto len = ::write(fd, out.data() + written, out.size() - written);
+      ASSERT_GT(len, 0);
+      written += static_cast<std::size_t>(len);
+    }
+    ::close(fd);
+  });
+
+  auto reader = Argo::TokenReader(fds[0]);
+  auto tokens = std::vector<std::string_view>();
+  for (auto token : reader) {
+    tokens.push_back(token);
+  }
+  writer.join();
+  ::close(fds[0]);
+
+  ASSERT_EQ(tokens.size(), 20001U);
+  for (int i = 0; i < 20000; i++) {
+    EXPECT_EQ(tokens[i], std::format("token{}", i));
+    EXPECT_EQ(tokens[i].data()[tokens[i].size()], '\0');
+  }
+  EXPECT_EQ(tokens.back(), std::string(200000, 'x'));
+}
+
+TEST(ArgoTest, LazyArgs) {
+  auto parser =
+      Argo::Parser<"LazyArgs">()
+          .addArg<"scale", int>()
+          .addArg<"ids", Argo::LazyArgs<int>, nargs('*')>(Range(0, 1024))
+          .addPositionalArg<"files", Argo::LazyArgs<std::string_view>,
+                            nargs('+')>();
+  // The views point into this process's argv
+  static_assert(!Serializable<decltype(parser)>);
+  auto [argc, argv] = createArgcArgv("./main", "--scale", "2", "a.txt",
+                                     "b.txt", "c.txt", "--ids", "3", "17",
+                                     "2048");
+  parser.parse(argc, argv.get());
+  EXPECT_EQ(parser.getArg<"scale">(), 2);
+
+  const auto& files = parser.getArg<"files">();
+  ASSERT_EQ(files.size(), 3U);
+  EXPECT_EQ(files[0].data(), argv[3]);
+  EXPECT_THAT(std::vector<std::string_view>(files.begin(), files.end()),
+              testing::ElementsAre("a.txt", "b.txt", "c.txt"));
+  static_assert(std::ranges::random_access_range<Argo::LazyArgs<int>>);
+
+  const auto& ids = parser.getArg<"ids">();
+  ASSERT_EQ(ids.size(), 3U);
+  EXPECT_EQ(ids[1], 17);
+  EXPECT_EQ(*(ids.begin() + 1), 17);
+  EXPECT_EQ(ids.raw(2), "2048");
+  EXPECT_THROW((void)ids[2], ValidationError);
+
+  parser.resetArgs();
+  auto [argc2, argv2] = createArgcArgv("./main", "x", "--ids=5");
+  parser.parse(argc2, argv2.get());
+  EXPECT_EQ(parser.getArg<"ids">().size(), 1U);
+  EXPECT_EQ(parser.getArg<"ids">()[0], 5);
+  EXPECT_EQ(parser.getArg<"files">().raw(0), "x");
+}
+
+TEST(ArgoTest, Repl) {
+  auto stats = Argo::Parser<"Repl_stats">()
+                   .addFlag<"verbose,v">()
+                   .addArg<"fields", std::vector<std::string>, nargs('+')>()
+                   .addHelp();
+  auto drain = Argo::Parser<"Repl_drain">()
+                   .addArg<"timeout", int>(Argo::explicitDefault(30))
+                   .addPositionalArg<"backend", std::string>();
+  auto parser = Argo::Parser<"Repl">()
+                    .addParser<"stats">(stats)
+                    .addParser<"drain">(drain);
+
+  auto calls = std::vector<std::string>();
+  auto repl = Argo::Repl(parser, "admin");
+  repl.on<"stats">([&](auto& p) {
+        calls.push_back(std::format("stats {} {}",
+                                    p.template getArg<"verbose">() ? "-v" : "",
+                                    p.template getArg<"fields">()));
+      })
+      .on<"drain">([&](auto& p) {
+        calls.push_back(std::format("drain {} {}",
+                                    p.template getArg<"timeout">(),
+                                    p.template getArg<"backend">()));
+      })
+      .otherwise([&](auto&) { calls.emplace_back("none"); });
+
+  EXPECT_TRUE(repl.execute("stats -v --fields rps 'p99 latency'"));
+  EXPECT_TRUE(repl.execute("drain --timeout 5 db1"));
+  EXPECT_TRUE(repl.execute("stats"));
+  EXPECT_TRUE(repl.execute("drain db2"));
+  EXPECT_FALSE(repl.execute("   "));
+  EXPECT_THROW(repl.execute("drain --unknown"), InvalidArgument);
+  EXPECT_TRUE(repl.execute("drain db3"));
+
+  // Help goes to stdout and the loop goes on
+  testing::internal::CaptureStdout();
+  EXPECT_TRUE(repl.execute("stats --help"));
+  EXPECT_THAT(testing::internal::GetCapturedStdout(),
+              testing::HasSubstr("--fields"));
+
+  auto in = std::istringstream("stats --bad\nstats -v --fields qps\n");
+  auto err = std::ostringstream();
+  repl.run(in, err);
+  EXPECT_THAT(err.str(), testing::HasSubstr("bad"));
+
+  EXPECT_THAT(calls, testing::ElementsAre(
+                         R"(stats -v ["rps", "p99 latency"])", "drain 5 db1",
+                         "stats  []", "drain 30 db2", "drain 30 db3",
+                         R"(stats -v ["qps"])"));
+}
+
+TEST(ArgoTest, Server) {
+  auto path = (std::filesystem::temp_directory_path() /
+               std::format("argo-server-{}.sock", ::getpid()))
+                  .string();
+  auto exit_parser =
+      Argo::Parser<"Server_exit">().addArg<"code", int>().addHelp();
+  auto parser = Argo::Parser<"Server">().addParser<"exit">(exit_parser);
+  using P = decltype(parser);
+  // Sub parsers are part of the schema
+  static_assert(Argo::server_schema<P> !=
+                Argo::server_schema<decltype(Argo::Parser<"Server_other">())>);
+
+  auto [argc, argv] = createArgcArgv("./client", "exit", "--code", "7");
+  EXPECT_EQ(Argo::forwardToServer<P>(path, argc, argv.get()), std::nullopt);
+
+  auto server = Argo::Server(parser, path);
+  server.on<"exit">([](auto& p) { return p.template getArg<"code">(); })
+      .otherwise([](auto&) { return 3; });
+
+  auto serve = std::thread([&] {
+    for (int i = 0; i < 5; i++) {
+      server.serveOne();
+    }
+  });
+  EXPECT_EQ(Argo::forwardToServer<P>(path, argc, argv.get()), 7);
+  auto [argc2, argv2] = createArgcArgv("./client");
+  EXPECT_EQ(Argo::forwardToServer<P>(path, argc2, argv2.get()), 3);
+  // Help exits with 0, an uncaught parse error aborts the request only
+  auto [argc3, argv3] = createArgcArgv("./client", "exit", "--help");
+  EXPECT_EQ(Argo::forwardToServer<P>(path, argc3, argv3.get()), 0);
+  auto [argc4, argv4] = createArgcArgv("./client", "exit", "--bad", "1");
+  EXPECT_EQ(Argo::forwardToServer<P>(path, argc4, argv4.get()), 128 + SIGABRT);
+  // A client built with other options parses in process
+  EXPECT_EQ(Argo::forwardToServer(path, argc, argv.get(),
+                                  Argo::server_schema<P> + 1),
+            std::nullopt);
+  serve.join();
+}